@@ -40,4 +40,30 @@
 
 + (ECKeyPair*)generateKeyPair;
 
+/**
+ *  Generate several curve25519 key pairs at once, which is cheaper per key than calling generateKeyPair repeatedly.
+ *
+ *  @param count number of key pairs to generate
+ *
+ *  @return array of count curve25519 key pairs.
+ */
+
++ (NSArray<ECKeyPair*>*)generateKeyPairs:(NSUInteger)count;
+
+#ifdef DEBUG
+
+/**
+ *  Checks curve25519-donna's 32-bit and 64-bit limb backends against the RFC 7748 test vectors, and against each
+ *  other on random scalars and points, throwing an NSInternalInconsistencyException on any mismatch. Then times a
+ *  scalar multiplication with each backend. Only the 32-bit backend is built on targets without 128-bit integers.
+ *
+ *  @param iterations number of random inputs to cross-check, and of multiplications to time per backend.
+ *
+ *  @return Seconds per scalar multiplication, keyed by backend name.
+ */
+
++ (NSDictionary<NSString*, NSNumber*>*)benchmarkScalarMultiplicationWithIterations:(NSUInteger)iterations;
+
+#endif
+
 @end
@@ -15,6 +15,22 @@ NSString * const TSECKeyPairPreKeyId    = @"TSECKeyPairPreKeyId";
 
 extern void curve25519_donna(unsigned char *output, const unsigned char *a, const unsigned char *b);
 
+#ifdef DEBUG
+// Mirrors the backend selection in curve25519-donna.c.
+#if defined(__SIZEOF_INT128__) && !defined(CURVE25519_DONNA_NO_64BIT)
+#define CURVE25519_DONNA_64BIT 1
+extern int curve25519_donna_64(unsigned char *output, const unsigned char *a, const unsigned char *b);
+#endif
+extern int curve25519_donna_32(unsigned char *output, const unsigned char *a, const unsigned char *b);
+#endif
+
+extern void curve25519_keygen(unsigned char* curve25519_pubkey_out, /* 32 bytes */
+                              const unsigned char* curve25519_privkey_in); /* 32 bytes */
+
+extern void curve25519_keygen_many(unsigned char* curve25519_pubkeys_out, /* 32 * count bytes */
+                                   const unsigned char* curve25519_privkeys_in, /* 32 * count bytes */
+                                   unsigned long count);
+
 extern int  curve25519_sign(unsigned char* signature_out, /* 64 bytes */
                      const unsigned char* curve25519_privkey, /* 32 bytes */
                      const unsigned char* msg, const unsigned long msg_len,
@@ -54,21 +70,54 @@ extern int  curve25519_sign(unsigned char* signature_out, /* 64 bytes */
 }
 
 
++(void)clampPrivateKey:(uint8_t *)privateKey{
+    // Clamp the private key as described in https://code.google.com/p/curve25519-donna/
+    privateKey[0]  &= 248;
+    privateKey[31] &= 127;
+    privateKey[31] |= 64;
+}
+
 +(ECKeyPair*)generateKeyPair{
     ECKeyPair* keyPair =[[ECKeyPair alloc] init];
     
-    // Generate key pair as described in https://code.google.com/p/curve25519-donna/
     memcpy(keyPair->privateKey, [[Randomness  generateRandomBytes:32] bytes], 32);
-    keyPair->privateKey[0]  &= 248;
-    keyPair->privateKey[31] &= 127;
-    keyPair->privateKey[31] |= 64;
+    [self clampPrivateKey:keyPair->privateKey];
     
-    static const uint8_t basepoint[ECCKeyLength] = {9};
-    curve25519_donna(keyPair->publicKey, keyPair->privateKey, basepoint);
+    // A fixed-base multiplication on the birationally equivalent Edwards curve, using its precomputed
+    // tables, gives the same public key as curve25519_donna(pub, priv, basepoint), in less time.
+    curve25519_keygen(keyPair->publicKey, keyPair->privateKey);
     
     return keyPair;
 }
 
++(NSArray<ECKeyPair*>*)generateKeyPairs:(NSUInteger)count{
+    if (count == 0) {
+        return @[];
+    }
+    
+    NSMutableData *privateKeys = [[Randomness generateRandomBytes:(int)(count * ECCKeyLength)] mutableCopy];
+    NSMutableData *publicKeys  = [NSMutableData dataWithLength:count * ECCKeyLength];
+    
+    uint8_t *privateKeyBytes = privateKeys.mutableBytes;
+    for (NSUInteger i = 0; i < count; i++) {
+        [self clampPrivateKey:privateKeyBytes + i * ECCKeyLength];
+    }
+    
+    curve25519_keygen_many(publicKeys.mutableBytes, privateKeyBytes, count);
+    
+    NSMutableArray<ECKeyPair*> *keyPairs = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        ECKeyPair* keyPair =[[ECKeyPair alloc] init];
+        memcpy(keyPair->privateKey, privateKeyBytes + i * ECCKeyLength, ECCKeyLength);
+        memcpy(keyPair->publicKey, (const uint8_t *)publicKeys.bytes + i * ECCKeyLength, ECCKeyLength);
+        [keyPairs addObject:keyPair];
+    }
+    
+    memset(privateKeyBytes, 0, privateKeys.length);
+    
+    return [keyPairs copy];
+}
+
 -(NSData*) publicKey {
     return [NSData dataWithBytes:self->publicKey length:32];
 }
@@ -117,8 +166,115 @@ extern int  curve25519_sign(unsigned char* signature_out, /* 64 bytes */
     return [ECKeyPair generateKeyPair];
 }
 
++(NSArray<ECKeyPair*>*)generateKeyPairs:(NSUInteger)count{
+    return [ECKeyPair generateKeyPairs:count];
+}
+
 +(NSData*)generateSharedSecretFromPublicKey:(NSData *)theirPublicKey andKeyPair:(ECKeyPair *)keyPair{
     return [keyPair generateSharedSecretFromPublicKey:theirPublicKey];
 }
 
+#ifdef DEBUG
+
++ (void)getBytes:(unsigned char *)bytes fromHexString:(NSString *)hexString{
+    for (NSUInteger i = 0; i < ECCKeyLength; i++) {
+        unsigned int byte = 0;
+        sscanf([[hexString substringWithRange:NSMakeRange(2 * i, 2)] UTF8String], "%2x", &byte);
+        bytes[i] = (unsigned char)byte;
+    }
+}
+
++ (void)checkScalarMultiplicationOfScalar:(const unsigned char *)scalar point:(const unsigned char *)point expecting:(const unsigned char *)expected{
+    unsigned char output[ECCKeyLength];
+    
+    curve25519_donna_32(output, scalar, point);
+    if (memcmp(output, expected, ECCKeyLength) != 0) {
+        @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"32-bit curve25519-donna gave the wrong result" userInfo:nil];
+    }
+#ifdef CURVE25519_DONNA_64BIT
+    curve25519_donna_64(output, scalar, point);
+    if (memcmp(output, expected, ECCKeyLength) != 0) {
+        @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"64-bit curve25519-donna gave the wrong result" userInfo:nil];
+    }
+#endif
+}
+
++ (NSDictionary<NSString*, NSNumber*>*)benchmarkScalarMultiplicationWithIterations:(NSUInteger)iterations{
+    unsigned char scalar[ECCKeyLength], point[ECCKeyLength], expected[ECCKeyLength], output[ECCKeyLength];
+    
+    // RFC 7748 section 5.2, and Alice's public key from section 6.1.
+    NSArray<NSArray<NSString*>*> *vectors = @[@[@"a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4",
+                                                @"e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c",
+                                                @"c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552"],
+                                              @[@"4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d",
+                                                @"e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493",
+                                                @"95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957"],
+                                              @[@"77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a",
+                                                @"0900000000000000000000000000000000000000000000000000000000000000",
+                                                @"8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a"]];
+    for (NSArray<NSString*> *vector in vectors) {
+        [self getBytes:scalar fromHexString:vector[0]];
+        [self getBytes:point fromHexString:vector[1]];
+        [self getBytes:expected fromHexString:vector[2]];
+        [self checkScalarMultiplicationOfScalar:scalar point:point expecting:expected];
+    }
+    
+    // RFC 7748 section 5.2 iterated test: k = u = 9, then k = X25519(k, u) and u = old k, 1000 times.
+    unsigned char scalar64[ECCKeyLength], point64[ECCKeyLength];
+    memset(scalar, 0, ECCKeyLength);
+    scalar[0] = 9;
+    memcpy(point, scalar, ECCKeyLength);
+    memcpy(scalar64, scalar, ECCKeyLength);
+    memcpy(point64, point, ECCKeyLength);
+    for (NSUInteger i = 0; i < 1000; i++) {
+        curve25519_donna_32(output, scalar, point);
+        memcpy(point, scalar, ECCKeyLength);
+        memcpy(scalar, output, ECCKeyLength);
+#ifdef CURVE25519_DONNA_64BIT
+        curve25519_donna_64(output, scalar64, point64);
+        memcpy(point64, scalar64, ECCKeyLength);
+        memcpy(scalar64, output, ECCKeyLength);
+#endif
+    }
+    [self getBytes:expected fromHexString:@"684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51"];
+    if (memcmp(scalar, expected, ECCKeyLength) != 0) {
+        @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"32-bit curve25519-donna failed the iterated test" userInfo:nil];
+    }
+#ifdef CURVE25519_DONNA_64BIT
+    if (memcmp(scalar64, expected, ECCKeyLength) != 0) {
+        @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"64-bit curve25519-donna failed the iterated test" userInfo:nil];
+    }
+#endif
+    
+    // The two backends must agree on arbitrary inputs, including unclamped scalars and non-canonical points.
+    for (NSUInteger i = 0; i < iterations; i++) {
+        memcpy(scalar, [[Randomness generateRandomBytes:ECCKeyLength] bytes], ECCKeyLength);
+        memcpy(point, [[Randomness generateRandomBytes:ECCKeyLength] bytes], ECCKeyLength);
+        curve25519_donna_32(expected, scalar, point);
+        [self checkScalarMultiplicationOfScalar:scalar point:point expecting:expected];
+    }
+    
+    NSMutableDictionary<NSString*, NSNumber*> *results = [NSMutableDictionary new];
+    if (iterations == 0) {
+        return results;
+    }
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < iterations; i++) {
+        curve25519_donna_32(output, scalar, point);
+    }
+    results[@"curve25519_donna_32"] = @((CFAbsoluteTimeGetCurrent() - start) / iterations);
+#ifdef CURVE25519_DONNA_64BIT
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < iterations; i++) {
+        curve25519_donna_64(output, scalar, point);
+    }
+    results[@"curve25519_donna_64"] = @((CFAbsoluteTimeGetCurrent() - start) / iterations);
+#endif
+    
+    return [results copy];
+}
+
+#endif
+
 @end
@@ -34,4 +34,45 @@
 
 +(BOOL)verifySignature:(NSData*)signature publicKey:(NSData*)pubKey data:(NSData*)data;
 
+/**
+ *  Verify many ed25519 signatures at once, which is faster per signature than verifying them one at a time.
+ *  Throws an NSInvalidArgumentException under the same conditions as verifySignature:publicKey:data:.
+ *
+ *  @param signatures ed25519 64-byte signatures.
+ *  @param pubKeys    public keys of the signers.
+ *  @param data       data to be checked against each signature.
+ *
+ *  @return The indexes of the valid signatures.
+ */
+
++(NSIndexSet*)verifySignatures:(NSArray<NSData*>*)signatures publicKeys:(NSArray<NSData*>*)pubKeys data:(NSArray<NSData*>*)data;
+
+#ifdef DEBUG
+
+/**
+ *  Checks crypto_hash_sha512 and crypto_hash_sha512_many against the NIST SHA-512 test vectors, throwing an
+ *  NSInternalInconsistencyException if either gets one wrong, then times both against CommonCrypto's CC_SHA512.
+ *
+ *  @param count  number of messages to hash with each implementation.
+ *  @param length length of each message, in bytes.
+ *
+ *  @return Seconds per message, keyed by implementation name.
+ */
+
++(NSDictionary<NSString*, NSNumber*>*)benchmarkSHA512WithMessageCount:(NSUInteger)count messageLength:(NSUInteger)length;
+
+/**
+ *  Measures verification throughput at batch sizes 1, 2, 4, ... 256. Each size verifies the same 256 freshly signed
+ *  messages, in batches of that size with verifySignatures:publicKeys:data:, and one at a time with
+ *  verifySignature:publicKey:data:. Throws an NSInternalInconsistencyException if any signature fails to verify.
+ *
+ *  @param length length of each signed message, in bytes.
+ *
+ *  @return Signatures per second for @"single" and @"batch", keyed by batch size.
+ */
+
++(NSDictionary<NSNumber*, NSDictionary<NSString*, NSNumber*>*>*)benchmarkVerificationWithMessageLength:(NSUInteger)length;
+
+#endif
+
 @end
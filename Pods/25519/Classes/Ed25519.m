@@ -8,6 +8,11 @@
 
 #import "Ed25519.h"
 #import "Curve25519.h"
+#import "Randomness.h"
+
+#ifdef DEBUG
+#import <CommonCrypto/CommonDigest.h>
+#endif
 
 @interface ECKeyPair ()
 -(NSData*) sign:(NSData*)data;
@@ -17,6 +22,22 @@ extern int curve25519_verify(const unsigned char* signature, /* 64 bytes */
                       const unsigned char* curve25519_pubkey, /* 32 bytes */
                       const unsigned char* msg, const unsigned long msg_len);
 
+extern int curve25519_verify_batch(int* results, /* count ints */
+                                   const unsigned char* signatures, /* 64 * count bytes */
+                                   const unsigned char* curve25519_pubkeys, /* 32 * count bytes */
+                                   const unsigned char* const* msgs,
+                                   const unsigned long* msg_lens,
+                                   unsigned long count,
+                                   const unsigned char* random); /* 16 * count bytes */
+
+#ifdef DEBUG
+extern int crypto_hash_sha512(unsigned char *out, const unsigned char *in, unsigned long long inlen);
+extern int crypto_hash_sha512_many(unsigned char *outs, /* 64 * count bytes */
+                                   const unsigned char * const *ins,
+                                   const unsigned long long *inlens,
+                                   unsigned long count);
+#endif
+
 @implementation Ed25519
 
 +(NSData*)sign:(NSData*)data withKeyPair:(ECKeyPair*)keyPair{
@@ -47,4 +68,193 @@ extern int curve25519_verify(const unsigned char* signature, /* 64 bytes */
     return success;
 }
 
++(NSIndexSet*)verifySignatures:(NSArray<NSData*>*)signatures publicKeys:(NSArray<NSData*>*)pubKeys data:(NSArray<NSData*>*)data{
+    
+    if ([signatures count] != [pubKeys count] || [signatures count] != [data count]) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException reason:@"Signatures, public keys and data need to be the same length" userInfo:nil];
+    }
+    
+    NSUInteger count = [signatures count];
+    if (count == 0) {
+        return [NSIndexSet indexSet];
+    }
+    
+    NSMutableData *signatureBytes = [NSMutableData dataWithCapacity:count * ECCSignatureLength];
+    NSMutableData *pubKeyBytes    = [NSMutableData dataWithCapacity:count * ECCKeyLength];
+    NSMutableData *messages       = [NSMutableData dataWithLength:count * sizeof(const unsigned char *)];
+    NSMutableData *messageLengths = [NSMutableData dataWithLength:count * sizeof(unsigned long)];
+    NSMutableData *results        = [NSMutableData dataWithLength:count * sizeof(int)];
+    
+    const unsigned char **messagePointers = messages.mutableBytes;
+    unsigned long *messageLengthValues = messageLengths.mutableBytes;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        if ([data[i] length] < 1) {
+            @throw [NSException exceptionWithName:NSInvalidArgumentException reason:@"Data needs to be at least one byte" userInfo:nil];
+        }
+        
+        if ([pubKeys[i] length] != ECCKeyLength) {
+            @throw [NSException exceptionWithName:NSInvalidArgumentException reason:@"Public Key isn't 32 bytes" userInfo:nil];
+        }
+        
+        if ([signatures[i] length] != ECCSignatureLength) {
+            @throw [NSException exceptionWithName:NSInvalidArgumentException reason:@"Signature isn't 64 bytes" userInfo:nil];
+        }
+        
+        [signatureBytes appendData:signatures[i]];
+        [pubKeyBytes appendData:pubKeys[i]];
+        messagePointers[i]     = [data[i] bytes];
+        messageLengthValues[i] = [data[i] length];
+    }
+    
+    // The random linear combination is only sound if the coefficients can't be predicted by the signers.
+    NSData *randomBytes = [Randomness generateRandomBytes:(int)(count * 16)];
+    
+    curve25519_verify_batch(results.mutableBytes, [signatureBytes bytes], [pubKeyBytes bytes], messagePointers, messageLengthValues, count, [randomBytes bytes]);
+    
+    NSMutableIndexSet *validIndexes = [NSMutableIndexSet indexSet];
+    const int *resultValues = results.bytes;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (resultValues[i] == 0) {
+            [validIndexes addIndex:i];
+        }
+    }
+    
+    return [validIndexes copy];
+}
+
+#ifdef DEBUG
+
++(NSString*)hexStringForDigest:(const unsigned char*)digest{
+    NSMutableString *hex = [NSMutableString stringWithCapacity:128];
+    for (NSUInteger i = 0; i < 64; i++) {
+        [hex appendFormat:@"%02x", digest[i]];
+    }
+    return hex;
+}
+
++(void)checkSHA512TestVectors{
+    // FIPS 180-2 appendix C, plus the empty message.
+    NSMutableData *million = [NSMutableData dataWithLength:1000000];
+    memset(million.mutableBytes, 'a', million.length);
+    NSArray<NSData*> *messages = @[[NSData data],
+                                   [@"abc" dataUsingEncoding:NSUTF8StringEncoding],
+                                   [@"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu" dataUsingEncoding:NSUTF8StringEncoding],
+                                   million];
+    NSArray<NSString*> *digests = @[@"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+                                    @"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+                                    @"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+                                    @"e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b"];
+    
+    NSUInteger count = [messages count];
+    const unsigned char *ins[count];
+    unsigned long long inlens[count];
+    unsigned char outs[64 * count];
+    unsigned char out[64];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        ins[i]    = [messages[i] bytes];
+        inlens[i] = [messages[i] length];
+    }
+    crypto_hash_sha512_many(outs, ins, inlens, count);
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        crypto_hash_sha512(out, ins[i], inlens[i]);
+        if (![[self hexStringForDigest:out] isEqualToString:digests[i]] ||
+            ![[self hexStringForDigest:outs + 64 * i] isEqualToString:digests[i]]) {
+            @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:[NSString stringWithFormat:@"SHA-512 test vector %lu failed", (unsigned long)i] userInfo:nil];
+        }
+    }
+}
+
++(NSDictionary<NSString*, NSNumber*>*)benchmarkSHA512WithMessageCount:(NSUInteger)count messageLength:(NSUInteger)length{
+    
+    [self checkSHA512TestVectors];
+    
+    if (count == 0) {
+        return @{};
+    }
+    
+    NSData *input = [Randomness generateRandomBytes:(int)(count * length)];
+    NSMutableData *outputs = [NSMutableData dataWithLength:count * 64];
+    NSMutableData *messages = [NSMutableData dataWithLength:count * sizeof(const unsigned char *)];
+    NSMutableData *messageLengths = [NSMutableData dataWithLength:count * sizeof(unsigned long long)];
+    
+    const unsigned char **messagePointers = messages.mutableBytes;
+    unsigned long long *messageLengthValues = messageLengths.mutableBytes;
+    unsigned char *outputBytes = outputs.mutableBytes;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        messagePointers[i]     = (const unsigned char *)[input bytes] + i * length;
+        messageLengthValues[i] = length;
+    }
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < count; i++) {
+        crypto_hash_sha512(outputBytes + 64 * i, messagePointers[i], length);
+    }
+    CFAbsoluteTime single = CFAbsoluteTimeGetCurrent() - start;
+    
+    start = CFAbsoluteTimeGetCurrent();
+    crypto_hash_sha512_many(outputBytes, messagePointers, messageLengthValues, count);
+    CFAbsoluteTime many = CFAbsoluteTimeGetCurrent() - start;
+    
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < count; i++) {
+        CC_SHA512(messagePointers[i], (CC_LONG)length, outputBytes + 64 * i);
+    }
+    CFAbsoluteTime commonCrypto = CFAbsoluteTimeGetCurrent() - start;
+    
+    return @{@"crypto_hash_sha512"      : @(single / count),
+             @"crypto_hash_sha512_many" : @(many / count),
+             @"CC_SHA512"               : @(commonCrypto / count)};
+}
+
++(NSDictionary<NSNumber*, NSDictionary<NSString*, NSNumber*>*>*)benchmarkVerificationWithMessageLength:(NSUInteger)length{
+    
+    const NSUInteger signatureCount = 256;
+    
+    NSArray<ECKeyPair*> *keyPairs = [Curve25519 generateKeyPairs:signatureCount];
+    NSMutableArray<NSData*> *signatures = [NSMutableArray arrayWithCapacity:signatureCount];
+    NSMutableArray<NSData*> *pubKeys    = [NSMutableArray arrayWithCapacity:signatureCount];
+    NSMutableArray<NSData*> *messages   = [NSMutableArray arrayWithCapacity:signatureCount];
+    
+    for (ECKeyPair *keyPair in keyPairs) {
+        NSData *message = [Randomness generateRandomBytes:(int)MAX(length, 1)];
+        [messages addObject:message];
+        [pubKeys addObject:[keyPair publicKey]];
+        [signatures addObject:[self sign:message withKeyPair:keyPair]];
+    }
+    
+    NSMutableDictionary<NSNumber*, NSDictionary<NSString*, NSNumber*>*> *results = [NSMutableDictionary new];
+    for (NSUInteger batchSize = 1; batchSize <= signatureCount; batchSize *= 2) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < signatureCount; i++) {
+            if (![self verifySignature:signatures[i] publicKey:pubKeys[i] data:messages[i]]) {
+                @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Signature failed to verify" userInfo:nil];
+            }
+        }
+        CFAbsoluteTime single = CFAbsoluteTimeGetCurrent() - start;
+        
+        start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < signatureCount; i += batchSize) {
+            NSRange range = NSMakeRange(i, batchSize);
+            NSIndexSet *validIndexes = [self verifySignatures:[signatures subarrayWithRange:range]
+                                                   publicKeys:[pubKeys subarrayWithRange:range]
+                                                         data:[messages subarrayWithRange:range]];
+            if ([validIndexes count] != batchSize) {
+                @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Signature failed to verify" userInfo:nil];
+            }
+        }
+        CFAbsoluteTime batch = CFAbsoluteTimeGetCurrent() - start;
+        
+        results[@(batchSize)] = @{@"single" : @(signatureCount / single),
+                                  @"batch"  : @(signatureCount / batch)};
+    }
+    
+    return [results copy];
+}
+
+#endif
+
 @end
@@ -840,8 +840,346 @@ crecip(limb *out, const limb *z) {
   /* 2^255 - 21 */ fmul(out,t1,z11);
 }
 
+/* -----------------------------------------------------------------------------
+ * 64-bit backend
+ *
+ * On targets with a 64x64->128 bit multiply (x86-64, arm64) field elements are
+ * held as five unsigned 51-bit limbs instead of ten 25.5-bit ones, so a field
+ * multiplication is 25 wide multiplies rather than 100 narrow ones, and
+ * reduction needs a single carry chain.
+ *
+ * Define CURVE25519_DONNA_NO_64BIT to always use the portable code above.
+ * -------------------------------------------------------------------------- */
+
+#if defined(__SIZEOF_INT128__) && !defined(CURVE25519_DONNA_NO_64BIT)
+#define CURVE25519_DONNA_64BIT 1
+
+typedef unsigned __int128 uint128_t;
+
+/* Field element representation:
+ *
+ * Field elements are written as an array of unsigned, 64-bit limbs, least
+ * significant first. The value of the field element is:
+ *   x[0] + 2^51·x[1] + 2^102·x[2] + 2^153·x[3] + 2^204·x[4]
+ *
+ * "Reduced" limbs are < 2^51 + 2^13, which is what every function below
+ * returns, except fe64_sum and fe64_difference whose results are < 2^55. */
+typedef uint64_t felem[5];
+
+static const uint64_t kBottom51Bits = 0x7ffffffffffffULL;
+
+/* output = in + in2 */
+static inline void
+fe64_sum(felem output, const felem in, const felem in2) {
+  output[0] = in[0] + in2[0];
+  output[1] = in[1] + in2[1];
+  output[2] = in[2] + in2[2];
+  output[3] = in[3] + in2[3];
+  output[4] = in[4] + in2[4];
+}
+
+/* output = in - in2. 8p is added first so reduced inputs can't underflow. */
+static inline void
+fe64_difference(felem output, const felem in, const felem in2) {
+  static const uint64_t two54m152 = (((uint64_t)1) << 54) - 152;
+  static const uint64_t two54m8 = (((uint64_t)1) << 54) - 8;
+
+  output[0] = in[0] + two54m152 - in2[0];
+  output[1] = in[1] + two54m8 - in2[1];
+  output[2] = in[2] + two54m8 - in2[2];
+  output[3] = in[3] + two54m8 - in2[3];
+  output[4] = in[4] + two54m8 - in2[4];
+}
+
+/* Carry 128-bit column sums into reduced limbs. 2^255 = 19, so the carry out
+ * of the top limb is folded back into the bottom one. */
+static inline void
+fe64_carry(felem output, uint128_t t[5]) {
+  uint64_t r0, r1, r2, r3, r4, c;
+
+  r0 = (uint64_t)t[0] & kBottom51Bits; t[1] += (uint64_t)(t[0] >> 51);
+  r1 = (uint64_t)t[1] & kBottom51Bits; t[2] += (uint64_t)(t[1] >> 51);
+  r2 = (uint64_t)t[2] & kBottom51Bits; t[3] += (uint64_t)(t[2] >> 51);
+  r3 = (uint64_t)t[3] & kBottom51Bits; t[4] += (uint64_t)(t[3] >> 51);
+  r4 = (uint64_t)t[4] & kBottom51Bits; c = (uint64_t)(t[4] >> 51);
+
+  r0 += c * 19; c = r0 >> 51; r0 &= kBottom51Bits;
+  r1 += c;
+
+  output[0] = r0;
+  output[1] = r1;
+  output[2] = r2;
+  output[3] = r3;
+  output[4] = r4;
+}
+
+/* output = in * scalar, for scalar < 2^25 */
+static inline void
+fe64_scalar_product(felem output, const felem in, const uint64_t scalar) {
+  uint128_t t[5];
+
+  t[0] = ((uint128_t) in[0]) * scalar;
+  t[1] = ((uint128_t) in[1]) * scalar;
+  t[2] = ((uint128_t) in[2]) * scalar;
+  t[3] = ((uint128_t) in[3]) * scalar;
+  t[4] = ((uint128_t) in[4]) * scalar;
+  fe64_carry(output, t);
+}
+
+/* output = in * in2. Inputs may be unreduced (< 2^55). output may alias
+ * either input. */
+static inline void
+fe64_mul(felem output, const felem in, const felem in2) {
+  uint128_t t[5];
+  uint64_t r0, r1, r2, r3, r4, s0, s1, s2, s3, s4;
+
+  r0 = in[0]; r1 = in[1]; r2 = in[2]; r3 = in[3]; r4 = in[4];
+  s0 = in2[0]; s1 = in2[1]; s2 = in2[2]; s3 = in2[3]; s4 = in2[4];
+
+  t[0] = ((uint128_t) r0) * s0;
+  t[1] = ((uint128_t) r0) * s1 + ((uint128_t) r1) * s0;
+  t[2] = ((uint128_t) r0) * s2 + ((uint128_t) r2) * s0 + ((uint128_t) r1) * s1;
+  t[3] = ((uint128_t) r0) * s3 + ((uint128_t) r3) * s0 + ((uint128_t) r1) * s2 + ((uint128_t) r2) * s1;
+  t[4] = ((uint128_t) r0) * s4 + ((uint128_t) r4) * s0 + ((uint128_t) r3) * s1 + ((uint128_t) r1) * s3 + ((uint128_t) r2) * s2;
+
+  /* Limb products past 2^255 wrap around multiplied by 19. */
+  r1 *= 19; r2 *= 19; r3 *= 19; r4 *= 19;
+
+  t[0] += ((uint128_t) r4) * s1 + ((uint128_t) r1) * s4 + ((uint128_t) r2) * s3 + ((uint128_t) r3) * s2;
+  t[1] += ((uint128_t) r4) * s2 + ((uint128_t) r2) * s4 + ((uint128_t) r3) * s3;
+  t[2] += ((uint128_t) r4) * s3 + ((uint128_t) r3) * s4;
+  t[3] += ((uint128_t) r4) * s4;
+
+  fe64_carry(output, t);
+}
+
+/* output = in^(2^count), for count >= 1. output may alias in. */
+static inline void
+fe64_square_times(felem output, const felem in, unsigned count) {
+  uint128_t t[5];
+  uint64_t r0, r1, r2, r3, r4, d0, d1, d2, d4, d419;
+
+  r0 = in[0]; r1 = in[1]; r2 = in[2]; r3 = in[3]; r4 = in[4];
+
+  do {
+    d0 = r0 * 2;
+    d1 = r1 * 2;
+    d2 = r2 * 2 * 19;
+    d419 = r4 * 19;
+    d4 = d419 * 2;
+
+    t[0] = ((uint128_t) r0) * r0 + ((uint128_t) d4) * r1 + ((uint128_t) d2) * r3;
+    t[1] = ((uint128_t) d0) * r1 + ((uint128_t) d4) * r2 + ((uint128_t) r3) * (r3 * 19);
+    t[2] = ((uint128_t) d0) * r2 + ((uint128_t) r1) * r1 + ((uint128_t) d4) * r3;
+    t[3] = ((uint128_t) d0) * r3 + ((uint128_t) d1) * r2 + ((uint128_t) r4) * d419;
+    t[4] = ((uint128_t) d0) * r4 + ((uint128_t) d1) * r3 + ((uint128_t) r2) * r2;
+
+    fe64_carry(output, t);
+    r0 = output[0]; r1 = output[1]; r2 = output[2]; r3 = output[3]; r4 = output[4];
+  } while (--count);
+}
+
+static inline uint64_t
+load_limb(const u8 *in) {
+  return ((uint64_t)in[0]) |
+         (((uint64_t)in[1]) << 8) |
+         (((uint64_t)in[2]) << 16) |
+         (((uint64_t)in[3]) << 24) |
+         (((uint64_t)in[4]) << 32) |
+         (((uint64_t)in[5]) << 40) |
+         (((uint64_t)in[6]) << 48) |
+         (((uint64_t)in[7]) << 56);
+}
+
+static inline void
+store_limb(u8 *out, uint64_t in) {
+  unsigned i;
+  for (i = 0; i < 8; ++i) {
+    out[i] = (u8)(in >> (8 * i));
+  }
+}
+
+/* Take a little-endian, 32-byte number and expand it into reduced form. The
+ * top bit is ignored, as it is by fexpand. */
+static void
+fe64_expand(felem output, const u8 *in) {
+  output[0] = load_limb(in) & kBottom51Bits;
+  output[1] = (load_limb(in + 6) >> 3) & kBottom51Bits;
+  output[2] = (load_limb(in + 12) >> 6) & kBottom51Bits;
+  output[3] = (load_limb(in + 19) >> 1) & kBottom51Bits;
+  output[4] = (load_limb(in + 24) >> 12) & kBottom51Bits;
+}
+
+static inline void
+fe64_contract_carry(uint64_t t[5]) {
+  t[1] += t[0] >> 51; t[0] &= kBottom51Bits;
+  t[2] += t[1] >> 51; t[1] &= kBottom51Bits;
+  t[3] += t[2] >> 51; t[2] &= kBottom51Bits;
+  t[4] += t[3] >> 51; t[3] &= kBottom51Bits;
+  t[0] += 19 * (t[4] >> 51); t[4] &= kBottom51Bits;
+}
+
+/* Take a reduced field element and write out the unique little-endian,
+ * 32-byte representation of its value mod 2^255 - 19. */
+static void
+fe64_contract(u8 *output, const felem input) {
+  uint64_t t[5];
+
+  t[0] = input[0];
+  t[1] = input[1];
+  t[2] = input[2];
+  t[3] = input[3];
+  t[4] = input[4];
+
+  fe64_contract_carry(t);
+  fe64_contract_carry(t);
+
+  /* t is now between 0 and 2^255-1, fully carried. Adding 19 carries out of
+   * the top iff t >= p, in which case t - p is what's left. */
+  t[0] += 19;
+  fe64_contract_carry(t);
+
+  /* t is now offset by 19 (or 19 - p, which is the same thing). Add
+   * 2^255 - 19 to cancel the offset, and drop the 2^255 this introduces. */
+  t[0] += 0x8000000000000ULL - 19;
+  t[1] += 0x8000000000000ULL - 1;
+  t[2] += 0x8000000000000ULL - 1;
+  t[3] += 0x8000000000000ULL - 1;
+  t[4] += 0x8000000000000ULL - 1;
+
+  t[1] += t[0] >> 51; t[0] &= kBottom51Bits;
+  t[2] += t[1] >> 51; t[1] &= kBottom51Bits;
+  t[3] += t[2] >> 51; t[2] &= kBottom51Bits;
+  t[4] += t[3] >> 51; t[3] &= kBottom51Bits;
+  t[4] &= kBottom51Bits;
+
+  store_limb(output, t[0] | (t[1] << 51));
+  store_limb(output + 8, (t[1] >> 13) | (t[2] << 38));
+  store_limb(output + 16, (t[2] >> 26) | (t[3] << 25));
+  store_limb(output + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+/* Conditionally swap a and b if 'iswap' is 1, in data-invariant time. 'iswap'
+ * must be 1 or 0. */
+static inline void
+fe64_swap_conditional(felem a, felem b, uint64_t iswap) {
+  const uint64_t swap = 0 - iswap;
+  unsigned i;
+
+  for (i = 0; i < 5; ++i) {
+    const uint64_t x = swap & (a[i] ^ b[i]);
+    a[i] ^= x;
+    b[i] ^= x;
+  }
+}
+
+/* Calculates nQ where Q is the x-coordinate of a point on the curve, using
+ * the same Montgomery ladder as cmult.
+ *
+ *   resultx/resultz: the x coordinate of the resulting curve point
+ *   n: a little endian, 32-byte number
+ *   q: a point of the curve */
+static void
+fe64_cmult(felem resultx, felem resultz, const u8 *n, const felem q) {
+  felem x2 = {1}, z2 = {0}, x3, z3 = {1};
+  felem a, aa, b, bb, e, c, d, da, cb, t;
+  uint64_t swap = 0;
+  int i;
+
+  memcpy(x3, q, sizeof(felem));
+
+  for (i = 255; i >= 0; --i) {
+    const uint64_t bit = (n[i >> 3] >> (i & 7)) & 1;
+
+    swap ^= bit;
+    fe64_swap_conditional(x2, x3, swap);
+    fe64_swap_conditional(z2, z3, swap);
+    swap = bit;
+
+    fe64_sum(a, x2, z2);
+    fe64_square_times(aa, a, 1);
+    fe64_difference(b, x2, z2);
+    fe64_square_times(bb, b, 1);
+    fe64_difference(e, aa, bb);
+    fe64_sum(c, x3, z3);
+    fe64_difference(d, x3, z3);
+    fe64_mul(da, d, a);
+    fe64_mul(cb, c, b);
+
+    fe64_sum(t, da, cb);
+    fe64_square_times(x3, t, 1);
+    fe64_difference(t, da, cb);
+    fe64_square_times(t, t, 1);
+    fe64_mul(z3, t, q);
+
+    fe64_mul(x2, aa, bb);
+    fe64_scalar_product(t, e, 121665);
+    fe64_sum(t, t, aa);
+    fe64_mul(z2, e, t);
+  }
+
+  fe64_swap_conditional(x2, x3, swap);
+  fe64_swap_conditional(z2, z3, swap);
+
+  memcpy(resultx, x2, sizeof(felem));
+  memcpy(resultz, z2, sizeof(felem));
+}
+
+/* out = z^(p-2), using the same addition chain as crecip. */
+static void
+fe64_recip(felem out, const felem z) {
+  felem a, t0, b, c;
+
+  /* 2 */ fe64_square_times(a, z, 1);
+  /* 8 */ fe64_square_times(t0, a, 2);
+  /* 9 */ fe64_mul(b, t0, z);
+  /* 11 */ fe64_mul(a, b, a);
+  /* 22 */ fe64_square_times(t0, a, 1);
+  /* 2^5 - 2^0 = 31 */ fe64_mul(b, t0, b);
+  /* 2^10 - 2^5 */ fe64_square_times(t0, b, 5);
+  /* 2^10 - 2^0 */ fe64_mul(b, t0, b);
+  /* 2^20 - 2^10 */ fe64_square_times(t0, b, 10);
+  /* 2^20 - 2^0 */ fe64_mul(c, t0, b);
+  /* 2^40 - 2^20 */ fe64_square_times(t0, c, 20);
+  /* 2^40 - 2^0 */ fe64_mul(t0, t0, c);
+  /* 2^50 - 2^10 */ fe64_square_times(t0, t0, 10);
+  /* 2^50 - 2^0 */ fe64_mul(b, t0, b);
+  /* 2^100 - 2^50 */ fe64_square_times(t0, b, 50);
+  /* 2^100 - 2^0 */ fe64_mul(c, t0, b);
+  /* 2^200 - 2^100 */ fe64_square_times(t0, c, 100);
+  /* 2^200 - 2^0 */ fe64_mul(t0, t0, c);
+  /* 2^250 - 2^50 */ fe64_square_times(t0, t0, 50);
+  /* 2^250 - 2^0 */ fe64_mul(t0, t0, b);
+  /* 2^255 - 2^5 */ fe64_square_times(t0, t0, 5);
+  /* 2^255 - 21 */ fe64_mul(out, t0, a);
+}
+
 int
-curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
+curve25519_donna_64(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
+  felem bp, x, z, zmone;
+  uint8_t e[32];
+  int i;
+
+  for (i = 0; i < 32; ++i) e[i] = secret[i];
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+
+  fe64_expand(bp, basepoint);
+  fe64_cmult(x, z, e, bp);
+  fe64_recip(zmone, z);
+  fe64_mul(z, x, zmone);
+  fe64_contract(mypublic, z);
+  return 0;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/* The portable 32-bit backend. It's always compiled, so the 64-bit backend can
+ * be cross-checked against it; see +[Curve25519
+ * benchmarkScalarMultiplicationWithIterations:] in DEBUG builds. */
+int
+curve25519_donna_32(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
   limb bp[10], x[10], z[11], zmone[10];
   uint8_t e[32];
   int i;
@@ -858,3 +1196,12 @@ curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
   fcontract(mypublic, z);
   return 0;
 }
+
+int
+curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
+#ifdef CURVE25519_DONNA_64BIT
+  return curve25519_donna_64(mypublic, secret, basepoint);
+#else
+  return curve25519_donna_32(mypublic, secret, basepoint);
+#endif
+}
@@ -3,4 +3,7 @@
 
 extern int crypto_hash_sha512(unsigned char *,const unsigned char *,unsigned long long);
 
+/* Hashes count messages, storing the digests back to back, 64 bytes each. */
+extern int crypto_hash_sha512_many(unsigned char *outs,const unsigned char * const *ins,const unsigned long long *inlens,unsigned long count);
+
 #endif
@@ -1,8 +1,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include "ge.h"
+#include "sc.h"
 #include "curve_sigs.h"
 #include "crypto_sign.h"
+#include "crypto_hash_sha512.h"
 
 void curve25519_keygen(unsigned char* curve25519_pubkey_out,
                        const unsigned char* curve25519_privkey_in)
@@ -34,6 +36,67 @@ void curve25519_keygen(unsigned char* curve25519_pubkey_out,
   fe_tobytes(curve25519_pubkey_out, mont_x);
 }
 
+/* Keys converted per shared inversion; bounds the stack space used. */
+#define KEYGEN_BATCH_SIZE 32
+
+void curve25519_keygen_many(unsigned char* curve25519_pubkeys_out,
+                            const unsigned char* curve25519_privkeys_in,
+                            unsigned long count)
+{
+  ge_p3 ed;
+  fe ed_y_plus_one[KEYGEN_BATCH_SIZE];
+  fe one_minus_ed_y[KEYGEN_BATCH_SIZE];
+  fe partial_products[KEYGEN_BATCH_SIZE];
+  fe one, zero, inv, inv_one_minus_ed_y, mont_x;
+  unsigned long start, n, i;
+  unsigned int is_zero;
+
+  fe_1(one);
+  fe_0(zero);
+
+  for (start = 0; start < count; start += n) {
+    n = count - start;
+    if (n > KEYGEN_BATCH_SIZE)
+      n = KEYGEN_BATCH_SIZE;
+
+    /* Same conversion as curve25519_keygen, but keep the projective
+       numerator and denominator of each mont_x. */
+    for (i = 0; i < n; i++) {
+      ge_scalarmult_base(&ed, curve25519_privkeys_in + 32 * (start + i));
+      fe_add(ed_y_plus_one[i], ed.Y, ed.Z);
+      fe_sub(one_minus_ed_y[i], ed.Z, ed.Y);
+
+      /* A zero denominator would zero the shared inversion for the whole
+         batch. curve25519_keygen maps it to mont_x=0, so do the same by
+         dividing 0 by 1 instead. */
+      is_zero = fe_isnonzero(one_minus_ed_y[i]) == 0;
+      fe_cmov(ed_y_plus_one[i], zero, is_zero);
+      fe_cmov(one_minus_ed_y[i], one, is_zero);
+
+      /* partial_products[i] = one_minus_ed_y[0] * ... * one_minus_ed_y[i] */
+      if (i == 0)
+        fe_copy(partial_products[0], one_minus_ed_y[0]);
+      else
+        fe_mul(partial_products[i], partial_products[i - 1], one_minus_ed_y[i]);
+    }
+
+    /* Montgomery's trick: invert the product once, then peel off one
+       denominator at a time from the end. */
+    fe_invert(inv, partial_products[n - 1]);
+
+    for (i = n; i-- > 0;) {
+      if (i == 0) {
+        fe_copy(inv_one_minus_ed_y, inv);
+      } else {
+        fe_mul(inv_one_minus_ed_y, inv, partial_products[i - 1]);
+        fe_mul(inv, inv, one_minus_ed_y[i]);
+      }
+      fe_mul(mont_x, ed_y_plus_one[i], inv_one_minus_ed_y);
+      fe_tobytes(curve25519_pubkeys_out + 32 * (start + i), mont_x);
+    }
+  }
+}
+
 int curve25519_sign(unsigned char* signature_out,
                     const unsigned char* curve25519_privkey,
                     const unsigned char* msg, const unsigned long msg_len,
@@ -136,3 +199,195 @@ int curve25519_verify(const unsigned char* signature,
 
   return result;
 }
+
+/* Signatures combined per multi-scalar multiplication; bounds the scratch
+   space, which is about 3.5KB per signature. */
+#define VERIFY_BATCH_SIZE 64
+
+int curve25519_verify_batch(int* results,
+                            const unsigned char* signatures,
+                            const unsigned char* curve25519_pubkeys,
+                            const unsigned char* const* msgs,
+                            const unsigned long* msg_lens,
+                            unsigned long count,
+                            const unsigned char* random)
+{
+  fe mont_x, one, zero, inv, inv_mont_x_plus_one, ed_y, d;
+  fe mont_x_minus_one[VERIFY_BATCH_SIZE];
+  fe mont_x_plus_one[VERIFY_BATCH_SIZE];
+  fe partial_products[VERIFY_BATCH_SIZE];
+  unsigned long batched[VERIFY_BATCH_SIZE];
+  unsigned char batched_s[VERIFY_BATCH_SIZE][32];
+  unsigned char h[VERIFY_BATCH_SIZE * 64];
+  const unsigned char *hash_ins[VERIFY_BATCH_SIZE];
+  unsigned long long hash_inlens[VERIFY_BATCH_SIZE];
+  unsigned char ed_pubkey[32], rcheck[32], s[32], z[32], b[32];
+  unsigned char zero_scalar[32] = {0};
+  const unsigned char *signature;
+  ge_p3 *points = NULL; /* -A_i and -R_i for each batched signature */
+  unsigned char *scalars = NULL;
+  signed char *slides = NULL;
+  ge_cached *tables = NULL;
+  unsigned char *hashbuf = NULL;
+  unsigned char *hashbuf_next;
+  unsigned long hashbuf_len = 0, chunk_len = 0, start, n, i, j, num_batched;
+  unsigned int is_zero;
+  ge_p2 check;
+  int result = 0;
+
+  /* A single signature gains nothing from batching */
+  if (count == 1) {
+    results[0] = curve25519_verify(signatures, curve25519_pubkeys, msgs[0], msg_lens[0]);
+    return results[0];
+  }
+
+  /* Room for the R || A || M hash inputs of the largest batch */
+  for (i = 0; i < count; i++) {
+    if (i % VERIFY_BATCH_SIZE == 0)
+      chunk_len = 0;
+    chunk_len += 64 + msg_lens[i];
+    if (chunk_len > hashbuf_len)
+      hashbuf_len = chunk_len;
+  }
+
+  points = malloc(2 * VERIFY_BATCH_SIZE * sizeof(ge_p3));
+  scalars = malloc(2 * VERIFY_BATCH_SIZE * 32);
+  slides = malloc(2 * VERIFY_BATCH_SIZE * 256);
+  tables = malloc(2 * VERIFY_BATCH_SIZE * 8 * sizeof(ge_cached));
+  hashbuf = malloc(hashbuf_len);
+
+  if (points == NULL || scalars == NULL || slides == NULL || tables == NULL || hashbuf == NULL) {
+    for (i = 0; i < count; i++) {
+      results[i] = curve25519_verify(signatures + 64 * i, curve25519_pubkeys + 32 * i, msgs[i], msg_lens[i]);
+    }
+    goto done;
+  }
+
+  fe_1(one);
+  fe_0(zero);
+
+  for (start = 0; start < count; start += n) {
+    n = count - start;
+    if (n > VERIFY_BATCH_SIZE)
+      n = VERIFY_BATCH_SIZE;
+
+    /* Convert the Curve25519 public keys into Ed25519 public keys as in
+       curve25519_verify, sharing one inversion with Montgomery's trick.
+       mont_x=-1 is again converted to ed_y=0. */
+    for (i = 0; i < n; i++) {
+      fe_frombytes(mont_x, curve25519_pubkeys + 32 * (start + i));
+      fe_sub(mont_x_minus_one[i], mont_x, one);
+      fe_add(mont_x_plus_one[i], mont_x, one);
+
+      is_zero = fe_isnonzero(mont_x_plus_one[i]) == 0;
+      fe_cmov(mont_x_minus_one[i], zero, is_zero);
+      fe_cmov(mont_x_plus_one[i], one, is_zero);
+
+      if (i == 0)
+        fe_copy(partial_products[0], mont_x_plus_one[0]);
+      else
+        fe_mul(partial_products[i], partial_products[i - 1], mont_x_plus_one[i]);
+    }
+
+    fe_invert(inv, partial_products[n - 1]);
+
+    /* With S_i, h_i, R_i, A_i as in crypto_sign_open, and random z_i:
+       sum(z_i * S_i) * B + sum(z_i * h_i * -A_i) + sum(z_i * -R_i) = 0 */
+    memset(b, 0, 32);
+    num_batched = 0;
+    hashbuf_next = hashbuf;
+
+    for (i = n; i-- > 0;) {
+      if (i == 0) {
+        fe_copy(inv_mont_x_plus_one, inv);
+      } else {
+        fe_mul(inv_mont_x_plus_one, inv, partial_products[i - 1]);
+        fe_mul(inv, inv, mont_x_plus_one[i]);
+      }
+      fe_mul(ed_y, mont_x_minus_one[i], inv_mont_x_plus_one);
+      fe_tobytes(ed_pubkey, ed_y);
+
+      signature = signatures + 64 * (start + i);
+      ed_pubkey[31] &= 0x7F;
+      ed_pubkey[31] |= (signature[63] & 0x80);
+      memmove(s, signature + 32, 32);
+      s[31] &= 0x7F;
+
+      /* Anything crypto_sign_open rejects before hashing is simply invalid.
+         So is an R which doesn't decode, since it can't match rcheck. */
+      results[start + i] = -1;
+      if (s[31] & 224) continue;
+      if (ge_frombytes_negate_vartime(&points[2 * num_batched], ed_pubkey) != 0) continue;
+      if (ge_frombytes_negate_vartime(&points[2 * num_batched + 1], signature) != 0) continue;
+
+      /* crypto_sign_open compares encodings, so a non-canonical R (which
+         decodes to the same point as the canonical one) has to be checked
+         on its own. */
+      ge_p3_tobytes(rcheck, &points[2 * num_batched + 1]);
+      rcheck[31] ^= 0x80;
+      if (memcmp(rcheck, signature, 32) != 0) {
+        results[start + i] = curve25519_verify(signature, curve25519_pubkeys + 32 * (start + i),
+                                               msgs[start + i], msg_lens[start + i]);
+        continue;
+      }
+
+      memmove(hashbuf_next, signature, 32);
+      memmove(hashbuf_next + 32, ed_pubkey, 32);
+      memmove(hashbuf_next + 64, msgs[start + i], msg_lens[start + i]);
+      hash_ins[num_batched] = hashbuf_next;
+      hash_inlens[num_batched] = 64 + msg_lens[start + i];
+      hashbuf_next += 64 + msg_lens[start + i];
+
+      memmove(batched_s[num_batched], s, 32);
+      batched[num_batched++] = start + i;
+    }
+
+    if (num_batched == 0)
+      continue;
+
+    /* All of the batch's h_i at once */
+    crypto_hash_sha512_many(h, hash_ins, hash_inlens, num_batched);
+
+    for (j = 0; j < num_batched; j++) {
+      sc_reduce(h + 64 * j);
+
+      memset(z, 0, 32);
+      memmove(z, random + 16 * batched[j], 16);
+
+      sc_muladd(scalars + 32 * (2 * j), z, h + 64 * j, zero_scalar);
+      memmove(scalars + 32 * (2 * j + 1), z, 32);
+      sc_muladd(b, z, batched_s[j], b);
+    }
+
+    ge_multi_scalarmult_vartime(&check, b, scalars, points, (int)(2 * num_batched), slides, tables);
+
+    /* The identity is (0:Z:Z) */
+    fe_sub(d, check.Y, check.Z);
+    if (fe_isnonzero(check.X) == 0 && fe_isnonzero(d) == 0) {
+      for (j = 0; j < num_batched; j++)
+        results[batched[j]] = 0;
+    } else {
+      /* At least one of them is bad; find out which. */
+      for (j = 0; j < num_batched; j++) {
+        results[batched[j]] = curve25519_verify(signatures + 64 * batched[j],
+                                                curve25519_pubkeys + 32 * batched[j],
+                                                msgs[batched[j]], msg_lens[batched[j]]);
+      }
+    }
+  }
+
+  done:
+
+  for (i = 0; i < count; i++) {
+    if (results[i] != 0)
+      result = -1;
+  }
+
+  free(points);
+  free(scalars);
+  free(slides);
+  free(tables);
+  free(hashbuf);
+
+  return result;
+}
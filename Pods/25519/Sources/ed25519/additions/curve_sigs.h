@@ -5,6 +5,13 @@
 void curve25519_keygen(unsigned char* curve25519_pubkey_out, /* 32 bytes */
                        const unsigned char* curve25519_privkey_in); /* 32 bytes */
 
+/* curve25519_keygen for count keys at once. The keys are stored back to back,
+   32 bytes each. Every key needs its own fixed-base multiplication, but the
+   field inversions of the Edwards to Montgomery conversion are shared. */
+void curve25519_keygen_many(unsigned char* curve25519_pubkeys_out, /* 32 * count bytes */
+                            const unsigned char* curve25519_privkeys_in, /* 32 * count bytes */
+                            unsigned long count);
+
 /* returns 0 on success */
 int curve25519_sign(unsigned char* signature_out, /* 64 bytes */
                      const unsigned char* curve25519_privkey, /* 32 bytes */
@@ -16,6 +23,29 @@ int curve25519_verify(const unsigned char* signature, /* 64 bytes */
                       const unsigned char* curve25519_pubkey, /* 32 bytes */
                       const unsigned char* msg, const unsigned long msg_len);
 
+/* Verifies count signatures at once, returning 0 if all of them are valid.
+   results[i] is set to what curve25519_verify would return for signature i.
+
+   signatures are 64 bytes each and pubkeys 32 bytes each, back to back.
+   random must be 16 * count fresh random bytes.
+
+   The signatures are checked together with one random linear combination,
+   and only checked one by one if that fails. Signatures which can't be
+   combined (e.g. whose R isn't a canonical point encoding) are always
+   checked one by one.
+
+   NOTE: like other non-cofactored batch verifiers this can accept a
+   signature which curve25519_verify rejects, if it differs from a valid
+   signature only by a small order component. Only the holder of the
+   private key can produce such a signature. */
+int curve25519_verify_batch(int* results, /* count ints */
+                            const unsigned char* signatures, /* 64 * count bytes */
+                            const unsigned char* curve25519_pubkeys, /* 32 * count bytes */
+                            const unsigned char* const* msgs,
+                            const unsigned long* msg_lens,
+                            unsigned long count,
+                            const unsigned char* random); /* 16 * count bytes */
+
 /* helper function - modified version of crypto_sign() to use 
    explicit private key.  In particular:
 
@@ -70,6 +70,7 @@ typedef struct {
 #define ge_sub crypto_sign_ed25519_ref10_ge_sub
 #define ge_scalarmult_base crypto_sign_ed25519_ref10_ge_scalarmult_base
 #define ge_double_scalarmult_vartime crypto_sign_ed25519_ref10_ge_double_scalarmult_vartime
+#define ge_multi_scalarmult_vartime crypto_sign_ed25519_ref10_ge_multi_scalarmult_vartime
 
 extern void ge_tobytes(unsigned char *,const ge_p2 *);
 extern void ge_p3_tobytes(unsigned char *,const ge_p3 *);
@@ -91,5 +92,6 @@ extern void ge_add(ge_p1p1 *,const ge_p3 *,const ge_cached *);
 extern void ge_sub(ge_p1p1 *,const ge_p3 *,const ge_cached *);
 extern void ge_scalarmult_base(ge_p3 *,const unsigned char *);
 extern void ge_double_scalarmult_vartime(ge_p2 *,const unsigned char *,const ge_p3 *,const unsigned char *);
+extern void ge_multi_scalarmult_vartime(ge_p2 *,const unsigned char *,const unsigned char *,const ge_p3 *,int,signed char *,ge_cached *);
 
 #endif
@@ -94,3 +94,72 @@ void ge_double_scalarmult_vartime(ge_p2 *r,const unsigned char *a,const ge_p3 *A
     ge_p1p1_to_p2(r,&t);
   }
 }
+
+/*
+r = b * B + a_0 * A_0 + ... + a_{n-1} * A_{n-1}
+where the a_j are stored back to back in a, 32 bytes each, encoded as above.
+
+Straus' method: every point gets its own table of odd multiples, but the
+doublings are shared by all of them.
+aslide is scratch space for 256 * n entries, and Ai for 8 * n.
+*/
+
+void ge_multi_scalarmult_vartime(ge_p2 *r,const unsigned char *b,
+                                 const unsigned char *a,const ge_p3 *A,int n,
+                                 signed char *aslide,ge_cached *Ai)
+{
+  signed char bslide[256];
+  ge_p1p1 t;
+  ge_p3 u;
+  ge_p3 A2;
+  int i;
+  int j;
+  int k;
+  signed char d;
+
+  slide(bslide,b);
+
+  for (j = 0;j < n;++j) {
+    slide(aslide + 256 * j,a + 32 * j);
+
+    ge_p3_to_cached(&Ai[8 * j],&A[j]);
+    ge_p3_dbl(&t,&A[j]); ge_p1p1_to_p3(&A2,&t);
+    for (k = 1;k < 8;++k) {
+      ge_add(&t,&A2,&Ai[8 * j + k - 1]); ge_p1p1_to_p3(&u,&t); ge_p3_to_cached(&Ai[8 * j + k],&u);
+    }
+  }
+
+  ge_p2_0(r);
+
+  for (i = 255;i >= 0;--i) {
+    if (bslide[i]) break;
+    for (j = 0;j < n;++j)
+      if (aslide[256 * j + i]) break;
+    if (j < n) break;
+  }
+
+  for (;i >= 0;--i) {
+    ge_p2_dbl(&t,r);
+
+    for (j = 0;j < n;++j) {
+      d = aslide[256 * j + i];
+      if (d > 0) {
+        ge_p1p1_to_p3(&u,&t);
+        ge_add(&t,&u,&Ai[8 * j + d/2]);
+      } else if (d < 0) {
+        ge_p1p1_to_p3(&u,&t);
+        ge_sub(&t,&u,&Ai[8 * j + (-d)/2]);
+      }
+    }
+
+    if (bslide[i] > 0) {
+      ge_p1p1_to_p3(&u,&t);
+      ge_madd(&t,&u,&Bi[bslide[i]/2]);
+    } else if (bslide[i] < 0) {
+      ge_p1p1_to_p3(&u,&t);
+      ge_msub(&t,&u,&Bi[(-bslide[i])/2]);
+    }
+
+    ge_p1p1_to_p2(r,&t);
+  }
+}
@@ -69,3 +69,13 @@ int crypto_hash_sha512(unsigned char *out,const unsigned char *in,unsigned long
 
   return 0;
 }
+
+int crypto_hash_sha512_many(unsigned char *outs,const unsigned char * const *ins,const unsigned long long *inlens,unsigned long count)
+{
+  unsigned long i;
+
+  for (i = 0;i < count;++i)
+    crypto_hash_sha512(outs + 64 * i,ins[i],inlens[i]);
+
+  return 0;
+}
@@ -18,6 +18,11 @@
 
 -(MessageKeys*)messageKeys;
 
+// Walks the chain forward to `index`, calling the block with the message keys of each index it passes
+// (this one included, `index` excluded), and returns the chain key at `index`. The same as stepping with
+// -messageKeys and -nextChainKey, but without allocating anything per step other than the message keys.
+-(instancetype)chainKeyAtIndex:(int)index skippedMessageKeys:(void (^)(MessageKeys *messageKeys))block;
+
 -(NSData*)baseMaterial:(NSData*)seed;
 
 @property (readonly) int index;
@@ -17,6 +17,121 @@ static NSString* const kCoderIndex   = @"kCoderIndex";
 static uint8_t kMessageKeySeed[kTSKeySeedLength]    = {01};
 static uint8_t kChainKeySeed[kTSKeySeedLength]      = {02};
 
+// TSDerivedSecrets derivedMessageKeysWithData: expands to 96 bytes: cipher key, mac key, iv (and padding).
+#define kMessageKeysInfo            "WhisperMessageKeys"
+#define kMessageKeysInfoLength      (sizeof(kMessageKeysInfo) - 1)
+#define kMessageKeysCipherKeyLength 32
+#define kMessageKeysMacKeyLength    32
+#define kMessageKeysIVLength        16
+#define kMessageKeysMaterialLength  (kMessageKeysCipherKeyLength + kMessageKeysMacKeyLength + kMessageKeysIVLength)
+
+#pragma mark - Derivation
+
+// HMAC-SHA256 with the padded key already absorbed into the inner and outer hash states, so that several
+// MACs under one key only pay for the key schedule once.
+typedef struct {
+    CC_SHA256_CTX inner;
+    CC_SHA256_CTX outer;
+} ChainKeyHMACKey;
+
+static void ChainKeyHMACKeyInit(ChainKeyHMACKey *hmacKey, const uint8_t *key, size_t keyLength)
+{
+    SPKAssert(keyLength <= CC_SHA256_BLOCK_BYTES);
+
+    uint8_t pad[CC_SHA256_BLOCK_BYTES];
+
+    memset(pad, 0x36, sizeof(pad));
+    for (size_t i = 0; i < keyLength; i++) {
+        pad[i] ^= key[i];
+    }
+    CC_SHA256_Init(&hmacKey->inner);
+    CC_SHA256_Update(&hmacKey->inner, pad, sizeof(pad));
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (size_t i = 0; i < keyLength; i++) {
+        pad[i] ^= key[i];
+    }
+    CC_SHA256_Init(&hmacKey->outer);
+    CC_SHA256_Update(&hmacKey->outer, pad, sizeof(pad));
+}
+
+static void ChainKeyHMAC(const ChainKeyHMACKey *hmacKey, const uint8_t *data, size_t dataLength, uint8_t mac[CC_SHA256_DIGEST_LENGTH])
+{
+    CC_SHA256_CTX ctx = hmacKey->inner;
+    CC_SHA256_Update(&ctx, data, (CC_LONG)dataLength);
+    CC_SHA256_Final(mac, &ctx);
+
+    ctx = hmacKey->outer;
+    CC_SHA256_Update(&ctx, mac, CC_SHA256_DIGEST_LENGTH);
+    CC_SHA256_Final(mac, &ctx);
+}
+
+// HKDF extract uses the default salt (all zeros) for message keys, so its key schedule never changes.
+static const ChainKeyHMACKey *ChainKeyMessageKeysSalt(void)
+{
+    static ChainKeyHMACKey salt;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        uint8_t zeros[CC_SHA256_DIGEST_LENGTH] = {0};
+        ChainKeyHMACKeyInit(&salt, zeros, sizeof(zeros));
+    });
+    return &salt;
+}
+
+/**
+ * One step of the chain, entirely on the stack: the message key material for chainKey (unless
+ * messageKeyMaterial is NULL), and the next chain key. nextChainKey may be the same buffer as chainKey.
+ *
+ * Equivalent to -messageKeys and -nextChainKey: the seeds are HMAC'd with the chain key, and the message
+ * key seed is run through HKDF (RFC 5869, counter from 1) with the "WhisperMessageKeys" info.
+ */
+static void ChainKeyDeriveStep(const uint8_t chainKey[ECCKeyLength],
+    uint8_t *messageKeyMaterial,
+    uint8_t nextChainKey[ECCKeyLength])
+{
+    ChainKeyHMACKey chainHMACKey;
+    ChainKeyHMACKeyInit(&chainHMACKey, chainKey, ECCKeyLength);
+
+    if (messageKeyMaterial) {
+        uint8_t inputKeyMaterial[CC_SHA256_DIGEST_LENGTH];
+        ChainKeyHMAC(&chainHMACKey, kMessageKeySeed, kTSKeySeedLength, inputKeyMaterial);
+
+        uint8_t pseudoRandomKey[CC_SHA256_DIGEST_LENGTH];
+        ChainKeyHMAC(ChainKeyMessageKeysSalt(), inputKeyMaterial, sizeof(inputKeyMaterial), pseudoRandomKey);
+
+        ChainKeyHMACKey expandKey;
+        ChainKeyHMACKeyInit(&expandKey, pseudoRandomKey, sizeof(pseudoRandomKey));
+
+        // T(n) = HMAC(PRK, T(n-1) | info | n)
+        uint8_t block[CC_SHA256_DIGEST_LENGTH + kMessageKeysInfoLength + 1];
+        uint8_t output[CC_SHA256_DIGEST_LENGTH];
+        size_t previousLength = 0;
+        for (size_t offset = 0, n = 1; offset < kMessageKeysMaterialLength; offset += CC_SHA256_DIGEST_LENGTH, n++) {
+            memcpy(block + previousLength, kMessageKeysInfo, kMessageKeysInfoLength);
+            block[previousLength + kMessageKeysInfoLength] = (uint8_t)n;
+            ChainKeyHMAC(&expandKey, block, previousLength + kMessageKeysInfoLength + 1, output);
+
+            memcpy(messageKeyMaterial + offset, output, MIN(sizeof(output), kMessageKeysMaterialLength - offset));
+            memcpy(block, output, sizeof(output));
+            previousLength = sizeof(output);
+        }
+    }
+
+    uint8_t result[CC_SHA256_DIGEST_LENGTH];
+    ChainKeyHMAC(&chainHMACKey, kChainKeySeed, kTSKeySeedLength, result);
+    memcpy(nextChainKey, result, ECCKeyLength);
+}
+
+static MessageKeys *ChainKeyMessageKeysWithMaterial(const uint8_t *material, int index)
+{
+    return [[MessageKeys alloc]
+        initWithCipherKey:[NSData dataWithBytes:material length:kMessageKeysCipherKeyLength]
+                   macKey:[NSData dataWithBytes:material + kMessageKeysCipherKeyLength length:kMessageKeysMacKeyLength]
+                       iv:[NSData dataWithBytes:material + kMessageKeysCipherKeyLength + kMessageKeysMacKeyLength
+                                         length:kMessageKeysIVLength]
+                    index:index];
+}
+
 + (BOOL)supportsSecureCoding{
     return YES;
 }
@@ -62,6 +177,24 @@ static uint8_t kChainKeySeed[kTSKeySeedLength]      = {02};
     return [[MessageKeys alloc] initWithCipherKey:derivedSecrets.cipherKey macKey:derivedSecrets.macKey iv:derivedSecrets.iv index:self.index];
 }
 
+- (instancetype)chainKeyAtIndex:(int)index skippedMessageKeys:(void (^)(MessageKeys *messageKeys))block{
+    SPKAssert(index >= self.index);
+    SPKAssert(self.key.length == ECCKeyLength);
+
+    uint8_t chainKey[ECCKeyLength];
+    [self.key getBytes:chainKey length:sizeof(chainKey)];
+
+    uint8_t messageKeyMaterial[kMessageKeysMaterialLength];
+    for (int stepIndex = self.index; stepIndex < index; stepIndex++) {
+        ChainKeyDeriveStep(chainKey, block ? messageKeyMaterial : NULL, chainKey);
+        if (block) {
+            block(ChainKeyMessageKeysWithMaterial(messageKeyMaterial, stepIndex));
+        }
+    }
+
+    return [[ChainKey alloc] initWithData:[NSData dataWithBytes:chainKey length:sizeof(chainKey)] index:index];
+}
+
 - (NSData*)baseMaterial:(NSData*)seed{
     uint8_t result[CC_SHA256_DIGEST_LENGTH] = {0};
     CCHmacContext ctx;
@@ -10,11 +10,23 @@
 #import "Chain.h"
 #import <25519/Curve25519.h>
 
+@class MessageKeys;
+
+// The most skipped message keys a receiving chain keeps. Beyond this, the oldest are dropped.
+extern const NSUInteger kReceivingChainMaxMessageKeys;
+
 @interface ReceivingChain : NSObject <Chain, NSSecureCoding>
 
 - (instancetype)initWithChainKey:(ChainKey*)chainKey senderRatchetKey:(NSData*)senderRatchet;
 
-@property NSMutableArray *messageKeysList;
 @property NSData *senderRatchetKey;
 
+// Skipped message keys, for messages which arrive out of order, indexed by counter.
+- (BOOL)hasMessageKeysForIndex:(int)index;
+- (MessageKeys*)removeMessageKeysForIndex:(int)index;
+- (void)addMessageKeys:(MessageKeys*)messageKeys;
+
+// The skipped message keys, ordered by index.
+@property (readonly) NSArray<MessageKeys*> *messageKeysList;
+
 @end
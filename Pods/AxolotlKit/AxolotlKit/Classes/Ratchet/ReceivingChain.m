@@ -7,18 +7,33 @@
 //
 
 #import "ReceivingChain.h"
+#import "MessageKeys.h"
+
+const NSUInteger kReceivingChainMaxMessageKeys = 2000;
+
+// Skipped message keys are encoded as one blob of fixed size records, rather than an archived
+// array of MessageKeys: index (int32, little endian), cipher key, mac key, iv.
+#define kMessageKeysCipherKeyLength 32
+#define kMessageKeysMacKeyLength    32
+#define kMessageKeysIVLength        16
+#define kMessageKeysRecordLength    (sizeof(int32_t) + kMessageKeysCipherKeyLength + kMessageKeysMacKeyLength + kMessageKeysIVLength)
 
 @interface ReceivingChain ()
 
 @property (nonatomic)ChainKey *chainKey;
 
+// MessageKeys by index, and the indexes present, so that the oldest can be found for eviction.
+@property (nonatomic, readonly) NSMutableDictionary<NSNumber*, MessageKeys*> *messageKeysByIndex;
+@property (nonatomic, readonly) NSMutableIndexSet *messageKeysIndexes;
+
 @end
 
 @implementation ReceivingChain
 
-static NSString* const kCoderChainKey      = @"kCoderChainKey";
-static NSString* const kCoderSenderRatchet = @"kCoderSenderRatchet";
-static NSString* const kCoderMessageKeys   = @"kCoderMessageKeys";
+static NSString* const kCoderChainKey        = @"kCoderChainKey";
+static NSString* const kCoderSenderRatchet   = @"kCoderSenderRatchet";
+static NSString* const kCoderMessageKeys     = @"kCoderMessageKeys";
+static NSString* const kCoderMessageKeysData = @"kCoderMessageKeysData";
 
 + (BOOL)supportsSecureCoding{
     return YES;
@@ -28,16 +43,74 @@ static NSString* const kCoderMessageKeys   = @"kCoderMessageKeys";
     self = [self initWithChainKey:[aDecoder decodeObjectOfClass:[NSData class] forKey:kCoderChainKey]
                  senderRatchetKey:[aDecoder decodeObjectOfClass:[NSData class] forKey:kCoderSenderRatchet]];
     if (self) {
-        self.messageKeysList = [aDecoder decodeObjectOfClass:[NSMutableArray class] forKey:kCoderMessageKeys];
+        if ([aDecoder containsValueForKey:kCoderMessageKeysData]) {
+            [self decodeMessageKeysData:[aDecoder decodeObjectOfClass:[NSData class] forKey:kCoderMessageKeysData]];
+        }
+
+        // Chains archived before the compact encoding, or which had keys it can't represent.
+        NSArray *messageKeysList = [aDecoder decodeObjectOfClass:[NSMutableArray class] forKey:kCoderMessageKeys];
+        for (MessageKeys *messageKeys in messageKeysList) {
+            [self addMessageKeys:messageKeys];
+        }
     }
 
     return self;
 }
 
+// Builds before the compact encoding only read kCoderMessageKeys, so after a downgrade they see no skipped keys (and
+// a nil list, which drops any they skip later) for chains written here; those late messages can't be decrypted.
 - (void)encodeWithCoder:(NSCoder *)aCoder{
     [aCoder encodeObject:self.chainKey forKey:kCoderChainKey];
     [aCoder encodeObject:self.senderRatchetKey forKey:kCoderSenderRatchet];
-    [aCoder encodeObject:self.messageKeysList forKey:kCoderMessageKeys];
+
+    NSMutableData *messageKeysData = [NSMutableData dataWithCapacity:self.messageKeysByIndex.count * kMessageKeysRecordLength];
+    NSMutableArray<MessageKeys*> *otherMessageKeys = [NSMutableArray array];
+    for (MessageKeys *messageKeys in self.messageKeysList) {
+        if (messageKeys.cipherKey.length != kMessageKeysCipherKeyLength ||
+            messageKeys.macKey.length != kMessageKeysMacKeyLength ||
+            messageKeys.iv.length != kMessageKeysIVLength) {
+            [otherMessageKeys addObject:messageKeys];
+            continue;
+        }
+
+        int32_t index = (int32_t)CFSwapInt32HostToLittle((uint32_t)messageKeys.index);
+        [messageKeysData appendBytes:&index length:sizeof(index)];
+        [messageKeysData appendData:messageKeys.cipherKey];
+        [messageKeysData appendData:messageKeys.macKey];
+        [messageKeysData appendData:messageKeys.iv];
+    }
+
+    [aCoder encodeObject:messageKeysData forKey:kCoderMessageKeysData];
+    if (otherMessageKeys.count > 0) {
+        [aCoder encodeObject:otherMessageKeys forKey:kCoderMessageKeys];
+    }
+}
+
+- (void)decodeMessageKeysData:(NSData *)messageKeysData{
+    if (messageKeysData.length % kMessageKeysRecordLength != 0) {
+        DDLogError(@"%@ Ignoring malformed message keys of length: %lu", self.tag, (unsigned long)messageKeysData.length);
+        return;
+    }
+
+    const uint8_t *bytes = messageKeysData.bytes;
+    for (NSUInteger offset = 0; offset < messageKeysData.length; offset += kMessageKeysRecordLength) {
+        const uint8_t *record = bytes + offset;
+
+        uint32_t index;
+        memcpy(&index, record, sizeof(index));
+        record += sizeof(index);
+
+        NSData *cipherKey = [NSData dataWithBytes:record length:kMessageKeysCipherKeyLength];
+        record += kMessageKeysCipherKeyLength;
+        NSData *macKey = [NSData dataWithBytes:record length:kMessageKeysMacKeyLength];
+        record += kMessageKeysMacKeyLength;
+        NSData *iv = [NSData dataWithBytes:record length:kMessageKeysIVLength];
+
+        [self addMessageKeys:[[MessageKeys alloc] initWithCipherKey:cipherKey
+                                                             macKey:macKey
+                                                                 iv:iv
+                                                              index:(int)CFSwapInt32LittleToHost(index)]];
+    }
 }
 
 - (instancetype)initWithChainKey:(ChainKey *)chainKey senderRatchetKey:(NSData *)senderRatchet{
@@ -45,9 +118,65 @@ static NSString* const kCoderMessageKeys   = @"kCoderMessageKeys";
 
     self.chainKey         = chainKey;
     self.senderRatchetKey = senderRatchet;
-    self.messageKeysList  = [NSMutableArray array];
+    _messageKeysByIndex   = [NSMutableDictionary dictionary];
+    _messageKeysIndexes   = [NSMutableIndexSet indexSet];
 
     return self;
 }
 
+#pragma mark - Message keys
+
+- (BOOL)hasMessageKeysForIndex:(int)index{
+    return index >= 0 && [self.messageKeysIndexes containsIndex:(NSUInteger)index];
+}
+
+- (MessageKeys*)removeMessageKeysForIndex:(int)index{
+    if (![self hasMessageKeysForIndex:index]) {
+        return nil;
+    }
+
+    MessageKeys *result = self.messageKeysByIndex[@(index)];
+    [self.messageKeysByIndex removeObjectForKey:@(index)];
+    [self.messageKeysIndexes removeIndex:(NSUInteger)index];
+
+    return result;
+}
+
+- (void)addMessageKeys:(MessageKeys*)messageKeys{
+    if (messageKeys.index < 0) {
+        DDLogError(@"%@ Ignoring message keys with invalid index: %d", self.tag, messageKeys.index);
+        return;
+    }
+
+    self.messageKeysByIndex[@(messageKeys.index)] = messageKeys;
+    [self.messageKeysIndexes addIndex:(NSUInteger)messageKeys.index];
+
+    // Counters only go up, so the lowest index is the oldest key.
+    while (self.messageKeysIndexes.count > kReceivingChainMaxMessageKeys) {
+        NSUInteger oldestIndex = self.messageKeysIndexes.firstIndex;
+        [self.messageKeysByIndex removeObjectForKey:@(oldestIndex)];
+        [self.messageKeysIndexes removeIndex:oldestIndex];
+    }
+}
+
+- (NSArray<MessageKeys*> *)messageKeysList{
+    NSMutableArray<MessageKeys*> *messageKeysList = [NSMutableArray arrayWithCapacity:self.messageKeysIndexes.count];
+    [self.messageKeysIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [messageKeysList addObject:self.messageKeysByIndex[@(index)]];
+    }];
+    return messageKeysList;
+}
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
 @end
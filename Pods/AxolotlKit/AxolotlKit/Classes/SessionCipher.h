@@ -40,4 +40,20 @@
 - (int)remoteRegistrationId;
 - (int)sessionVersion;
 
+#ifdef DEBUG
+
+/**
+ * Sets up a session between two in-memory stores, then has one side decrypt messageCount messages in the order they
+ * were sent, and another messageCount in a random order, so every message but the last is first skipped. Stores
+ * archive the session record on every store and unarchive it on every load, like the database-backed store. Logs the
+ * throughput of each.
+ *
+ * Must be called on the session cipher dispatch queue.
+ *
+ * @param messageCount    number of messages to decrypt in each order; at most kReceivingChainMaxMessageKeys.
+ */
++ (void)logOutOfOrderDecryptBenchmarkWithMessageCount:(int)messageCount;
+
+#endif
+
 @end
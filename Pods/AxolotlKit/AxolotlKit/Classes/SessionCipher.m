@@ -14,6 +14,7 @@
 #import "AES-CBC.h"
 #import "AxolotlParameters.h"
 #import "MessageKeys.h"
+#import "ReceivingChain.h"
 #import "SessionState.h"
 #import "ChainKey.h"
 #import "RootKey.h"
@@ -21,6 +22,9 @@
 
 #import "SignedPreKeyStore.h"
 #import "PreKeyStore.h"
+#import "PreKeyBundle.h"
+#import "PreKeyRecord.h"
+#import "SignedPrekeyRecord.h"
 
 #import <HKDFKit/HKDFKit.h>
 
@@ -41,6 +45,126 @@ static dispatch_queue_t _sessionCipherDispatchQueue;
 
 @end
 
+#ifdef DEBUG
+
+// An in-memory store for +logOutOfOrderDecryptBenchmarkWithMessageCount:. Like the database-backed store, it archives
+// session records when they're stored and hands out a fresh copy on every load.
+@interface SPKBenchmarkAxolotlStore : NSObject <AxolotlStore>
+
+@property (nonatomic, readonly) ECKeyPair *identityKeyPair;
+@property (nonatomic, readonly) int localRegistrationId;
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, NSData *> *sessions;
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, NSData *> *identityKeys;
+@property (nonatomic, readonly) NSMutableDictionary<NSNumber *, PreKeyRecord *> *preKeys;
+@property (nonatomic, readonly) NSMutableDictionary<NSNumber *, SignedPreKeyRecord *> *signedPreKeys;
+
+@end
+
+@implementation SPKBenchmarkAxolotlStore
+
+- (instancetype)initWithRegistrationId:(int)registrationId{
+    self = [super init];
+    if (self) {
+        _identityKeyPair     = [Curve25519 generateKeyPair];
+        _localRegistrationId = registrationId;
+        _sessions            = [NSMutableDictionary new];
+        _identityKeys        = [NSMutableDictionary new];
+        _preKeys             = [NSMutableDictionary new];
+        _signedPreKeys       = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (NSString *)sessionKeyForContact:(NSString *)contactIdentifier deviceId:(int)deviceId{
+    return [NSString stringWithFormat:@"%@.%d", contactIdentifier, deviceId];
+}
+
+- (SessionRecord *)loadSession:(NSString *)contactIdentifier deviceId:(int)deviceId{
+    NSData *data = self.sessions[[self sessionKeyForContact:contactIdentifier deviceId:deviceId]];
+    return data ? [NSKeyedUnarchiver unarchiveObjectWithData:data] : [SessionRecord new];
+}
+
+- (NSArray *)subDevicesSessions:(NSString *)contactIdentifier{
+    return @[];
+}
+
+- (void)storeSession:(NSString *)contactIdentifier deviceId:(int)deviceId session:(SessionRecord *)session{
+    self.sessions[[self sessionKeyForContact:contactIdentifier deviceId:deviceId]] =
+        [NSKeyedArchiver archivedDataWithRootObject:session];
+}
+
+- (BOOL)containsSession:(NSString *)contactIdentifier deviceId:(int)deviceId{
+    return self.sessions[[self sessionKeyForContact:contactIdentifier deviceId:deviceId]] != nil;
+}
+
+- (void)deleteSessionForContact:(NSString *)contactIdentifier deviceId:(int)deviceId{
+    [self.sessions removeObjectForKey:[self sessionKeyForContact:contactIdentifier deviceId:deviceId]];
+}
+
+- (void)deleteAllSessionsForContact:(NSString *)contactIdentifier{
+    NSString *prefix = [contactIdentifier stringByAppendingString:@"."];
+    for (NSString *key in self.sessions.allKeys) {
+        if ([key hasPrefix:prefix]) {
+            [self.sessions removeObjectForKey:key];
+        }
+    }
+}
+
+- (BOOL)saveRemoteIdentity:(NSData *)identityKey recipientId:(NSString *)recipientId{
+    NSData *existingKey = self.identityKeys[recipientId];
+    self.identityKeys[recipientId] = identityKey;
+    return existingKey != nil && ![existingKey isEqualToData:identityKey];
+}
+
+- (BOOL)isTrustedIdentityKey:(NSData *)identityKey recipientId:(NSString *)recipientId direction:(TSMessageDirection)direction{
+    NSData *existingKey = self.identityKeys[recipientId];
+    return existingKey == nil || [existingKey isEqualToData:identityKey];
+}
+
+- (PreKeyRecord *)loadPreKey:(int)preKeyId{
+    return self.preKeys[@(preKeyId)];
+}
+
+- (void)storePreKey:(int)preKeyId preKeyRecord:(PreKeyRecord *)record{
+    self.preKeys[@(preKeyId)] = record;
+}
+
+- (BOOL)containsPreKey:(int)preKeyId{
+    return self.preKeys[@(preKeyId)] != nil;
+}
+
+- (void)removePreKey:(int)preKeyId{
+    [self.preKeys removeObjectForKey:@(preKeyId)];
+}
+
+- (SignedPreKeyRecord *)loadSignedPrekey:(int)signedPreKeyId{
+    return self.signedPreKeys[@(signedPreKeyId)];
+}
+
+- (nullable SignedPreKeyRecord *)loadSignedPrekeyOrNil:(int)signedPreKeyId{
+    return self.signedPreKeys[@(signedPreKeyId)];
+}
+
+- (NSArray<SignedPreKeyRecord *> *)loadSignedPreKeys{
+    return self.signedPreKeys.allValues;
+}
+
+- (void)storeSignedPreKey:(int)signedPreKeyId signedPreKeyRecord:(SignedPreKeyRecord *)signedPreKeyRecord{
+    self.signedPreKeys[@(signedPreKeyId)] = signedPreKeyRecord;
+}
+
+- (BOOL)containsSignedPreKey:(int)signedPreKeyId{
+    return self.signedPreKeys[@(signedPreKeyId)] != nil;
+}
+
+- (void)removeSignedPreKey:(int)signedPrekeyId{
+    [self.signedPreKeys removeObjectForKey:@(signedPrekeyId)];
+}
+
+@end
+
+#endif
+
 
 @implementation SessionCipher
 
@@ -351,7 +475,8 @@ static dispatch_queue_t _sessionCipherDispatchQueue;
         }
     }
 
-    NSUInteger kCounterLimit = 2000;
+    // A receiving chain can't hold more skipped keys than this anyway.
+    NSUInteger kCounterLimit = kReceivingChainMaxMessageKeys;
     if (counter - chainKey.index > kCounterLimit) {
         DDLogError(@"%@ %@.%d Exceeded future message limit: %lu, index: %d, counter: %d)",
             self.tag,
@@ -365,10 +490,11 @@ static dispatch_queue_t _sessionCipherDispatchQueue;
                                      userInfo:@{}];
     }
     
-    while (chainKey.index < counter) {
-        MessageKeys *messageKeys = [chainKey messageKeys];
-        [sessionState setMessageKeys:theirEphemeral messageKeys:messageKeys];
-        chainKey = chainKey.nextChainKey;
+    if (chainKey.index < counter) {
+        chainKey = [chainKey chainKeyAtIndex:counter
+                          skippedMessageKeys:^(MessageKeys *messageKeys) {
+                              [sessionState setMessageKeys:theirEphemeral messageKeys:messageKeys];
+                          }];
     }
     
     [sessionState setReceiverChainKey:theirEphemeral chainKey:[chainKey nextChainKey]];
@@ -410,6 +536,86 @@ static dispatch_queue_t _sessionCipherDispatchQueue;
     return record.sessionState.version;
 }
 
+#pragma mark - Benchmark
+
+#ifdef DEBUG
+
++ (void)logOutOfOrderDecryptBenchmarkWithMessageCount:(int)messageCount{
+    SPKAssert(messageCount > 0 && messageCount <= (int)kReceivingChainMaxMessageKeys);
+
+    NSString *aliceId = @"+15555550100";
+    NSString *bobId   = @"+15555550101";
+    SPKBenchmarkAxolotlStore *aliceStore = [[SPKBenchmarkAxolotlStore alloc] initWithRegistrationId:1];
+    SPKBenchmarkAxolotlStore *bobStore   = [[SPKBenchmarkAxolotlStore alloc] initWithRegistrationId:2];
+
+    ECKeyPair *bobPreKey       = [Curve25519 generateKeyPair];
+    ECKeyPair *bobSignedPreKey = [Curve25519 generateKeyPair];
+    NSData *signature          = [Ed25519 sign:bobSignedPreKey.publicKey.prependKeyType withKeyPair:bobStore.identityKeyPair];
+    [bobStore storePreKey:1 preKeyRecord:[[PreKeyRecord alloc] initWithId:1 keyPair:bobPreKey]];
+    [bobStore storeSignedPreKey:1
+             signedPreKeyRecord:[[SignedPreKeyRecord alloc] initWithId:1
+                                                              keyPair:bobSignedPreKey
+                                                            signature:signature
+                                                          generatedAt:[NSDate date]]];
+
+    PreKeyBundle *bundle = [[PreKeyBundle alloc] initWithRegistrationId:bobStore.localRegistrationId
+                                                               deviceId:1
+                                                               preKeyId:1
+                                                           preKeyPublic:bobPreKey.publicKey.prependKeyType
+                                                     signedPreKeyPublic:bobSignedPreKey.publicKey.prependKeyType
+                                                         signedPreKeyId:1
+                                                  signedPreKeySignature:signature
+                                                            identityKey:bobStore.identityKeyPair.publicKey.prependKeyType];
+    SessionBuilder *aliceBuilder = [[SessionBuilder alloc] initWithAxolotlStore:aliceStore recipientId:bobId deviceId:1];
+    [aliceBuilder processPrekeyBundle:bundle];
+
+    SessionCipher *aliceCipher = [[SessionCipher alloc] initWithAxolotlStore:aliceStore recipientId:bobId deviceId:1];
+    SessionCipher *bobCipher   = [[SessionCipher alloc] initWithAxolotlStore:bobStore recipientId:aliceId deviceId:1];
+
+    // Padded plaintexts are a multiple of 160 bytes.
+    NSMutableData *plaintext = [NSMutableData dataWithLength:160];
+    id<CipherMessage> preKeyMessage = [aliceCipher encryptMessage:plaintext];
+    [bobCipher decrypt:[[PreKeyWhisperMessage alloc] initWithData:preKeyMessage.serialized]];
+    // Bob's reply acknowledges the prekey message, so from here on Alice sends plain WhisperMessages.
+    id<CipherMessage> reply = [bobCipher encryptMessage:plaintext];
+    [aliceCipher decrypt:[[WhisperMessage alloc] initWithData:reply.serialized]];
+
+    CFAbsoluteTime decryptTimes[2];
+    for (int run = 0; run < 2; run++) {
+        NSMutableArray<NSData *> *messages = [NSMutableArray arrayWithCapacity:(NSUInteger)messageCount];
+        for (int i = 0; i < messageCount; i++) {
+            @autoreleasepool {
+                [messages addObject:[aliceCipher encryptMessage:plaintext].serialized];
+            }
+        }
+        if (run == 1) {
+            for (NSUInteger i = messages.count - 1; i > 0; i--) {
+                [messages exchangeObjectAtIndex:i withObjectAtIndex:arc4random_uniform((uint32_t)i + 1)];
+            }
+        }
+
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        for (NSData *message in messages) {
+            @autoreleasepool {
+                NSData *decrypted = [bobCipher decrypt:[[WhisperMessage alloc] initWithData:message]];
+                SPKAssert([decrypted isEqualToData:plaintext]);
+            }
+        }
+        decryptTimes[run] = CFAbsoluteTimeGetCurrent() - startTime;
+    }
+
+    DDLogInfo(@"%@ Benchmark (%d messages): decrypted in order in %.1fms (%.0f messages/s), out of order in %.1fms "
+              @"(%.0f messages/s)",
+        self.tag,
+        messageCount,
+        decryptTimes[0] * 1000,
+        messageCount / MAX(decryptTimes[0], DBL_EPSILON),
+        decryptTimes[1] * 1000,
+        messageCount / MAX(decryptTimes[1], DBL_EPSILON));
+}
+
+#endif
+
 #pragma mark - Logging
 
 + (NSString *)tag
@@ -28,6 +28,10 @@ extern const int kPreKeyOfLastResortId;
                             deviceId:(int)deviceId;
 
 - (void)processPrekeyBundle:(PreKeyBundle *)preKeyBundle;
+
+// Processes the bundles of several of the recipient's devices, each into the session for its own deviceId.
+// Their signed prekey signatures are checked in a single batch, and if any is invalid, none are processed.
+- (void)processPrekeyBundles:(NSArray<PreKeyBundle *> *)preKeyBundles;
 - (int)processPrekeyWhisperMessage:(PreKeyWhisperMessage *)message
                        withSession:(SessionRecord *)sessionRecord;
 
@@ -70,8 +70,7 @@ const int kPreKeyOfLastResortId = 0xFFFFFF;
 }
 
 - (void)processPrekeyBundle:(PreKeyBundle*)preKeyBundle{
-    NSData *theirIdentityKey  = preKeyBundle.identityKey.removeKeyType;
-    NSData *theirSignedPreKey = preKeyBundle.signedPreKeyPublic.removeKeyType;
+    NSData *theirIdentityKey = preKeyBundle.identityKey.removeKeyType;
     
     if (![self.identityStore isTrustedIdentityKey:theirIdentityKey recipientId:self.recipientId direction:TSMessageDirectionOutgoing]) {
         @throw [NSException exceptionWithName:UntrustedIdentityKeyException reason:@"Identity key is not valid" userInfo:@{}];
@@ -81,6 +80,42 @@ const int kPreKeyOfLastResortId = 0xFFFFFF;
         @throw [NSException exceptionWithName:InvalidKeyException reason:@"KeyIsNotValidlySigned" userInfo:nil];
     }
     
+    [self processVerifiedPrekeyBundle:preKeyBundle deviceId:self.deviceId];
+}
+
+- (void)processPrekeyBundles:(NSArray<PreKeyBundle*>*)preKeyBundles{
+    NSMutableArray<NSData*> *signatures        = [NSMutableArray arrayWithCapacity:preKeyBundles.count];
+    NSMutableArray<NSData*> *theirIdentityKeys = [NSMutableArray arrayWithCapacity:preKeyBundles.count];
+    NSMutableArray<NSData*> *signedPreKeys     = [NSMutableArray arrayWithCapacity:preKeyBundles.count];
+    
+    for (PreKeyBundle *preKeyBundle in preKeyBundles) {
+        NSData *theirIdentityKey = preKeyBundle.identityKey.removeKeyType;
+        
+        if (![self.identityStore isTrustedIdentityKey:theirIdentityKey recipientId:self.recipientId direction:TSMessageDirectionOutgoing]) {
+            @throw [NSException exceptionWithName:UntrustedIdentityKeyException reason:@"Identity key is not valid" userInfo:@{}];
+        }
+        
+        [signatures addObject:preKeyBundle.signedPreKeySignature];
+        [theirIdentityKeys addObject:theirIdentityKey];
+        [signedPreKeys addObject:preKeyBundle.signedPreKeyPublic];
+    }
+    
+    // Check every signed prekey before touching any session, so one bad bundle leaves them all unprocessed,
+    // just as it would have if each had been processed on its own.
+    NSIndexSet *validIndexes = [Ed25519 verifySignatures:signatures publicKeys:theirIdentityKeys data:signedPreKeys];
+    if (validIndexes.count != preKeyBundles.count) {
+        @throw [NSException exceptionWithName:InvalidKeyException reason:@"KeyIsNotValidlySigned" userInfo:nil];
+    }
+    
+    for (PreKeyBundle *preKeyBundle in preKeyBundles) {
+        [self processVerifiedPrekeyBundle:preKeyBundle deviceId:preKeyBundle.deviceId];
+    }
+}
+
+- (void)processVerifiedPrekeyBundle:(PreKeyBundle*)preKeyBundle deviceId:(int)deviceId{
+    NSData *theirIdentityKey  = preKeyBundle.identityKey.removeKeyType;
+    NSData *theirSignedPreKey = preKeyBundle.signedPreKeyPublic.removeKeyType;
+    
     SessionRecord *sessionRecord       = [self.sessionStore loadSession:self.recipientId deviceId:preKeyBundle.deviceId];
     ECKeyPair     *ourBaseKey          = [Curve25519 generateKeyPair];
     NSData        *theirOneTimePreKey  = preKeyBundle.preKeyPublic.removeKeyType;
@@ -118,7 +153,7 @@ const int kPreKeyOfLastResortId = 0xFFFFFF;
         [sessionRecord removePreviousSessionStates];
     }
 
-    [self.sessionStore storeSession:self.recipientId deviceId:self.deviceId session:sessionRecord];
+    [self.sessionStore storeSession:self.recipientId deviceId:deviceId session:sessionRecord];
 }
 
 - (int)processPrekeyWhisperMessage:(PreKeyWhisperMessage*)message withSession:(SessionRecord*)sessionRecord{
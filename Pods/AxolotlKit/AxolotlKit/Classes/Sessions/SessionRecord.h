@@ -5,11 +5,30 @@
 #import <Foundation/Foundation.h>
 #import "SessionState.h"
 
+/**
+ *  Returns the archived (previous) session states of a record, most recent first.
+ */
+typedef NSArray<SessionState *> *(^SessionRecordPreviousStatesLoader)(void);
+
 @interface SessionRecord : NSObject <NSSecureCoding>
 
 - (instancetype)init;
 - (instancetype)initWithSessionState:(SessionState*)sessionState;
 
+/**
+ *  Creates a record whose previous session states are only loaded, via the loader, when first needed.
+ *  This lets a session store persist archived states separately from the current state, so the common
+ *  ratchet step doesn't have to deserialize and re-serialize up to 40 archived states.
+ */
+- (instancetype)initWithSessionState:(SessionState *)sessionState
+         previousSessionStatesLoader:(SessionRecordPreviousStatesLoader)loader;
+
+/**
+ *  NO if the previous session states were deferred and haven't been needed yet, in which case they can't have changed
+ *  and a store need not rewrite them.
+ */
+- (BOOL)hasLoadedPreviousSessionStates;
+
 - (BOOL)hasSessionState:(int)version baseKey:(NSData*)aliceBaseKey;
 - (SessionState*)sessionState;
 - (NSMutableArray<SessionState *> *)previousSessionStates;
@@ -10,6 +10,7 @@
 
 @property (nonatomic, retain) SessionState* sessionState;
 @property (nonatomic, retain) NSMutableArray* previousStates;
+@property (nonatomic, copy) SessionRecordPreviousStatesLoader previousStatesLoader;
 @property (nonatomic) BOOL fresh;
 
 @end
@@ -64,6 +65,36 @@
     return self;
 }
 
+- (instancetype)initWithSessionState:(SessionState *)sessionState
+         previousSessionStatesLoader:(SessionRecordPreviousStatesLoader)loader
+{
+    assert(loader);
+    self = [self initWithSessionState:sessionState];
+
+    if (self) {
+        _previousStates = nil;
+        _previousStatesLoader = [loader copy];
+    }
+
+    return self;
+}
+
+- (NSMutableArray *)previousStates
+{
+    if (_previousStatesLoader) {
+        NSArray<SessionState *> *loadedStates = _previousStatesLoader();
+        _previousStatesLoader = nil;
+        _previousStates = loadedStates ? [loadedStates mutableCopy] : [NSMutableArray new];
+    }
+
+    return _previousStates;
+}
+
+- (BOOL)hasLoadedPreviousSessionStates
+{
+    return _previousStatesLoader == nil;
+}
+
 - (BOOL)hasSessionState:(int)version baseKey:(NSData *)aliceBaseKey{
     if (self.sessionState.version == version && [aliceBaseKey isEqualToData:self.sessionState.aliceBaseKey]) {
         return YES;
@@ -84,12 +115,14 @@
 
 - (NSMutableArray<SessionState *> *)previousSessionStates
 {
-    return _previousStates;
+    return self.previousStates;
 }
 
 - (void)removePreviousSessionStates
 {
-    [_previousStates removeAllObjects];
+    // No need to load states we're about to discard.
+    _previousStatesLoader = nil;
+    _previousStates = [NSMutableArray new];
 }
 
 - (BOOL)isFresh{
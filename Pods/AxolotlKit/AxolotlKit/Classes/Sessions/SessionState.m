@@ -213,15 +213,7 @@ static NSString* const kCoderPendingPrekey    = @"kCoderPendingPrekey";
         return NO;
     }
 
-    NSArray *messageKeyArray = receivingChain.messageKeysList;
-    
-    for (MessageKeys *keys in messageKeyArray) {
-        if (keys.index == counter) {
-            return YES;
-        }
-    }
-
-    return NO;
+    return [receivingChain hasMessageKeysForIndex:counter];
 }
 
 - (MessageKeys*)removeMessageKeys:(NSData*)senderRatcherKey counter:(int)counter{
@@ -232,20 +224,7 @@ static NSString* const kCoderPendingPrekey    = @"kCoderPendingPrekey";
         return nil;
     }
     
-    NSMutableArray *messageList = receivingChain.messageKeysList;
-    
-    MessageKeys *result;
-    
-    for(MessageKeys *messageKeys in messageList){
-        if (messageKeys.index == counter) {
-            result = messageKeys;
-            break;
-        }
-    }
-    
-    [messageList removeObject:result];
-    
-    return result;
+    return [receivingChain removeMessageKeysForIndex:counter];
 }
 
 -(void)setReceiverChain:(int)index updatedChain:(ReceivingChain*)recvchain{
@@ -255,7 +234,7 @@ static NSString* const kCoderPendingPrekey    = @"kCoderPendingPrekey";
 - (void)setMessageKeys:(NSData*)senderRatchetKey messageKeys:(MessageKeys*)messageKeys{
     ChainAndIndex  *chainAndIndex = [self receiverChain:senderRatchetKey];
     ReceivingChain *chain         = (ReceivingChain*)chainAndIndex.chain;
-    [chain.messageKeysList addObject:messageKeys];
+    [chain addMessageKeys:messageKeys];
     
     [self setReceiverChain:chainAndIndex.index updatedChain:chain];
 }
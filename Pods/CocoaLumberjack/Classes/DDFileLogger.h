@@ -40,6 +40,7 @@ extern unsigned long long const kDDDefaultLogMaxFileSize;
 extern NSTimeInterval     const kDDDefaultLogRollingFrequency;
 extern NSUInteger         const kDDDefaultLogMaxNumLogFiles;
 extern unsigned long long const kDDDefaultLogFilesDiskQuota;
+extern NSTimeInterval     const kDDDefaultLogBufferFlushInterval;
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -393,6 +394,43 @@ extern unsigned long long const kDDDefaultLogFilesDiskQuota;
  **/
 @property (nonatomic, readwrite, assign) BOOL automaticallyAppendNewlineForCustomFormatters;
 
+/**
+ * Log Buffering:
+ *
+ * `logBufferSize`
+ *   When non-zero, log messages are appended to a buffer of this many bytes instead of being
+ *   written to the log file one at a time. Default value is 0 (every message is written immediately).
+ *
+ * `logBufferFlushInterval`
+ *   The longest a buffered message waits before it is written to the log file.
+ *   The frequency is given as an `NSTimeInterval`. Default value is 1 second.
+ *   Set it to zero (or any non-positive number) to only flush when the buffer fills up.
+ *
+ * The buffer is also flushed by `-[DDLog flushLog]`, and before the log file is rolled.
+ *
+ * The buffer is a memory mapped file in the logs directory, so messages which haven't been flushed
+ * yet survive the app crashing or being killed, and are appended to the log file on the next launch.
+ * If the app dies part way through a flush, the partly written messages are truncated from the log file
+ * before the buffer is written again. They are only duplicated when the log file was rolled or removed
+ * before the next launch.
+ **/
+@property (readwrite, assign) NSUInteger logBufferSize;
+
+/**
+ *  See description for `logBufferSize`
+ */
+@property (readwrite, assign) NSTimeInterval logBufferFlushInterval;
+
+/**
+ * The average number of messages and bytes logged per second over the last minute.
+ **/
+@property (readonly) double loggedMessagesPerSecond;
+
+/**
+ *  See description for `loggedMessagesPerSecond`
+ */
+@property (readonly) double loggedBytesPerSecond;
+
 /**
  *  You can optionally force the current log file to be rolled with this method.
  *  CompletionBlock will be called on main queue.
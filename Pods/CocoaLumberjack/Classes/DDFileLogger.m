@@ -15,8 +15,11 @@
 
 #import "DDFileLogger.h"
 
+#import <fcntl.h>
 #import <unistd.h>
 #import <sys/attr.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
 #import <sys/xattr.h>
 #import <libkern/OSAtomic.h>
 
@@ -50,6 +53,7 @@ unsigned long long const kDDDefaultLogMaxFileSize      = 1024 * 1024;      // 1
 NSTimeInterval     const kDDDefaultLogRollingFrequency = 60 * 60 * 24;     // 24 Hours
 NSUInteger         const kDDDefaultLogMaxNumLogFiles   = 5;                // 5 Files
 unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20 MB
+NSTimeInterval     const kDDDefaultLogBufferFlushInterval = 1;             // 1 Second
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -546,6 +550,78 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// The log buffer file starts with this header, followed by `capacity` bytes of which the first `length`
+// haven't been written to the log file yet.
+//
+// While the buffer is being written out, `flushing` is set and `flushDevice`, `flushInode` and `flushOffset`
+// identify the log file and the offset the buffer is being written at. If the process dies before `length`
+// is reset, recovery truncates that file back to `flushOffset` before writing the buffer again,
+// so the messages aren't duplicated.
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;
+    uint64_t length;
+    uint32_t flushing;
+    uint32_t reserved;
+    uint64_t flushDevice;
+    uint64_t flushInode;
+    uint64_t flushOffset;
+} DDLogBufferHeader;
+
+static uint32_t const kDDLogBufferMagic = 0x324c4444; // "DDL2", little endian
+static NSString *const kDDLogBufferFileName = @"DDFileLogger.buffer";
+
+static BOOL DDWriteFully(int fd, const uint8_t *bytes, size_t length);
+
+// loggedMessagesPerSecond and loggedBytesPerSecond are averaged over this many one second buckets.
+#define kDDLogRateWindowSeconds 60
+
+/**
+ * Appends a log buffer's contents to the file, recording where in the header first.
+ * Only resets the buffer once everything has been written.
+ **/
+static BOOL DDWriteLogBuffer(DDLogBufferHeader *header, int fd) {
+    struct stat fileStat;
+    off_t offset = lseek(fd, 0, SEEK_END);
+
+    if (offset < 0 || fstat(fd, &fileStat) != 0) {
+        return NO;
+    }
+
+    header->flushDevice = (uint64_t)fileStat.st_dev;
+    header->flushInode = (uint64_t)fileStat.st_ino;
+    header->flushOffset = (uint64_t)offset;
+    header->flushing = 1;
+
+    if (!DDWriteFully(fd, (const uint8_t *)(header + 1), (size_t)header->length)) {
+        return NO;
+    }
+
+    header->length = 0;
+    header->flushing = 0;
+
+    return YES;
+}
+
+static BOOL DDWriteFully(int fd, const uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return NO;
+        }
+
+        bytes += written;
+        length -= (size_t)written;
+    }
+
+    return YES;
+}
+
 @interface DDFileLogger () {
     __strong id <DDLogFileManager> _logFileManager;
     
@@ -556,11 +632,24 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     
     unsigned long long _maximumFileSize;
     NSTimeInterval _rollingFrequency;
+
+    NSUInteger _logBufferSize;
+    NSTimeInterval _logBufferFlushInterval;
+    DDLogBufferHeader *_logBuffer;
+    size_t _logBufferMappedLength;
+    dispatch_source_t _logBufferFlushTimer;
+
+    uint64_t _loggedMessageCounts[kDDLogRateWindowSeconds];
+    uint64_t _loggedByteCounts[kDDLogRateWindowSeconds];
+    int64_t _loggedSeconds[kDDLogRateWindowSeconds];
+    int64_t _firstLoggedSecond;
+    BOOL _hasLoggedMessage;
 }
 
 - (void)rollLogFileNow;
 - (void)maybeRollLogFileDueToAge;
 - (void)maybeRollLogFileDueToSize;
+- (void)flushLogBuffer;
 
 @end
 
@@ -577,6 +666,7 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
         _maximumFileSize = kDDDefaultLogMaxFileSize;
         _rollingFrequency = kDDDefaultLogRollingFrequency;
         _automaticallyAppendNewlineForCustomFormatters = YES;
+        _logBufferFlushInterval = kDDDefaultLogBufferFlushInterval;
 
         logFileManager = aLogFileManager;
 
@@ -587,6 +677,21 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
 }
 
 - (void)dealloc {
+    if (_logBuffer) {
+        // Anything we can't write now stays in the buffer file, and is recovered the next time it's opened.
+        if (_currentLogFileHandle && _logBuffer->length > 0) {
+            DDWriteLogBuffer(_logBuffer, [_currentLogFileHandle fileDescriptor]);
+        }
+
+        munmap(_logBuffer, _logBufferMappedLength);
+        _logBuffer = NULL;
+    }
+
+    if (_logBufferFlushTimer) {
+        dispatch_source_cancel(_logBufferFlushTimer);
+        _logBufferFlushTimer = NULL;
+    }
+
     [_currentLogFileHandle synchronizeFile];
     [_currentLogFileHandle closeFile];
 
@@ -721,6 +826,176 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     });
 }
 
+- (NSUInteger)logBufferSize {
+    __block NSUInteger result;
+
+    dispatch_block_t block = ^{
+        result = _logBufferSize;
+    };
+
+    // The design of this method is the same as maximumFileSize.
+    // The internal implementation MUST access the logBufferSize variable directly.
+
+    NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+    NSAssert(![self isOnInternalLoggerQueue], @"MUST access ivar directly, NOT via self.* syntax.");
+
+    dispatch_queue_t globalLoggingQueue = [DDLog loggingQueue];
+
+    dispatch_sync(globalLoggingQueue, ^{
+        dispatch_sync(self.loggerQueue, block);
+    });
+
+    return result;
+}
+
+- (void)setLogBufferSize:(NSUInteger)newLogBufferSize {
+    dispatch_block_t block = ^{
+        @autoreleasepool {
+            if (_logBufferSize != newLogBufferSize) {
+                // The buffer is mapped at its current size, so write it out and map it again when it's next needed.
+                [self closeLogBuffer];
+                _logBufferSize = newLogBufferSize;
+            }
+        }
+    };
+
+    // The design of this method is the same as maximumFileSize.
+    // The internal implementation MUST access the logBufferSize variable directly.
+
+    NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+    NSAssert(![self isOnInternalLoggerQueue], @"MUST access ivar directly, NOT via self.* syntax.");
+
+    dispatch_queue_t globalLoggingQueue = [DDLog loggingQueue];
+
+    dispatch_async(globalLoggingQueue, ^{
+        dispatch_async(self.loggerQueue, block);
+    });
+}
+
+- (NSTimeInterval)logBufferFlushInterval {
+    __block NSTimeInterval result;
+
+    dispatch_block_t block = ^{
+        result = _logBufferFlushInterval;
+    };
+
+    // The design of this method is the same as maximumFileSize.
+    // The internal implementation MUST access the logBufferFlushInterval variable directly.
+
+    NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+    NSAssert(![self isOnInternalLoggerQueue], @"MUST access ivar directly, NOT via self.* syntax.");
+
+    dispatch_queue_t globalLoggingQueue = [DDLog loggingQueue];
+
+    dispatch_sync(globalLoggingQueue, ^{
+        dispatch_sync(self.loggerQueue, block);
+    });
+
+    return result;
+}
+
+- (void)setLogBufferFlushInterval:(NSTimeInterval)newLogBufferFlushInterval {
+    dispatch_block_t block = ^{
+        @autoreleasepool {
+            _logBufferFlushInterval = newLogBufferFlushInterval;
+        }
+    };
+
+    // The design of this method is the same as maximumFileSize.
+    // The internal implementation MUST access the logBufferFlushInterval variable directly.
+
+    NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+    NSAssert(![self isOnInternalLoggerQueue], @"MUST access ivar directly, NOT via self.* syntax.");
+
+    dispatch_queue_t globalLoggingQueue = [DDLog loggingQueue];
+
+    dispatch_async(globalLoggingQueue, ^{
+        dispatch_async(self.loggerQueue, block);
+    });
+}
+
+- (double)loggedMessagesPerSecond {
+    __block double result;
+
+    dispatch_block_t block = ^{
+        result = [self lt_ratePerSecondForCounts:_loggedMessageCounts];
+    };
+
+    // The design of this method is the same as maximumFileSize.
+
+    NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+    NSAssert(![self isOnInternalLoggerQueue], @"MUST access ivar directly, NOT via self.* syntax.");
+
+    dispatch_queue_t globalLoggingQueue = [DDLog loggingQueue];
+
+    dispatch_sync(globalLoggingQueue, ^{
+        dispatch_sync(self.loggerQueue, block);
+    });
+
+    return result;
+}
+
+- (double)loggedBytesPerSecond {
+    __block double result;
+
+    dispatch_block_t block = ^{
+        result = [self lt_ratePerSecondForCounts:_loggedByteCounts];
+    };
+
+    // The design of this method is the same as maximumFileSize.
+
+    NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+    NSAssert(![self isOnInternalLoggerQueue], @"MUST access ivar directly, NOT via self.* syntax.");
+
+    dispatch_queue_t globalLoggingQueue = [DDLog loggingQueue];
+
+    dispatch_sync(globalLoggingQueue, ^{
+        dispatch_sync(self.loggerQueue, block);
+    });
+
+    return result;
+}
+
+- (double)lt_ratePerSecondForCounts:(const uint64_t *)counts {
+    if (!_hasLoggedMessage) {
+        return 0;
+    }
+
+    int64_t now = (int64_t)floor(CFAbsoluteTimeGetCurrent());
+    uint64_t total = 0;
+
+    // Buckets last written more than a window ago hold stale counts.
+    for (NSUInteger i = 0; i < kDDLogRateWindowSeconds; i++) {
+        if (now - _loggedSeconds[i] < kDDLogRateWindowSeconds) {
+            total += counts[i];
+        }
+    }
+
+    // Until a full window has passed since the first message, only average over the time we've been logging.
+    int64_t seconds = MIN(MAX(now - _firstLoggedSecond + 1, 1), kDDLogRateWindowSeconds);
+
+    return (double)total / (double)seconds;
+}
+
+- (void)lt_countLoggedMessageWithByteCount:(NSUInteger)byteCount {
+    int64_t now = (int64_t)floor(CFAbsoluteTimeGetCurrent());
+    NSUInteger bucket = (NSUInteger)(((now % kDDLogRateWindowSeconds) + kDDLogRateWindowSeconds) % kDDLogRateWindowSeconds);
+
+    if (!_hasLoggedMessage) {
+        _firstLoggedSecond = now;
+        _hasLoggedMessage = YES;
+    }
+
+    if (_loggedSeconds[bucket] != now) {
+        _loggedSeconds[bucket] = now;
+        _loggedMessageCounts[bucket] = 0;
+        _loggedByteCounts[bucket] = 0;
+    }
+
+    _loggedMessageCounts[bucket]++;
+    _loggedByteCounts[bucket] += byteCount;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark File Rolling
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -805,6 +1080,9 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
 - (void)rollLogFileNow {
     NSLogVerbose(@"DDFileLogger: rollLogFileNow");
 
+    // Buffered messages belong at the end of the file being rolled.
+    [self flushLogBuffer];
+
     if (_currentLogFileHandle == nil) {
         return;
     }
@@ -852,6 +1130,10 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     if (_maximumFileSize > 0) {
         unsigned long long fileSize = [_currentLogFileHandle offsetInFile];
 
+        if (_logBuffer) {
+            fileSize += _logBuffer->length;
+        }
+
         if (fileSize >= _maximumFileSize) {
             NSLogVerbose(@"DDFileLogger: Rolling log file due to size (%qu)...", fileSize);
 
@@ -975,6 +1257,224 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     return _currentLogFileHandle;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Log Buffer
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (NSString *)logBufferFilePath {
+    return [[logFileManager logsDirectory] stringByAppendingPathComponent:kDDLogBufferFileName];
+}
+
+/**
+ * Maps the log buffer file, creating it if needed.
+ *
+ * If the previous process didn't get a chance to flush its buffer, the leftover messages are
+ * appended to the current log file first.
+ **/
+- (BOOL)openLogBuffer {
+    if (_logBuffer) {
+        return YES;
+    }
+
+    NSString *filePath = [self logBufferFilePath];
+
+    if (![[NSFileManager defaultManager] fileExistsAtPath:filePath]) {
+        NSDictionary *attributes = nil;
+
+    #if TARGET_OS_IPHONE
+        // Messages are buffered while the app is running in the background, possibly with the device locked.
+        attributes = @{ NSFileProtectionKey: NSFileProtectionCompleteUntilFirstUserAuthentication };
+    #endif
+
+        [[NSFileManager defaultManager] createFileAtPath:filePath contents:nil attributes:attributes];
+    }
+
+    int fd = open([filePath fileSystemRepresentation], O_RDWR);
+
+    if (fd < 0) {
+        NSLogError(@"DDFileLogger: Failed to open log buffer file: %d", errno);
+        return NO;
+    }
+
+    DDLogBufferHeader header;
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+
+    if (pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+        header.magic == kDDLogBufferMagic &&
+        header.length > 0 &&
+        header.length <= (uint64_t)fileSize - sizeof(header)) {
+        NSLogInfo(@"DDFileLogger: Recovering %qu bytes from log buffer", header.length);
+
+        NSMutableData *recoveredData = [NSMutableData dataWithLength:(NSUInteger)header.length];
+
+        NSFileHandle *fileHandle = [self currentLogFileHandle];
+        int logFileDescriptor = [fileHandle fileDescriptor];
+        struct stat logFileStat;
+
+        // If we died part way through a flush into the same log file, drop what it got of the buffer
+        // before writing the buffer again.
+        if (fileHandle != nil &&
+            header.flushing &&
+            fstat(logFileDescriptor, &logFileStat) == 0 &&
+            (uint64_t)logFileStat.st_dev == header.flushDevice &&
+            (uint64_t)logFileStat.st_ino == header.flushInode &&
+            (uint64_t)logFileStat.st_size >= header.flushOffset) {
+            if (ftruncate(logFileDescriptor, (off_t)header.flushOffset) == 0) {
+                [fileHandle seekToEndOfFile];
+            } else {
+                NSLogError(@"DDFileLogger: Failed to truncate partially flushed log buffer: %d", errno);
+            }
+        }
+
+        if (fileHandle == nil ||
+            pread(fd, recoveredData.mutableBytes, recoveredData.length, sizeof(header)) != (ssize_t)recoveredData.length ||
+            !DDWriteFully(logFileDescriptor, recoveredData.bytes, recoveredData.length)) {
+            NSLogError(@"DDFileLogger: Failed to recover log buffer");
+        }
+    }
+
+    uint32_t capacity = (uint32_t)MIN(_logBufferSize, (NSUInteger)(UINT32_MAX - sizeof(DDLogBufferHeader)));
+    size_t mappedLength = sizeof(DDLogBufferHeader) + capacity;
+
+    if (ftruncate(fd, (off_t)mappedLength) != 0) {
+        NSLogError(@"DDFileLogger: Failed to size log buffer file: %d", errno);
+        close(fd);
+        return NO;
+    }
+
+    void *mapping = mmap(NULL, mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        NSLogError(@"DDFileLogger: Failed to map log buffer file: %d", errno);
+        return NO;
+    }
+
+    _logBuffer = mapping;
+    _logBufferMappedLength = mappedLength;
+
+    _logBuffer->magic = kDDLogBufferMagic;
+    _logBuffer->capacity = capacity;
+    _logBuffer->length = 0;
+
+    return YES;
+}
+
+- (void)closeLogBuffer {
+    if (_logBuffer == NULL) {
+        return;
+    }
+
+    [self flushLogBuffer];
+
+    munmap(_logBuffer, _logBufferMappedLength);
+    _logBuffer = NULL;
+    _logBufferMappedLength = 0;
+}
+
+- (void)flushLogBuffer {
+    if (_logBufferFlushTimer) {
+        dispatch_source_cancel(_logBufferFlushTimer);
+        _logBufferFlushTimer = NULL;
+    }
+
+    if (_logBuffer == NULL || _logBuffer->length == 0) {
+        return;
+    }
+
+    NSFileHandle *fileHandle = [self currentLogFileHandle];
+
+    if (fileHandle == nil || !DDWriteLogBuffer(_logBuffer, [fileHandle fileDescriptor])) {
+        NSLogError(@"DDFileLogger: Failed to flush log buffer, dropping %qu bytes", _logBuffer->length);
+    }
+
+    _logBuffer->length = 0;
+    _logBuffer->flushing = 0;
+}
+
+- (void)scheduleLogBufferFlush {
+    if (_logBufferFlushTimer || _logBufferFlushInterval <= 0.0) {
+        return;
+    }
+
+    _logBufferFlushTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.loggerQueue);
+
+    dispatch_source_set_event_handler(_logBufferFlushTimer, ^{ @autoreleasepool {
+                                                                  [self flushLogBuffer];
+                                                              } });
+
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_source_t theFlushTimer = _logBufferFlushTimer;
+    dispatch_source_set_cancel_handler(_logBufferFlushTimer, ^{
+        dispatch_release(theFlushTimer);
+    });
+    #endif
+
+    uint64_t delay = (uint64_t)(_logBufferFlushInterval * (NSTimeInterval) NSEC_PER_SEC);
+    dispatch_time_t fireTime = dispatch_time(DISPATCH_TIME_NOW, delay);
+
+    dispatch_source_set_timer(_logBufferFlushTimer, fireTime, DISPATCH_TIME_FOREVER, NSEC_PER_SEC / 10);
+    dispatch_resume(_logBufferFlushTimer);
+}
+
+/**
+ * Encodes the message straight into the free space of the buffer.
+ * Returns NO, leaving the buffer unchanged, if it doesn't fit.
+ **/
+- (BOOL)appendToLogBuffer:(NSString *)message usedLength:(NSUInteger *)usedLength {
+    uint8_t *bytes = (uint8_t *)(_logBuffer + 1) + _logBuffer->length;
+    NSUInteger available = (NSUInteger)(_logBuffer->capacity - _logBuffer->length);
+    NSRange remainingRange;
+
+    BOOL encoded = [message getBytes:bytes
+                           maxLength:available
+                          usedLength:usedLength
+                            encoding:NSUTF8StringEncoding
+                             options:0
+                               range:NSMakeRange(0, message.length)
+                      remainingRange:&remainingRange];
+
+    if (!encoded || remainingRange.length > 0) {
+        return NO;
+    }
+
+    // Only publish the new length once the bytes are in place, so a crash never recovers a partial message.
+    _logBuffer->length += *usedLength;
+
+    return YES;
+}
+
+/**
+ * Returns the number of bytes logged.
+ **/
+- (NSUInteger)writeLogMessage:(NSString *)message {
+    if (_logBufferSize > 0 && [self openLogBuffer]) {
+        NSUInteger usedLength = 0;
+
+        if ([self appendToLogBuffer:message usedLength:&usedLength]) {
+            [self scheduleLogBufferFlush];
+            return usedLength;
+        }
+
+        [self flushLogBuffer];
+
+        if ([self appendToLogBuffer:message usedLength:&usedLength]) {
+            [self scheduleLogBufferFlush];
+            return usedLength;
+        }
+
+        // The message is larger than the whole buffer, so fall through and write it directly.
+    }
+
+    NSData *logData = [message dataUsingEncoding:NSUTF8StringEncoding];
+
+    [[self currentLogFileHandle] writeData:logData];
+
+    return logData.length;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark DDLogger Protocol
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -995,12 +1495,12 @@ static int exception_count = 0;
             message = [message stringByAppendingString:@"\n"];
         }
 
-        NSData *logData = [message dataUsingEncoding:NSUTF8StringEncoding];
-
         @try {
             [self willLogMessage];
 			
-            [[self currentLogFileHandle] writeData:logData];
+            NSUInteger byteCount = [self writeLogMessage:message];
+
+            [self lt_countLoggedMessageWithByteCount:byteCount];
 
             [self didLogMessage];
         } @catch (NSException *exception) {
@@ -1017,6 +1517,15 @@ static int exception_count = 0;
     }
 }
 
+- (void)flush {
+    // This method is invoked by DDLog's flushLog method.
+    //
+    // It is called automatically when the application quits,
+    // or if the developer invokes DDLog's flushLog method prior to crashing or something.
+
+    [self flushLogBuffer];
+}
+
 - (void)willLogMessage {
 	
 }
@@ -34,26 +34,30 @@
 
 + (NSData*)expand:(NSData*)data info:(NSData*)info outputSize:(int)outputSize offset:(int)offset{
     int             iterations = (int)ceil((double)outputSize/(double)HKDF_HASH_LEN);
-    NSData          *mixin = [NSData data];
-    NSMutableData   *results = [NSMutableData data];
+    NSMutableData   *results = [NSMutableData dataWithCapacity:iterations * HKDF_HASH_LEN];
+
+    // The key is the same for every iteration, so its schedule is only computed once.
+    CCHmacContext keyCtx;
+    CCHmacInit(&keyCtx, HKDF_HASH_ALG, [data bytes], [data length]);
+
+    unsigned char T[HKDF_HASH_LEN];
+    size_t mixinLength = 0;
 
     for (int i=offset; i<(iterations+offset); i++) {
-        CCHmacContext ctx;
-        CCHmacInit(&ctx, HKDF_HASH_ALG, [data bytes], [data length]);
-        CCHmacUpdate(&ctx, [mixin bytes], [mixin length]);
+        CCHmacContext ctx = keyCtx;
+        CCHmacUpdate(&ctx, T, mixinLength);
         if (info != nil) {
             CCHmacUpdate(&ctx, [info bytes], [info length]);
         }
         unsigned char c = i;
         CCHmacUpdate(&ctx, &c, 1);
-        unsigned char T[HKDF_HASH_LEN];
         CCHmacFinal(&ctx, T);
-        NSData *stepResult = [NSData dataWithBytes:T length:sizeof(T)];
-        [results appendData:stepResult];
-        mixin = [stepResult copy];
+        [results appendBytes:T length:sizeof(T)];
+        mixinLength = sizeof(T);
     }
     
-    return [[NSData dataWithData:results] subdataWithRange:NSMakeRange(0, outputSize)];
+    [results setLength:outputSize];
+    return results;
 }
 
 @end
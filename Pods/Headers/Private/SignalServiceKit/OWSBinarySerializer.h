@@ -0,0 +1 @@
+../../../SignalServiceKit/SignalServiceKit/src/Storage/OWSBinarySerializer.h
\ No newline at end of file
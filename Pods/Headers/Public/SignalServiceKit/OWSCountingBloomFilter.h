@@ -0,0 +1 @@
+../../../SignalServiceKit/SignalServiceKit/src/Util/OWSCountingBloomFilter.h
\ No newline at end of file
@@ -33,7 +33,11 @@
  */
 @interface PBCodedInputStream : NSObject {
 @private
-  NSMutableData* buffer;
+  NSData* buffer;
+  /** Cached {@code buffer.bytes}, so the hot paths don't send a message per byte. */
+  const uint8_t* bufferBytes;
+  /** YES when the whole input is resident in {@code buffer} (i.e. there is no input stream). */
+  BOOL bufferIsResident;
   SInt32 bufferSize;
   SInt32 bufferSizeAfterLimit;
   SInt32 bufferPos;
@@ -61,6 +65,15 @@
 + (PBCodedInputStream*) streamWithData:(NSData*) data;
 + (PBCodedInputStream*) streamWithInputStream:(NSInputStream*) input;
 
+/**
+ * When reading from an {@code NSData}, {@code bytes} fields of at least
+ * {@code PBCodedInputStreamZeroCopyMinimumSize} bytes are returned as views
+ * onto the input instead of copies.  Each view retains the whole input, so
+ * turn this off if small fields may outlive a large input.  Defaults to YES.
+ * Has no effect when reading from an {@code NSInputStream}.
+ */
+@property (assign) BOOL zeroCopyEnabled;
+
 /**
  * Attempt to read a field tag, returning zero if we have reached EOF.
  * Protocol message parsers use this to read tags, since a protocol message
@@ -17,6 +17,7 @@
 
 #import "CodedInputStream.h"
 
+#import "CodedOutputStream.h"
 #import "MessageBuilder.h"
 #import "Utilities.h"
 #import "WireFormat.h"
@@ -25,7 +26,7 @@
 
 
 @interface PBCodedInputStream ()
-@property (strong) NSMutableData* buffer;
+@property (strong) NSData* buffer;
 @property (strong) NSInputStream* input;
 @end
 
@@ -35,9 +36,15 @@
 const SInt32 DEFAULT_RECURSION_LIMIT = 64;
 const SInt32 DEFAULT_SIZE_LIMIT = 64 << 20;  // 64MB
 const SInt32 BUFFER_SIZE = 4096;
+// Smaller bytes fields are cheaper to copy than to wrap, and copying them
+// avoids pinning a large input for the sake of a few bytes.
+const SInt32 PBCodedInputStreamZeroCopyMinimumSize = 64;
+// The longest possible varint encoding.
+const SInt32 MAX_VARINT_SIZE = 10;
 
 @synthesize buffer;
 @synthesize input;
+@synthesize zeroCopyEnabled;
 
 
 
@@ -51,8 +58,13 @@ const SInt32 BUFFER_SIZE = 4096;
 
 - (instancetype) initWithData:(NSData*) data {
   if ((self = [super init])) {
-    self.buffer = [NSMutableData dataWithData:data];
+    // -copy of an immutable NSData is just a retain, so we read the
+    // caller's bytes in place.
+    self.buffer = [data copy];
+    bufferBytes = (const uint8_t*)buffer.bytes;
     bufferSize = (UInt32)buffer.length;
+    bufferIsResident = YES;
+    zeroCopyEnabled = YES;
     self.input = nil;
     [self commonInit];
   }
@@ -64,7 +76,10 @@ const SInt32 BUFFER_SIZE = 4096;
 - (instancetype) initWithInputStream:(NSInputStream*) input_ {
   if ((self = [super init])) {
     self.buffer = [NSMutableData dataWithLength:BUFFER_SIZE];
+    bufferBytes = (const uint8_t*)buffer.bytes;
     bufferSize = 0;
+    bufferIsResident = NO;
+    zeroCopyEnabled = NO;
     self.input = input_;
     [input open];
     [self commonInit];
@@ -220,7 +235,7 @@ const SInt32 BUFFER_SIZE = 4096;
     // Fast path:  We already have the bytes in a contiguous buffer, so
     //   just copy directly from it.
     //  new String(buffer, bufferPos, size, "UTF-8");
-    NSString* result = [[NSString alloc] initWithBytes:(((uint8_t*) buffer.bytes) + bufferPos)
+    NSString* result = [[NSString alloc] initWithBytes:(bufferBytes + bufferPos)
                                                  length:size
                                                encoding:NSUTF8StringEncoding];
     bufferPos += size;
@@ -279,13 +294,34 @@ const SInt32 BUFFER_SIZE = 4096;
 }
 
 
+/**
+ * Returns {@code size} bytes at the current position as a view onto the
+ * resident buffer.  The view retains the buffer, so no bytes are copied.
+ */
+- (NSData*) readSharedData:(SInt32) size {
+  NSData* parent = buffer;
+  NSData* result = [[NSData alloc] initWithBytesNoCopy:(void*)(bufferBytes + bufferPos)
+                                                length:size
+                                           deallocator:^(void* bytes, NSUInteger length) {
+                                             // Keep the parent buffer alive for as long as the view.
+                                             (void)parent;
+                                           }];
+  bufferPos += size;
+  return result;
+}
+
+
 /** Read a {@code bytes} field value from the stream. */
 - (NSData*) readData {
   SInt32 size = [self readRawVarint32];
-  if (size < bufferSize - bufferPos && size > 0) {
+  if (size <= bufferSize - bufferPos && size > 0) {
+    if (bufferIsResident && zeroCopyEnabled && size >= PBCodedInputStreamZeroCopyMinimumSize) {
+      // Zero-copy path:  The whole input is resident, so hand out a view.
+      return [self readSharedData:size];
+    }
     // Fast path:  We already have the bytes in a contiguous buffer, so
     //   just copy directly from it.
-    NSData* result = [NSData dataWithBytes:(((uint8_t*) buffer.bytes) + bufferPos) length:size];
+    NSData* result = [NSData dataWithBytes:(bufferBytes + bufferPos) length:size];
     bufferPos += size;
     return result;
   } else {
@@ -341,6 +377,45 @@ const SInt32 BUFFER_SIZE = 4096;
  * upper bits.
  */
 - (SInt32) readRawVarint32 {
+  if (bufferSize - bufferPos >= MAX_VARINT_SIZE) {
+    // Fast path:  The longest possible varint is already in the buffer, so
+    //   decode it in place without bounds checks or a message send per byte.
+    const int8_t* bytes = (const int8_t*)(bufferBytes + bufferPos);
+    SInt32 pos = 0;
+    int8_t tmp = bytes[pos++];
+    SInt32 result;
+    if (tmp >= 0) {
+      result = tmp;
+    } else if ((tmp = bytes[pos++]) >= 0) {
+      result = (bytes[0] & 0x7f) | (tmp << 7);
+    } else {
+      result = (bytes[0] & 0x7f) | ((tmp & 0x7f) << 7);
+      if ((tmp = bytes[pos++]) >= 0) {
+        result |= tmp << 14;
+      } else {
+        result |= (tmp & 0x7f) << 14;
+        if ((tmp = bytes[pos++]) >= 0) {
+          result |= tmp << 21;
+        } else {
+          result |= (tmp & 0x7f) << 21;
+          result |= (tmp = bytes[pos++]) << 28;
+          if (tmp < 0) {
+            // Discard upper 32 bits.
+            while (pos < MAX_VARINT_SIZE && bytes[pos] < 0) {
+              pos++;
+            }
+            if (pos == MAX_VARINT_SIZE) {
+              @throw [NSException exceptionWithName:@"InvalidProtocolBuffer" reason:@"malformedVarint" userInfo:nil];
+            }
+            pos++;
+          }
+        }
+      }
+    }
+    bufferPos += pos;
+    return result;
+  }
+
   int8_t tmp = [self readRawByte];
   if (tmp >= 0) {
     return tmp;
@@ -377,6 +452,23 @@ const SInt32 BUFFER_SIZE = 4096;
 
 /** Read a raw Varint from the stream. */
 - (SInt64) readRawVarint64 {
+  if (bufferSize - bufferPos >= MAX_VARINT_SIZE) {
+    // Fast path:  The longest possible varint is already in the buffer.
+    const uint8_t* bytes = bufferBytes + bufferPos;
+    SInt32 shift = 0;
+    SInt64 result = 0;
+    for (SInt32 pos = 0; pos < MAX_VARINT_SIZE; pos++) {
+      uint8_t b = bytes[pos];
+      result |= (SInt64)(b & 0x7F) << shift;
+      if ((b & 0x80) == 0) {
+        bufferPos += pos + 1;
+        return result;
+      }
+      shift += 7;
+    }
+    @throw [NSException exceptionWithName:@"InvalidProtocolBuffer" reason:@"malformedVarint" userInfo:nil];
+  }
+
   SInt32 shift = 0;
   SInt64 result = 0;
   while (shift < 64) {
@@ -571,7 +663,8 @@ const SInt32 BUFFER_SIZE = 4096;
   bufferPos = 0;
   bufferSize = 0;
   if (input != nil) {
-    bufferSize = (SInt32)[input read:buffer.mutableBytes maxLength:buffer.length];
+    // When reading from an input stream, buffer is our own NSMutableData.
+    bufferSize = (SInt32)[input read:(uint8_t*)bufferBytes maxLength:buffer.length];
   }
 
   if (bufferSize <= 0) {
@@ -602,8 +695,7 @@ const SInt32 BUFFER_SIZE = 4096;
   if (bufferPos == bufferSize) {
     [self refillBuffer:YES];
   }
-  int8_t* bytes = (int8_t*)buffer.bytes;
-  return bytes[bufferPos++];
+  return (int8_t)bufferBytes[bufferPos++];
 }
 
 
@@ -627,7 +719,10 @@ const SInt32 BUFFER_SIZE = 4096;
 
   if (size <= bufferSize - bufferPos) {
     // We have all the bytes we need already.
-    NSData* data = [NSData dataWithBytes:(((int8_t*) buffer.bytes) + bufferPos) length:size];
+    if (bufferIsResident && zeroCopyEnabled && size >= PBCodedInputStreamZeroCopyMinimumSize) {
+      return [self readSharedData:size];
+    }
+    NSData* data = [NSData dataWithBytes:(bufferBytes + bufferPos) length:size];
     bufferPos += size;
     return data;
   } else if (size < BUFFER_SIZE) {
@@ -637,7 +732,7 @@ const SInt32 BUFFER_SIZE = 4096;
     // First copy what we have.
     NSMutableData* bytes = [NSMutableData dataWithLength:size];
     SInt32 pos = bufferSize - bufferPos;
-    memcpy(bytes.mutableBytes, ((int8_t*)buffer.bytes) + bufferPos, pos);
+    memcpy(bytes.mutableBytes, bufferBytes + bufferPos, pos);
     bufferPos = bufferSize;
 
     // We want to use refillBuffer() and then copy from the buffer into our
@@ -646,13 +741,13 @@ const SInt32 BUFFER_SIZE = 4096;
     [self refillBuffer:YES];
 
     while (size - pos > bufferSize) {
-      memcpy(((int8_t*)bytes.mutableBytes) + pos, buffer.bytes, bufferSize);
+      memcpy(((int8_t*)bytes.mutableBytes) + pos, bufferBytes, bufferSize);
       pos += bufferSize;
       bufferPos = bufferSize;
       [self refillBuffer:YES];
     }
 
-    memcpy(((int8_t*)bytes.mutableBytes) + pos, buffer.bytes, size - pos);
+    memcpy(((int8_t*)bytes.mutableBytes) + pos, bufferBytes, size - pos);
     bufferPos = size - pos;
 
     return bytes;
@@ -703,7 +798,7 @@ const SInt32 BUFFER_SIZE = 4096;
 
     // Start by copying the leftover bytes from this.buffer.
     SInt32 pos = originalBufferSize - originalBufferPos;
-    memcpy(bytes.mutableBytes, ((int8_t*)buffer.bytes) + originalBufferPos, pos);
+    memcpy(bytes.mutableBytes, bufferBytes + originalBufferPos, pos);
 
     // And now all the chunks.
     for (NSData* chunk in chunks) {
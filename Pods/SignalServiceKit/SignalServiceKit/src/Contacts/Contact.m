@@ -16,6 +16,8 @@ NS_ASSUME_NONNULL_BEGIN
 @interface Contact ()
 
 @property (readonly, nonatomic) NSMutableDictionary<NSString *, NSString *> *phoneNumberNameMap;
+// The label for each of the user text phone numbers, which phoneNumberNameMap is built from when they're parsed.
+@property (readonly, nonatomic) NSDictionary<NSString *, NSString *> *userTextPhoneNumberNameMap;
 
 @end
 
@@ -26,6 +28,7 @@ NS_ASSUME_NONNULL_BEGIN
 @synthesize fullName = _fullName;
 @synthesize comparableNameFirstLast = _comparableNameFirstLast;
 @synthesize comparableNameLastFirst = _comparableNameLastFirst;
+@synthesize parsedPhoneNumbers = _parsedPhoneNumbers;
 
 #if TARGET_OS_IOS
 - (instancetype)initWithContactWithFirstName:(nullable NSString *)firstName
@@ -45,7 +48,7 @@ NS_ASSUME_NONNULL_BEGIN
     _recordID = record;
     _userTextPhoneNumbers = phoneNumbers;
     _phoneNumberNameMap = [NSMutableDictionary new];
-    _parsedPhoneNumbers = [self parsedPhoneNumbersFromUserTextPhoneNumbers:phoneNumbers phoneNumberNameMap:@{}];
+    _userTextPhoneNumberNameMap = @{};
     _image = image;
     // Not using emails for old AB style contacts.
     _emails = [NSMutableArray new];
@@ -115,8 +118,7 @@ NS_ASSUME_NONNULL_BEGIN
 
     _userTextPhoneNumbers = [phoneNumbers copy];
     _phoneNumberNameMap = [NSMutableDictionary new];
-    _parsedPhoneNumbers =
-        [self parsedPhoneNumbersFromUserTextPhoneNumbers:phoneNumbers phoneNumberNameMap:phoneNumberNameMap];
+    _userTextPhoneNumberNameMap = [phoneNumberNameMap copy];
 
     NSMutableArray<NSString *> *emailAddresses = [NSMutableArray new];
     for (CNLabeledValue *emailField in contact.emailAddresses) {
@@ -145,6 +147,20 @@ NS_ASSUME_NONNULL_BEGIN
 
 #endif // TARGET_OS_IOS
 
+// Parsing is deferred until the numbers are first needed, so that callers with many contacts (e.g. ContactsUpdater)
+// can parse all of their numbers in one batch first.
+- (NSArray<PhoneNumber *> *)parsedPhoneNumbers
+{
+    @synchronized(self)
+    {
+        if (_parsedPhoneNumbers == nil) {
+            _parsedPhoneNumbers = [self parsedPhoneNumbersFromUserTextPhoneNumbers:self.userTextPhoneNumbers
+                                                                phoneNumberNameMap:self.userTextPhoneNumberNameMap];
+        }
+        return _parsedPhoneNumbers;
+    }
+}
+
 - (NSArray<PhoneNumber *> *)parsedPhoneNumbersFromUserTextPhoneNumbers:(NSArray<NSString *> *)userTextPhoneNumbers
                                                     phoneNumberNameMap:(nullable NSDictionary<NSString *, NSString *> *)
                                                                            phoneNumberNameMap
@@ -271,6 +287,8 @@ NS_ASSUME_NONNULL_BEGIN
     OWSAssert(recipientId.length > 0);
     OWSAssert([self.textSecureIdentifiers containsObject:recipientId]);
 
+    // phoneNumberNameMap is filled in as the numbers are parsed.
+    [self parsedPhoneNumbers];
     NSString *value = self.phoneNumberNameMap[recipientId];
     OWSAssert(value);
     if (!value) {
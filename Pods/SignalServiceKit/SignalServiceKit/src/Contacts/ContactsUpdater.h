@@ -33,10 +33,24 @@ NS_ASSUME_NONNULL_BEGIN
                   success:(void (^)(NSArray<SignalRecipient *> *recipients))success
                   failure:(void (^)(NSError *error))failure;
 
+// Intersects incrementally (see below), unless the last full intersection
+// was more than a day ago.
 - (void)updateSignalContactIntersectionWithABContacts:(NSArray<Contact *> *)abContacts
                                               success:(void (^)())success
                                               failure:(void (^)(NSError *error))failure;
 
+// A full intersection sends every contact and existing recipient, and removes
+// recipients who are no longer registered.
+//
+// An incremental intersection only sends the contacts which haven't been
+// intersected before, so it is cheap for a large address book that hasn't
+// changed much. It won't notice existing contacts who have since registered
+// or unregistered; that is left to the next full intersection.
+- (void)updateSignalContactIntersectionWithABContacts:(NSArray<Contact *> *)abContacts
+                                          incremental:(BOOL)incremental
+                                              success:(void (^)())success
+                                              failure:(void (^)(NSError *error))failure;
+
 @end
 
 NS_ASSUME_NONNULL_END
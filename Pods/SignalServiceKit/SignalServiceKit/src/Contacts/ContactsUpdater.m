@@ -14,6 +14,19 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// identifier -> contact intersection token, for every identifier which has been intersected.
+NSString *const OWSContactsUpdaterTokenCollection = @"OWSContactsUpdaterTokenCollection";
+NSString *const OWSContactsUpdaterStateCollection = @"OWSContactsUpdaterStateCollection";
+NSString *const OWSContactsUpdaterLastFullIntersectionDateKey = @"lastFullIntersectionDate";
+
+// Incremental intersections only send identifiers which haven't been intersected before, so they can't
+// notice existing contacts who have since registered (or unregistered). A full intersection is done at
+// least this often to catch up.
+const NSTimeInterval kOWSContactsUpdaterFullIntersectionInterval = 24 * 60 * 60;
+
+// Below this, it isn't worth spreading hashing across threads.
+const NSUInteger kOWSContactsUpdaterHashingChunkLength = 256;
+
 @implementation ContactsUpdater
 
 + (instancetype)sharedUpdater {
@@ -113,6 +126,32 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)updateSignalContactIntersectionWithABContacts:(NSArray<Contact *> *)abContacts
                                               success:(void (^)())success
                                               failure:(void (^)(NSError *error))failure {
+    __block NSDate *_Nullable lastFullIntersectionDate;
+    [[TSStorageManager sharedManager].dbReadConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+        lastFullIntersectionDate = [transaction objectForKey:OWSContactsUpdaterLastFullIntersectionDateKey
+                                                inCollection:OWSContactsUpdaterStateCollection];
+    }];
+
+    BOOL incremental = (lastFullIntersectionDate != nil
+        && fabs(lastFullIntersectionDate.timeIntervalSinceNow) < kOWSContactsUpdaterFullIntersectionInterval);
+
+    [self updateSignalContactIntersectionWithABContacts:abContacts
+                                            incremental:incremental
+                                                success:success
+                                                failure:failure];
+}
+
+- (void)updateSignalContactIntersectionWithABContacts:(NSArray<Contact *> *)abContacts
+                                          incremental:(BOOL)incremental
+                                              success:(void (^)())success
+                                              failure:(void (^)(NSError *error))failure {
+    // Contacts parse their numbers lazily, so parse every contact's numbers in one batch first.
+    NSMutableArray<NSString *> *userTextPhoneNumbers = [NSMutableArray array];
+    for (Contact *contact in abContacts) {
+        [userTextPhoneNumbers addObjectsFromArray:contact.userTextPhoneNumbers];
+    }
+    [PhoneNumber preparsePhoneNumbersFromUserSpecifiedTexts:userTextPhoneNumbers];
+
     NSMutableSet<NSString *> *abPhoneNumbers = [NSMutableSet set];
 
     for (Contact *contact in abContacts) {
@@ -121,6 +160,38 @@ NS_ASSUME_NONNULL_BEGIN
         }
     }
 
+    if (incremental) {
+        // Only intersect the identifiers we haven't intersected before. Existing recipients were
+        // checked by the last full intersection, and will be again by the next one.
+        [[TSStorageManager sharedManager].dbReadConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+            NSArray<NSString *> *identifiers = abPhoneNumbers.allObjects;
+            [transaction enumerateObjectsForKeys:identifiers
+                                    inCollection:OWSContactsUpdaterTokenCollection
+                             unorderedUsingBlock:^(NSUInteger keyIndex, id _Nullable token, BOOL *stop) {
+                                 if (token) {
+                                     [abPhoneNumbers removeObject:identifiers[keyIndex]];
+                                 }
+                             }];
+        }];
+
+        if (abPhoneNumbers.count == 0) {
+            DDLogInfo(@"%@ no new contacts to intersect.", self.tag);
+            success();
+            return;
+        }
+
+        [self contactIntersectionWithSet:abPhoneNumbers
+                         pruneTokenCache:NO
+                                 success:^(NSSet<NSString *> *matchedIds) {
+                                     DDLogInfo(@"%@ successfully intersected %lu new contacts.",
+                                         self.tag,
+                                         (unsigned long)abPhoneNumbers.count);
+                                     success();
+                                 }
+                                 failure:failure];
+        return;
+    }
+
     NSMutableSet *recipientIds = [NSMutableSet set];
     [[TSStorageManager sharedManager].dbReadConnection
         readWithBlock:^(YapDatabaseReadTransaction *_Nonnull transaction) {
@@ -131,6 +202,7 @@ NS_ASSUME_NONNULL_BEGIN
     NSMutableSet<NSString *> *allContacts = [[abPhoneNumbers setByAddingObjectsFromSet:recipientIds] mutableCopy];
 
     [self contactIntersectionWithSet:allContacts
+                     pruneTokenCache:YES
                              success:^(NSSet<NSString *> *matchedIds) {
                                  [recipientIds minusSet:matchedIds];
 
@@ -152,15 +224,98 @@ NS_ASSUME_NONNULL_BEGIN
                              failure:failure];
 }
 
+#pragma mark - Tokens
+
+// Returns the contact intersection token for each identifier, using the token cache and hashing the rest
+// in parallel. The tokens which weren't cached are also added to uncachedTokens.
+- (NSDictionary<NSString *, NSString *> *)tokensForIdentifiers:(NSArray<NSString *> *)identifiers
+                                                uncachedTokens:(NSMutableDictionary<NSString *, NSString *> *)uncachedTokens
+{
+    NSMutableDictionary<NSString *, NSString *> *tokensByIdentifier =
+        [NSMutableDictionary dictionaryWithCapacity:identifiers.count];
+    NSMutableArray<NSString *> *uncachedIdentifiers = [NSMutableArray array];
+
+    [[TSStorageManager sharedManager].dbReadConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+        [transaction enumerateObjectsForKeys:identifiers
+                                inCollection:OWSContactsUpdaterTokenCollection
+                         unorderedUsingBlock:^(NSUInteger keyIndex, id _Nullable token, BOOL *stop) {
+                             if ([token isKindOfClass:[NSString class]]) {
+                                 tokensByIdentifier[identifiers[keyIndex]] = token;
+                             } else {
+                                 [uncachedIdentifiers addObject:identifiers[keyIndex]];
+                             }
+                         }];
+    }];
+
+    NSUInteger uncachedCount = uncachedIdentifiers.count;
+    if (uncachedCount == 0) {
+        return tokensByIdentifier;
+    }
+
+    // Hash contiguous chunks concurrently, and merge them afterwards.
+    NSUInteger chunkCount = MIN(MAX((NSUInteger)1, [NSProcessInfo processInfo].activeProcessorCount),
+        (uncachedCount + kOWSContactsUpdaterHashingChunkLength - 1) / kOWSContactsUpdaterHashingChunkLength);
+    NSUInteger chunkLength = (uncachedCount + chunkCount - 1) / chunkCount;
+
+    NSMutableArray<NSArray<NSString *> *> *chunkTokens = [NSMutableArray arrayWithCapacity:chunkCount];
+    for (NSUInteger chunk = 0; chunk < chunkCount; chunk++) {
+        [chunkTokens addObject:@[]];
+    }
+    NSLock *chunkTokensLock = [NSLock new];
+
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        NSUInteger start = chunk * chunkLength;
+        NSUInteger end = MIN(uncachedCount, start + chunkLength);
+
+        NSMutableArray<NSString *> *tokens = [NSMutableArray arrayWithCapacity:end - start];
+        for (NSUInteger i = start; i < end; i++) {
+            @autoreleasepool {
+                [tokens addObject:[Cryptography truncatedSHA1Base64EncodedWithoutPadding:uncachedIdentifiers[i]]];
+            }
+        }
+
+        [chunkTokensLock lock];
+        chunkTokens[chunk] = tokens;
+        [chunkTokensLock unlock];
+    });
+
+    NSUInteger index = 0;
+    for (NSArray<NSString *> *tokens in chunkTokens) {
+        for (NSString *token in tokens) {
+            NSString *identifier = uncachedIdentifiers[index++];
+            tokensByIdentifier[identifier] = token;
+            uncachedTokens[identifier] = token;
+        }
+    }
+    OWSAssert(index == uncachedCount);
+
+    return tokensByIdentifier;
+}
+
+#pragma mark - Intersection
+
 - (void)contactIntersectionWithSet:(NSSet<NSString *> *)idSet
                            success:(void (^)(NSSet<NSString *> *matchedIds))success
                            failure:(void (^)(NSError *error))failure {
+    [self contactIntersectionWithSet:idSet pruneTokenCache:NO success:success failure:failure];
+}
+
+// Tokens are only cached once their identifiers have been intersected, so that incremental intersections
+// know which identifiers are new. If pruneTokenCache is YES, idSet is taken to be every identifier we
+// care about, and tokens for any others are dropped.
+- (void)contactIntersectionWithSet:(NSSet<NSString *> *)idSet
+                   pruneTokenCache:(BOOL)pruneTokenCache
+                           success:(void (^)(NSSet<NSString *> *matchedIds))success
+                           failure:(void (^)(NSError *error))failure {
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-      NSMutableDictionary *phoneNumbersByHashes = [NSMutableDictionary dictionary];
-      for (NSString *identifier in idSet) {
-          [phoneNumbersByHashes setObject:identifier
-                                   forKey:[Cryptography truncatedSHA1Base64EncodedWithoutPadding:identifier]];
-      }
+      NSMutableDictionary<NSString *, NSString *> *uncachedTokens = [NSMutableDictionary dictionary];
+      NSDictionary<NSString *, NSString *> *tokensByIdentifier =
+          [self tokensForIdentifiers:idSet.allObjects uncachedTokens:uncachedTokens];
+
+      NSMutableDictionary *phoneNumbersByHashes = [NSMutableDictionary dictionaryWithCapacity:tokensByIdentifier.count];
+      [tokensByIdentifier enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSString *token, BOOL *stop) {
+          phoneNumbersByHashes[token] = identifier;
+      }];
       NSArray *hashes = [phoneNumbersByHashes allKeys];
 
       TSRequest *request = [[TSContactsIntersectionRequest alloc] initWithHashesArray:hashes];
@@ -200,6 +355,27 @@ NS_ASSUME_NONNULL_BEGIN
 
                           [recipient saveWithTransaction:transaction];
                       }
+
+                      [uncachedTokens enumerateKeysAndObjectsUsingBlock:^(
+                          NSString *identifier, NSString *token, BOOL *stop) {
+                          [transaction setObject:token forKey:identifier inCollection:OWSContactsUpdaterTokenCollection];
+                      }];
+
+                      if (pruneTokenCache) {
+                          NSMutableArray<NSString *> *staleIdentifiers = [NSMutableArray array];
+                          [transaction enumerateKeysInCollection:OWSContactsUpdaterTokenCollection
+                                                      usingBlock:^(NSString *identifier, BOOL *stop) {
+                                                          if (!tokensByIdentifier[identifier]) {
+                                                              [staleIdentifiers addObject:identifier];
+                                                          }
+                                                      }];
+                          [transaction removeObjectsForKeys:staleIdentifiers
+                                               inCollection:OWSContactsUpdaterTokenCollection];
+
+                          [transaction setObject:[NSDate new]
+                                          forKey:OWSContactsUpdaterLastFullIntersectionDateKey
+                                    inCollection:OWSContactsUpdaterStateCollection];
+                      }
                   }];
 
               success([NSSet setWithArray:attributesForIdentifier.allKeys]);
@@ -26,6 +26,11 @@
 + (NSArray<PhoneNumber *> *)tryParsePhoneNumbersFromsUserSpecifiedText:(NSString *)text
                                                      clientPhoneNumber:(NSString *)clientPhoneNumber;
 
+// Parses everything that tryParsePhoneNumbersFromsUserSpecifiedText:clientPhoneNumber: would parse for
+// each of the texts in one batch, on several threads. The results are cached, so that the subsequent
+// calls for these texts don't have to parse again.
++ (void)preparsePhoneNumbersFromUserSpecifiedTexts:(NSArray<NSString *> *)texts;
+
 + (NSString *)removeFormattingCharacters:(NSString *)inputString;
 + (NSString *)bestEffortFormatPartialUserSpecifiedTextToLookLikeAPhoneNumber:(NSString *)input;
 + (NSString *)bestEffortFormatPartialUserSpecifiedTextToLookLikeAPhoneNumber:(NSString *)input
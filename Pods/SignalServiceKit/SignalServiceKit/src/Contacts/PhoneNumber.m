@@ -223,6 +223,26 @@ static NSString *const RPDefaultsKeyPhoneNumberCanonical = @"RPDefaultsKeyPhoneN
     return [result copy];
 }
 
++ (void)preparsePhoneNumbersFromUserSpecifiedTexts:(NSArray<NSString *> *)texts
+{
+    // These must match the texts tryParsePhoneNumbersFromNormalizedText:clientPhoneNumber: parses.
+    NSMutableArray<NSString *> *numbersToParse = [NSMutableArray arrayWithCapacity:texts.count * 2];
+    for (NSString *text in texts) {
+        NSString *trimmedText = [text stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if ([trimmedText isEqualToString:@""]) {
+            continue;
+        }
+
+        NSString *sanitizedString = [self removeFormattingCharacters:trimmedText];
+        [numbersToParse addObject:sanitizedString];
+        if (![sanitizedString hasPrefix:@"+"]) {
+            [numbersToParse addObject:[NSString stringWithFormat:@"+%@", sanitizedString]];
+        }
+    }
+
+    [[PhoneNumberUtil sharedUtil] cacheParsedNumbers:numbersToParse defaultRegion:[self defaultRegionCode]];
+}
+
 + (NSArray<PhoneNumber *> *)tryParsePhoneNumbersFromNormalizedText:(NSString *)text
                                                  clientPhoneNumber:(NSString *)clientPhoneNumber
 {
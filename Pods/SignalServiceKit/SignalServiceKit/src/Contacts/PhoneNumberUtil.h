@@ -31,8 +31,22 @@
 + (instancetype)sharedUtil;
 
 - (NBPhoneNumber *)parse:(NSString *)numberToParse defaultRegion:(NSString *)defaultRegion error:(NSError **)error;
+
+// Parses the numbers which aren't already cached on several threads, and caches the ones which parse, so that
+// subsequent calls to parse:defaultRegion:error: for them are cache hits.
+- (void)cacheParsedNumbers:(NSArray<NSString *> *)numbersToParse defaultRegion:(NSString *)defaultRegion;
 - (NSString *)format:(NBPhoneNumber *)phoneNumber
         numberFormat:(NBEPhoneNumberFormat)numberFormat
                error:(NSError **)error;
 
+#ifdef DEBUG
+
+/**
+ * Parses a synthetic address book, one number at a time and with the batch API,
+ * and logs the timings.
+ */
++ (void)logParsingBenchmarkWithPhoneNumberCount:(NSUInteger)phoneNumberCount;
+
+#endif
+
 @end
@@ -42,11 +42,16 @@
     return self;
 }
 
+- (NSString *)parsedPhoneNumberCacheKeyForNumber:(NSString *)numberToParse defaultRegion:(NSString *)defaultRegion
+{
+    return [NSString stringWithFormat:@"numberToParse:%@defaultRegion:%@", numberToParse, defaultRegion];
+}
+
 - (nullable NBPhoneNumber *)parse:(NSString *)numberToParse
                     defaultRegion:(NSString *)defaultRegion
                             error:(NSError **)error
 {
-    NSString *hashKey = [NSString stringWithFormat:@"numberToParse:%@defaultRegion:%@", numberToParse, defaultRegion];
+    NSString *hashKey = [self parsedPhoneNumberCacheKeyForNumber:numberToParse defaultRegion:defaultRegion];
 
     NBPhoneNumber *result = [self.parsedPhoneNumberCache objectForKey:hashKey];
 
@@ -73,6 +78,34 @@
     }
 }
 
+- (void)cacheParsedNumbers:(NSArray<NSString *> *)numbersToParse defaultRegion:(NSString *)defaultRegion
+{
+    NSMutableArray<NSString *> *uncachedNumbers = [NSMutableArray array];
+    NSMutableArray<NSString *> *uncachedKeys = [NSMutableArray array];
+    for (NSString *numberToParse in [NSOrderedSet orderedSetWithArray:numbersToParse]) {
+        NSString *hashKey = [self parsedPhoneNumberCacheKeyForNumber:numberToParse defaultRegion:defaultRegion];
+        if (![self.parsedPhoneNumberCache objectForKey:hashKey]) {
+            [uncachedNumbers addObject:numberToParse];
+            [uncachedKeys addObject:hashKey];
+        }
+    }
+
+    if (uncachedNumbers.count == 0) {
+        return;
+    }
+
+    // parseNumbers:defaultRegion: drops the errors, so failures aren't cached; parse:defaultRegion:error: will
+    // parse them again to report the error.
+    NSArray *results = [self.nbPhoneNumberUtil parseNumbers:uncachedNumbers defaultRegion:defaultRegion];
+    OWSAssert(results.count == uncachedNumbers.count);
+
+    [results enumerateObjectsUsingBlock:^(id result, NSUInteger index, BOOL *stop) {
+        if ([result isKindOfClass:[NBPhoneNumber class]]) {
+            [self.parsedPhoneNumberCache setObject:result forKey:uncachedKeys[index]];
+        }
+    }];
+}
+
 - (NSString *)format:(NBPhoneNumber *)phoneNumber
         numberFormat:(NBEPhoneNumberFormat)numberFormat
                error:(NSError **)error
@@ -598,4 +631,81 @@
     return result;
 }
 
+#ifdef DEBUG
+
++ (void)logParsingBenchmarkWithPhoneNumberCount:(NSUInteger)phoneNumberCount
+{
+    OWSAssert(phoneNumberCount > 0);
+
+    // The ways numbers tend to be written in an address book.
+    NSArray<NSString *> *formats = @[
+        @"(%03u) %03u-%04u",
+        @"%03u-%03u-%04u",
+        @"%03u.%03u.%04u",
+        @"+1 %03u %03u %04u",
+        @"+1 (%03u) %03u-%04u",
+        @"1%03u%03u%04u",
+        @"%03u%03u%04u",
+        @"+1-%03u-%03u-%04u ext. 12",
+    ];
+
+    NSMutableArray<NSString *> *phoneNumbers = [NSMutableArray arrayWithCapacity:phoneNumberCount];
+    for (NSUInteger i = 0; i < phoneNumberCount; i++) {
+        NSString *format = formats[i % formats.count];
+        [phoneNumbers addObject:[NSString stringWithFormat:format,
+                                          200 + arc4random_uniform(800),
+                                          200 + arc4random_uniform(800),
+                                          arc4random_uniform(10000)]];
+    }
+
+    // Use fresh utils, so that neither run benefits from the other's caches.
+    NBPhoneNumberUtil *serialUtil = [NBPhoneNumberUtil new];
+    NSUInteger serialParsedCount = 0;
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (NSString *phoneNumber in phoneNumbers) {
+        @autoreleasepool {
+            NSError *error;
+            if ([serialUtil parse:phoneNumber defaultRegion:@"US" error:&error] && !error) {
+                serialParsedCount++;
+            }
+        }
+    }
+    CFAbsoluteTime serialTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+    NBPhoneNumberUtil *batchUtil = [NBPhoneNumberUtil new];
+    startTime = CFAbsoluteTimeGetCurrent();
+    NSArray *batchResults = [batchUtil parseNumbers:phoneNumbers defaultRegion:@"US"];
+    CFAbsoluteTime batchTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+    NSUInteger batchParsedCount = 0;
+    for (id result in batchResults) {
+        if (![result isKindOfClass:[NSNull class]]) {
+            batchParsedCount++;
+        }
+    }
+    OWSAssert(batchResults.count == phoneNumbers.count);
+    OWSAssert(batchParsedCount == serialParsedCount);
+
+    DDLogInfo(@"%@ Benchmark (%lu numbers): parse %.1fms, parseNumbers %.1fms, %lu parsed",
+        self.tag,
+        (unsigned long)phoneNumberCount,
+        serialTime * 1000,
+        batchTime * 1000,
+        (unsigned long)batchParsedCount);
+}
+
+#endif
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
 @end
@@ -68,7 +68,7 @@ NS_ASSUME_NONNULL_BEGIN
     TSThread *thread = [transcript threadWithTransaction:transaction];
     if (transcript.isEndSessionMessage) {
         DDLogInfo(@"%@ EndSession was sent to recipient: %@.", self.tag, transcript.recipientId);
-        dispatch_async([OWSDispatch sessionStoreQueue], ^{
+        dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
             [self.storageManager deleteAllSessionsForContact:transcript.recipientId];
         });
         [[[TSInfoMessage alloc] initWithTimestamp:transcript.timestamp
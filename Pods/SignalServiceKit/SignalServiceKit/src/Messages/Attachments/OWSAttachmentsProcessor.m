@@ -197,13 +197,13 @@ static const CGFloat kAttachmentDownloadProgressTheta = 0.001f;
             dispatch_async([OWSDispatch attachmentsQueue], ^{
                 [self downloadFromLocation:location
                     pointer:attachment
-                    success:^(NSData *_Nonnull encryptedData) {
-                        [self decryptAttachmentData:encryptedData
-                                            pointer:attachment
-                                            success:markAndHandleSuccess
-                                            failure:markAndHandleFailure];
+                    success:^(NSString *_Nonnull encryptedFilePath) {
+                        [self decryptAttachmentAtPath:encryptedFilePath
+                                              pointer:attachment
+                                              success:markAndHandleSuccess
+                                              failure:markAndHandleFailure];
                     }
-                    failure:^(NSURLSessionDataTask *_Nullable task, NSError *_Nonnull error) {
+                    failure:^(NSURLSessionTask *_Nullable task, NSError *_Nonnull error) {
                         if (attachment.serverId < 100) {
                             // This looks like the symptom of the "frequent 404
                             // downloading attachments with low server ids".
@@ -241,37 +241,37 @@ static const CGFloat kAttachmentDownloadProgressTheta = 0.001f;
         }];
 }
 
-- (void)decryptAttachmentData:(NSData *)cipherText
-                      pointer:(TSAttachmentPointer *)attachment
-                      success:(void (^)(TSAttachmentStream *attachmentStream))successHandler
-                      failure:(void (^)(NSError *error))failureHandler
+- (void)decryptAttachmentAtPath:(NSString *)encryptedFilePath
+                        pointer:(TSAttachmentPointer *)attachment
+                        success:(void (^)(TSAttachmentStream *attachmentStream))successHandler
+                        failure:(void (^)(NSError *error))failureHandler
 {
-    NSError *decryptError;
-    NSData *plaintext = [Cryptography decryptAttachment:cipherText
-                                                withKey:attachment.encryptionKey
-                                                 digest:attachment.digest
-                                           unpaddedSize:attachment.byteCount
-                                                  error:&decryptError];
-
-    if (decryptError) {
-        DDLogError(@"%@ failed to decrypt with error: %@", self.tag, decryptError);
-        failureHandler(decryptError);
-        return;
-    }
-
-    if (!plaintext) {
+    TSAttachmentStream *stream = [[TSAttachmentStream alloc] initWithPointer:attachment];
+    NSString *_Nullable filePath = stream.filePath;
+    if (!filePath) {
+        OWSFail(@"%@ Missing path for attachment.", self.tag);
+        [[NSFileManager defaultManager] removeItemAtPath:encryptedFilePath error:nil];
         NSError *error = OWSErrorWithCodeDescription(OWSErrorCodeFailedToDecryptMessage, NSLocalizedString(@"ERROR_MESSAGE_INVALID_MESSAGE", @""));
         failureHandler(error);
         return;
     }
 
-    TSAttachmentStream *stream = [[TSAttachmentStream alloc] initWithPointer:attachment];
-
-    NSError *writeError;
-    [stream writeData:plaintext error:&writeError];
-    if (writeError) {
-        DDLogError(@"%@ Failed writing attachment stream with error: %@", self.tag, writeError);
-        failureHandler(writeError);
+    // Decrypt straight from the downloaded file into the attachment file, so we never
+    // hold the whole attachment in memory.
+    DDLogInfo(@"%@ Writing attachment to file: %@", self.tag, filePath);
+    NSError *decryptError;
+    BOOL success = [Cryptography decryptAttachmentAtPath:encryptedFilePath
+                                                  toPath:filePath
+                                                 withKey:attachment.encryptionKey
+                                                  digest:attachment.digest
+                                            unpaddedSize:attachment.byteCount
+                                                   error:&decryptError];
+    [[NSFileManager defaultManager] removeItemAtPath:encryptedFilePath error:nil];
+
+    if (!success) {
+        DDLogError(@"%@ failed to decrypt with error: %@", self.tag, decryptError);
+        NSError *error = decryptError ?: OWSErrorWithCodeDescription(OWSErrorCodeFailedToDecryptMessage, NSLocalizedString(@"ERROR_MESSAGE_INVALID_MESSAGE", @""));
+        failureHandler(error);
         return;
     }
 
@@ -281,8 +281,8 @@ static const CGFloat kAttachmentDownloadProgressTheta = 0.001f;
 
 - (void)downloadFromLocation:(NSString *)location
                      pointer:(TSAttachmentPointer *)pointer
-                     success:(void (^)(NSData *encryptedData))successHandler
-                     failure:(void (^)(NSURLSessionDataTask *_Nullable task, NSError *_Nonnull error))failureHandler
+                     success:(void (^)(NSString *encryptedFilePath))successHandler
+                     failure:(void (^)(NSURLSessionTask *_Nullable task, NSError *_Nonnull error))failureHandler
 {
     AFHTTPSessionManager *manager = [AFHTTPSessionManager manager];
     manager.requestSerializer     = [AFHTTPRequestSerializer serializer];
@@ -290,13 +290,24 @@ static const CGFloat kAttachmentDownloadProgressTheta = 0.001f;
     manager.responseSerializer = [AFHTTPResponseSerializer serializer];
     manager.completionQueue    = dispatch_get_main_queue();
 
+    NSError *requestError;
+    NSMutableURLRequest *request =
+        [manager.requestSerializer requestWithMethod:@"GET" URLString:location parameters:nil error:&requestError];
+    if (!request) {
+        DDLogError(@"%@ Failed to build attachment download request: %@", self.tag, requestError);
+        return failureHandler(nil, requestError ?: OWSErrorMakeUnableToProcessServerResponseError());
+    }
+
+    // The encrypted attachment is streamed to a temporary file rather than
+    // buffered in memory.
+    NSString *encryptedFilePath =
+        [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+
     // We want to avoid large downloads from a compromised or buggy service.
     const long kMaxDownloadSize = 150 * 1024 * 1024;
-    // TODO stream this download rather than storing the entire blob.
-    __block NSURLSessionDataTask *task = nil;
+    __block NSURLSessionDownloadTask *task = nil;
     __block BOOL hasCheckedContentLength = NO;
-    task = [manager GET:location
-        parameters:nil
+    task = [manager downloadTaskWithRequest:request
         progress:^(NSProgress *_Nonnull progress) {
             OWSAssert(progress != nil);
             
@@ -375,22 +386,27 @@ static const CGFloat kAttachmentDownloadProgressTheta = 0.001f;
             // than our max download size.  Proceed with the download.
             hasCheckedContentLength = YES;
         }
-        success:^(NSURLSessionDataTask *_Nonnull task, id _Nullable responseObject) {
+        destination:^NSURL *_Nonnull(NSURL *_Nonnull targetPath, NSURLResponse *_Nonnull response) {
+            return [NSURL fileURLWithPath:encryptedFilePath];
+        }
+        completionHandler:^(NSURLResponse *_Nonnull response, NSURL *_Nullable filePath, NSError *_Nullable error) {
             dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-                if (![responseObject isKindOfClass:[NSData class]]) {
-                    DDLogError(@"%@ Failed retrieval of attachment. Response had unexpected format.", self.tag);
-                    NSError *error = OWSErrorMakeUnableToProcessServerResponseError();
+                if (error) {
+                    DDLogError(@"Failed to retrieve attachment with error: %@", error.description);
+                    [[NSFileManager defaultManager] removeItemAtPath:encryptedFilePath error:nil];
                     return failureHandler(task, error);
                 }
-                successHandler((NSData *)responseObject);
-            });
-        }
-        failure:^(NSURLSessionDataTask *_Nullable task, NSError *_Nonnull error) {
-            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-                DDLogError(@"Failed to retrieve attachment with error: %@", error.description);
-                return failureHandler(task, error);
+                NSInteger statusCode = ((NSHTTPURLResponse *)response).statusCode;
+                if (statusCode < 200 || statusCode >= 300 || !filePath) {
+                    DDLogError(@"%@ Failed retrieval of attachment. Response had unexpected format.", self.tag);
+                    [[NSFileManager defaultManager] removeItemAtPath:encryptedFilePath error:nil];
+                    NSError *responseError = OWSErrorMakeUnableToProcessServerResponseError();
+                    return failureHandler(task, responseError);
+                }
+                successHandler(filePath.path);
             });
         }];
+    [task resume];
 }
 
 - (void)fireProgressNotification:(CGFloat)progress attachmentId:(NSString *)attachmentId
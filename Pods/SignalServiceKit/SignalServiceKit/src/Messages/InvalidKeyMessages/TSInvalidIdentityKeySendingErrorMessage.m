@@ -57,7 +57,7 @@ NSString *TSInvalidRecipientKey = @"TSInvalidRecipientKey";
         return;
     }
 
-    dispatch_async([OWSDispatch sessionStoreQueue], ^{
+    dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
         [[OWSIdentityManager sharedManager] saveRemoteIdentity:newIdentityKey recipientId:self.recipientId];
     });
 }
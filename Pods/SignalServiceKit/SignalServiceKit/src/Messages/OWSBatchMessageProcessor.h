@@ -6,6 +6,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class OWSSignalServiceProtosEnvelope;
 @class YapDatabase;
+@class YapDatabaseReadWriteTransaction;
 
 // This class is used to write incoming (decrypted, unprocessed)
 // messages to a durable queue and then process them in batches,
@@ -16,8 +17,33 @@ NS_ASSUME_NONNULL_BEGIN
 + (void)syncRegisterDatabaseExtension:(YapDatabase *)database;
 
 - (void)enqueueEnvelopeData:(NSData *)envelopeData plaintextData:(NSData *_Nullable)plaintextData;
+
+/**
+ * Jobs are processed in createdAt order. Pass the time the envelope was received so that envelopes which finish
+ * decrypting out of order are still processed in the order they arrived.
+ */
+- (void)enqueueEnvelopeData:(NSData *)envelopeData
+               plaintextData:(NSData *_Nullable)plaintextData
+                   createdAt:(NSDate *)createdAt;
+/**
+ * Saves the job in the caller's transaction, so that it commits atomically with the caller's own writes, e.g. removing
+ * the decrypt job it came from. Processing starts once the transaction has committed.
+ */
+- (void)enqueueEnvelopeData:(NSData *)envelopeData
+               plaintextData:(NSData *_Nullable)plaintextData
+                   createdAt:(NSDate *)createdAt
+                 transaction:(YapDatabaseReadWriteTransaction *)transaction;
 - (void)handleAnyUnprocessedEnvelopesAsync;
 
+// Counters for the processing queue. Batches are sized from the queue depth
+// and the measured transaction duration; these reflect the sizes and commit
+// times actually observed.
+@property (atomic, readonly) NSUInteger batchCount;
+@property (atomic, readonly) NSUInteger processedJobCount;
+@property (atomic, readonly) NSUInteger lastBatchSize;
+@property (atomic, readonly) NSTimeInterval lastBatchDuration;
+@property (atomic, readonly) NSTimeInterval totalBatchDuration;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -30,7 +30,8 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly, nullable) NSData *plaintextData;
 
 - (instancetype)initWithEnvelopeData:(NSData *)envelopeData
-                       plaintextData:(NSData *_Nullable)plaintextData NS_DESIGNATED_INITIALIZER;
+                       plaintextData:(NSData *_Nullable)plaintextData
+                           createdAt:(NSDate *)createdAt NS_DESIGNATED_INITIALIZER;
 - (nullable instancetype)initWithCoder:(NSCoder *)coder NS_DESIGNATED_INITIALIZER;
 - (instancetype)initWithUniqueId:(NSString *)uniqueId NS_UNAVAILABLE;
 - (OWSSignalServiceProtosEnvelope *)envelopeProto;
@@ -46,9 +47,12 @@ NS_ASSUME_NONNULL_BEGIN
     return @"OWSBatchMessageProcessingJob";
 }
 
-- (instancetype)initWithEnvelopeData:(NSData *)envelopeData plaintextData:(NSData *_Nullable)plaintextData
+- (instancetype)initWithEnvelopeData:(NSData *)envelopeData
+                       plaintextData:(NSData *_Nullable)plaintextData
+                           createdAt:(NSDate *)createdAt
 {
     OWSAssert(envelopeData);
+    OWSAssert(createdAt);
 
     self = [super initWithUniqueId:[NSUUID new].UUIDString];
     if (!self) {
@@ -57,7 +61,7 @@ NS_ASSUME_NONNULL_BEGIN
 
     _envelopeData = envelopeData;
     _plaintextData = plaintextData;
-    _createdAt = [NSDate new];
+    _createdAt = createdAt;
 
     return self;
 }
@@ -132,21 +136,43 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
     return [jobs copy];
 }
 
-- (void)addJobWithEnvelopeData:(NSData *)envelopeData plaintextData:(NSData *_Nullable)plaintextData
+- (void)addJobWithEnvelopeData:(NSData *)envelopeData
+                 plaintextData:(NSData *_Nullable)plaintextData
+                     createdAt:(NSDate *)createdAt
 {
     // We need to persist the decrypted envelope data ASAP to prevent data loss.
     [self.dbConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *_Nonnull transaction) {
-        OWSMessageContentJob *job =
-        [[OWSMessageContentJob alloc] initWithEnvelopeData:envelopeData plaintextData:plaintextData];
-        [job saveWithTransaction:transaction];
+        [self addJobWithEnvelopeData:envelopeData
+                       plaintextData:plaintextData
+                           createdAt:createdAt
+                         transaction:transaction];
     }];
 }
 
-- (void)removeJobsWithIds:(NSArray<NSString *> *)uniqueIds
+- (void)addJobWithEnvelopeData:(NSData *)envelopeData
+                 plaintextData:(NSData *_Nullable)plaintextData
+                     createdAt:(NSDate *)createdAt
+                   transaction:(YapDatabaseReadWriteTransaction *)transaction
 {
-    [self.dbConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *_Nonnull transaction) {
-        [transaction removeObjectsForKeys:uniqueIds inCollection:[OWSMessageContentJob collection]];
+    OWSMessageContentJob *job =
+        [[OWSMessageContentJob alloc] initWithEnvelopeData:envelopeData plaintextData:plaintextData createdAt:createdAt];
+    [job saveWithTransaction:transaction];
+}
+
+- (NSUInteger)jobCount
+{
+    __block NSUInteger jobCount = 0;
+    [self.dbConnection readWithBlock:^(YapDatabaseReadTransaction *_Nonnull transaction) {
+        YapDatabaseViewTransaction *viewTransaction = [transaction ext:OWSMessageContentJobFinderExtensionName];
+        OWSAssert(viewTransaction != nil);
+        jobCount = [viewTransaction numberOfItemsInGroup:OWSMessageContentJobFinderExtensionGroup];
     }];
+    return jobCount;
+}
+
+- (void)removeJobsWithIds:(NSArray<NSString *> *)uniqueIds transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    [transaction removeObjectsForKeys:uniqueIds inCollection:[OWSMessageContentJob collection]];
 }
 
 + (YapDatabaseView *)databaseExtension
@@ -225,6 +251,18 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
 
 #pragma mark - Queue Processing
 
+// Bounds for the adaptive batch size.
+static const NSUInteger kIncomingMessageBatchSizeMin = 8;
+static const NSUInteger kIncomingMessageBatchSizeMax = 512;
+
+// Each batch is processed in a single write transaction, which blocks other
+// writers. We size batches so that a transaction takes roughly this long.
+static const NSTimeInterval kIncomingMessageBatchTargetDuration = 0.1f;
+
+// When only a handful of jobs are left, wait this long in hopes of
+// increasing the batch size.
+static const NSTimeInterval kIncomingMessageBatchCoalesceInterval = 0.1f;
+
 @interface OWSMessageContentQueue : NSObject
 
 @property (nonatomic, readonly) OWSMessageManager *messagesManager;
@@ -232,6 +270,17 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
 @property (nonatomic, readonly) OWSMessageContentJobFinder *finder;
 @property (nonatomic) BOOL isDrainingQueue;
 
+// Moving average of the time it takes to process a single job.
+// Only accessed on the serial queue.
+@property (nonatomic) NSTimeInterval averageJobDuration;
+
+// Counters. Written on the serial queue, may be read from any thread.
+@property (atomic) NSUInteger batchCount;
+@property (atomic) NSUInteger processedJobCount;
+@property (atomic) NSUInteger lastBatchSize;
+@property (atomic) NSTimeInterval lastBatchDuration;
+@property (atomic) NSTimeInterval totalBatchDuration;
+
 - (instancetype)initWithMessagesManager:(OWSMessageManager *)messagesManager
                          storageManager:(TSStorageManager *)storageManager
                                  finder:(OWSMessageContentJobFinder *)finder NS_DESIGNATED_INITIALIZER;
@@ -256,6 +305,7 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
 
     _messagesManager = messagesManager;
     _dbReadWriteConnection = [storageManager newDatabaseConnection];
+    _dbReadWriteConnection.coalescesChangesets = YES;
     _finder = finder;
     _isDrainingQueue = NO;
 
@@ -289,12 +339,14 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
     return queue;
 }
 
-- (void)enqueueEnvelopeData:(NSData *)envelopeData plaintextData:(NSData *_Nullable)plaintextData
+- (void)enqueueEnvelopeData:(NSData *)envelopeData
+               plaintextData:(NSData *_Nullable)plaintextData
+                   createdAt:(NSDate *)createdAt
 {
     OWSAssert(envelopeData);
 
     // We need to persist the decrypted envelope data ASAP to prevent data loss.
-    [self.finder addJobWithEnvelopeData:envelopeData plaintextData:plaintextData];
+    [self.finder addJobWithEnvelopeData:envelopeData plaintextData:plaintextData createdAt:createdAt];
 }
 
 - (void)drainQueue
@@ -315,14 +367,34 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
     });
 }
 
+- (NSUInteger)batchSizeForJobCount:(NSUInteger)jobCount
+{
+    AssertOnDispatchQueue(self.serialQueue);
+
+    // Until we've measured anything, start with a small batch.
+    NSUInteger batchSize = kIncomingMessageBatchSizeMin;
+    if (self.averageJobDuration > 0) {
+        batchSize = (NSUInteger)(kIncomingMessageBatchTargetDuration / self.averageJobDuration);
+    }
+    batchSize = MAX(kIncomingMessageBatchSizeMin, MIN(kIncomingMessageBatchSizeMax, batchSize));
+
+    // Don't ask for more jobs than are queued.
+    return MAX((NSUInteger)1, MIN(jobCount, batchSize));
+}
+
 - (void)drainQueueWorkStep
 {
     AssertOnDispatchQueue(self.serialQueue);
 
-    // We want a value that is just high enough to yield perf benefits.
-    const NSUInteger kIncomingMessageBatchSize = 32;
+    NSUInteger jobCount = [self.finder jobCount];
+    if (jobCount < 1) {
+        self.isDrainingQueue = NO;
+        DDLogVerbose(@"%@ Queue is drained", self.tag);
+        return;
+    }
 
-    NSArray<OWSMessageContentJob *> *jobs = [self.finder nextJobsForBatchSize:kIncomingMessageBatchSize];
+    NSUInteger batchSize = [self batchSizeForJobCount:jobCount];
+    NSArray<OWSMessageContentJob *> *jobs = [self.finder nextJobsForBatchSize:batchSize];
     OWSAssert(jobs);
     if (jobs.count < 1) {
         self.isDrainingQueue = NO;
@@ -330,34 +402,72 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
         return;
     }
 
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
     [self processJobs:jobs];
+    NSTimeInterval batchDuration = CFAbsoluteTimeGetCurrent() - startTime;
 
-    [self.finder removeJobsWithIds:jobs.uniqueIds];
+    [self updateCountersWithBatchSize:jobs.count batchDuration:batchDuration];
 
-    DDLogVerbose(@"%@ completed %zd jobs. %zd jobs left.",
+    NSUInteger remainingJobCount = jobCount > jobs.count ? jobCount - jobs.count : 0;
+    DDLogVerbose(@"%@ completed %zd jobs in %0.3fs. ~%zd jobs left.",
                  self.tag,
                  jobs.count,
-                 [OWSMessageContentJob numberOfKeysInCollection]);
+                 batchDuration,
+                 remainingJobCount);
+
+    if (remainingJobCount >= kIncomingMessageBatchSizeMin) {
+        // There's a backlog; drain it back-to-back.
+        dispatch_async(self.serialQueue, ^{
+            [self drainQueueWorkStep];
+        });
+    } else {
+        // We're nearly idle. Wait a bit in hopes of increasing the batch size.
+        // This delay won't affect the first message to arrive when this queue is idle,
+        // so by definition we're receiving more than one message and can benefit from
+        // batching.
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kIncomingMessageBatchCoalesceInterval * NSEC_PER_SEC)),
+            self.serialQueue,
+            ^{
+                [self drainQueueWorkStep];
+            });
+    }
+}
 
-    // Wait a bit in hopes of increasing the batch size.
-    // This delay won't affect the first message to arrive when this queue is idle,
-    // so by definition we're receiving more than one message and can benefit from
-    // batching.
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5f * NSEC_PER_SEC)), self.serialQueue, ^{
-        [self drainQueueWorkStep];
-    });
+- (void)updateCountersWithBatchSize:(NSUInteger)batchSize batchDuration:(NSTimeInterval)batchDuration
+{
+    AssertOnDispatchQueue(self.serialQueue);
+    OWSAssert(batchSize > 0);
+
+    NSTimeInterval jobDuration = batchDuration / batchSize;
+    if (self.averageJobDuration > 0) {
+        // Exponential moving average, so that the batch size tracks changes
+        // in load (e.g. attachment-heavy batches) without thrashing.
+        const double kSmoothingFactor = 0.25;
+        self.averageJobDuration = kSmoothingFactor * jobDuration + (1 - kSmoothingFactor) * self.averageJobDuration;
+    } else {
+        self.averageJobDuration = jobDuration;
+    }
+
+    self.batchCount = self.batchCount + 1;
+    self.processedJobCount = self.processedJobCount + batchSize;
+    self.lastBatchSize = batchSize;
+    self.lastBatchDuration = batchDuration;
+    self.totalBatchDuration = self.totalBatchDuration + batchDuration;
 }
 
 - (void)processJobs:(NSArray<OWSMessageContentJob *> *)jobs
 {
     AssertOnDispatchQueue(self.serialQueue);
 
+    // Process the jobs and remove them from the queue in the same transaction,
+    // so each batch costs a single commit.
     [self.dbReadWriteConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
         for (OWSMessageContentJob *job in jobs) {
             [self.messagesManager processEnvelope:job.envelopeProto
                                     plaintextData:job.plaintextData
                                       transaction:transaction];
         }
+        [self.finder removeJobsWithIds:jobs.uniqueIds transaction:transaction];
     }];
 }
 
@@ -445,15 +555,67 @@ NSString *const OWSMessageContentJobFinderExtensionGroup = @"OWSMessageContentJo
     [self.processingQueue drainQueue];
 }
 
+#pragma mark - Counters
+
+- (NSUInteger)batchCount
+{
+    return self.processingQueue.batchCount;
+}
+
+- (NSUInteger)processedJobCount
+{
+    return self.processingQueue.processedJobCount;
+}
+
+- (NSUInteger)lastBatchSize
+{
+    return self.processingQueue.lastBatchSize;
+}
+
+- (NSTimeInterval)lastBatchDuration
+{
+    return self.processingQueue.lastBatchDuration;
+}
+
+- (NSTimeInterval)totalBatchDuration
+{
+    return self.processingQueue.totalBatchDuration;
+}
+
 - (void)enqueueEnvelopeData:(NSData *)envelopeData plaintextData:(NSData *_Nullable)plaintextData
+{
+    [self enqueueEnvelopeData:envelopeData plaintextData:plaintextData createdAt:[NSDate new]];
+}
+
+- (void)enqueueEnvelopeData:(NSData *)envelopeData
+               plaintextData:(NSData *_Nullable)plaintextData
+                   createdAt:(NSDate *)createdAt
 {
     OWSAssert(envelopeData);
 
     // We need to persist the decrypted envelope data ASAP to prevent data loss.
-    [self.processingQueue enqueueEnvelopeData:envelopeData plaintextData:plaintextData];
+    [self.processingQueue enqueueEnvelopeData:envelopeData plaintextData:plaintextData createdAt:createdAt];
     [self.processingQueue drainQueue];
 }
 
+- (void)enqueueEnvelopeData:(NSData *)envelopeData
+               plaintextData:(NSData *_Nullable)plaintextData
+                   createdAt:(NSDate *)createdAt
+                 transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    OWSAssert(envelopeData);
+    OWSAssert(transaction);
+
+    [self.processingQueue.finder addJobWithEnvelopeData:envelopeData
+                                          plaintextData:plaintextData
+                                              createdAt:createdAt
+                                            transaction:transaction];
+    [transaction addCompletionQueue:nil
+                    completionBlock:^{
+                        [self.processingQueue drainQueue];
+                    }];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
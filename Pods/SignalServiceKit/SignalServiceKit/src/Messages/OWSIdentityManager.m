@@ -195,7 +195,7 @@ NSString *const kNSNotificationName_IdentityStateDidChange = @"kNSNotificationNa
                                                      createdAt:[NSDate new]
                                              verificationState:verificationState] save];
 
-            dispatch_async([OWSDispatch sessionStoreQueue], ^{
+            dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
                 [self.storageManager archiveAllSessionsForContact:recipientId];
             });
 
@@ -21,6 +21,10 @@ typedef void (^DecryptFailureBlock)();
 //
 // Exactly one of successBlock & failureBlock will be called,
 // once.
+//
+// Envelopes from the same sender are decrypted one at a time, in the order
+// they are passed in; envelopes from different senders may be decrypted
+// concurrently.
 - (void)decryptEnvelope:(OWSSignalServiceProtosEnvelope *)envelope
            successBlock:(DecryptSuccessBlock)successBlock
            failureBlock:(DecryptFailureBlock)failureBlock;
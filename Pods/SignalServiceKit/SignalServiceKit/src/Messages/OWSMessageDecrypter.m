@@ -24,12 +24,19 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// The number of serial queues incoming envelopes are sharded onto by sender.
+static NSUInteger OWSMessageDecrypterSenderQueueCount(void)
+{
+    return MAX((NSUInteger)2, [NSProcessInfo processInfo].activeProcessorCount);
+}
+
 @interface OWSMessageDecrypter ()
 
 @property (nonatomic, readonly) TSStorageManager *storageManager;
 @property (nonatomic, readonly) YapDatabaseConnection *dbConnection;
 @property (nonatomic, readonly) OWSBlockingManager *blockingManager;
 @property (nonatomic, readonly) OWSIdentityManager *identityManager;
+@property (nonatomic, readonly) NSArray<dispatch_queue_t> *senderQueues;
 
 @end
 
@@ -72,6 +79,12 @@ NS_ASSUME_NONNULL_BEGIN
 
     _dbConnection = storageManager.newDatabaseConnection;
 
+    NSMutableArray<dispatch_queue_t> *senderQueues = [NSMutableArray new];
+    for (NSUInteger i = 0; i < OWSMessageDecrypterSenderQueueCount(); i++) {
+        [senderQueues addObject:dispatch_queue_create("org.whispersystems.signal.decrypt", DISPATCH_QUEUE_SERIAL)];
+    }
+    _senderQueues = [senderQueues copy];
+
     OWSSingletonAssert();
 
     return self;
@@ -88,6 +101,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - Decryption
 
+// Every envelope from a given sender is decrypted on the same serial queue, in the order it was submitted.
+//
+// We shard by sender rather than by sender and device: all of a contact's device sessions are stored in a single
+// row, and they share one identity key, so two of their devices can't safely be ratcheted at the same time.
+- (dispatch_queue_t)senderQueueForEnvelope:(OWSSignalServiceProtosEnvelope *)envelope
+{
+    return self.senderQueues[envelope.source.hash % self.senderQueues.count];
+}
+
 - (void)decryptEnvelope:(OWSSignalServiceProtosEnvelope *)envelope
            successBlock:(DecryptSuccessBlock)successBlockParameter
            failureBlock:(DecryptFailureBlock)failureBlockParameter
@@ -234,27 +256,32 @@ NS_ASSUME_NONNULL_BEGIN
         return;
     }
 
-    dispatch_async([OWSDispatch sessionStoreQueue], ^{
-        @try {
-            id<CipherMessage> cipherMessage = cipherMessageBlock(encryptedData);
-            SessionCipher *cipher = [[SessionCipher alloc] initWithSessionStore:storageManager
-                                                                    preKeyStore:storageManager
-                                                              signedPreKeyStore:storageManager
-                                                               identityKeyStore:self.identityManager
-                                                                    recipientId:recipientId
-                                                                       deviceId:deviceId];
-
-            NSData *plaintextData = [[cipher decrypt:cipherMessage] removePadding];
-            successBlock(plaintextData);
-        } @catch (NSException *exception) {
-            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-                [self processException:exception envelope:envelope];
-                NSString *errorDescription = [NSString
-                    stringWithFormat:@"Exception while decrypting %@: %@", cipherTypeName, exception.description];
-                NSError *error = OWSErrorWithCodeDescription(OWSErrorCodeFailedToDecryptMessage, errorDescription);
-                failureBlock(error);
-            });
-        }
+    // The ratchet step runs as a non-barrier block on the (concurrent) session store queue, so decrypts for different
+    // senders overlap while anything else that touches session state still runs exclusively. The sender queue
+    // guarantees we never have two envelopes from the same sender in flight.
+    dispatch_async([self senderQueueForEnvelope:envelope], ^{
+        dispatch_sync([OWSDispatch sessionStoreQueue], ^{
+            @try {
+                id<CipherMessage> cipherMessage = cipherMessageBlock(encryptedData);
+                SessionCipher *cipher = [[SessionCipher alloc] initWithSessionStore:storageManager
+                                                                        preKeyStore:storageManager
+                                                                  signedPreKeyStore:storageManager
+                                                                   identityKeyStore:self.identityManager
+                                                                        recipientId:recipientId
+                                                                           deviceId:deviceId];
+
+                NSData *plaintextData = [[cipher decrypt:cipherMessage] removePadding];
+                successBlock(plaintextData);
+            } @catch (NSException *exception) {
+                dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                    [self processException:exception envelope:envelope];
+                    NSString *errorDescription = [NSString
+                        stringWithFormat:@"Exception while decrypting %@: %@", cipherTypeName, exception.description];
+                    NSError *error = OWSErrorWithCodeDescription(OWSErrorCodeFailedToDecryptMessage, errorDescription);
+                    failureBlock(error);
+                });
+            }
+        });
     });
 }
 
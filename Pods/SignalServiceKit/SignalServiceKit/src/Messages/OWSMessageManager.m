@@ -675,7 +675,7 @@ NS_ASSUME_NONNULL_BEGIN
                                      inThread:thread
                                   messageType:TSInfoMessageTypeSessionDidEnd] saveWithTransaction:transaction];
 
-    dispatch_async([OWSDispatch sessionStoreQueue], ^{
+    dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
         [self.storageManager deleteAllSessionsForContact:envelope.source];
     });
 }
@@ -19,6 +19,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)handleReceivedEnvelope:(OWSSignalServiceProtosEnvelope *)envelope;
 - (void)handleAnyUnprocessedEnvelopesAsync;
 
+#ifdef DEBUG
+
+/**
+ * Parses envelopes with a contentLength-byte content field from NSData with and without zero-copy, and from an
+ * NSInputStream, and logs the parse time and the heap blocks and bytes each parsed envelope keeps alive.
+ */
++ (void)logEnvelopeParsingBenchmarkWithEnvelopeCount:(NSUInteger)envelopeCount contentLength:(NSUInteger)contentLength;
+
+#endif
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -17,6 +17,7 @@
 #import <YapDatabase/YapDatabaseView.h>
 #import <YapDatabase/YapDatabaseAutoView.h>
 #import <YapDatabase/YapDatabaseViewTypes.h>
+#import <malloc/malloc.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -105,16 +106,27 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
     return self;
 }
 
-- (OWSMessageDecryptJob *_Nullable)nextJob
+- (NSArray<OWSMessageDecryptJob *> *)nextJobsForBatchSize:(NSUInteger)maxBatchSize
 {
-    __block OWSMessageDecryptJob *_Nullable job = nil;
+    NSMutableArray<OWSMessageDecryptJob *> *jobs = [NSMutableArray new];
     [self.dbConnection readWithBlock:^(YapDatabaseReadTransaction *_Nonnull transaction) {
         YapDatabaseViewTransaction *viewTransaction = [transaction ext:OWSMessageDecryptJobFinderExtensionName];
         OWSAssert(viewTransaction != nil);
-        job = [viewTransaction firstObjectInGroup:OWSMessageDecryptJobFinderExtensionGroup];
+        [viewTransaction enumerateKeysAndObjectsInGroup:OWSMessageDecryptJobFinderExtensionGroup
+                                             usingBlock:^(NSString *_Nonnull collection,
+                                                          NSString *_Nonnull key,
+                                                          id _Nonnull object,
+                                                          NSUInteger index,
+                                                          BOOL *_Nonnull stop) {
+                                                 OWSMessageDecryptJob *job = object;
+                                                 [jobs addObject:job];
+                                                 if (jobs.count >= maxBatchSize) {
+                                                     *stop = YES;
+                                                 }
+                                             }];
     }];
 
-    return job;
+    return [jobs copy];
 }
 
 - (void)addJobForEnvelope:(OWSSignalServiceProtosEnvelope *)envelope
@@ -127,10 +139,15 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
 - (void)removeJobWithId:(NSString *)uniqueId
 {
     [self.dbConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *_Nonnull transaction) {
-        [transaction removeObjectForKey:uniqueId inCollection:[OWSMessageDecryptJob collection]];
+        [self removeJobWithId:uniqueId transaction:transaction];
     }];
 }
 
+- (void)removeJobWithId:(NSString *)uniqueId transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    [transaction removeObjectForKey:uniqueId inCollection:[OWSMessageDecryptJob collection]];
+}
+
 + (YapDatabaseView *)databaseExtension
 {
     YapDatabaseViewSorting *sorting =
@@ -205,6 +222,16 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
 
 #pragma mark - Queue Processing
 
+// The number of decrypt jobs we keep in flight at once.
+//
+// OWSMessageDecrypter shards envelopes by sender onto a pool of serial queues,
+// so a window of jobs from several senders is decrypted in parallel, while each
+// sender's envelopes are still decrypted one at a time, in the order we submit
+// them here.
+static const NSUInteger kDecryptPipelineDepth = 16;
+
+#pragma mark -
+
 @interface OWSMessageDecryptQueue : NSObject
 
 @property (nonatomic, readonly) OWSMessageDecrypter *messageDecrypter;
@@ -212,6 +239,12 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
 @property (nonatomic, readonly) OWSMessageDecryptJobFinder *finder;
 @property (nonatomic) BOOL isDrainingQueue;
 
+// The jobs in flight, and how many of them have completed.
+// Only accessed on the serial queue.
+@property (nonatomic, nullable) NSArray<OWSMessageDecryptJob *> *pendingJobs;
+@property (nonatomic) NSUInteger completedJobCount;
+@property (nonatomic) NSUInteger failedJobCount;
+
 - (instancetype)initWithMessageDecrypter:(OWSMessageDecrypter *)messageDecrypter
                    batchMessageProcessor:(OWSBatchMessageProcessor *)batchMessageProcessor
                                   finder:(OWSMessageDecryptJobFinder *)finder NS_DESIGNATED_INITIALIZER;
@@ -295,23 +328,53 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
 - (void)drainQueueWorkStep
 {
     AssertOnDispatchQueue(self.serialQueue);
+    OWSAssert(!self.pendingJobs);
 
-    OWSMessageDecryptJob *_Nullable job = [self.finder nextJob];
-    if (!job) {
+    NSArray<OWSMessageDecryptJob *> *jobs = [self.finder nextJobsForBatchSize:kDecryptPipelineDepth];
+    OWSAssert(jobs);
+    if (jobs.count < 1) {
         self.isDrainingQueue = NO;
         DDLogVerbose(@"%@ Queue is drained.", self.tag);
         return;
     }
 
-    [self processJob:job
-          completion:^(BOOL success) {
-              [self.finder removeJobWithId:job.uniqueId];
-              DDLogVerbose(@"%@ %@ job. %lu jobs left.",
-                           self.tag,
-                           success ? @"decrypted" : @"failed to decrypt",
-                           (unsigned long)[OWSMessageDecryptJob numberOfKeysInCollection]);
-              [self drainQueueWorkStep];
-          }];
+    self.pendingJobs = jobs;
+
+    // Jobs are submitted in the order they were received, so jobs from the same
+    // sender are still decrypted in that order.
+    for (OWSMessageDecryptJob *job in jobs) {
+        [self processJob:job
+              completion:^(BOOL success) {
+                  self.completedJobCount++;
+                  if (!success) {
+                      self.failedJobCount++;
+                  }
+                  if (self.completedJobCount == self.pendingJobs.count) {
+                      [self completeWindow];
+                  }
+              }];
+    }
+}
+
+// Each job has already been removed by the time its completion runs; this just
+// moves on to the next window.
+- (void)completeWindow
+{
+    AssertOnDispatchQueue(self.serialQueue);
+
+    NSUInteger jobCount = self.completedJobCount;
+    NSUInteger failureCount = self.failedJobCount;
+    self.completedJobCount = 0;
+    self.failedJobCount = 0;
+    self.pendingJobs = nil;
+
+    DDLogVerbose(@"%@ decrypted %lu jobs, failed to decrypt %lu jobs. %lu jobs left.",
+                 self.tag,
+                 (unsigned long)(jobCount - failureCount),
+                 (unsigned long)failureCount,
+                 (unsigned long)[OWSMessageDecryptJob numberOfKeysInCollection]);
+
+    [self drainQueueWorkStep];
 }
 
 - (void)processJob:(OWSMessageDecryptJob *)job completion:(void (^)(BOOL))completion
@@ -322,16 +385,30 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
     OWSSignalServiceProtosEnvelope *envelope = job.envelopeProto;
     [self.messageDecrypter decryptEnvelope:envelope
                               successBlock:^(NSData *_Nullable plaintextData) {
-
                                   // We can't decrypt the same message twice, so we need to persist
                                   // the decrypted envelope data ASAP to prevent data loss.
-                                  [self.batchMessageProcessor enqueueEnvelopeData:job.envelopeData plaintextData:plaintextData];
+                                  //
+                                  // The plaintext is enqueued and the job removed in one transaction,
+                                  // so we never end up with both or neither of them after a crash.
+                                  //
+                                  // Success blocks can run out of order, so the job keeps the time
+                                  // its envelope was received, which orders the batch processor.
+                                  [self.finder.dbConnection readWriteWithBlock:^(
+                                      YapDatabaseReadWriteTransaction *_Nonnull transaction) {
+                                      [self.batchMessageProcessor enqueueEnvelopeData:job.envelopeData
+                                                                        plaintextData:plaintextData
+                                                                            createdAt:job.createdAt
+                                                                          transaction:transaction];
+                                      [self.finder removeJobWithId:job.uniqueId transaction:transaction];
+                                  }];
 
                                   dispatch_async(self.serialQueue, ^{
                                       completion(YES);
                                   });
                               }
                               failureBlock:^{
+                                  [self.finder removeJobWithId:job.uniqueId];
+
                                   dispatch_async(self.serialQueue, ^{
                                       completion(NO);
                                   });
@@ -445,6 +522,83 @@ NSString *const OWSMessageDecryptJobFinderExtensionGroup = @"OWSMessageProcessin
     [self.processingQueue drainQueue];
 }
 
+#pragma mark - Benchmark
+
+#ifdef DEBUG
+
++ (void)logEnvelopeParsingBenchmarkWithEnvelopeCount:(NSUInteger)envelopeCount contentLength:(NSUInteger)contentLength
+{
+    OWSAssert(envelopeCount > 0);
+
+    NSMutableData *content = [NSMutableData dataWithLength:contentLength];
+    arc4random_buf(content.mutableBytes, contentLength);
+
+    NSMutableArray<NSData *> *corpus = [NSMutableArray arrayWithCapacity:envelopeCount];
+    for (NSUInteger i = 0; i < envelopeCount; i++) {
+        OWSSignalServiceProtosEnvelopeBuilder *builder = [OWSSignalServiceProtosEnvelopeBuilder new];
+        [builder setType:OWSSignalServiceProtosEnvelopeTypeCiphertext];
+        [builder setSource:[NSString stringWithFormat:@"+1555%07lu", (unsigned long)i]];
+        [builder setSourceDevice:1];
+        [builder setTimestamp:1500000000000 + i];
+        [builder setContent:content];
+        [corpus addObject:[builder build].data];
+    }
+
+    NSArray<NSString *> *modes = @[ @"zero-copy", @"copying", @"input stream" ];
+    for (NSUInteger mode = 0; mode < modes.count; mode++) {
+        NSMutableArray<OWSSignalServiceProtosEnvelope *> *envelopes = [NSMutableArray arrayWithCapacity:envelopeCount];
+
+        malloc_statistics_t before;
+        malloc_zone_statistics(NULL, &before);
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        @autoreleasepool {
+            for (NSData *data in corpus) {
+                OWSSignalServiceProtosEnvelope *envelope;
+                if (mode == 2) {
+                    envelope = [OWSSignalServiceProtosEnvelope
+                        parseFromInputStream:[NSInputStream inputStreamWithData:data]];
+                } else {
+                    PBCodedInputStream *input = [PBCodedInputStream streamWithData:data];
+                    input.zeroCopyEnabled = (mode == 0);
+                    envelope = [OWSSignalServiceProtosEnvelope parseFromCodedInputStream:input];
+                }
+                [envelopes addObject:envelope];
+            }
+        }
+        CFAbsoluteTime parseTime = CFAbsoluteTimeGetCurrent() - startTime;
+        // The envelopes are still alive, so this is what they (and their content) hold on to, not transient garbage.
+        malloc_statistics_t after;
+        malloc_zone_statistics(NULL, &after);
+
+        OWSAssert(envelopes.lastObject.content.length == contentLength);
+        OWSAssert(envelopes.lastObject.timestamp == 1500000000000 + envelopeCount - 1);
+
+        DDLogInfo(@"%@ Envelope parsing benchmark (%lu envelopes, %lu-byte content), %@: %.1fms, %.1f blocks and "
+                  @"%.0f bytes held per envelope",
+            self.tag,
+            (unsigned long)envelopeCount,
+            (unsigned long)contentLength,
+            modes[mode],
+            parseTime * 1000,
+            ((double)after.blocks_in_use - (double)before.blocks_in_use) / envelopeCount,
+            ((double)after.size_in_use - (double)before.size_in_use) / envelopeCount);
+    }
+}
+
+#endif
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
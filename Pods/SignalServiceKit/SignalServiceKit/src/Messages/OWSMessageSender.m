@@ -1069,7 +1069,7 @@ NSString *const OWSMessageSenderRateLimitedException = @"RateLimitedException";
     NSArray *extraDevices = [dictionary objectForKey:@"extraDevices"];
     NSArray *missingDevices = [dictionary objectForKey:@"missingDevices"];
 
-    dispatch_async([OWSDispatch sessionStoreQueue], ^{
+    dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
         if (extraDevices.count < 1 && missingDevices.count < 1) {
             OWSProdFail([OWSAnalyticsEvents messageSenderErrorNoMissingOrExtraDevices]);
         }
@@ -1175,13 +1175,15 @@ NSString *const OWSMessageSenderRateLimitedException = @"RateLimitedException";
     NSData *plainText = [message buildPlainTextData:recipient];
     DDLogDebug(@"%@ built message: %@ plainTextData.length: %lu", self.tag, [message class], (unsigned long)plainText.length);
 
+    [self establishMissingSessionsWithRecipient:recipient];
+
     for (NSNumber *deviceNumber in recipient.devices) {
         @try {
             __block NSDictionary *messageDict;
             __block NSException *encryptionException;
-            // Mutating session state is not thread safe, so we operate on a serial queue, shared with decryption
-            // operations.
-            dispatch_sync([OWSDispatch sessionStoreQueue], ^{
+            // Mutating session state is not thread safe, so we run exclusively on the session store queue, which is
+            // shared with decryption operations.
+            dispatch_barrier_sync([OWSDispatch sessionStoreQueue], ^{
                 @try {
                     messageDict = [self encryptedMessageWithPlaintext:plainText
                                                           toRecipient:recipient.uniqueId
@@ -1217,6 +1219,129 @@ NSString *const OWSMessageSenderRateLimitedException = @"RateLimitedException";
     return [messagesArray copy];
 }
 
+// Sets up sessions with any of the recipient's devices we don't have one with yet. Fetching all of their bundles
+// first lets us check the signed prekey signatures in a single batch rather than one device at a time.
+- (void)establishMissingSessionsWithRecipient:(SignalRecipient *)recipient
+{
+    OWSAssert(recipient);
+
+    __block NSException *sessionException;
+    // Mutating session state is not thread safe, so we run exclusively on the session store queue, which is
+    // shared with decryption operations.
+    dispatch_barrier_sync([OWSDispatch sessionStoreQueue], ^{
+        NSMutableArray<PreKeyBundle *> *bundles = [NSMutableArray new];
+        NSMutableSet<NSNumber *> *invalidDevices = [NSMutableSet new];
+        @try {
+            for (NSNumber *deviceNumber in recipient.devices) {
+                if ([self.storageManager containsSession:recipient.uniqueId deviceId:[deviceNumber intValue]]) {
+                    continue;
+                }
+                @try {
+                    [bundles addObject:[self preKeyBundleForRecipientId:recipient.uniqueId deviceId:deviceNumber]];
+                } @catch (NSException *exception) {
+                    if ([exception.name isEqualToString:OWSMessageSenderInvalidDeviceException]) {
+                        [invalidDevices addObject:deviceNumber];
+                    } else {
+                        @throw exception;
+                    }
+                }
+            }
+
+            if (bundles.count > 0) {
+                [self processPreKeyBundles:bundles forRecipientId:recipient.uniqueId];
+            }
+        } @catch (NSException *exception) {
+            sessionException = exception;
+        }
+
+        if (invalidDevices.count > 0) {
+            [recipient removeDevices:invalidDevices];
+        }
+    });
+
+    if (sessionException) {
+        DDLogInfo(@"%@ Exception while establishing sessions: %@", self.tag, sessionException);
+        @throw sessionException;
+    }
+}
+
+- (void)processPreKeyBundles:(NSArray<PreKeyBundle *> *)bundles forRecipientId:(NSString *)identifier
+{
+    OWSAssert(bundles.count > 0);
+    OWSAssert(identifier.length > 0);
+
+    SessionBuilder *builder = [[SessionBuilder alloc] initWithSessionStore:self.storageManager
+                                                               preKeyStore:self.storageManager
+                                                         signedPreKeyStore:self.storageManager
+                                                          identityKeyStore:[OWSIdentityManager sharedManager]
+                                                               recipientId:identifier
+                                                                  deviceId:bundles.firstObject.deviceId];
+    @try {
+        // Mutating session state is not thread safe.
+        @synchronized(self) {
+            [builder processPrekeyBundles:bundles];
+        }
+    } @catch (NSException *exception) {
+        if ([exception.name isEqualToString:UntrustedIdentityKeyException]) {
+            // The identity key is per recipient, so every bundle carries the same one.
+            @throw [NSException exceptionWithName:UntrustedIdentityKeyException
+                                           reason:nil
+                                         userInfo:@{
+                                             TSInvalidPreKeyBundleKey : bundles.firstObject,
+                                             TSInvalidRecipientKey : identifier
+                                         }];
+        }
+        @throw exception;
+    }
+}
+
+- (PreKeyBundle *)preKeyBundleForRecipientId:(NSString *)identifier deviceId:(NSNumber *)deviceNumber
+{
+    OWSAssert(identifier.length > 0);
+    OWSAssert(deviceNumber);
+
+    __block dispatch_semaphore_t sema = dispatch_semaphore_create(0);
+    __block PreKeyBundle *_Nullable bundle;
+    __block NSException *_Nullable exception;
+    [self.networkManager makeRequest:[[TSRecipientPrekeyRequest alloc] initWithRecipient:identifier
+                                                                                deviceId:[deviceNumber stringValue]]
+                             success:^(NSURLSessionDataTask *task, id responseObject) {
+                                 bundle = [PreKeyBundle preKeyBundleFromDictionary:responseObject forDeviceNumber:deviceNumber];
+                                 dispatch_semaphore_signal(sema);
+                             }
+                             failure:^(NSURLSessionDataTask *task, NSError *error) {
+                                 if (!IsNSErrorNetworkFailure(error)) {
+                                     OWSProdError([OWSAnalyticsEvents messageSenderErrorRecipientPrekeyRequestFailed]);
+                                 }
+                                 DDLogError(@"Server replied to PreKeyBundle request with error: %@", error);
+                                 NSHTTPURLResponse *response = (NSHTTPURLResponse *)task.response;
+                                 if (response.statusCode == 404) {
+                                     // Can't throw exception from within callback as it's probabably a different thread.
+                                     exception = [NSException exceptionWithName:OWSMessageSenderInvalidDeviceException
+                                                                         reason:@"Device not registered"
+                                                                       userInfo:nil];
+                                 } else if (response.statusCode == 413) {
+                                     // Can't throw exception from within callback as it's probabably a different thread.
+                                     exception = [NSException exceptionWithName:OWSMessageSenderRateLimitedException
+                                                                         reason:@"Too many prekey requests"
+                                                                       userInfo:nil];
+                                 }
+                                 dispatch_semaphore_signal(sema);
+                             }];
+    dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
+    if (exception) {
+        @throw exception;
+    }
+
+    if (!bundle) {
+        @throw [NSException exceptionWithName:InvalidVersionException
+                                       reason:@"Can't get a prekey bundle from the server with required information"
+                                     userInfo:nil];
+    }
+
+    return bundle;
+}
+
 - (NSDictionary *)encryptedMessageWithPlaintext:(NSData *)plainText
                                     toRecipient:(NSString *)identifier
                                        deviceId:(NSNumber *)deviceNumber
@@ -1229,64 +1354,26 @@ NSString *const OWSMessageSenderRateLimitedException = @"RateLimitedException";
     OWSAssert(storage);
 
     if (![storage containsSession:identifier deviceId:[deviceNumber intValue]]) {
-        __block dispatch_semaphore_t sema = dispatch_semaphore_create(0);
-        __block PreKeyBundle *_Nullable bundle;
-        __block NSException *_Nullable exception;
-        [self.networkManager makeRequest:[[TSRecipientPrekeyRequest alloc] initWithRecipient:identifier
-                                                                                    deviceId:[deviceNumber stringValue]]
-                                 success:^(NSURLSessionDataTask *task, id responseObject) {
-                                     bundle = [PreKeyBundle preKeyBundleFromDictionary:responseObject forDeviceNumber:deviceNumber];
-                                     dispatch_semaphore_signal(sema);
-                                 }
-                                 failure:^(NSURLSessionDataTask *task, NSError *error) {
-                                     if (!IsNSErrorNetworkFailure(error)) {
-                                         OWSProdError([OWSAnalyticsEvents messageSenderErrorRecipientPrekeyRequestFailed]);
-                                     }
-                                     DDLogError(@"Server replied to PreKeyBundle request with error: %@", error);
-                                     NSHTTPURLResponse *response = (NSHTTPURLResponse *)task.response;
-                                     if (response.statusCode == 404) {
-                                         // Can't throw exception from within callback as it's probabably a different thread.
-                                         exception = [NSException exceptionWithName:OWSMessageSenderInvalidDeviceException
-                                                                             reason:@"Device not registered"
-                                                                           userInfo:nil];
-                                     } else if (response.statusCode == 413) {
-                                         // Can't throw exception from within callback as it's probabably a different thread.
-                                         exception = [NSException exceptionWithName:OWSMessageSenderRateLimitedException
-                                                                             reason:@"Too many prekey requests"
-                                                                           userInfo:nil];
-                                     }
-                                     dispatch_semaphore_signal(sema);
-                                 }];
-        dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
-        if (exception) {
-            @throw exception;
-        }
-
-        if (!bundle) {
-            @throw [NSException exceptionWithName:InvalidVersionException
-                                           reason:@"Can't get a prekey bundle from the server with required information"
-                                         userInfo:nil];
-        } else {
-            SessionBuilder *builder = [[SessionBuilder alloc] initWithSessionStore:storage
-                                                                       preKeyStore:storage
-                                                                 signedPreKeyStore:storage
-                                                                  identityKeyStore:[OWSIdentityManager sharedManager]
-                                                                       recipientId:identifier
-                                                                          deviceId:[deviceNumber intValue]];
-            @try {
-                // Mutating session state is not thread safe.
-                @synchronized(self) {
-                    [builder processPrekeyBundle:bundle];
-                }
-            } @catch (NSException *exception) {
-                if ([exception.name isEqualToString:UntrustedIdentityKeyException]) {
-                    @throw [NSException
-                            exceptionWithName:UntrustedIdentityKeyException
-                            reason:nil
-                            userInfo:@{ TSInvalidPreKeyBundleKey : bundle, TSInvalidRecipientKey : identifier }];
-                }
-                @throw exception;
+        PreKeyBundle *bundle = [self preKeyBundleForRecipientId:identifier deviceId:deviceNumber];
+        SessionBuilder *builder = [[SessionBuilder alloc] initWithSessionStore:storage
+                                                                   preKeyStore:storage
+                                                             signedPreKeyStore:storage
+                                                              identityKeyStore:[OWSIdentityManager sharedManager]
+                                                                   recipientId:identifier
+                                                                      deviceId:[deviceNumber intValue]];
+        @try {
+            // Mutating session state is not thread safe.
+            @synchronized(self) {
+                [builder processPrekeyBundle:bundle];
+            }
+        } @catch (NSException *exception) {
+            if ([exception.name isEqualToString:UntrustedIdentityKeyException]) {
+                @throw [NSException
+                        exceptionWithName:UntrustedIdentityKeyException
+                        reason:nil
+                        userInfo:@{ TSInvalidPreKeyBundleKey : bundle, TSInvalidRecipientKey : identifier }];
             }
+            @throw exception;
         }
     }
 
@@ -1365,7 +1452,7 @@ NSString *const OWSMessageSenderRateLimitedException = @"RateLimitedException";
             return;
         }
 
-        dispatch_async([OWSDispatch sessionStoreQueue], ^{
+        dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
             for (NSUInteger i = 0; i < [devices count]; i++) {
                 int deviceNumber = [devices[i] intValue];
                 [[TSStorageManager sharedManager] deleteSessionForContact:identifier deviceId:deviceNumber];
@@ -82,23 +82,34 @@ static const CGFloat kAttachmentUploadProgressTheta = 0.001f;
                 UInt64 serverId = ((NSDecimalNumber *)[responseDict objectForKey:@"id"]).unsignedLongLongValue;
                 NSString *location = [responseDict objectForKey:@"location"];
 
-                NSError *error;
-                NSData *attachmentData = [attachmentStream readDataFromFileWithError:&error];
-                if (error) {
-                    DDLogError(@"%@ Failed to read attachment data with error:%@", self.tag, error);
-                    [error setIsRetryable:YES];
+                NSString *_Nullable attachmentFilePath = attachmentStream.filePath;
+                if (!attachmentFilePath) {
+                    DDLogError(@"%@ Missing path for attachment.", self.tag);
+                    NSError *error = OWSErrorMakeFailedToSendOutgoingMessageError();
+                    [error setIsRetryable:NO];
                     return failureHandlerWrapper(error);
                 }
 
+                // Encrypt into a temporary file in fixed-size chunks, rather than
+                // loading the whole attachment into memory.
+                NSString *encryptedFilePath =
+                    [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
                 NSData *encryptionKey;
                 NSData *digest;
-                NSData *encryptedAttachmentData =
-                    [Cryptography encryptAttachmentData:attachmentData outKey:&encryptionKey outDigest:&digest];
+                if (![Cryptography encryptAttachmentAtPath:attachmentFilePath
+                                                    toPath:encryptedFilePath
+                                                    outKey:&encryptionKey
+                                                 outDigest:&digest]) {
+                    DDLogError(@"%@ Failed to encrypt attachment.", self.tag);
+                    NSError *error = OWSErrorMakeFailedToSendOutgoingMessageError();
+                    [error setIsRetryable:YES];
+                    return failureHandlerWrapper(error);
+                }
 
                 attachmentStream.encryptionKey = encryptionKey;
                 attachmentStream.digest = digest;
 
-                [self uploadDataWithProgress:encryptedAttachmentData
+                [self uploadFileWithProgress:encryptedFilePath
                                     location:location
                                 attachmentId:attachmentStream.uniqueId
                                      success:^{
@@ -123,7 +134,7 @@ static const CGFloat kAttachmentUploadProgressTheta = 0.001f;
 }
 
 
-- (void)uploadDataWithProgress:(NSData *)cipherText
+- (void)uploadFileWithProgress:(NSString *)cipherTextFilePath
                       location:(NSString *)location
                   attachmentId:(NSString *)attachmentId
                        success:(void (^)())successHandler
@@ -131,7 +142,6 @@ static const CGFloat kAttachmentUploadProgressTheta = 0.001f;
 {
     NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:[NSURL URLWithString:location]];
     request.HTTPMethod = @"PUT";
-    request.HTTPBody = cipherText;
     [request setValue:OWSMimeTypeApplicationOctetStream forHTTPHeaderField:@"Content-Type"];
 
     AFURLSessionManager *manager = [[AFURLSessionManager alloc]
@@ -139,13 +149,14 @@ static const CGFloat kAttachmentUploadProgressTheta = 0.001f;
 
     NSURLSessionUploadTask *uploadTask;
     uploadTask = [manager uploadTaskWithRequest:request
-        fromData:cipherText
+        fromFile:[NSURL fileURLWithPath:cipherTextFilePath]
         progress:^(NSProgress *_Nonnull uploadProgress) {
             [self fireProgressNotification:MAX(kAttachmentUploadProgressTheta, uploadProgress.fractionCompleted)
                               attachmentId:attachmentId];
         }
         completionHandler:^(NSURLResponse *_Nonnull response, id _Nullable responseObject, NSError *_Nullable error) {
             OWSAssert([NSThread isMainThread]);
+            [[NSFileManager defaultManager] removeItemAtPath:cipherTextFilePath error:nil];
             if (error) {
                 [error setIsRetryable:YES];
                 return failureHandler(error);
@@ -15,6 +15,9 @@ NS_ASSUME_NONNULL_BEGIN
 static uint32_t const OWSFingerprintHashingVersion = 0;
 static uint32_t const OWSFingerprintScannableFormatVersion = 1;
 static uint32_t const OWSFingerprintDefaultHashIterations = 5200;
+// Identity keys are hashed with their key type byte prepended.
+static size_t const kOWSFingerprintPublicKeyLength = 33;
+static NSUInteger const kOWSFingerprintDataCacheCountLimit = 1024;
 
 @interface OWSFingerprint ()
 
@@ -51,8 +54,12 @@ static uint32_t const OWSFingerprintDefaultHashIterations = 5200;
     _theirName = theirName;
     _hashIterations = hashIterations;
 
-    _myFingerprintData = [self dataForStableId:_myStableIdData publicKey:_myIdentityKey];
-    _theirFingerprintData = [self dataForStableId:_theirStableIdData publicKey:_theirIdentityKey];
+    _myFingerprintData = [self.class dataForStableId:_myStableIdData
+                                           publicKey:_myIdentityKey
+                                      hashIterations:hashIterations];
+    _theirFingerprintData = [self.class dataForStableId:_theirStableIdData
+                                              publicKey:_theirIdentityKey
+                                         hashIterations:hashIterations];
 
     return self;
 }
@@ -181,20 +188,46 @@ static uint32_t const OWSFingerprintDefaultHashIterations = 5200;
 }
 
 
-- (NSData *)dataFromShort:(uint32_t)aShort
+/**
+ * Runs the fingerprint hash rounds in place: digest = SHA512(digest || publicKey).
+ *
+ * The digest and the public key live side by side in a single fixed stack buffer, so each round is one
+ * hash over that buffer without any allocation.
+ *
+ * This stays on CommonCrypto rather than the 25519 pod's crypto_hash_sha512_many: the two chains of a
+ * fingerprint could be hashed together, but that function hashes one message at a time with a portable C
+ * implementation, while CC_SHA512 is the platform's optimized one (see +[Ed25519 benchmarkSHA512WithMessageCount:
+ * messageLength:]).
+ */
+static void OWSFingerprintIterateHash(uint8_t *digest, const uint8_t *publicKey, uint32_t iterations)
 {
-    uint8_t bytes[] = {
-        ((uint8_t)(aShort & 0xFF00) >> 8),
-        (uint8_t)(aShort & 0x00FF)
-    };
+    uint8_t buffer[CC_SHA512_DIGEST_LENGTH + kOWSFingerprintPublicKeyLength];
+    memcpy(buffer, digest, CC_SHA512_DIGEST_LENGTH);
+    memcpy(buffer + CC_SHA512_DIGEST_LENGTH, publicKey, kOWSFingerprintPublicKeyLength);
 
-    return [NSData dataWithBytes:bytes length:2];
+    for (uint32_t i = 0; i < iterations; i++) {
+        CC_SHA512(buffer, (CC_LONG)sizeof(buffer), digest);
+        memcpy(buffer, digest, CC_SHA512_DIGEST_LENGTH);
+    }
+}
+
++ (NSCache<NSData *, NSData *> *)fingerprintDataCache
+{
+    static NSCache<NSData *, NSData *> *cache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        cache = [NSCache new];
+        cache.countLimit = kOWSFingerprintDataCacheCountLimit;
+    });
+    return cache;
 }
 
 /**
  * An identifier for a mutable public key, belonging to an immutable identifier (stableId).
  *
  * This method is intended to be somewhat expensive to produce in order to be brute force adverse.
+ * Results are memoized, since both halves of a fingerprint only change when a key changes and our own half
+ * is shared by every fingerprint we build.
  *
  * @param stableIdData
  *      Immutable global identifier e.g. Signal Identifier, an e164 formatted phone number encoded as UTF-8 data
@@ -203,27 +236,47 @@ static uint32_t const OWSFingerprintDefaultHashIterations = 5200;
  * @return
  *      All-number textual representation
  */
-- (NSData *)dataForStableId:(NSData *)stableIdData publicKey:(NSData *)publicKey
++ (NSData *)dataForStableId:(NSData *)stableIdData publicKey:(NSData *)publicKey hashIterations:(uint32_t)hashIterations
 {
     OWSAssert(stableIdData);
-    OWSAssert(publicKey);
+    OWSAssert(publicKey.length == kOWSFingerprintPublicKeyLength);
 
-    NSData *versionData = [self dataFromShort:OWSFingerprintHashingVersion];
-    NSMutableData *hash = [NSMutableData dataWithData:versionData];
-    [hash appendData:publicKey];
-    [hash appendData:stableIdData];
+    uint16_t version = (uint16_t)OWSFingerprintHashingVersion;
+    uint8_t versionBytes[] = { (uint8_t)(version >> 8), (uint8_t)(version & 0x00FF) };
 
-    uint8_t digest[CC_SHA512_DIGEST_LENGTH];
-    for (int i = 0; i < self.hashIterations; i++) {
-        [hash appendData:publicKey];
-        CC_SHA512(hash.bytes, (unsigned int)hash.length, digest);
-        // TODO get rid of this loop-allocation
-        hash = [NSMutableData dataWithBytes:digest length:CC_SHA512_DIGEST_LENGTH];
+    NSMutableData *cacheKey = [NSMutableData dataWithBytes:&hashIterations length:sizeof(hashIterations)];
+    [cacheKey appendBytes:versionBytes length:sizeof(versionBytes)];
+    [cacheKey appendData:publicKey];
+    [cacheKey appendData:stableIdData];
+
+    NSCache<NSData *, NSData *> *cache = [self fingerprintDataCache];
+    NSData *_Nullable cachedData = [cache objectForKey:cacheKey];
+    if (cachedData) {
+        return cachedData;
     }
 
-    return [hash copy];
-}
+    // The hash input is version || publicKey || stableIdData, so it's the cache key less its iteration count.
+    NSData *initialData = [cacheKey subdataWithRange:NSMakeRange(sizeof(hashIterations),
+                                                         cacheKey.length - sizeof(hashIterations))];
+    if (hashIterations == 0) {
+        [cache setObject:initialData forKey:cacheKey];
+        return initialData;
+    }
+
+    // The first round hashes the variable-length input, after which every round is fixed-size.
+    uint8_t digest[CC_SHA512_DIGEST_LENGTH];
+    CC_SHA512_CTX context;
+    CC_SHA512_Init(&context);
+    CC_SHA512_Update(&context, initialData.bytes, (CC_LONG)initialData.length);
+    CC_SHA512_Update(&context, publicKey.bytes, (CC_LONG)publicKey.length);
+    CC_SHA512_Final(digest, &context);
+
+    OWSFingerprintIterateHash(digest, publicKey.bytes, hashIterations - 1);
 
+    NSData *result = [NSData dataWithBytes:digest length:CC_SHA512_DIGEST_LENGTH];
+    [cache setObject:result forKey:cacheKey];
+    return result;
+}
 
 - (NSString *)stringForFingerprintData:(NSData *)data
 {
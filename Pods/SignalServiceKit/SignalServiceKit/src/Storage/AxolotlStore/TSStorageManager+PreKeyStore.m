@@ -34,8 +34,7 @@
         int preKeyId = [self nextPreKeyId];
 
         DDLogInfo(@"%@ building %d new preKeys starting from preKeyId: %d", self.tag, BATCH_SIZE, preKeyId);
-        for (int i = 0; i < BATCH_SIZE; i++) {
-            ECKeyPair *keyPair   = [Curve25519 generateKeyPair];
+        for (ECKeyPair *keyPair in [Curve25519 generateKeyPairs:BATCH_SIZE]) {
             PreKeyRecord *record = [[PreKeyRecord alloc] initWithId:preKeyId keyPair:keyPair];
 
             [preKeyRecords addObject:record];
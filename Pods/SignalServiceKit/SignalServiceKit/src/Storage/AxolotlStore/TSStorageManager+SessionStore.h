@@ -5,6 +5,9 @@
 #import <AxolotlKit/SessionStore.h>
 #import "TSStorageManager.h"
 
+extern NSString *const TSStorageManagerSessionStateCollection;
+extern NSString *const TSStorageManagerArchivedSessionStatesCollection;
+
 @interface TSStorageManager (SessionStore) <SessionStore>
 
 - (void)archiveAllSessionsForContact:(NSString *)contactIdentifier;
@@ -4,10 +4,20 @@
 
 #import "TSStorageManager+SessionStore.h"
 #import <AxolotlKit/SessionRecord.h>
+#import <YapDatabase/YapCache.h>
 
+// Legacy layout: contactIdentifier -> NSDictionary<NSNumber *deviceId, SessionRecord *>.
+// Contacts are migrated to the collections below the first time any of their sessions are written.
 NSString *const TSStorageManagerSessionStoreCollection = @"TSStorageManagerSessionStoreCollection";
+// contactIdentifier -> NSDictionary<NSNumber *deviceId, SessionState *> (current state only)
+NSString *const TSStorageManagerSessionStateCollection = @"TSStorageManagerSessionStateCollection";
+// contactIdentifier -> NSDictionary<NSNumber *deviceId, NSArray<SessionState *> *> (most recent first)
+NSString *const TSStorageManagerArchivedSessionStatesCollection = @"TSStorageManagerArchivedSessionStatesCollection";
 NSString *const kSessionStoreDBConnectionKey = @"kSessionStoreDBConnectionKey";
 
+// Enough for every device of the contacts in a busy session, without holding onto every record we've ever touched.
+static const NSUInteger kSessionRecordCacheCountLimit = 256;
+
 void AssertIsOnSessionStoreQueue()
 {
 #ifdef DEBUG
@@ -17,6 +27,11 @@ void AssertIsOnSessionStoreQueue()
 #endif
 }
 
+static NSString *OWSSessionRecordCacheKey(NSString *contactIdentifier, int deviceId)
+{
+    return [NSString stringWithFormat:@"%@.%d", contactIdentifier, deviceId];
+}
+
 @implementation TSStorageManager (SessionStore)
 
 /**
@@ -44,28 +59,77 @@ void AssertIsOnSessionStoreQueue()
     return [[self class] sessionDBConnection];
 }
 
+/**
+ * Write-through cache of the SessionRecords we've most recently loaded or stored, only accessed on the session store
+ * queue. Decrypts for different senders run concurrently on that queue, so every access also synchronizes on the
+ * cache itself; a given contact's records are still only touched by one block at a time.
+ *
+ * The SessionStore contract is that loadSession: hands out a copy, and SessionCipher relies on that: a failed decrypt
+ * can leave the record it loaded half-ratcheted, and simply never stores it. So instead of sharing cached instances, a
+ * record is *checked out* of the cache when it's loaded and only returns when it's stored. Anything that was loaded
+ * but never stored is re-read from the database next time.
+ */
++ (YapCache<NSString *, SessionRecord *> *)sessionRecordCache
+{
+    static dispatch_once_t onceToken;
+    static YapCache<NSString *, SessionRecord *> *sessionRecordCache;
+    dispatch_once(&onceToken, ^{
+        sessionRecordCache = [[YapCache alloc] initWithCountLimit:kSessionRecordCacheCountLimit];
+    });
+
+    return sessionRecordCache;
+}
+
+- (YapCache<NSString *, SessionRecord *> *)sessionRecordCache
+{
+    return [[self class] sessionRecordCache];
+}
+
+- (void)setCachedSessionRecord:(nullable SessionRecord *)sessionRecord
+                    forContact:(NSString *)contactIdentifier
+                      deviceId:(int)deviceId
+{
+    NSString *cacheKey = OWSSessionRecordCacheKey(contactIdentifier, deviceId);
+    @synchronized(self.sessionRecordCache)
+    {
+        if (sessionRecord) {
+            [self.sessionRecordCache setObject:sessionRecord forKey:cacheKey];
+        } else {
+            [self.sessionRecordCache removeObjectForKey:cacheKey];
+        }
+    }
+}
+
 #pragma mark - SessionStore
 
 - (SessionRecord *)loadSession:(NSString *)contactIdentifier deviceId:(int)deviceId
 {
     AssertIsOnSessionStoreQueue();
 
-    __block NSDictionary *dictionary;
+    NSString *cacheKey = OWSSessionRecordCacheKey(contactIdentifier, deviceId);
+    YapCache<NSString *, SessionRecord *> *sessionRecordCache = self.sessionRecordCache;
+    SessionRecord *_Nullable record;
+    @synchronized(sessionRecordCache)
+    {
+        record = [sessionRecordCache objectForKey:cacheKey];
+        if (record) {
+            [sessionRecordCache removeObjectForKey:cacheKey];
+        }
+    }
+    if (record) {
+        return record;
+    }
+
+    __block SessionRecord *_Nullable storedRecord;
     [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
-        dictionary = [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
+        storedRecord = [self sessionRecordForContact:contactIdentifier deviceId:deviceId transaction:transaction];
     }];
 
-    SessionRecord *record;
-
-    if (dictionary) {
-        record = [dictionary objectForKey:@(deviceId)];
-    }
-
-    if (!record) {
+    if (!storedRecord) {
         return [SessionRecord new];
     }
 
-    return record;
+    return storedRecord;
 }
 
 - (NSArray *)subDevicesSessions:(NSString *)contactIdentifier
@@ -75,12 +139,7 @@ void AssertIsOnSessionStoreQueue()
     OWSFail(@"%@ subDevicesSessions is deprecated", self.tag);
     AssertIsOnSessionStoreQueue();
 
-    __block NSDictionary *dictionary;
-    [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
-        dictionary = [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
-    }];
-
-    return dictionary ? dictionary.allKeys : @[];
+    return [self deviceIdsForContact:contactIdentifier];
 }
 
 - (void)storeSession:(NSString *)contactIdentifier deviceId:(int)deviceId session:(SessionRecord *)session
@@ -89,38 +148,45 @@ void AssertIsOnSessionStoreQueue()
 
     // We need to ensure subsequent usage of this SessionRecord does not consider this session as "fresh". Normally this
     // is achieved by marking things as "not fresh" at the point of deserialization - when we fetch a SessionRecord from
-    // YapDB (initWithCoder:). However, because YapDB has an object cache, rather than fetching/deserializing, it's
+    // YapDB (initWithCoder:). However, because we cache the stored instance, rather than fetching/deserializing, it's
     // possible we'd get back *this* exact instance of the object (which, at this point, is still potentially "fresh"),
     // thus we explicitly mark this instance as "unfresh", any time we save.
-    // NOTE: this may no longer be necessary now that we have a non-caching session db connection.
     [session markAsUnFresh];
 
-    __block NSDictionary *immutableDictionary;
-    [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
-        immutableDictionary =
-        [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
-    }];
-
-    NSMutableDictionary *dictionary = [immutableDictionary mutableCopy];
-
-    if (!dictionary) {
-        dictionary = [NSMutableDictionary dictionary];
-    }
-
-    [dictionary setObject:session forKey:@(deviceId)];
-
     [self.sessionDBConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
-        [transaction setObject:[dictionary copy]
-                        forKey:contactIdentifier
-                  inCollection:TSStorageManagerSessionStoreCollection];
+        [self setSessionRecord:session forContact:contactIdentifier deviceId:deviceId transaction:transaction];
     }];
+
+    [self setCachedSessionRecord:session forContact:contactIdentifier deviceId:deviceId];
 }
 
 - (BOOL)containsSession:(NSString *)contactIdentifier deviceId:(int)deviceId
 {
     AssertIsOnSessionStoreQueue();
 
-    return [self loadSession:contactIdentifier deviceId:deviceId].sessionState.hasSenderChain;
+    // Peek rather than load, so we don't check the record out of the cache.
+    SessionRecord *_Nullable cachedRecord;
+    @synchronized(self.sessionRecordCache)
+    {
+        cachedRecord = [self.sessionRecordCache objectForKey:OWSSessionRecordCacheKey(contactIdentifier, deviceId)];
+    }
+    if (cachedRecord) {
+        return cachedRecord.sessionState.hasSenderChain;
+    }
+
+    __block SessionRecord *_Nullable storedRecord;
+    [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+        storedRecord = [self sessionRecordForContact:contactIdentifier deviceId:deviceId transaction:transaction];
+    }];
+
+    if (!storedRecord) {
+        return NO;
+    }
+
+    // Nobody else has seen this instance, so it's safe to cache for the subsequent encrypt/decrypt.
+    [self setCachedSessionRecord:storedRecord forContact:contactIdentifier deviceId:deviceId];
+
+    return storedRecord.sessionState.hasSenderChain;
 }
 
 - (void)deleteSessionForContact:(NSString *)contactIdentifier deviceId:(int)deviceId
@@ -129,23 +195,27 @@ void AssertIsOnSessionStoreQueue()
     DDLogInfo(
               @"[TSStorageManager (SessionStore)] deleting session for contact: %@ device: %d", contactIdentifier, deviceId);
 
-    __block NSDictionary *immutableDictionary;
-    [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
-        immutableDictionary =
-        [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
-    }];
-    NSMutableDictionary *dictionary = [immutableDictionary mutableCopy];
-
-    if (!dictionary) {
-        dictionary = [NSMutableDictionary dictionary];
-    }
-
-    [dictionary removeObjectForKey:@(deviceId)];
+    [self setCachedSessionRecord:nil forContact:contactIdentifier deviceId:deviceId];
 
     [self.sessionDBConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
-        [transaction setObject:[dictionary copy]
-                        forKey:contactIdentifier
-                  inCollection:TSStorageManagerSessionStoreCollection];
+        [self migrateLegacySessionsForContact:contactIdentifier transaction:transaction];
+
+        NSMutableDictionary *sessionStates =
+            [[transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStateCollection] mutableCopy];
+        [sessionStates removeObjectForKey:@(deviceId)];
+        [self setDictionary:sessionStates
+                      forKey:contactIdentifier
+                inCollection:TSStorageManagerSessionStateCollection
+                 transaction:transaction];
+
+        NSMutableDictionary *archivedStates = [[transaction objectForKey:contactIdentifier
+                                                            inCollection:TSStorageManagerArchivedSessionStatesCollection]
+            mutableCopy];
+        [archivedStates removeObjectForKey:@(deviceId)];
+        [self setDictionary:archivedStates
+                      forKey:contactIdentifier
+                inCollection:TSStorageManagerArchivedSessionStatesCollection
+                 transaction:transaction];
     }];
 }
 
@@ -154,8 +224,14 @@ void AssertIsOnSessionStoreQueue()
     AssertIsOnSessionStoreQueue();
     DDLogInfo(@"[TSStorageManager (SessionStore)] deleting all sessions for contact:%@", contactIdentifier);
 
+    for (NSNumber *deviceId in [self deviceIdsForContact:contactIdentifier]) {
+        [self setCachedSessionRecord:nil forContact:contactIdentifier deviceId:deviceId.intValue];
+    }
+
     [self.sessionDBConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
         [transaction removeObjectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
+        [transaction removeObjectForKey:contactIdentifier inCollection:TSStorageManagerSessionStateCollection];
+        [transaction removeObjectForKey:contactIdentifier inCollection:TSStorageManagerArchivedSessionStatesCollection];
     }];
 }
 
@@ -165,26 +241,178 @@ void AssertIsOnSessionStoreQueue()
 
     DDLogInfo(@"[TSStorageManager (SessionStore)] archiving all sessions for contact: %@", contactIdentifier);
 
-    __block NSDictionary<NSNumber *, SessionRecord *> *sessionRecords;
+    // Archiving needs each record's previous states, which are loaded lazily in their own read transaction,
+    // so do that before opening the write transaction.
+    NSMutableDictionary<NSNumber *, SessionRecord *> *sessionRecords = [NSMutableDictionary new];
+    for (NSNumber *deviceId in [self deviceIdsForContact:contactIdentifier]) {
+        SessionRecord *sessionRecord = [self loadSession:contactIdentifier deviceId:deviceId.intValue];
+        [sessionRecord archiveCurrentState];
+        sessionRecords[deviceId] = sessionRecord;
+    }
+
     [self.sessionDBConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
-        sessionRecords =
+        [sessionRecords enumerateKeysAndObjectsUsingBlock:^(
+            NSNumber *deviceId, SessionRecord *sessionRecord, BOOL *stop) {
+            [self setSessionRecord:sessionRecord
+                        forContact:contactIdentifier
+                          deviceId:deviceId.intValue
+                       transaction:transaction];
+        }];
+    }];
+
+    [sessionRecords enumerateKeysAndObjectsUsingBlock:^(NSNumber *deviceId, SessionRecord *sessionRecord, BOOL *stop) {
+        [self setCachedSessionRecord:sessionRecord forContact:contactIdentifier deviceId:deviceId.intValue];
+    }];
+}
+
+#pragma mark - Storage
+
+- (NSArray<NSNumber *> *)deviceIdsForContact:(NSString *)contactIdentifier
+{
+    NSMutableSet<NSNumber *> *deviceIds = [NSMutableSet new];
+    [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+        NSDictionary *sessionStates =
+            [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStateCollection];
+        [deviceIds addObjectsFromArray:sessionStates.allKeys];
+
+        NSDictionary *legacySessionRecords =
+            [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
+        [deviceIds addObjectsFromArray:legacySessionRecords.allKeys];
+    }];
+
+    return deviceIds.allObjects;
+}
+
+- (nullable SessionRecord *)sessionRecordForContact:(NSString *)contactIdentifier
+                                           deviceId:(int)deviceId
+                                        transaction:(YapDatabaseReadTransaction *)transaction
+{
+    NSDictionary<NSNumber *, SessionState *> *sessionStates =
+        [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStateCollection];
+    SessionState *_Nullable sessionState = sessionStates[@(deviceId)];
+
+    if (!sessionState) {
+        // Not yet migrated; the legacy record carries its previous states with it.
+        NSDictionary<NSNumber *, SessionRecord *> *legacySessionRecords =
+            [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
+        return legacySessionRecords[@(deviceId)];
+    }
+
+    return [[SessionRecord alloc] initWithSessionState:sessionState
+                           previousSessionStatesLoader:^{
+                               return [self archivedSessionStatesForContact:contactIdentifier deviceId:deviceId];
+                           }];
+}
+
+- (NSArray<SessionState *> *)archivedSessionStatesForContact:(NSString *)contactIdentifier deviceId:(int)deviceId
+{
+    AssertIsOnSessionStoreQueue();
+
+    __block NSDictionary<NSNumber *, NSArray<SessionState *> *> *archivedStates;
+    [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+        archivedStates =
+            [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerArchivedSessionStatesCollection];
+    }];
+
+    return archivedStates[@(deviceId)] ?: @[];
+}
+
+/**
+ * Only rewrites the contact's archived states if the record's previous states were actually loaded, which is never
+ * the case on the hot path of ratcheting an established session.
+ */
+- (void)setSessionRecord:(SessionRecord *)sessionRecord
+              forContact:(NSString *)contactIdentifier
+                deviceId:(int)deviceId
+             transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    OWSAssert(sessionRecord.sessionState);
+
+    [self migrateLegacySessionsForContact:contactIdentifier transaction:transaction];
+
+    NSMutableDictionary *sessionStates =
+        [[transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStateCollection] mutableCopy];
+    if (!sessionStates) {
+        sessionStates = [NSMutableDictionary new];
+    }
+    sessionStates[@(deviceId)] = sessionRecord.sessionState;
+    [transaction setObject:[sessionStates copy]
+                    forKey:contactIdentifier
+              inCollection:TSStorageManagerSessionStateCollection];
+
+    if (!sessionRecord.hasLoadedPreviousSessionStates) {
+        return;
+    }
+
+    NSMutableDictionary *archivedStates =
+        [[transaction objectForKey:contactIdentifier inCollection:TSStorageManagerArchivedSessionStatesCollection]
+            mutableCopy];
+    if (!archivedStates) {
+        archivedStates = [NSMutableDictionary new];
+    }
+    if (sessionRecord.previousSessionStates.count > 0) {
+        archivedStates[@(deviceId)] = [sessionRecord.previousSessionStates copy];
+    } else {
+        [archivedStates removeObjectForKey:@(deviceId)];
+    }
+    [self setDictionary:archivedStates
+                  forKey:contactIdentifier
+            inCollection:TSStorageManagerArchivedSessionStatesCollection
+             transaction:transaction];
+}
+
+- (void)migrateLegacySessionsForContact:(NSString *)contactIdentifier
+                            transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    if (![transaction hasObjectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection]) {
+        return;
+    }
+
+    NSDictionary *legacySessionRecords =
         [transaction objectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
 
-        for (id deviceId in sessionRecords) {
-            id object = sessionRecords[deviceId];
-            if (![object isKindOfClass:[SessionRecord class]]) {
-                OWSFail(@"Unexpected object in session dict: %@", object);
-                continue;
-            }
+    NSMutableDictionary *sessionStates = [NSMutableDictionary new];
+    NSMutableDictionary *archivedStates = [NSMutableDictionary new];
+    for (NSNumber *deviceId in legacySessionRecords) {
+        id object = legacySessionRecords[deviceId];
+        if (![object isKindOfClass:[SessionRecord class]]) {
+            OWSFail(@"%@ Unexpected object in session dict: %@", self.tag, object);
+            continue;
+        }
 
-            SessionRecord *sessionRecord = (SessionRecord *)object;
-            [sessionRecord archiveCurrentState];
+        SessionRecord *sessionRecord = (SessionRecord *)object;
+        sessionStates[deviceId] = sessionRecord.sessionState;
+        if (sessionRecord.previousSessionStates.count > 0) {
+            archivedStates[deviceId] = [sessionRecord.previousSessionStates copy];
         }
+    }
 
-        [transaction setObject:sessionRecords
-                        forKey:contactIdentifier
-                  inCollection:TSStorageManagerSessionStoreCollection];
-    }];
+    DDLogInfo(@"%@ migrating %lu legacy sessions for contact: %@",
+        self.tag,
+        (unsigned long)sessionStates.count,
+        contactIdentifier);
+
+    [self setDictionary:sessionStates
+                  forKey:contactIdentifier
+            inCollection:TSStorageManagerSessionStateCollection
+             transaction:transaction];
+    [self setDictionary:archivedStates
+                  forKey:contactIdentifier
+            inCollection:TSStorageManagerArchivedSessionStatesCollection
+             transaction:transaction];
+    [transaction removeObjectForKey:contactIdentifier inCollection:TSStorageManagerSessionStoreCollection];
+}
+
+- (void)setDictionary:(nullable NSDictionary *)dictionary
+               forKey:(NSString *)key
+         inCollection:(NSString *)collection
+          transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    if (dictionary.count > 0) {
+        [transaction setObject:[dictionary copy] forKey:key inCollection:collection];
+    } else {
+        [transaction removeObjectForKey:key inCollection:collection];
+    }
 }
 
 #pragma mark - debug
@@ -194,7 +422,17 @@ void AssertIsOnSessionStoreQueue()
     DDLogWarn(@"%@ resetting session store", self.tag);
     [self.sessionDBConnection readWriteWithBlock:^(YapDatabaseReadWriteTransaction *_Nonnull transaction) {
         [transaction removeAllObjectsInCollection:TSStorageManagerSessionStoreCollection];
+        [transaction removeAllObjectsInCollection:TSStorageManagerSessionStateCollection];
+        [transaction removeAllObjectsInCollection:TSStorageManagerArchivedSessionStatesCollection];
     }];
+
+    // The cache is only accessed on the session store queue.
+    dispatch_barrier_async([OWSDispatch sessionStoreQueue], ^{
+        @synchronized(self.sessionRecordCache)
+        {
+            [self.sessionRecordCache removeAllObjects];
+        }
+    });
 }
 
 - (void)printAllSessions
@@ -205,39 +443,37 @@ void AssertIsOnSessionStoreQueue()
     [self.sessionDBConnection readWithBlock:^(YapDatabaseReadTransaction *_Nonnull transaction) {
         DDLogDebug(@"%@ All Sessions:", tag);
         [transaction
-         enumerateKeysAndObjectsInCollection:TSStorageManagerSessionStoreCollection
+         enumerateKeysAndObjectsInCollection:TSStorageManagerSessionStateCollection
          usingBlock:^(NSString *_Nonnull key,
-                      id _Nonnull deviceSessionsObject,
+                      id _Nonnull sessionStatesObject,
                       BOOL *_Nonnull stop) {
-             if (![deviceSessionsObject isKindOfClass:[NSDictionary class]]) {
+             if (![sessionStatesObject isKindOfClass:[NSDictionary class]]) {
                  OWSFail(
-                         @"%@ Unexpected type: %@ in collection.", tag, deviceSessionsObject);
+                         @"%@ Unexpected type: %@ in collection.", tag, sessionStatesObject);
                  return;
              }
-             NSDictionary *deviceSessions = (NSDictionary *)deviceSessionsObject;
+             NSDictionary *sessionStates = (NSDictionary *)sessionStatesObject;
+             NSDictionary *archivedStates =
+                 [transaction objectForKey:key inCollection:TSStorageManagerArchivedSessionStatesCollection];
 
              DDLogDebug(@"%@     Sessions for recipient: %@", tag, key);
-             [deviceSessions enumerateKeysAndObjectsUsingBlock:^(
-                                                                 id _Nonnull key, id _Nonnull sessionRecordObject, BOOL *_Nonnull stop) {
-                 if (![sessionRecordObject isKindOfClass:[SessionRecord class]]) {
-                     OWSFail(@"%@ Unexpected type: %@ in collection.",
-                             tag,
-                             sessionRecordObject);
-                     return;
-                 }
-                 SessionRecord *sessionRecord = (SessionRecord *)sessionRecordObject;
-                 SessionState *activeState = [sessionRecord sessionState];
-                 NSArray<SessionState *> *previousStates =
-                 [sessionRecord previousSessionStates];
-                 DDLogDebug(@"%@         Device: %@ SessionRecord: %@ activeSessionState: "
-                            @"%@ previousSessionStates: %@",
+             [sessionStates enumerateKeysAndObjectsUsingBlock:^(
+                                                                 id _Nonnull deviceId, id _Nonnull activeState, BOOL *_Nonnull stop) {
+                 DDLogDebug(@"%@         Device: %@ activeSessionState: %@ previousSessionStates: %@",
                             tag,
-                            key,
-                            sessionRecord,
+                            deviceId,
                             activeState,
-                            previousStates);
+                            archivedStates[deviceId]);
              }];
          }];
+
+        [transaction
+         enumerateKeysAndObjectsInCollection:TSStorageManagerSessionStoreCollection
+         usingBlock:^(NSString *_Nonnull key,
+                      id _Nonnull deviceSessionsObject,
+                      BOOL *_Nonnull stop) {
+             DDLogDebug(@"%@     Legacy sessions for recipient: %@ %@", tag, key, deviceSessionsObject);
+         }];
     }];
 }
 
@@ -254,4 +490,3 @@ void AssertIsOnSessionStoreQueue()
 }
 
 @end
-
@@ -0,0 +1,77 @@
+//
+//  Copyright (c) 2017 Open Whisper Systems. All rights reserved.
+//
+
+#import <YapDatabase/YapDatabase.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A compact, versioned replacement for NSKeyedArchiver.
+ *
+ * The "schema" of each class is the set of keys its existing NSCoding (or Mantle) implementation encodes,
+ * so any class that supports keyed coding can be archived without changes. Class names and keys are written
+ * once per archive into a string table and referenced by index, and common Foundation value types
+ * (strings, numbers, data, dates and collections) are written inline without going through NSCoding.
+ *
+ * Only keyed coding is supported. Encoding an object which uses non-keyed coding raises
+ * NSInvalidArchiveOperationException.
+ */
+@interface OWSBinaryArchiver : NSCoder
+
++ (NSData *)archivedDataWithRootObject:(nullable id)rootObject;
+
+@end
+
+#pragma mark -
+
+@interface OWSBinaryUnarchiver : NSCoder
+
+/**
+ * Returns YES if the data starts with the binary archive header.
+ */
++ (BOOL)isBinaryArchive:(nullable NSData *)data;
+
+/**
+ * Raises NSInvalidUnarchiveOperationException if the data is malformed, or was written by a newer version.
+ * Objects whose class can't be found are decoded as nil.
+ */
++ (nullable id)unarchiveObjectWithData:(NSData *)data;
+
+@end
+
+#pragma mark -
+
+/**
+ * YapDatabase serializer & deserializer blocks which use the binary archive format.
+ *
+ * Register them per collection with -[YapDatabaseOptions setObjectSerializer:deserializer:forCollection:].
+ * Existing rows are migrated lazily: they are read with the legacy deserializer until the next time they're
+ * written, at which point they're stored in the binary format.
+ */
+@interface OWSBinarySerializer : NSObject
+
+/**
+ * Falls back to NSKeyedArchiver for objects which can't be archived with OWSBinaryArchiver.
+ */
++ (YapDatabaseSerializer)serializer;
+
+/**
+ * Reads the binary format, and uses the given deserializer for anything else (i.e. rows which haven't been
+ * rewritten since the binary format was adopted).
+ */
++ (YapDatabaseDeserializer)deserializerWithLegacyDeserializer:(YapDatabaseDeserializer)legacyDeserializer;
+
+#ifdef DEBUG
+
+/**
+ * Compares the encode time, decode time and size of the binary format against NSKeyedArchiver,
+ * using a synthetic corpus of incoming & outgoing messages, and logs the results.
+ */
++ (void)logBenchmarkWithMessageCount:(NSUInteger)messageCount;
+
+#endif
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,934 @@
+//
+//  Copyright (c) 2017 Open Whisper Systems. All rights reserved.
+//
+
+#import "OWSBinarySerializer.h"
+#import "OWSAnalytics.h"
+
+#ifdef DEBUG
+#import "TSContactThread.h"
+#import "TSIncomingMessage.h"
+#import "TSOutgoingMessage.h"
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Archive layout:
+//
+// - magic ("OWSB") and format version (1 byte)
+// - string table: varint count, then (varint length, UTF-8 bytes) per string
+// - root value
+//
+// Every value starts with a one byte tag. Objects which go through NSCoding are written as
+// (varint class name index, fields..., 0), where each field is (varint key index + 1, value).
+// Each such object is assigned the next object index, so later occurrences are written as references.
+static const uint8_t kOWSBinaryArchiveMagic[4] = { 'O', 'W', 'S', 'B' };
+static const uint8_t kOWSBinaryArchiveVersion = 1;
+static const NSUInteger kOWSBinaryArchiveHeaderLength = sizeof(kOWSBinaryArchiveMagic) + 1;
+
+typedef NS_ENUM(uint8_t, OWSBinaryArchiveTag) {
+    OWSBinaryArchiveTagNil = 0,
+    OWSBinaryArchiveTagNull,
+    OWSBinaryArchiveTagTrue,
+    OWSBinaryArchiveTagFalse,
+    // zig-zag encoded varint
+    OWSBinaryArchiveTagInteger,
+    // varint, only used for unsigned values > INT64_MAX
+    OWSBinaryArchiveTagUnsignedInteger,
+    // little-endian IEEE 754 double
+    OWSBinaryArchiveTagDouble,
+    // timeIntervalSinceReferenceDate as a double
+    OWSBinaryArchiveTagDate,
+    OWSBinaryArchiveTagString,
+    OWSBinaryArchiveTagMutableString,
+    OWSBinaryArchiveTagData,
+    OWSBinaryArchiveTagMutableData,
+    OWSBinaryArchiveTagArray,
+    OWSBinaryArchiveTagMutableArray,
+    OWSBinaryArchiveTagDictionary,
+    OWSBinaryArchiveTagMutableDictionary,
+    OWSBinaryArchiveTagSet,
+    OWSBinaryArchiveTagMutableSet,
+    OWSBinaryArchiveTagObject,
+    OWSBinaryArchiveTagReference,
+};
+
+#pragma mark - Writing
+
+static inline void OWSBinaryWriteTag(NSMutableData *data, OWSBinaryArchiveTag tag)
+{
+    [data appendBytes:&tag length:1];
+}
+
+static inline void OWSBinaryWriteVarint(NSMutableData *data, uint64_t value)
+{
+    uint8_t buffer[10];
+    size_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    [data appendBytes:buffer length:length];
+}
+
+static inline void OWSBinaryWriteDouble(NSMutableData *data, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = CFSwapInt64HostToLittle(bits);
+    [data appendBytes:&bits length:sizeof(bits)];
+}
+
+static inline void OWSBinaryWriteBytes(NSMutableData *data, const void *bytes, NSUInteger length)
+{
+    OWSBinaryWriteVarint(data, length);
+    [data appendBytes:bytes length:length];
+}
+
+static void OWSBinaryWriteString(NSMutableData *data, NSString *string)
+{
+    NSUInteger length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    if (length == 0 && string.length > 0) {
+        // e.g. unpaired surrogates, which can't be represented as UTF-8.
+        [NSException raise:NSInvalidArchiveOperationException format:@"String is not representable as UTF-8"];
+    }
+    OWSBinaryWriteVarint(data, length);
+
+    // Transcode directly into the archive to avoid an intermediate NSData.
+    NSUInteger offset = data.length;
+    [data increaseLengthBy:length];
+    NSUInteger usedLength = 0;
+    [string getBytes:(uint8_t *)data.mutableBytes + offset
+             maxLength:length
+            usedLength:&usedLength
+              encoding:NSUTF8StringEncoding
+               options:0
+                 range:NSMakeRange(0, string.length)
+        remainingRange:NULL];
+    OWSCAssert(usedLength == length);
+}
+
+#pragma mark - Reading
+
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger offset;
+} OWSBinaryReader;
+
+static void OWSBinaryReaderFail(NSString *reason)
+{
+    [NSException raise:NSInvalidUnarchiveOperationException format:@"Malformed binary archive: %@", reason];
+}
+
+static inline uint8_t OWSBinaryReadByte(OWSBinaryReader *reader)
+{
+    if (reader->offset >= reader->length) {
+        OWSBinaryReaderFail(@"unexpected end of data");
+    }
+    return reader->bytes[reader->offset++];
+}
+
+static inline uint64_t OWSBinaryReadVarint(OWSBinaryReader *reader)
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = OWSBinaryReadByte(reader);
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    OWSBinaryReaderFail(@"varint too long");
+    return 0;
+}
+
+static inline double OWSBinaryReadDouble(OWSBinaryReader *reader)
+{
+    if (reader->length - reader->offset < sizeof(uint64_t)) {
+        OWSBinaryReaderFail(@"unexpected end of data");
+    }
+    uint64_t bits;
+    memcpy(&bits, reader->bytes + reader->offset, sizeof(bits));
+    reader->offset += sizeof(bits);
+    bits = CFSwapInt64LittleToHost(bits);
+
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static inline const uint8_t *OWSBinaryReadBytes(OWSBinaryReader *reader, NSUInteger *lengthOut)
+{
+    uint64_t length = OWSBinaryReadVarint(reader);
+    if (length > reader->length - reader->offset) {
+        OWSBinaryReaderFail(@"length exceeds data");
+    }
+    const uint8_t *bytes = reader->bytes + reader->offset;
+    reader->offset += (NSUInteger)length;
+    *lengthOut = (NSUInteger)length;
+    return bytes;
+}
+
+// Every encoded value takes at least one byte, so a count can never exceed the remaining length.
+static inline NSUInteger OWSBinaryReadCount(OWSBinaryReader *reader)
+{
+    uint64_t count = OWSBinaryReadVarint(reader);
+    if (count > reader->length - reader->offset) {
+        OWSBinaryReaderFail(@"count exceeds data");
+    }
+    return (NSUInteger)count;
+}
+
+// Distinguishes "encoded nil for key" from "no value for key" in the decoded fields.
+static id OWSBinaryArchiveNilValue(void)
+{
+    static id instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [NSObject new];
+    });
+    return instance;
+}
+
+#pragma mark -
+
+@implementation OWSBinaryArchiver {
+    NSMutableData *_body;
+    NSMutableArray<NSString *> *_strings;
+    NSMutableDictionary<NSString *, NSNumber *> *_stringIndexes;
+    NSMapTable<id, NSNumber *> *_objectIndexes;
+}
+
++ (NSData *)archivedDataWithRootObject:(nullable id)rootObject
+{
+    OWSBinaryArchiver *archiver = [OWSBinaryArchiver new];
+    [archiver encodeValue:rootObject];
+    return [archiver archivedData];
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) {
+        return self;
+    }
+
+    _body = [NSMutableData dataWithCapacity:256];
+    _strings = [NSMutableArray new];
+    _stringIndexes = [NSMutableDictionary new];
+    _objectIndexes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                           valueOptions:NSPointerFunctionsStrongMemory];
+
+    return self;
+}
+
+- (NSData *)archivedData
+{
+    NSMutableData *result = [NSMutableData dataWithCapacity:kOWSBinaryArchiveHeaderLength + _body.length + 256];
+    [result appendBytes:kOWSBinaryArchiveMagic length:sizeof(kOWSBinaryArchiveMagic)];
+    [result appendBytes:&kOWSBinaryArchiveVersion length:1];
+
+    OWSBinaryWriteVarint(result, _strings.count);
+    for (NSString *string in _strings) {
+        OWSBinaryWriteString(result, string);
+    }
+
+    [result appendData:_body];
+    return result;
+}
+
+- (NSUInteger)indexForString:(NSString *)string
+{
+    NSNumber *index = _stringIndexes[string];
+    if (index) {
+        return index.unsignedIntegerValue;
+    }
+
+    NSUInteger newIndex = _strings.count;
+    NSString *copy = [string copy];
+    [_strings addObject:copy];
+    _stringIndexes[copy] = @(newIndex);
+    return newIndex;
+}
+
+- (void)writeKey:(NSString *)key
+{
+    OWSAssert(key);
+
+    OWSBinaryWriteVarint(_body, [self indexForString:key] + 1);
+}
+
+#pragma mark - Values
+
+- (void)encodeValue:(nullable id)value
+{
+    if (value == nil) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagNil);
+    } else if ([value isKindOfClass:[NSString class]]) {
+        BOOL isMutable = [[value classForCoder] isSubclassOfClass:[NSMutableString class]];
+        OWSBinaryWriteTag(_body, isMutable ? OWSBinaryArchiveTagMutableString : OWSBinaryArchiveTagString);
+        OWSBinaryWriteString(_body, value);
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        [self encodeNumber:value];
+    } else if ([value isKindOfClass:[NSData class]]) {
+        NSData *data = value;
+        BOOL isMutable = [[value classForCoder] isSubclassOfClass:[NSMutableData class]];
+        OWSBinaryWriteTag(_body, isMutable ? OWSBinaryArchiveTagMutableData : OWSBinaryArchiveTagData);
+        OWSBinaryWriteBytes(_body, data.bytes, data.length);
+    } else if ([value isKindOfClass:[NSDate class]]) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagDate);
+        OWSBinaryWriteDouble(_body, [value timeIntervalSinceReferenceDate]);
+    } else if ([value isKindOfClass:[NSNull class]]) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagNull);
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        NSArray *array = value;
+        BOOL isMutable = [[value classForCoder] isSubclassOfClass:[NSMutableArray class]];
+        OWSBinaryWriteTag(_body, isMutable ? OWSBinaryArchiveTagMutableArray : OWSBinaryArchiveTagArray);
+        OWSBinaryWriteVarint(_body, array.count);
+        for (id element in array) {
+            [self encodeValue:element];
+        }
+    } else if ([value isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dictionary = value;
+        BOOL isMutable = [[value classForCoder] isSubclassOfClass:[NSMutableDictionary class]];
+        OWSBinaryWriteTag(_body, isMutable ? OWSBinaryArchiveTagMutableDictionary : OWSBinaryArchiveTagDictionary);
+        OWSBinaryWriteVarint(_body, dictionary.count);
+        [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id object, BOOL *stop) {
+            [self encodeValue:key];
+            [self encodeValue:object];
+        }];
+    } else if ([value isKindOfClass:[NSSet class]]) {
+        NSSet *set = value;
+        BOOL isMutable = [[value classForCoder] isSubclassOfClass:[NSMutableSet class]];
+        OWSBinaryWriteTag(_body, isMutable ? OWSBinaryArchiveTagMutableSet : OWSBinaryArchiveTagSet);
+        OWSBinaryWriteVarint(_body, set.count);
+        for (id element in set) {
+            [self encodeValue:element];
+        }
+    } else {
+        [self encodeCodingObject:value];
+    }
+}
+
+- (void)encodeNumber:(NSNumber *)number
+{
+    if ((__bridge CFBooleanRef)number == kCFBooleanTrue) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagTrue);
+        return;
+    }
+    if ((__bridge CFBooleanRef)number == kCFBooleanFalse) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagFalse);
+        return;
+    }
+
+    switch (number.objCType[0]) {
+        case 'f':
+        case 'd':
+            OWSBinaryWriteTag(_body, OWSBinaryArchiveTagDouble);
+            OWSBinaryWriteDouble(_body, number.doubleValue);
+            return;
+        case 'Q':
+        case 'L':
+            if (number.unsignedLongLongValue > INT64_MAX) {
+                OWSBinaryWriteTag(_body, OWSBinaryArchiveTagUnsignedInteger);
+                OWSBinaryWriteVarint(_body, number.unsignedLongLongValue);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    [self writeInteger:number.longLongValue];
+}
+
+- (void)writeInteger:(int64_t)value
+{
+    OWSBinaryWriteTag(_body, OWSBinaryArchiveTagInteger);
+    OWSBinaryWriteVarint(_body, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+- (void)encodeCodingObject:(id)value
+{
+    id object = [value replacementObjectForCoder:self];
+    if (object == nil) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagNil);
+        return;
+    }
+
+    NSNumber *existingIndex = [_objectIndexes objectForKey:object];
+    if (existingIndex) {
+        OWSBinaryWriteTag(_body, OWSBinaryArchiveTagReference);
+        OWSBinaryWriteVarint(_body, existingIndex.unsignedIntegerValue);
+        return;
+    }
+
+    if (![object conformsToProtocol:@protocol(NSCoding)]) {
+        [NSException raise:NSInvalidArchiveOperationException
+                    format:@"%@ does not conform to NSCoding", [object class]];
+    }
+
+    [_objectIndexes setObject:@(_objectIndexes.count) forKey:object];
+
+    OWSBinaryWriteTag(_body, OWSBinaryArchiveTagObject);
+    OWSBinaryWriteVarint(_body, [self indexForString:NSStringFromClass([object classForCoder])]);
+    [object encodeWithCoder:self];
+    OWSBinaryWriteVarint(_body, 0);
+}
+
+#pragma mark - NSCoder
+
+- (BOOL)allowsKeyedCoding
+{
+    return YES;
+}
+
+- (void)encodeObject:(nullable id)object forKey:(NSString *)key
+{
+    [self writeKey:key];
+    [self encodeValue:object];
+}
+
+- (void)encodeConditionalObject:(nullable id)object forKey:(NSString *)key
+{
+    [self encodeObject:object forKey:key];
+}
+
+- (void)encodeBool:(BOOL)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    OWSBinaryWriteTag(_body, value ? OWSBinaryArchiveTagTrue : OWSBinaryArchiveTagFalse);
+}
+
+- (void)encodeInt:(int)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    [self writeInteger:value];
+}
+
+- (void)encodeInt32:(int32_t)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    [self writeInteger:value];
+}
+
+- (void)encodeInt64:(int64_t)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    [self writeInteger:value];
+}
+
+- (void)encodeInteger:(NSInteger)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    [self writeInteger:value];
+}
+
+- (void)encodeFloat:(float)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    OWSBinaryWriteTag(_body, OWSBinaryArchiveTagDouble);
+    OWSBinaryWriteDouble(_body, value);
+}
+
+- (void)encodeDouble:(double)value forKey:(NSString *)key
+{
+    [self writeKey:key];
+    OWSBinaryWriteTag(_body, OWSBinaryArchiveTagDouble);
+    OWSBinaryWriteDouble(_body, value);
+}
+
+- (void)encodeBytes:(nullable const uint8_t *)bytes length:(NSUInteger)length forKey:(NSString *)key
+{
+    [self writeKey:key];
+    OWSBinaryWriteTag(_body, OWSBinaryArchiveTagData);
+    OWSBinaryWriteBytes(_body, bytes, length);
+}
+
+- (void)encodeValueOfObjCType:(const char *)type at:(const void *)addr
+{
+    [NSException raise:NSInvalidArchiveOperationException format:@"OWSBinaryArchiver only supports keyed coding"];
+}
+
+- (void)encodeDataObject:(NSData *)data
+{
+    [NSException raise:NSInvalidArchiveOperationException format:@"OWSBinaryArchiver only supports keyed coding"];
+}
+
+@end
+
+#pragma mark -
+
+@implementation OWSBinaryUnarchiver {
+    NSData *_data;
+    OWSBinaryReader _reader;
+    NSArray<NSString *> *_strings;
+    // Decoded NSCoding objects by object index, NSNull for objects which decoded as nil.
+    NSMutableArray *_objects;
+    // The fields of the object currently being decoded.
+    NSDictionary<NSString *, id> *_fields;
+}
+
++ (BOOL)isBinaryArchive:(nullable NSData *)data
+{
+    if (data.length < kOWSBinaryArchiveHeaderLength) {
+        return NO;
+    }
+    return memcmp(data.bytes, kOWSBinaryArchiveMagic, sizeof(kOWSBinaryArchiveMagic)) == 0;
+}
+
++ (nullable id)unarchiveObjectWithData:(NSData *)data
+{
+    if (![self isBinaryArchive:data]) {
+        OWSBinaryReaderFail(@"missing header");
+    }
+
+    OWSBinaryUnarchiver *unarchiver = [[OWSBinaryUnarchiver alloc] initWithData:data];
+    return [unarchiver decodeRootObject];
+}
+
+- (instancetype)initWithData:(NSData *)data
+{
+    self = [super init];
+    if (!self) {
+        return self;
+    }
+
+    _data = data;
+    _reader.bytes = data.bytes;
+    _reader.length = data.length;
+    _reader.offset = sizeof(kOWSBinaryArchiveMagic);
+    _objects = [NSMutableArray new];
+
+    return self;
+}
+
+- (nullable id)decodeRootObject
+{
+    uint8_t version = OWSBinaryReadByte(&_reader);
+    if (version > kOWSBinaryArchiveVersion) {
+        OWSBinaryReaderFail([NSString stringWithFormat:@"unsupported version %d", (int)version]);
+    }
+
+    NSUInteger stringCount = OWSBinaryReadCount(&_reader);
+    NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:stringCount];
+    for (NSUInteger i = 0; i < stringCount; i++) {
+        [strings addObject:[self readString:NO]];
+    }
+    _strings = strings;
+
+    return [self decodeValue];
+}
+
+- (NSString *)readString:(BOOL)isMutable
+{
+    NSUInteger length = 0;
+    const uint8_t *bytes = OWSBinaryReadBytes(&_reader, &length);
+    NSString *string = isMutable
+        ? [[NSMutableString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding]
+        : [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (!string) {
+        OWSBinaryReaderFail(@"invalid UTF-8 string");
+    }
+    return string;
+}
+
+- (NSString *)stringAtIndex:(uint64_t)index
+{
+    if (index >= _strings.count) {
+        OWSBinaryReaderFail(@"string index out of range");
+    }
+    return _strings[(NSUInteger)index];
+}
+
+#pragma mark - Values
+
+- (nullable id)decodeValue
+{
+    OWSBinaryArchiveTag tag = OWSBinaryReadByte(&_reader);
+    switch (tag) {
+        case OWSBinaryArchiveTagNil:
+            return nil;
+        case OWSBinaryArchiveTagNull:
+            return [NSNull null];
+        case OWSBinaryArchiveTagTrue:
+            return @(YES);
+        case OWSBinaryArchiveTagFalse:
+            return @(NO);
+        case OWSBinaryArchiveTagInteger: {
+            uint64_t zigzag = OWSBinaryReadVarint(&_reader);
+            return @((int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1));
+        }
+        case OWSBinaryArchiveTagUnsignedInteger:
+            return @(OWSBinaryReadVarint(&_reader));
+        case OWSBinaryArchiveTagDouble:
+            return @(OWSBinaryReadDouble(&_reader));
+        case OWSBinaryArchiveTagDate:
+            return [NSDate dateWithTimeIntervalSinceReferenceDate:OWSBinaryReadDouble(&_reader)];
+        case OWSBinaryArchiveTagString:
+        case OWSBinaryArchiveTagMutableString:
+            return [self readString:(tag == OWSBinaryArchiveTagMutableString)];
+        case OWSBinaryArchiveTagData:
+        case OWSBinaryArchiveTagMutableData: {
+            NSUInteger length = 0;
+            const uint8_t *bytes = OWSBinaryReadBytes(&_reader, &length);
+            return (tag == OWSBinaryArchiveTagMutableData) ? [NSMutableData dataWithBytes:bytes length:length]
+                                                           : [NSData dataWithBytes:bytes length:length];
+        }
+        case OWSBinaryArchiveTagArray:
+        case OWSBinaryArchiveTagMutableArray: {
+            NSUInteger count = OWSBinaryReadCount(&_reader);
+            NSMutableArray *array = [NSMutableArray arrayWithCapacity:count];
+            for (NSUInteger i = 0; i < count; i++) {
+                id element = [self decodeValue];
+                if (element) {
+                    [array addObject:element];
+                }
+            }
+            return (tag == OWSBinaryArchiveTagMutableArray) ? array : [array copy];
+        }
+        case OWSBinaryArchiveTagDictionary:
+        case OWSBinaryArchiveTagMutableDictionary: {
+            NSUInteger count = OWSBinaryReadCount(&_reader);
+            NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:count];
+            for (NSUInteger i = 0; i < count; i++) {
+                id key = [self decodeValue];
+                id object = [self decodeValue];
+                if (key && object) {
+                    dictionary[key] = object;
+                }
+            }
+            return (tag == OWSBinaryArchiveTagMutableDictionary) ? dictionary : [dictionary copy];
+        }
+        case OWSBinaryArchiveTagSet:
+        case OWSBinaryArchiveTagMutableSet: {
+            NSUInteger count = OWSBinaryReadCount(&_reader);
+            NSMutableSet *set = [NSMutableSet setWithCapacity:count];
+            for (NSUInteger i = 0; i < count; i++) {
+                id element = [self decodeValue];
+                if (element) {
+                    [set addObject:element];
+                }
+            }
+            return (tag == OWSBinaryArchiveTagMutableSet) ? set : [set copy];
+        }
+        case OWSBinaryArchiveTagObject:
+            return [self decodeCodingObject];
+        case OWSBinaryArchiveTagReference: {
+            uint64_t index = OWSBinaryReadVarint(&_reader);
+            if (index >= _objects.count) {
+                OWSBinaryReaderFail(@"object reference out of range");
+            }
+            id object = _objects[(NSUInteger)index];
+            return (object == [NSNull null]) ? nil : object;
+        }
+    }
+
+    OWSBinaryReaderFail([NSString stringWithFormat:@"unknown tag %d", (int)tag]);
+    return nil;
+}
+
+- (nullable id)decodeCodingObject
+{
+    NSString *className = [self stringAtIndex:OWSBinaryReadVarint(&_reader)];
+    Class objectClass = NSClassFromString(className);
+    if (objectClass && ![objectClass conformsToProtocol:@protocol(NSCoding)]) {
+        objectClass = nil;
+    }
+
+    // Register the object before decoding its fields, so that references back to it resolve
+    // (just like NSKeyedUnarchiver, they resolve to the allocated but not yet initialized object).
+    NSUInteger objectIndex = _objects.count;
+    id placeholder = [objectClass alloc];
+    [_objects addObject:placeholder ?: [NSNull null]];
+
+    NSMutableDictionary<NSString *, id> *fields = [NSMutableDictionary new];
+    while (YES) {
+        uint64_t keyIndex = OWSBinaryReadVarint(&_reader);
+        if (keyIndex == 0) {
+            break;
+        }
+        NSString *key = [self stringAtIndex:keyIndex - 1];
+        fields[key] = [self decodeValue] ?: OWSBinaryArchiveNilValue();
+    }
+
+    if (!placeholder) {
+        DDLogError(@"%@ Could not decode object: %@", self.tag, className);
+        OWSProdError([OWSAnalyticsEvents storageErrorCouldNotDecodeClass]);
+        return nil;
+    }
+
+    NSDictionary<NSString *, id> *outerFields = _fields;
+    _fields = fields;
+    id object = [placeholder initWithCoder:self];
+    _fields = outerFields;
+
+    object = [object awakeAfterUsingCoder:self];
+
+    _objects[objectIndex] = object ?: [NSNull null];
+    return object;
+}
+
+- (nullable NSNumber *)numberForKey:(NSString *)key
+{
+    id value = _fields[key];
+    return [value isKindOfClass:[NSNumber class]] ? value : nil;
+}
+
+#pragma mark - NSCoder
+
+- (BOOL)allowsKeyedCoding
+{
+    return YES;
+}
+
+- (BOOL)requiresSecureCoding
+{
+    return NO;
+}
+
+- (BOOL)containsValueForKey:(NSString *)key
+{
+    return _fields[key] != nil;
+}
+
+- (nullable id)decodeObjectForKey:(NSString *)key
+{
+    id value = _fields[key];
+    return (value == OWSBinaryArchiveNilValue()) ? nil : value;
+}
+
+- (nullable id)decodeObjectOfClass:(Class)aClass forKey:(NSString *)key
+{
+    // Like NSKeyedUnarchiver when requiresSecureCoding is NO, the class isn't enforced.
+    return [self decodeObjectForKey:key];
+}
+
+- (nullable id)decodeObjectOfClasses:(nullable NSSet<Class> *)classes forKey:(NSString *)key
+{
+    return [self decodeObjectForKey:key];
+}
+
+- (BOOL)decodeBoolForKey:(NSString *)key
+{
+    return [self numberForKey:key].boolValue;
+}
+
+- (int)decodeIntForKey:(NSString *)key
+{
+    return [self numberForKey:key].intValue;
+}
+
+- (int32_t)decodeInt32ForKey:(NSString *)key
+{
+    return [self numberForKey:key].intValue;
+}
+
+- (int64_t)decodeInt64ForKey:(NSString *)key
+{
+    return [self numberForKey:key].longLongValue;
+}
+
+- (NSInteger)decodeIntegerForKey:(NSString *)key
+{
+    return [self numberForKey:key].integerValue;
+}
+
+- (float)decodeFloatForKey:(NSString *)key
+{
+    return [self numberForKey:key].floatValue;
+}
+
+- (double)decodeDoubleForKey:(NSString *)key
+{
+    return [self numberForKey:key].doubleValue;
+}
+
+- (nullable const uint8_t *)decodeBytesForKey:(NSString *)key returnedLength:(nullable NSUInteger *)lengthp
+{
+    id value = _fields[key];
+    NSData *data = [value isKindOfClass:[NSData class]] ? value : nil;
+    if (lengthp) {
+        *lengthp = data.length;
+    }
+    // The fields retain the data until the object has finished decoding.
+    return data.bytes;
+}
+
+- (void)decodeValueOfObjCType:(const char *)type at:(void *)data
+{
+    [NSException raise:NSInvalidUnarchiveOperationException format:@"OWSBinaryUnarchiver only supports keyed coding"];
+}
+
+- (nullable NSData *)decodeDataObject
+{
+    [NSException raise:NSInvalidUnarchiveOperationException format:@"OWSBinaryUnarchiver only supports keyed coding"];
+    return nil;
+}
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
+@end
+
+#pragma mark -
+
+@implementation OWSBinarySerializer
+
++ (YapDatabaseSerializer)serializer
+{
+    return ^NSData *(NSString *collection, NSString *key, id object) {
+        @try {
+            return [OWSBinaryArchiver archivedDataWithRootObject:object];
+        } @catch (NSException *exception) {
+            // e.g. an object graph containing a class which only supports non-keyed coding.
+            // The deserializer reads both formats, so falling back is safe.
+            DDLogWarn(@"%@ Falling back to NSKeyedArchiver for %@: %@", self.tag, [object class], exception);
+            return [NSKeyedArchiver archivedDataWithRootObject:object];
+        }
+    };
+}
+
++ (YapDatabaseDeserializer)deserializerWithLegacyDeserializer:(YapDatabaseDeserializer)legacyDeserializer
+{
+    OWSAssert(legacyDeserializer);
+
+    return ^id(NSString *collection, NSString *key, NSData *data) {
+        if (![OWSBinaryUnarchiver isBinaryArchive:data]) {
+            return legacyDeserializer(collection, key, data);
+        }
+
+        @try {
+            return [OWSBinaryUnarchiver unarchiveObjectWithData:data];
+        } @catch (NSException *exception) {
+            // Sync log in case we bail.
+            OWSProdError([OWSAnalyticsEvents storageErrorDeserialization]);
+            @throw exception;
+        }
+    };
+}
+
+#pragma mark - Benchmark
+
+#ifdef DEBUG
+
++ (void)logBenchmarkWithMessageCount:(NSUInteger)messageCount
+{
+    OWSAssert(messageCount > 0);
+
+    TSContactThread *thread = [[TSContactThread alloc] initWithUniqueId:@"c+15555550100"];
+    NSString *bodyFragment = @"The quick brown fox jumps over the lazy dog. ";
+
+    NSMutableArray<TSMessage *> *corpus = [NSMutableArray arrayWithCapacity:messageCount];
+    uint64_t timestamp = 1500000000000;
+    for (NSUInteger i = 0; i < messageCount; i++) {
+        NSMutableString *body = [NSMutableString new];
+        NSUInteger fragmentCount = 1 + arc4random_uniform(8);
+        for (NSUInteger j = 0; j < fragmentCount; j++) {
+            [body appendString:bodyFragment];
+        }
+        timestamp += arc4random_uniform(60 * 1000);
+
+        if (i % 2 == 0) {
+            [corpus addObject:[[TSIncomingMessage alloc] initWithTimestamp:timestamp
+                                                                  inThread:thread
+                                                                  authorId:@"+15555550100"
+                                                            sourceDeviceId:1
+                                                               messageBody:body]];
+        } else {
+            [corpus addObject:[[TSOutgoingMessage alloc] initWithTimestamp:timestamp
+                                                                  inThread:thread
+                                                               messageBody:body]];
+        }
+    }
+
+    NSMutableArray<NSData *> *keyedArchives = [NSMutableArray arrayWithCapacity:messageCount];
+    NSMutableArray<NSData *> *binaryArchives = [NSMutableArray arrayWithCapacity:messageCount];
+    NSUInteger keyedSize = 0;
+    NSUInteger binarySize = 0;
+
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (TSMessage *message in corpus) {
+        @autoreleasepool {
+            NSData *archive = [NSKeyedArchiver archivedDataWithRootObject:message];
+            keyedSize += archive.length;
+            [keyedArchives addObject:archive];
+        }
+    }
+    CFAbsoluteTime keyedEncodeTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (TSMessage *message in corpus) {
+        @autoreleasepool {
+            NSData *archive = [OWSBinaryArchiver archivedDataWithRootObject:message];
+            binarySize += archive.length;
+            [binaryArchives addObject:archive];
+        }
+    }
+    CFAbsoluteTime binaryEncodeTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSData *archive in keyedArchives) {
+        @autoreleasepool {
+            [NSKeyedUnarchiver unarchiveObjectWithData:archive];
+        }
+    }
+    CFAbsoluteTime keyedDecodeTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSData *archive in binaryArchives) {
+        @autoreleasepool {
+            [OWSBinaryUnarchiver unarchiveObjectWithData:archive];
+        }
+    }
+    CFAbsoluteTime binaryDecodeTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+    // Sanity check the round trip.
+    TSMessage *original = corpus.firstObject;
+    TSMessage *decoded = [OWSBinaryUnarchiver unarchiveObjectWithData:binaryArchives.firstObject];
+    OWSAssert([decoded isKindOfClass:[original class]]);
+    OWSAssert([decoded.body isEqualToString:original.body]);
+    OWSAssert(decoded.timestamp == original.timestamp);
+
+    DDLogInfo(@"%@ Benchmark (%lu messages): NSKeyedArchiver encode %.1fms, decode %.1fms, %lu bytes",
+        self.tag,
+        (unsigned long)messageCount,
+        keyedEncodeTime * 1000,
+        keyedDecodeTime * 1000,
+        (unsigned long)keyedSize);
+    DDLogInfo(@"%@ Benchmark (%lu messages): OWSBinaryArchiver encode %.1fms, decode %.1fms, %lu bytes",
+        self.tag,
+        (unsigned long)messageCount,
+        binaryEncodeTime * 1000,
+        binaryDecodeTime * 1000,
+        (unsigned long)binarySize);
+}
+
+#endif
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
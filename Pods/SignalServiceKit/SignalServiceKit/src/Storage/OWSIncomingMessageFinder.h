@@ -11,6 +11,21 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithDatabase:(YapDatabase *)database NS_DESIGNATED_INITIALIZER;
 
+/**
+ * Registers the hooks which keep the duplicate filter up to date. Writes made before this can't be seen by the
+ * filter, so it must be called with the other sync registrations, before anything writes to the database.
+ */
++ (void)syncRegisterDatabaseHooks:(YapDatabase *)database;
+
+/**
+ * Saves the duplicate filter, so the next launch can load it instead of rebuilding it from the index. This happens
+ * automatically when the app resigns active or enters the background, but an app woken for a background fetch may be
+ * suspended without either, so call this before reporting the fetch complete.
+ *
+ * The completion block is called on the main queue once the filter is saved, or if there was nothing to save.
+ */
++ (void)persistDuplicateFilterForDatabase:(YapDatabase *)database completion:(nullable void (^)(void))completion;
+
 /**
  * Must be called before using this finder.
  */
@@ -24,6 +39,17 @@ NS_ASSUME_NONNULL_BEGIN
                     sourceDeviceId:(uint32_t)sourceDeviceId
                        transaction:(YapDatabaseReadTransaction *)transaction;
 
+/**
+ * The fraction of lookups for messages which don't exist that the duplicate filter failed to rule out, and so
+ * had to be answered with a query.
+ */
+- (double)falsePositiveRate;
+
+/**
+ * The false positive rate expected from the duplicate filter's current size and load.
+ */
+- (double)estimatedFalsePositiveRate;
+
 @end
 
 NS_ASSUME_NONNULL_END
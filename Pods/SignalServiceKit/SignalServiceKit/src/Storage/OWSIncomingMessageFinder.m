@@ -3,9 +3,11 @@
 //
 
 #import "OWSIncomingMessageFinder.h"
+#import "OWSCountingBloomFilter.h"
 #import "TSIncomingMessage.h"
 #import "TSStorageManager.h"
 #import <YapDatabase/YapDatabase.h>
+#import <YapDatabase/YapDatabaseHooks.h>
 #import <YapDatabase/YapDatabaseSecondaryIndex.h>
 
 NS_ASSUME_NONNULL_BEGIN
@@ -16,6 +18,531 @@ NSString *const OWSIncomingMessageFinderColumnTimestamp = @"OWSIncomingMessageFi
 NSString *const OWSIncomingMessageFinderColumnSourceId = @"OWSIncomingMessageFinderColumnSourceId";
 NSString *const OWSIncomingMessageFinderColumnSourceDeviceId = @"OWSIncomingMessageFinderColumnSourceDeviceId";
 
+NSString *const OWSIncomingMessageFinderHooksExtensionName = @"OWSIncomingMessageFinderHooksExtensionName";
+
+NSString *const OWSIncomingMessageFilterCollection = @"OWSIncomingMessageFilterCollection";
+NSString *const OWSIncomingMessageFilterKey = @"OWSIncomingMessageFilterKey";
+NSString *const OWSIncomingMessageFilterDataKey = @"OWSIncomingMessageFilterDataKey";
+NSString *const OWSIncomingMessageFilterRowCountKey = @"OWSIncomingMessageFilterRowCountKey";
+
+static const double kOWSIncomingMessageFilterFalsePositiveRate = 0.01;
+static const NSUInteger kOWSIncomingMessageFilterMinimumCapacity = 10000;
+
+typedef NS_ENUM(NSUInteger, OWSIncomingMessageFilterResult) {
+    // The filter is still being loaded or rebuilt.
+    OWSIncomingMessageFilterResultUnavailable,
+    OWSIncomingMessageFilterResultAbsent,
+    OWSIncomingMessageFilterResultMaybePresent,
+};
+
+// 64-bit FNV-1a. NSString's -hash isn't guaranteed to be stable across OS versions, which would invalidate the
+// persisted filter.
+static uint64_t OWSIncomingMessageFilterHash(uint64_t timestamp, NSString *sourceId, uint32_t sourceDeviceId)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const uint8_t *bytes;
+
+    bytes = (const uint8_t *)&timestamp;
+    for (size_t i = 0; i < sizeof(timestamp); i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    bytes = (const uint8_t *)&sourceDeviceId;
+    for (size_t i = 0; i < sizeof(sourceDeviceId); i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    for (bytes = (const uint8_t *)sourceId.UTF8String; *bytes; bytes++) {
+        hash = (hash ^ *bytes) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Returns NO for anything the secondary index query can't match, i.e. anything other than an incoming message with
+// an authorId.
+static BOOL OWSIncomingMessageFilterHashForObject(id _Nullable object, uint64_t *hash)
+{
+    if (![object isKindOfClass:[TSIncomingMessage class]]) {
+        return NO;
+    }
+    TSIncomingMessage *incomingMessage = (TSIncomingMessage *)object;
+    if (!incomingMessage.authorId) {
+        return NO;
+    }
+    *hash = OWSIncomingMessageFilterHash(
+        incomingMessage.timestamp, incomingMessage.authorId, incomingMessage.sourceDeviceId);
+    return YES;
+}
+
+/**
+ * A counting Bloom filter over the (timestamp, sourceId, sourceDeviceId) of every indexed incoming message, so that
+ * most lookups for new messages can be answered without a query.
+ *
+ * It is kept up to date by a YapDatabaseHooks extension. Elements are added from within the write transaction which
+ * inserts them, before the commit, and only removed after the commit, once the row is known to be gone. So the filter
+ * may briefly hold extra elements (e.g. after a rollback), which only costs a query, but never lacks one.
+ *
+ * The hooks are registered synchronously at launch, before anything writes to the database, so that no change to an
+ * incoming message goes unseen.
+ *
+ * The filter is persisted in the database when the app resigns active or enters the background, and at the end of
+ * background fetches, along with the number of indexed rows. Any
+ * write which changes the filter afterwards, whether or not the filter has been loaded yet, deletes that copy in the
+ * same transaction, and loading it deletes it too. If there's no copy at launch, or its row count doesn't match, the
+ * filter is rebuilt from the index.
+ */
+@interface OWSIncomingMessageFilter : NSObject
+
+@property (nonatomic, readonly) YapDatabaseConnection *dbConnection;
+@property (nonatomic, readonly) dispatch_queue_t serialQueue;
+
+// These properties should only be accessed while synchronized on self.
+@property (nonatomic, nullable) OWSCountingBloomFilter *filter;
+// NO while the filter is being loaded or rebuilt.
+@property (nonatomic) BOOL isReady;
+@property (nonatomic) BOOL isRebuilding;
+// YES while a persisted copy may exist.
+@property (nonatomic) BOOL hasPersistedCopy;
+@property (nonatomic) uint64_t absentCount;
+@property (nonatomic) uint64_t falsePositiveCount;
+
+@end
+
+#pragma mark -
+
+@implementation OWSIncomingMessageFilter
+
++ (instancetype)filterForDatabase:(YapDatabase *)database
+{
+    static NSMapTable<YapDatabase *, OWSIncomingMessageFilter *> *filters;
+    @synchronized(self) {
+        if (!filters) {
+            filters = [NSMapTable weakToStrongObjectsMapTable];
+        }
+        OWSIncomingMessageFilter *filter = [filters objectForKey:database];
+        if (!filter) {
+            filter = [[self alloc] initWithDatabase:database];
+            [filters setObject:filter forKey:database];
+        }
+        return filter;
+    }
+}
+
+- (instancetype)initWithDatabase:(YapDatabase *)database
+{
+    self = [super init];
+    if (!self) {
+        return self;
+    }
+
+    _dbConnection = database.newConnection;
+    _serialQueue = dispatch_queue_create("org.whispersystems.signal.incomingMessageFilter", DISPATCH_QUEUE_SERIAL);
+    // Until -load has looked, assume a previous launch left one.
+    _hasPersistedCopy = YES;
+
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(applicationWillResignActive:)
+                                                 name:UIApplicationWillResignActiveNotification
+                                               object:nil];
+    // An app launched into the background never resigns active.
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(applicationDidEnterBackground:)
+                                                 name:UIApplicationDidEnterBackgroundNotification
+                                               object:nil];
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)applicationWillResignActive:(NSNotification *)notification
+{
+    [self persistWithCompletion:nil];
+}
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification
+{
+    [self persistWithCompletion:nil];
+}
+
+#pragma mark - Lookup
+
+- (OWSIncomingMessageFilterResult)lookupTimestamp:(uint64_t)timestamp
+                                         sourceId:(NSString *)sourceId
+                                   sourceDeviceId:(uint32_t)sourceDeviceId
+{
+    uint64_t hash = OWSIncomingMessageFilterHash(timestamp, sourceId, sourceDeviceId);
+
+    @synchronized(self) {
+        if (!self.isReady) {
+            return OWSIncomingMessageFilterResultUnavailable;
+        }
+        if (![self.filter containsHash:hash]) {
+            self.absentCount++;
+            return OWSIncomingMessageFilterResultAbsent;
+        }
+        return OWSIncomingMessageFilterResultMaybePresent;
+    }
+}
+
+- (void)noteFalsePositive
+{
+    @synchronized(self) {
+        self.falsePositiveCount++;
+    }
+}
+
+- (double)falsePositiveRate
+{
+    @synchronized(self) {
+        uint64_t negativeCount = self.absentCount + self.falsePositiveCount;
+        return negativeCount > 0 ? (double)self.falsePositiveCount / negativeCount : 0;
+    }
+}
+
+- (double)estimatedFalsePositiveRate
+{
+    @synchronized(self) {
+        return self.isReady ? self.filter.estimatedFalsePositiveRate : 0;
+    }
+}
+
+#pragma mark - YAP integration
+
+- (YapDatabaseHooks *)hooksExtension
+{
+    YapDatabaseHooks *hooks = [YapDatabaseHooks new];
+    hooks.allowedCollections =
+        [[YapWhitelistBlacklist alloc] initWithWhitelist:[NSSet setWithObject:[TSIncomingMessage collection]]];
+
+    __weak OWSIncomingMessageFilter *weakSelf = self;
+    hooks.willModifyRow = ^(YapDatabaseReadWriteTransaction *transaction,
+        NSString *collection,
+        NSString *key,
+        YapProxyObject *proxyObject,
+        YapProxyObject *proxyMetadata,
+        YapDatabaseHooksBitMask flags) {
+        if (!(flags & YapDatabaseHooksChangedObject)) {
+            return;
+        }
+
+        uint64_t hash, oldHash;
+        if (!OWSIncomingMessageFilterHashForObject(proxyObject.realObject, &hash)) {
+            return;
+        }
+        BOOL hasOldHash = (flags & YapDatabaseHooksUpdatedRow)
+            && OWSIncomingMessageFilterHashForObject([transaction objectForKey:key inCollection:collection], &oldHash);
+        if (hasOldHash && oldHash == hash) {
+            return;
+        }
+
+        [weakSelf addHash:hash transaction:transaction];
+        if (hasOldHash) {
+            [weakSelf removeHash:oldHash forKey:key inCollection:collection transaction:transaction];
+        }
+    };
+
+    hooks.willRemoveRow = ^(YapDatabaseReadWriteTransaction *transaction, NSString *collection, NSString *key) {
+        uint64_t hash;
+        if (OWSIncomingMessageFilterHashForObject([transaction objectForKey:key inCollection:collection], &hash)) {
+            [weakSelf removeHash:hash forKey:key inCollection:collection transaction:transaction];
+        }
+    };
+
+    hooks.willRemoveAllRows = ^(YapDatabaseReadWriteTransaction *transaction) {
+        OWSIncomingMessageFilter *strongSelf = weakSelf;
+        if (!strongSelf) {
+            return;
+        }
+        // Fall back to queries until the (now empty) index has been scanned again.
+        @synchronized(strongSelf) {
+            strongSelf.filter = nil;
+            strongSelf.isReady = NO;
+            strongSelf.hasPersistedCopy = NO;
+        }
+        [transaction addCompletionQueue:strongSelf.serialQueue
+                        completionBlock:^{
+                            [strongSelf rebuild];
+                        }];
+    };
+
+    return hooks;
+}
+
+- (void)syncRegisterExtensionWithDatabase:(YapDatabase *)database
+{
+    if (![database registerExtension:self.hooksExtension withName:OWSIncomingMessageFinderHooksExtensionName]) {
+        OWSFail(@"%@ could not register hooks extension", self.tag);
+    }
+}
+
+- (BOOL)getRowCount:(NSUInteger *)rowCount transaction:(YapDatabaseReadTransaction *)transaction
+{
+    NSString *queryFormat =
+        [NSString stringWithFormat:@"WHERE %@ IS NOT NULL", OWSIncomingMessageFinderColumnSourceId];
+    return [[transaction ext:OWSIncomingMessageFinderExtensionName]
+        getNumberOfRows:rowCount
+          matchingQuery:[YapDatabaseQuery queryWithFormat:queryFormat]];
+}
+
+#pragma mark - Updates
+
+// Must be called from within the write transaction which inserts the row.
+- (void)addHash:(uint64_t)hash transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    @synchronized(self) {
+        [self invalidatePersistedFilterWithTransaction:transaction];
+        if (!self.filter) {
+            return;
+        }
+        [self.filter addHash:hash];
+
+        if (self.isReady && !self.isRebuilding && self.filter.count > self.filter.capacity) {
+            DDLogInfo(@"%@ filter is over capacity (%lu), rebuilding.", self.tag, (unsigned long)self.filter.capacity);
+            [self rebuild];
+        }
+    }
+}
+
+// The hash is removed once the transaction has committed, and only if the row no longer hashes to it; until then
+// the filter just holds an extra element.
+- (void)removeHash:(uint64_t)hash
+            forKey:(NSString *)key
+      inCollection:(NSString *)collection
+       transaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    OWSCountingBloomFilter *filter;
+    @synchronized(self) {
+        [self invalidatePersistedFilterWithTransaction:transaction];
+        // A rebuild may or may not have seen this row, so it's not safe to remove it from a filter
+        // which is being rebuilt.
+        if (!self.isReady) {
+            return;
+        }
+        filter = self.filter;
+    }
+
+    [transaction addCompletionQueue:self.serialQueue
+                    completionBlock:^{
+                        __block uint64_t currentHash;
+                        __block BOOL hasCurrentHash = NO;
+                        [self.dbConnection readWithBlock:^(YapDatabaseReadTransaction *readTransaction) {
+                            hasCurrentHash = OWSIncomingMessageFilterHashForObject(
+                                [readTransaction objectForKey:key inCollection:collection], &currentHash);
+                        }];
+                        if (hasCurrentHash && currentHash == hash) {
+                            // The transaction was rolled back.
+                            return;
+                        }
+
+                        @synchronized(self) {
+                            if (self.filter == filter) {
+                                [filter removeHash:hash];
+                            }
+                        }
+                    }];
+}
+
+- (void)invalidatePersistedFilterWithTransaction:(YapDatabaseReadWriteTransaction *)transaction
+{
+    if (self.hasPersistedCopy) {
+        [transaction removeObjectForKey:OWSIncomingMessageFilterKey inCollection:OWSIncomingMessageFilterCollection];
+        self.hasPersistedCopy = NO;
+    }
+}
+
+#pragma mark - Persistence
+
+- (void)load
+{
+    __block BOOL didLoad = NO;
+    [self.dbConnection asyncReadWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+        @synchronized(self) {
+            if (self.filter || self.isRebuilding) {
+                // Already loaded.
+                didLoad = YES;
+                return;
+            }
+        }
+
+        NSDictionary *persisted =
+            [transaction objectForKey:OWSIncomingMessageFilterKey inCollection:OWSIncomingMessageFilterCollection];
+        // The copy is only good for this launch; -persistWithCompletion: writes a new one.
+        @synchronized(self) {
+            [self invalidatePersistedFilterWithTransaction:transaction];
+        }
+        if (![persisted isKindOfClass:[NSDictionary class]]) {
+            return;
+        }
+
+        // Belt and braces: the hooks should have deleted the copy if anything changed since it was saved.
+        NSUInteger rowCount;
+        if (![self getRowCount:&rowCount transaction:transaction]) {
+            return;
+        }
+        NSNumber *persistedRowCount = persisted[OWSIncomingMessageFilterRowCountKey];
+        if (![persistedRowCount isKindOfClass:[NSNumber class]] || persistedRowCount.unsignedIntegerValue != rowCount) {
+            DDLogWarn(@"%@ persisted filter is stale.", self.tag);
+            return;
+        }
+
+        NSData *data = persisted[OWSIncomingMessageFilterDataKey];
+        OWSCountingBloomFilter *filter =
+            [data isKindOfClass:[NSData class]] ? [[OWSCountingBloomFilter alloc] initWithSerializedData:data] : nil;
+        if (!filter) {
+            DDLogError(@"%@ persisted filter is invalid.", self.tag);
+            return;
+        }
+
+        @synchronized(self) {
+            self.filter = filter;
+            self.isReady = YES;
+        }
+        didLoad = YES;
+    }
+        completionQueue:self.serialQueue
+        completionBlock:^{
+            if (didLoad) {
+                DDLogInfo(@"%@ loaded filter.", self.tag);
+            } else {
+                [self rebuild];
+            }
+        }];
+}
+
+// A no-op if the saved copy is still current, so it's cheap to call repeatedly.
+- (void)persistWithCompletion:(nullable void (^)(void))completion
+{
+    // The app may be suspended as soon as it's in the background.
+    __block UIBackgroundTaskIdentifier task;
+    task = [UIApplication.sharedApplication beginBackgroundTaskWithExpirationHandler:^{
+        [UIApplication.sharedApplication endBackgroundTask:task];
+    }];
+
+    [self.dbConnection asyncReadWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+        NSData *data;
+        @synchronized(self) {
+            if (!self.isReady || self.hasPersistedCopy) {
+                return;
+            }
+            data = [self.filter serializedData];
+        }
+
+        NSUInteger rowCount;
+        if (![self getRowCount:&rowCount transaction:transaction]) {
+            return;
+        }
+
+        [transaction setObject:@{
+            OWSIncomingMessageFilterDataKey : data,
+            OWSIncomingMessageFilterRowCountKey : @(rowCount),
+        }
+                        forKey:OWSIncomingMessageFilterKey
+                  inCollection:OWSIncomingMessageFilterCollection];
+        @synchronized(self) {
+            self.hasPersistedCopy = YES;
+        }
+    }
+        completionBlock:^{
+            if (completion) {
+                completion();
+            }
+
+            [UIApplication.sharedApplication endBackgroundTask:task];
+        }];
+}
+
+- (void)rebuild
+{
+    @synchronized(self) {
+        if (self.isRebuilding) {
+            return;
+        }
+        self.isRebuilding = YES;
+    }
+
+    // No other write can be in progress while the new filter is installed, so every write which commits after this
+    // transaction reaches it through the hooks, and every write before it is visible to the scan below. Writes in
+    // between may be added twice, which is harmless.
+    __block OWSCountingBloomFilter *filter;
+    [self.dbConnection asyncReadWriteWithBlock:^(YapDatabaseReadWriteTransaction *transaction) {
+        NSUInteger rowCount;
+        if (![self getRowCount:&rowCount transaction:transaction]) {
+            OWSFail(@"%@ Could not count rows", self.tag);
+            return;
+        }
+
+        filter = [[OWSCountingBloomFilter alloc]
+            initWithCapacity:MAX(2 * rowCount, kOWSIncomingMessageFilterMinimumCapacity)
+           falsePositiveRate:kOWSIncomingMessageFilterFalsePositiveRate];
+        @synchronized(self) {
+            self.filter = filter;
+            self.isReady = NO;
+            [self invalidatePersistedFilterWithTransaction:transaction];
+        }
+    }
+        completionQueue:self.serialQueue
+        completionBlock:^{
+            if (!filter) {
+                @synchronized(self) {
+                    self.isRebuilding = NO;
+                }
+                return;
+            }
+
+            CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+            NSString *queryFormat =
+                [NSString stringWithFormat:@"WHERE %@ IS NOT NULL", OWSIncomingMessageFinderColumnSourceId];
+            [self.dbConnection readWithBlock:^(YapDatabaseReadTransaction *transaction) {
+                [[transaction ext:OWSIncomingMessageFinderExtensionName]
+                    enumerateKeysAndObjectsMatchingQuery:[YapDatabaseQuery queryWithFormat:queryFormat]
+                                              usingBlock:^(NSString *collection, NSString *key, id object, BOOL *stop) {
+                                                  uint64_t hash;
+                                                  if (OWSIncomingMessageFilterHashForObject(object, &hash)) {
+                                                      @synchronized(self) {
+                                                          [filter addHash:hash];
+                                                      }
+                                                  }
+                                              }];
+            }];
+
+            BOOL wasReplaced;
+            @synchronized(self) {
+                // All rows were removed during the scan.
+                wasReplaced = self.filter != filter;
+                if (!wasReplaced) {
+                    self.isReady = YES;
+                }
+                self.isRebuilding = NO;
+            }
+            if (wasReplaced) {
+                [self rebuild];
+                return;
+            }
+            DDLogInfo(@"%@ rebuilt filter with %lu elements in %f seconds.",
+                self.tag,
+                (unsigned long)filter.count,
+                CFAbsoluteTimeGetCurrent() - startTime);
+        }];
+}
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
+@end
+
+#pragma mark -
+
 @interface OWSIncomingMessageFinder ()
 
 @property (nonatomic, readonly) YapDatabase *database;
@@ -92,6 +619,16 @@ NSString *const OWSIncomingMessageFinderColumnSourceDeviceId = @"OWSIncomingMess
     return [[YapDatabaseSecondaryIndex alloc] initWithSetup:setup handler:handler];
 }
 
++ (void)syncRegisterDatabaseHooks:(YapDatabase *)database
+{
+    [[OWSIncomingMessageFilter filterForDatabase:database] syncRegisterExtensionWithDatabase:database];
+}
+
++ (void)persistDuplicateFilterForDatabase:(YapDatabase *)database completion:(nullable void (^)(void))completion
+{
+    [[OWSIncomingMessageFilter filterForDatabase:database] persistWithCompletion:completion];
+}
+
 - (void)asyncRegisterExtension
 {
     DDLogInfo(@"%@ registering async.", self.tag);
@@ -99,6 +636,10 @@ NSString *const OWSIncomingMessageFinderColumnSourceDeviceId = @"OWSIncomingMess
                                  withName:OWSIncomingMessageFinderExtensionName
                           completionBlock:^(BOOL ready) {
                               DDLogInfo(@"%@ finished registering async.", self.tag);
+                              // The filter is loaded or rebuilt using the index.
+                              if (ready) {
+                                  [[OWSIncomingMessageFilter filterForDatabase:self.database] load];
+                              }
                           }];
 }
 
@@ -106,7 +647,9 @@ NSString *const OWSIncomingMessageFinderColumnSourceDeviceId = @"OWSIncomingMess
 - (void)registerExtension
 {
     DDLogError(@"%@ registering SYNC. We should prefer async when possible.", self.tag);
-    [self.database registerExtension:self.indexExtension withName:OWSIncomingMessageFinderExtensionName];
+    if ([self.database registerExtension:self.indexExtension withName:OWSIncomingMessageFinderExtensionName]) {
+        [[OWSIncomingMessageFilter filterForDatabase:self.database] load];
+    }
 }
 
 #pragma mark - instance methods
@@ -123,6 +666,14 @@ NSString *const OWSIncomingMessageFinderColumnSourceDeviceId = @"OWSIncomingMess
         [self registerExtension];
     }
 
+    // Almost every envelope is new, and the filter can rule most of those out without a query.
+    OWSIncomingMessageFilter *filter = [OWSIncomingMessageFilter filterForDatabase:self.database];
+    OWSIncomingMessageFilterResult filterResult =
+        [filter lookupTimestamp:timestamp sourceId:sourceId sourceDeviceId:sourceDeviceId];
+    if (filterResult == OWSIncomingMessageFilterResultAbsent) {
+        return NO;
+    }
+
     NSString *queryFormat = [NSString stringWithFormat:@"WHERE %@ = ? AND %@ = ? AND %@ = ?",
                                       OWSIncomingMessageFinderColumnTimestamp,
                                       OWSIncomingMessageFinderColumnSourceId,
@@ -137,9 +688,23 @@ NSString *const OWSIncomingMessageFinderColumnSourceDeviceId = @"OWSIncomingMess
         return NO;
     }
 
+    if (count == 0 && filterResult == OWSIncomingMessageFilterResultMaybePresent) {
+        [filter noteFalsePositive];
+    }
+
     return count > 0;
 }
 
+- (double)falsePositiveRate
+{
+    return [OWSIncomingMessageFilter filterForDatabase:self.database].falsePositiveRate;
+}
+
+- (double)estimatedFalsePositiveRate
+{
+    return [OWSIncomingMessageFilter filterForDatabase:self.database].estimatedFalsePositiveRate;
+}
+
 #pragma mark - Logging
 
 + (NSString *)tag
@@ -110,6 +110,9 @@ NSString *const TSSecondaryDevicesDatabaseViewExtensionName = @"TSSecondaryDevic
     options.isPersistent = YES;
     options.allowedCollections =
     [[YapWhitelistBlacklist alloc] initWithWhitelist:[NSSet setWithObject:[TSInteraction collection]]];
+    // The message grouping blocks and messagesSorting don't use the transaction,
+    // so these (large) views can be populated in parallel.
+    options.parallelizeViewPopulation = YES;
 
     YapDatabaseView *view =
     [[YapDatabaseAutoView alloc] initWithGrouping:viewGrouping sorting:viewSorting versionTag:version options:options];
@@ -5,6 +5,7 @@
 #import "TSStorageManager.h"
 #import "NSData+Base64.h"
 #import "OWSAnalytics.h"
+#import "OWSBinarySerializer.h"
 #import "OWSDisappearingMessagesFinder.h"
 #import "OWSFailedAttachmentDownloadsJob.h"
 #import "OWSFailedMessagesJob.h"
@@ -14,6 +15,7 @@
 #import "TSDatabaseSecondaryIndexes.h"
 #import "TSDatabaseView.h"
 #import "TSInteraction.h"
+#import "TSStorageManager+SessionStore.h"
 #import "TSThread.h"
 #import <25519/Randomness.h>
 #import "TSAccountManager.h"
@@ -41,6 +43,11 @@ static NSString *keychainDBPassAccount    = @"TSDatabasePass";
 // This flag is only used in DEBUG builds.
 static BOOL isDatabaseInitializedFlag = NO;
 
+// Builds before the binary format was adopted can't read rows written in it (they fail to unarchive, and are
+// logged & treated as missing), so a downgrade loses every row rewritten since. Set this to NO to ship a build
+// which still reads the binary format but writes NSKeyedArchiver again, before shipping one that can't read it.
+static const BOOL kTSStorageManagerWritesBinaryFormat = YES;
+
 NSObject *isDatabaseInitializedFlagLock()
 {
     static NSObject *instance = nil;
@@ -294,6 +301,15 @@ void setDatabaseInitialized()
 
     YapDatabaseOptions *options = [[YapDatabaseOptions alloc] init];
     options.corruptAction       = YapDatabaseCorruptAction_Fail;
+    // Message bursts write continuously, so spread WAL checkpoints out rather than
+    // stalling the writers for one large checkpoint once the WAL gets too big.
+    options.checkpointLatencyBudget = 0.02;
+    [[self class] registerBinarySerializersWithOptions:options
+                                           collections:@[
+                                               [TSInteraction collection],
+                                               [TSThread collection],
+                                               [TSAttachment collection],
+                                           ]];
 
     __weak typeof (self)weakSelf = self;
     options.cipherKeyBlock = ^{
@@ -333,9 +349,19 @@ void setDatabaseInitialized()
 
     _dbReadConnection = self.newDatabaseConnection;
     _dbReadWriteConnection = self.newDatabaseConnection;
+    // Neither connection uses long-lived read transactions, so they can catch up on
+    // sibling commits lazily rather than processing every changeset as it's committed.
+    _dbReadConnection.coalescesChangesets = YES;
+    _dbReadWriteConnection.coalescesChangesets = YES;
 
     YapDatabaseOptions *keysDBOptions = [[YapDatabaseOptions alloc] init];
     keysDBOptions.corruptAction       = YapDatabaseCorruptAction_Fail;
+    // Sessions live in the keys database, and are read for every message sent or received.
+    [[self class] registerBinarySerializersWithOptions:keysDBOptions
+                                           collections:@[
+                                               TSStorageManagerSessionStateCollection,
+                                               TSStorageManagerArchivedSessionStatesCollection,
+                                           ]];
 
     keysDBOptions.cipherKeyBlock = ^{
         typeof(self)strongSelf = weakSelf;
@@ -378,6 +404,31 @@ void setDatabaseInitialized()
     return corruptedDBFilePath;
 }
 
+/**
+ * The most frequently read collections use the compact binary format instead of NSKeyedArchiver.
+ * Existing rows stay in the keyed archive format until they're next written.
+ *
+ * The binary format is always readable, but is only written if kTSStorageManagerWritesBinaryFormat is set
+ * (see the downgrade note there).
+ */
++ (void)registerBinarySerializersWithOptions:(YapDatabaseOptions *)options collections:(NSArray<NSString *> *)collections
+{
+    YapDatabaseSerializer serializer;
+    if (kTSStorageManagerWritesBinaryFormat) {
+        serializer = [OWSBinarySerializer serializer];
+    } else {
+        serializer = ^NSData *(NSString *collection, NSString *key, id object) {
+            return [NSKeyedArchiver archivedDataWithRootObject:object];
+        };
+    }
+    YapDatabaseDeserializer deserializer =
+        [OWSBinarySerializer deserializerWithLegacyDeserializer:[self logOnFailureDeserializer]];
+
+    for (NSString *collection in collections) {
+        [options setObjectSerializer:serializer deserializer:deserializer forCollection:collection];
+    }
+}
+
 /**
  * NSCoding sometimes throws exceptions killing our app. We want to log that exception.
  **/
@@ -453,6 +504,7 @@ void setDatabaseInitialized()
     [self.database registerExtension:[TSDatabaseSecondaryIndexes registerTimeStampIndex] withName:@"idx"];
     [OWSMessageReceiver syncRegisterDatabaseExtension:self.database];
     [OWSBatchMessageProcessor syncRegisterDatabaseExtension:self.database];
+    [OWSIncomingMessageFinder syncRegisterDatabaseHooks:self.database];
 
     // See comments on OWSDatabaseConnection.
     //
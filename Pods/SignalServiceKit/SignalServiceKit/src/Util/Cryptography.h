@@ -66,6 +66,24 @@ typedef NS_ENUM(NSInteger, TSMACType) {
                            outKey:(NSData *_Nonnull *_Nullable)outKey
                         outDigest:(NSData *_Nonnull *_Nullable)outDigest;
 
+#pragma mark streaming encrypt and decrypt attachment files
+
+// These process the attachment in fixed-size chunks, computing the HMAC and digest
+// incrementally, so peak memory use doesn't depend on the size of the attachment.
+//
+// On failure no plaintext is left at plaintextFilePath.
++ (BOOL)decryptAttachmentAtPath:(NSString *)encryptedFilePath
+                         toPath:(NSString *)plaintextFilePath
+                        withKey:(NSData *)key
+                         digest:(nullable NSData *)digest
+                   unpaddedSize:(UInt32)unpaddedSize
+                          error:(NSError **)error;
+
++ (BOOL)encryptAttachmentAtPath:(NSString *)plaintextFilePath
+                         toPath:(NSString *)encryptedFilePath
+                         outKey:(NSData *_Nonnull *_Nullable)outKey
+                      outDigest:(NSData *_Nonnull *_Nullable)outDigest;
+
 + (nullable NSData *)encryptAESGCMWithData:(NSData *)plaintextData key:(OWSAES256Key *)key;
 + (nullable NSData *)decryptAESGCMWithData:(NSData *)encryptedData key:(OWSAES256Key *)key;
 
@@ -115,13 +115,11 @@ const NSUInteger kAES256_KeyByteLength = 32;
 
 + (NSString *)truncatedSHA1Base64EncodedWithoutPadding:(NSString *)string {
     /* used by TSContactManager to send hashed/truncated contact list to server */
-    NSMutableData *hashData = [NSMutableData dataWithLength:20];
+    NSData *stringData = [string dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t hash[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1(stringData.bytes, (CC_LONG)stringData.length, hash);
 
-    CC_SHA1([string dataUsingEncoding:NSUTF8StringEncoding].bytes,
-            (unsigned int)[string dataUsingEncoding:NSUTF8StringEncoding].length,
-            hashData.mutableBytes);
-
-    NSData *truncatedData = [hashData subdataWithRange:NSMakeRange(0, 10)];
+    NSData *truncatedData = [NSData dataWithBytes:hash length:10];
 
     return [[truncatedData base64EncodedString] stringByReplacingOccurrencesOfString:@"=" withString:@""];
 }
@@ -443,6 +441,393 @@ const NSUInteger kAES256_KeyByteLength = 32;
     return [encryptedPaddedData copy];
 }
 
+#pragma mark streaming encrypt and decrypt attachment files
+
+// Attachments are streamed through a buffer of this size, so peak memory
+// doesn't grow with the size of the attachment. Must be a multiple of the AES block size.
+static const NSUInteger kAttachmentStreamChunkLength = 64 * 1024;
+
+// Reads exactly `length` bytes unless the stream ends or fails first.
+static NSInteger OWSReadFully(NSInputStream *inputStream, uint8_t *buffer, NSUInteger length)
+{
+    NSUInteger totalRead = 0;
+    while (totalRead < length) {
+        NSInteger bytesRead = [inputStream read:buffer + totalRead maxLength:length - totalRead];
+        if (bytesRead < 0) {
+            return bytesRead;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        totalRead += (NSUInteger)bytesRead;
+    }
+    return (NSInteger)totalRead;
+}
+
+static BOOL OWSWriteFully(NSOutputStream *outputStream, const uint8_t *buffer, NSUInteger length)
+{
+    NSUInteger totalWritten = 0;
+    while (totalWritten < length) {
+        NSInteger bytesWritten = [outputStream write:buffer + totalWritten maxLength:length - totalWritten];
+        if (bytesWritten <= 0) {
+            return NO;
+        }
+        totalWritten += (NSUInteger)bytesWritten;
+    }
+    return YES;
+}
+
++ (BOOL)decryptAttachmentAtPath:(NSString *)encryptedFilePath
+                         toPath:(NSString *)plaintextFilePath
+                        withKey:(NSData *)key
+                         digest:(nullable NSData *)digest
+                   unpaddedSize:(UInt32)unpaddedSize
+                          error:(NSError **)error
+{
+    OWSAssert(encryptedFilePath.length > 0);
+    OWSAssert(plaintextFilePath.length > 0);
+
+    BOOL success = [self streamDecryptAttachmentAtPath:encryptedFilePath
+                                                toPath:plaintextFilePath
+                                               withKey:key
+                                                digest:digest
+                                          unpaddedSize:unpaddedSize
+                                                 error:error];
+    if (!success) {
+        // Never leave unauthenticated plaintext behind.
+        [[NSFileManager defaultManager] removeItemAtPath:plaintextFilePath error:nil];
+    }
+    return success;
+}
+
++ (BOOL)streamDecryptAttachmentAtPath:(NSString *)encryptedFilePath
+                               toPath:(NSString *)plaintextFilePath
+                              withKey:(NSData *)key
+                               digest:(nullable NSData *)digest
+                         unpaddedSize:(UInt32)unpaddedSize
+                                error:(NSError **)error
+{
+    NSError *invalidMessageError = OWSErrorWithCodeDescription(
+        OWSErrorCodeFailedToDecryptMessage, NSLocalizedString(@"ERROR_MESSAGE_INVALID_MESSAGE", @""));
+
+    if (digest.length <= 0) {
+        // This *could* happen with sufficiently outdated clients.
+        DDLogError(@"%@ Refusing to decrypt attachment without a digest.", self.tag);
+        *error = OWSErrorWithCodeDescription(OWSErrorCodeFailedToDecryptMessage,
+            NSLocalizedString(@"ERROR_MESSAGE_ATTACHMENT_FROM_OLD_CLIENT",
+                @"Error message when unable to receive an attachment because the sending client is too old."));
+        return NO;
+    }
+
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:encryptedFilePath error:error];
+    if (!attributes) {
+        DDLogError(@"%@ Could not read attachment file attributes: %@", self.tag, *error);
+        return NO;
+    }
+    unsigned long long encryptedLength = attributes.fileSize;
+
+    if ((encryptedLength < AES_CBC_IV_LENGTH + HMAC256_OUTPUT_LENGTH) || ([key length] < AES_KEY_SIZE + HMAC256_KEY_LENGTH)) {
+        DDLogError(@"%@ Message shorter than crypto overhead!", self.tag);
+        *error = invalidMessageError;
+        return NO;
+    }
+    unsigned long long cipherTextLength = encryptedLength - AES_CBC_IV_LENGTH - HMAC256_OUTPUT_LENGTH;
+    if (cipherTextLength == 0 || (cipherTextLength % kCCBlockSizeAES128) != 0) {
+        DDLogError(@"%@ Ciphertext is not a whole number of blocks.", self.tag);
+        *error = invalidMessageError;
+        return NO;
+    }
+
+    // key: 32 byte AES key || 32 byte Hmac-SHA256 key.
+    const uint8_t *encryptionKey = key.bytes;
+    const uint8_t *hmacKey = encryptionKey + AES_KEY_SIZE;
+
+    NSInputStream *inputStream = [NSInputStream inputStreamWithFileAtPath:encryptedFilePath];
+    NSOutputStream *outputStream = [NSOutputStream outputStreamToFileAtPath:plaintextFilePath append:NO];
+    [inputStream open];
+    [outputStream open];
+
+    NSMutableData *inputBuffer = [NSMutableData dataWithLength:kAttachmentStreamChunkLength];
+    NSMutableData *outputBuffer = [NSMutableData dataWithLength:kAttachmentStreamChunkLength + kCCBlockSizeAES128];
+    uint8_t *input = inputBuffer.mutableBytes;
+    uint8_t *output = outputBuffer.mutableBytes;
+
+    CCHmacContext hmacContext;
+    CCHmacInit(&hmacContext, kCCHmacAlgSHA256, hmacKey, HMAC256_KEY_LENGTH);
+    CC_SHA256_CTX digestContext;
+    CC_SHA256_Init(&digestContext);
+    CCCryptorRef cryptor = NULL;
+
+    BOOL success = NO;
+    unsigned long long plaintextLength = 0;
+    // Bytes of plaintext past unpaddedSize are padding, and aren't written.
+    unsigned long long plaintextLimit = unpaddedSize > 0 ? unpaddedSize : ULLONG_MAX;
+
+    do {
+        // dataToDecrypt: IV || Ciphertext || truncated MAC(IV||Ciphertext)
+        uint8_t iv[AES_CBC_IV_LENGTH];
+        if (OWSReadFully(inputStream, iv, AES_CBC_IV_LENGTH) != AES_CBC_IV_LENGTH) {
+            DDLogError(@"%@ Failed to read attachment IV.", self.tag);
+            break;
+        }
+        CCHmacUpdate(&hmacContext, iv, AES_CBC_IV_LENGTH);
+        CC_SHA256_Update(&digestContext, iv, AES_CBC_IV_LENGTH);
+
+        CCCryptorStatus cryptStatus = CCCryptorCreate(
+            kCCDecrypt, kCCAlgorithmAES128, kCCOptionPKCS7Padding, encryptionKey, AES_KEY_SIZE, iv, &cryptor);
+        if (cryptStatus != kCCSuccess) {
+            DDLogError(@"%@ Failed to create cryptor with status: %d", self.tag, (int32_t)cryptStatus);
+            break;
+        }
+
+        BOOL didFail = NO;
+        unsigned long long cipherTextRemaining = cipherTextLength;
+        while (cipherTextRemaining > 0) {
+            NSUInteger chunkLength = (NSUInteger)MIN((unsigned long long)kAttachmentStreamChunkLength, cipherTextRemaining);
+            if (OWSReadFully(inputStream, input, chunkLength) != (NSInteger)chunkLength) {
+                DDLogError(@"%@ Failed to read attachment ciphertext.", self.tag);
+                didFail = YES;
+                break;
+            }
+            cipherTextRemaining -= chunkLength;
+
+            CCHmacUpdate(&hmacContext, input, chunkLength);
+            CC_SHA256_Update(&digestContext, input, (CC_LONG)chunkLength);
+
+            size_t bytesDecrypted = 0;
+            cryptStatus = CCCryptorUpdate(cryptor, input, chunkLength, output, outputBuffer.length, &bytesDecrypted);
+            if (cryptStatus != kCCSuccess) {
+                DDLogError(@"%@ Failed CBC decryption", self.tag);
+                didFail = YES;
+                break;
+            }
+
+            NSUInteger bytesToWrite = (NSUInteger)MIN((unsigned long long)bytesDecrypted, plaintextLimit - MIN(plaintextLimit, plaintextLength));
+            if (!OWSWriteFully(outputStream, output, bytesToWrite)) {
+                DDLogError(@"%@ Failed to write attachment plaintext: %@", self.tag, outputStream.streamError);
+                didFail = YES;
+                break;
+            }
+            plaintextLength += bytesDecrypted;
+        }
+        if (didFail) {
+            break;
+        }
+
+        uint8_t theirHmac[HMAC256_OUTPUT_LENGTH];
+        if (OWSReadFully(inputStream, theirHmac, HMAC256_OUTPUT_LENGTH) != HMAC256_OUTPUT_LENGTH) {
+            DDLogError(@"%@ Failed to read attachment HMAC.", self.tag);
+            break;
+        }
+
+        uint8_t ourHmac[CC_SHA256_DIGEST_LENGTH];
+        CCHmacFinal(&hmacContext, ourHmac);
+        NSData *ourHmacData = [NSData dataWithBytes:ourHmac length:HMAC256_OUTPUT_LENGTH];
+        NSData *theirHmacData = [NSData dataWithBytes:theirHmac length:HMAC256_OUTPUT_LENGTH];
+        if (![ourHmacData ows_constantTimeIsEqualToData:theirHmacData]) {
+            DDLogError(@"%@ %s Bad HMAC on decrypting payload. Their MAC: %@, our MAC: %@",
+                self.tag,
+                __PRETTY_FUNCTION__,
+                theirHmacData,
+                ourHmacData);
+            break;
+        }
+
+        // Verify digest of: iv || encrypted data || hmac
+        CC_SHA256_Update(&digestContext, ourHmac, HMAC256_OUTPUT_LENGTH);
+        uint8_t ourDigest[CC_SHA256_DIGEST_LENGTH];
+        CC_SHA256_Final(ourDigest, &digestContext);
+        NSData *ourDigestData = [NSData dataWithBytes:ourDigest length:CC_SHA256_DIGEST_LENGTH];
+        if (![ourDigestData ows_constantTimeIsEqualToData:digest]) {
+            DDLogWarn(@"%@ Bad digest on decrypting payload. Their digest: %@, our digest: %@",
+                self.tag,
+                digest,
+                ourDigestData);
+            break;
+        }
+
+        size_t finalBytes = 0;
+        cryptStatus = CCCryptorFinal(cryptor, output, outputBuffer.length, &finalBytes);
+        if (cryptStatus != kCCSuccess) {
+            DDLogError(@"%@ Failed CBC decryption", self.tag);
+            break;
+        }
+        NSUInteger bytesToWrite = (NSUInteger)MIN((unsigned long long)finalBytes, plaintextLimit - MIN(plaintextLimit, plaintextLength));
+        if (!OWSWriteFully(outputStream, output, bytesToWrite)) {
+            DDLogError(@"%@ Failed to write attachment plaintext: %@", self.tag, outputStream.streamError);
+            break;
+        }
+        plaintextLength += finalBytes;
+
+        if (unpaddedSize == 0) {
+            // Work around for legacy iOS client's which weren't setting padding size.
+            // Since we know those clients pre-date attachment padding we keep the entire data.
+            DDLogWarn(@"%@ Decrypted attachment with unspecified size.", self.tag);
+        } else if (unpaddedSize > plaintextLength) {
+            break;
+        } else if (unpaddedSize == plaintextLength) {
+            DDLogInfo(@"%@ decrypted unpadded attachment.", self.tag);
+        } else {
+            DDLogInfo(@"%@ decrypted padded attachment with unpaddedSize: %u, paddingSize: %llu",
+                self.tag,
+                unpaddedSize,
+                plaintextLength - unpaddedSize);
+        }
+
+        success = YES;
+    } while (NO);
+
+    if (cryptor) {
+        CCCryptorRelease(cryptor);
+    }
+    [inputStream close];
+    [outputStream close];
+
+    if (!success && !*error) {
+        *error = invalidMessageError;
+    }
+    return success;
+}
+
++ (BOOL)encryptAttachmentAtPath:(NSString *)plaintextFilePath
+                         toPath:(NSString *)encryptedFilePath
+                         outKey:(NSData *_Nonnull *_Nullable)outKey
+                      outDigest:(NSData *_Nonnull *_Nullable)outDigest
+{
+    OWSAssert(plaintextFilePath.length > 0);
+    OWSAssert(encryptedFilePath.length > 0);
+
+    NSError *error;
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:plaintextFilePath error:&error];
+    if (!attributes) {
+        DDLogError(@"%@ Could not read attachment file attributes: %@", self.tag, error);
+        return NO;
+    }
+    unsigned long long plaintextLength = attributes.fileSize;
+    // Apply any padding
+    unsigned long long paddedLength = [self paddedSize:(unsigned long)plaintextLength];
+
+    NSData *iv            = [Cryptography generateRandomBytes:AES_CBC_IV_LENGTH];
+    NSData *encryptionKey = [Cryptography generateRandomBytes:AES_KEY_SIZE];
+    NSData *hmacKey       = [Cryptography generateRandomBytes:HMAC256_KEY_LENGTH];
+
+    NSInputStream *inputStream = [NSInputStream inputStreamWithFileAtPath:plaintextFilePath];
+    NSOutputStream *outputStream = [NSOutputStream outputStreamToFileAtPath:encryptedFilePath append:NO];
+    [inputStream open];
+    [outputStream open];
+
+    NSMutableData *inputBuffer = [NSMutableData dataWithLength:kAttachmentStreamChunkLength];
+    NSMutableData *outputBuffer = [NSMutableData dataWithLength:kAttachmentStreamChunkLength + kCCBlockSizeAES128];
+    uint8_t *input = inputBuffer.mutableBytes;
+    uint8_t *output = outputBuffer.mutableBytes;
+
+    CCHmacContext hmacContext;
+    CCHmacInit(&hmacContext, kCCHmacAlgSHA256, hmacKey.bytes, HMAC256_KEY_LENGTH);
+    CC_SHA256_CTX digestContext;
+    CC_SHA256_Init(&digestContext);
+    CCCryptorRef cryptor = NULL;
+
+    BOOL success = NO;
+    do {
+        CCCryptorStatus cryptStatus = CCCryptorCreate(
+            kCCEncrypt, kCCAlgorithmAES128, kCCOptionPKCS7Padding, encryptionKey.bytes, AES_KEY_SIZE, iv.bytes, &cryptor);
+        if (cryptStatus != kCCSuccess) {
+            DDLogError(@"%@ Failed to create cryptor with status: %d", self.tag, (int32_t)cryptStatus);
+            break;
+        }
+
+        // encrypted file: iv || encrypted data || hmac
+        if (!OWSWriteFully(outputStream, iv.bytes, AES_CBC_IV_LENGTH)) {
+            break;
+        }
+        CCHmacUpdate(&hmacContext, iv.bytes, AES_CBC_IV_LENGTH);
+        CC_SHA256_Update(&digestContext, iv.bytes, AES_CBC_IV_LENGTH);
+
+        BOOL didFail = NO;
+        unsigned long long plaintextRemaining = plaintextLength;
+        unsigned long long paddingRemaining = paddedLength - plaintextLength;
+        while (plaintextRemaining > 0 || paddingRemaining > 0) {
+            NSUInteger chunkLength;
+            if (plaintextRemaining > 0) {
+                chunkLength = (NSUInteger)MIN((unsigned long long)kAttachmentStreamChunkLength, plaintextRemaining);
+                if (OWSReadFully(inputStream, input, chunkLength) != (NSInteger)chunkLength) {
+                    DDLogError(@"%@ Failed to read attachment plaintext.", self.tag);
+                    didFail = YES;
+                    break;
+                }
+                plaintextRemaining -= chunkLength;
+            } else {
+                chunkLength = (NSUInteger)MIN((unsigned long long)kAttachmentStreamChunkLength, paddingRemaining);
+                memset(input, 0, chunkLength);
+                paddingRemaining -= chunkLength;
+            }
+
+            size_t bytesEncrypted = 0;
+            cryptStatus = CCCryptorUpdate(cryptor, input, chunkLength, output, outputBuffer.length, &bytesEncrypted);
+            if (cryptStatus != kCCSuccess) {
+                DDLogError(@"%@ %s CCCrypt failed with status: %d", self.tag, __PRETTY_FUNCTION__, (int32_t)cryptStatus);
+                didFail = YES;
+                break;
+            }
+            CCHmacUpdate(&hmacContext, output, bytesEncrypted);
+            CC_SHA256_Update(&digestContext, output, (CC_LONG)bytesEncrypted);
+            if (!OWSWriteFully(outputStream, output, bytesEncrypted)) {
+                didFail = YES;
+                break;
+            }
+        }
+        if (didFail) {
+            break;
+        }
+
+        size_t finalBytes = 0;
+        cryptStatus = CCCryptorFinal(cryptor, output, outputBuffer.length, &finalBytes);
+        if (cryptStatus != kCCSuccess) {
+            DDLogError(@"%@ %s CCCrypt failed with status: %d", self.tag, __PRETTY_FUNCTION__, (int32_t)cryptStatus);
+            break;
+        }
+        CCHmacUpdate(&hmacContext, output, finalBytes);
+        CC_SHA256_Update(&digestContext, output, (CC_LONG)finalBytes);
+        if (!OWSWriteFully(outputStream, output, finalBytes)) {
+            break;
+        }
+
+        // compute hmac of: iv || encrypted data
+        uint8_t hmac[CC_SHA256_DIGEST_LENGTH];
+        CCHmacFinal(&hmacContext, hmac);
+        if (!OWSWriteFully(outputStream, hmac, HMAC256_OUTPUT_LENGTH)) {
+            break;
+        }
+
+        // compute digest of: iv || encrypted data || hmac
+        CC_SHA256_Update(&digestContext, hmac, HMAC256_OUTPUT_LENGTH);
+        uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+        CC_SHA256_Final(digest, &digestContext);
+
+        // The concatenated key for storage
+        NSMutableData *attachmentKey = [NSMutableData data];
+        [attachmentKey appendData:encryptionKey];
+        [attachmentKey appendData:hmacKey];
+        *outKey = [attachmentKey copy];
+        *outDigest = [NSData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH];
+        DDLogVerbose(@"%@ computed digest: %@", self.tag, *outDigest);
+
+        success = YES;
+    } while (NO);
+
+    if (cryptor) {
+        CCCryptorRelease(cryptor);
+    }
+    [inputStream close];
+    [outputStream close];
+
+    if (!success) {
+        DDLogError(@"%@ Failed to encrypt attachment file: %@", self.tag, outputStream.streamError);
+        [[NSFileManager defaultManager] removeItemAtPath:encryptedFilePath error:nil];
+    }
+    return success;
+}
+
 + (nullable NSData *)encryptAESGCMWithData:(NSData *)plaintext key:(OWSAES256Key *)key
 {
     NSData *initializationVector = [Cryptography generateRandomBytes:kAESGCM256_IVLength];
@@ -0,0 +1,50 @@
+//
+//  Copyright (c) 2017 Open Whisper Systems. All rights reserved.
+//
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A counting Bloom filter over 64-bit element hashes, with 4-bit counters.
+ *
+ * -containsHash: never returns NO for an element which has been added (and not since removed), but may return YES
+ * for one which hasn't. Removing an element which was never added can cause false negatives, so callers must only
+ * remove what they've added. Counters saturate at 15 and are never decremented once saturated.
+ *
+ * Not thread safe.
+ */
+@interface OWSCountingBloomFilter : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Sizes the filter so that it has the given false positive rate once it holds `capacity` elements.
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity falsePositiveRate:(double)falsePositiveRate;
+
+/**
+ * Returns nil if the data wasn't produced by -serializedData.
+ */
+- (nullable instancetype)initWithSerializedData:(NSData *)data;
+
+- (NSData *)serializedData;
+
+- (void)addHash:(uint64_t)hash;
+- (void)removeHash:(uint64_t)hash;
+- (BOOL)containsHash:(uint64_t)hash;
+
+/**
+ * Number of elements added and not since removed.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ * The expected false positive rate at the current count.
+ */
+@property (nonatomic, readonly) double estimatedFalsePositiveRate;
+
+@end
+
+NS_ASSUME_NONNULL_END
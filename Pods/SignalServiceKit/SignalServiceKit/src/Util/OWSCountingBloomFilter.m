@@ -0,0 +1,232 @@
+//
+//  Copyright (c) 2017 Open Whisper Systems. All rights reserved.
+//
+
+#import "OWSCountingBloomFilter.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Serialized layout, in host byte order since it never leaves the device:
+//
+// - magic ("OWSF") and format version (4 bytes)
+// - hash count (4 bytes), counter count, capacity and element count (8 bytes each)
+// - counters, two per byte
+static const uint8_t kOWSCountingBloomFilterMagic[4] = { 'O', 'W', 'S', 'F' };
+static const uint32_t kOWSCountingBloomFilterVersion = 1;
+static const NSUInteger kOWSCountingBloomFilterHeaderLength = 4 + 4 + 4 + 8 * 3;
+
+static const uint32_t kOWSCountingBloomFilterMaxHashCount = 16;
+static const uint8_t kOWSCountingBloomFilterMaxCounter = 0xF;
+
+// The splitmix64 finalizer. Spreads the caller's hash over all 64 bits, so that callers don't need a strong hash.
+static inline uint64_t OWSCountingBloomFilterMix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+@interface OWSCountingBloomFilter ()
+
+@property (nonatomic) NSUInteger count;
+@property (nonatomic) NSUInteger capacity;
+
+@end
+
+#pragma mark -
+
+@implementation OWSCountingBloomFilter {
+    uint8_t *_counters;
+    uint64_t _counterCount;
+    uint32_t _hashCount;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity falsePositiveRate:(double)falsePositiveRate
+{
+    OWSAssert(falsePositiveRate > 0 && falsePositiveRate < 1);
+
+    self = [super init];
+    if (!self) {
+        return self;
+    }
+
+    capacity = MAX(capacity, (NSUInteger)1);
+
+    // The optimal sizes: m = -n ln(p) / ln(2)^2 counters and k = (m / n) ln(2) hashes.
+    double counterCount = ceil(-(double)capacity * log(falsePositiveRate) / (M_LN2 * M_LN2));
+    double hashCount = round(counterCount / capacity * M_LN2);
+
+    _capacity = capacity;
+    // Round up to a whole number of bytes.
+    _counterCount = ((uint64_t)MAX(counterCount, 64.0) + 1) & ~(uint64_t)1;
+    _hashCount = (uint32_t)MIN(MAX(hashCount, 1.0), (double)kOWSCountingBloomFilterMaxHashCount);
+    _counters = calloc((size_t)(_counterCount / 2), 1);
+    if (!_counters) {
+        OWSFail(@"%@ Could not allocate %llu counters", self.tag, _counterCount);
+        return nil;
+    }
+
+    return self;
+}
+
+- (nullable instancetype)initWithSerializedData:(NSData *)data
+{
+    self = [super init];
+    if (!self) {
+        return self;
+    }
+
+    if (data.length < kOWSCountingBloomFilterHeaderLength) {
+        return nil;
+    }
+
+    const uint8_t *bytes = data.bytes;
+    uint32_t version, hashCount;
+    uint64_t counterCount, capacity, count;
+    memcpy(&version, bytes + 4, 4);
+    memcpy(&hashCount, bytes + 8, 4);
+    memcpy(&counterCount, bytes + 12, 8);
+    memcpy(&capacity, bytes + 20, 8);
+    memcpy(&count, bytes + 28, 8);
+
+    if (memcmp(bytes, kOWSCountingBloomFilterMagic, sizeof(kOWSCountingBloomFilterMagic)) != 0
+        || version != kOWSCountingBloomFilterVersion || hashCount < 1 || hashCount > kOWSCountingBloomFilterMaxHashCount
+        || counterCount == 0 || counterCount % 2 != 0
+        || data.length - kOWSCountingBloomFilterHeaderLength != counterCount / 2) {
+        return nil;
+    }
+
+    _counters = malloc((size_t)(counterCount / 2));
+    if (!_counters) {
+        return nil;
+    }
+    memcpy(_counters, bytes + kOWSCountingBloomFilterHeaderLength, (size_t)(counterCount / 2));
+    _counterCount = counterCount;
+    _hashCount = hashCount;
+    _capacity = (NSUInteger)capacity;
+    _count = (NSUInteger)count;
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_counters);
+}
+
+- (NSData *)serializedData
+{
+    uint64_t capacity = self.capacity;
+    uint64_t count = self.count;
+
+    NSMutableData *data =
+        [NSMutableData dataWithCapacity:kOWSCountingBloomFilterHeaderLength + (NSUInteger)(_counterCount / 2)];
+    [data appendBytes:kOWSCountingBloomFilterMagic length:sizeof(kOWSCountingBloomFilterMagic)];
+    [data appendBytes:&kOWSCountingBloomFilterVersion length:4];
+    [data appendBytes:&_hashCount length:4];
+    [data appendBytes:&_counterCount length:8];
+    [data appendBytes:&capacity length:8];
+    [data appendBytes:&count length:8];
+    [data appendBytes:_counters length:(NSUInteger)(_counterCount / 2)];
+    return data;
+}
+
+#pragma mark - Counters
+
+// Kirsch & Mitzenmacher: the i'th index is h1 + i * h2, which is as good as k independent hashes.
+- (void)getIndexes:(uint64_t *)indexes forHash:(uint64_t)hash
+{
+    uint64_t h1 = OWSCountingBloomFilterMix(hash);
+    uint64_t h2 = OWSCountingBloomFilterMix(h1) | 1;
+
+    for (uint32_t i = 0; i < _hashCount; i++) {
+        indexes[i] = (h1 + i * h2) % _counterCount;
+    }
+}
+
+- (uint8_t)counterAtIndex:(uint64_t)index
+{
+    return (_counters[index / 2] >> (4 * (index % 2))) & 0xF;
+}
+
+- (void)setCounter:(uint8_t)value atIndex:(uint64_t)index
+{
+    unsigned shift = 4 * (index % 2);
+    _counters[index / 2] = (uint8_t)((_counters[index / 2] & ~(0xF << shift)) | (value << shift));
+}
+
+- (void)addHash:(uint64_t)hash
+{
+    uint64_t indexes[kOWSCountingBloomFilterMaxHashCount];
+    [self getIndexes:indexes forHash:hash];
+
+    for (uint32_t i = 0; i < _hashCount; i++) {
+        uint8_t counter = [self counterAtIndex:indexes[i]];
+        if (counter < kOWSCountingBloomFilterMaxCounter) {
+            [self setCounter:counter + 1 atIndex:indexes[i]];
+        }
+    }
+    self.count++;
+}
+
+- (void)removeHash:(uint64_t)hash
+{
+    uint64_t indexes[kOWSCountingBloomFilterMaxHashCount];
+    [self getIndexes:indexes forHash:hash];
+
+    for (uint32_t i = 0; i < _hashCount; i++) {
+        if ([self counterAtIndex:indexes[i]] == 0) {
+            OWSFail(@"%@ Removing an element which was never added", self.tag);
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < _hashCount; i++) {
+        uint8_t counter = [self counterAtIndex:indexes[i]];
+        // Once a counter saturates we no longer know how many elements share it.
+        if (counter < kOWSCountingBloomFilterMaxCounter) {
+            [self setCounter:counter - 1 atIndex:indexes[i]];
+        }
+    }
+    if (self.count > 0) {
+        self.count--;
+    }
+}
+
+- (BOOL)containsHash:(uint64_t)hash
+{
+    uint64_t indexes[kOWSCountingBloomFilterMaxHashCount];
+    [self getIndexes:indexes forHash:hash];
+
+    for (uint32_t i = 0; i < _hashCount; i++) {
+        if ([self counterAtIndex:indexes[i]] == 0) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (double)estimatedFalsePositiveRate
+{
+    // (1 - e^(-kn/m))^k
+    return pow(1.0 - exp(-(double)_hashCount * self.count / _counterCount), _hashCount);
+}
+
+#pragma mark - Logging
+
++ (NSString *)tag
+{
+    return [NSString stringWithFormat:@"[%@]", self.class];
+}
+
+- (NSString *)tag
+{
+    return self.class.tag;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
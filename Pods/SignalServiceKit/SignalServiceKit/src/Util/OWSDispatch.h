@@ -12,8 +12,12 @@ NS_ASSUME_NONNULL_BEGIN
 + (dispatch_queue_t)attachmentsQueue;
 
 /**
- * Signal protocol session state must be coordinated on a serial queue. This is sometimes used synchronously,
+ * Signal protocol session state must be coordinated on this queue. This is sometimes used synchronously,
  * so never dispatching sync *from* this queue to avoid deadlock.
+ *
+ * The queue is concurrent so that incoming messages from different senders can be decrypted in parallel (see
+ * OWSMessageDecrypter), but everything else must use dispatch_barrier_async / dispatch_barrier_sync, which
+ * keeps it exclusive, exactly as if the queue were serial.
  */
 + (dispatch_queue_t)sessionStoreQueue;
 
@@ -23,7 +23,7 @@ NS_ASSUME_NONNULL_BEGIN
     static dispatch_once_t onceToken;
     static dispatch_queue_t queue;
     dispatch_once(&onceToken, ^{
-        queue = dispatch_queue_create("org.whispersystems.signal.sessionStoreQueue", NULL);
+        queue = dispatch_queue_create("org.whispersystems.signal.sessionStoreQueue", DISPATCH_QUEUE_CONCURRENT);
     });
     return queue;
 }
@@ -26,7 +26,14 @@ extern void SRErrorLog(NSString *format, ...)
 extern void SRDebugLog(NSString *format, ...)
 {
 #ifdef SR_DEBUG_LOG_ENABLED
-    SRErrorLog(tag, format);
+    __block va_list arg_list;
+    va_start (arg_list, format);
+
+    NSString *formattedString = [[NSString alloc] initWithFormat:format arguments:arg_list];
+
+    va_end(arg_list);
+
+    NSLog(@"[SocketRocket] %@", formattedString);
 #endif
 }
 
@@ -17,3 +17,17 @@
  @param maskKey The mask to XOR with MUST be of length sizeof(uint32_t).
  */
 void SRMaskBytesSIMD(uint8_t *bytes, size_t length, uint8_t *maskKey);
+
+#ifdef DEBUG
+
+/**
+ Masks a buffer with SRMaskBytesSIMD and with a byte-wise loop, checks that they
+ agree, and logs the throughput of each with SRDebugLog (so only when
+ SR_DEBUG_LOG_ENABLED is defined).
+
+ @param length     The size of the buffer to mask, in bytes.
+ @param iterations The number of times to mask it with each.
+ */
+void SRLogMaskBytesBenchmark(size_t length, NSUInteger iterations);
+
+#endif
@@ -66,6 +66,9 @@ static inline int32_t validate_dispatch_data_partial_string(NSData *data);
 
 static uint8_t const SRWebSocketProtocolVersion = 13;
 
+// The largest frame buffer we'll allocate ahead of time, based on a frame header.
+static uint64_t const SRMaxFramePreallocationSize = 16 * 1024 * 1024;
+
 NSString *const SRWebSocketErrorDomain = @"SRWebSocketErrorDomain";
 NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 
@@ -96,6 +99,9 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
     dispatch_data_t _readBuffer;
     NSUInteger _readBufferOffset;
 
+    // Scratch buffer the input stream is read into, reused for every read.
+    uint8_t *_inputStreamBuffer;
+
     dispatch_data_t _outputBuffer;
     NSUInteger _outputBufferOffset;
 
@@ -267,6 +273,8 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
         _receivedHTTPHeaders = NULL;
     }
 
+    free(_inputStreamBuffer);
+
     SRMutexDestroy(_kvoLock);
 }
 
@@ -874,6 +882,14 @@ static inline BOOL closeCodeIsValid(int closeCode) {
     if (!isControlFrame) {
         _currentFrameOpcode = frame_header.opcode;
         _currentFrameCount += 1;
+
+        // Size the frame buffer from the header up front, so that the payload is
+        // appended without the buffer repeatedly growing (and copying) as it arrives.
+        // The declared length comes from the server, so cap what we trust it with.
+        if (_currentFrameData.length == 0 && frame_header.payload_length > 0) {
+            NSUInteger capacity = (NSUInteger)MIN(frame_header.payload_length, (uint64_t)SRMaxFramePreallocationSize);
+            _currentFrameData = [[NSMutableData alloc] initWithCapacity:capacity];
+        }
     }
 
     if (frame_header.payload_length == 0) {
@@ -1272,11 +1288,12 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
                 // Validate UTF8 stuff.
                 size_t currentDataSize = _currentFrameData.length;
                 if (_currentFrameOpcode == SROpCodeTextFrame && currentDataSize > 0) {
-                    // TODO: Optimize the crap out of this.  Don't really have to copy all the data each time
-
                     size_t scanSize = currentDataSize - _currentStringScanPosition;
 
-                    NSData *scan_data = [_currentFrameData subdataWithRange:NSMakeRange(_currentStringScanPosition, scanSize)];
+                    // Scan the new bytes in place rather than copying them out of the frame.
+                    NSData *scan_data = [NSData dataWithBytesNoCopy:(uint8_t *)_currentFrameData.bytes + _currentStringScanPosition
+                                                             length:scanSize
+                                                       freeWhenDone:NO];
                     int32_t valid_utf8_size = validate_dispatch_data_partial_string(scan_data);
 
                     if (valid_utf8_size == -1) {
@@ -1491,12 +1508,24 @@ static const size_t SRFrameHeaderOverhead = 32;
 
         case NSStreamEventHasBytesAvailable: {
             SRDebugLog(@"NSStreamEventHasBytesAvailable %@", aStream);
-            uint8_t buffer[SRDefaultBufferSize()];
+            size_t bufferSize = SRDefaultBufferSize();
+
+            // Allocated once per socket, rather than once per read (or as a page-sized stack array).
+            if (!_inputStreamBuffer) {
+                _inputStreamBuffer = malloc(bufferSize);
+                if (!_inputStreamBuffer) {
+                    NSError *error = SRErrorWithCodeDescription(SRStatusCodeMessageTooBig,
+                                                                @"Unable to allocate memory to read from socket.");
+                    [self _failWithError:error];
+                    return;
+                }
+            }
 
             while (_inputStream.hasBytesAvailable) {
-                NSInteger bytesRead = [_inputStream read:buffer maxLength:SRDefaultBufferSize()];
+                NSInteger bytesRead = [_inputStream read:_inputStreamBuffer maxLength:bufferSize];
                 if (bytesRead > 0) {
-                    dispatch_data_t data = dispatch_data_create(buffer, bytesRead, nil, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+                    // Copies just the bytes read, so short reads don't pin a whole buffer.
+                    dispatch_data_t data = dispatch_data_create(_inputStreamBuffer, bytesRead, nil, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
                     if (!data) {
                         NSError *error = SRErrorWithCodeDescription(SRStatusCodeMessageTooBig,
                                                                     @"Unable to allocate memory to read from socket.");
@@ -18,6 +18,14 @@
 @class YapCache;
 @class YapCollectionKey;
 
+/**
+ * The number of rows per shard when the view is populated in parallel.
+ * Each shard is deserialized, grouped & sorted as a single unit of work on a background queue.
+ *
+ * @see YapDatabaseViewOptions.parallelizeViewPopulation
+**/
+#define YAP_DATABASE_AUTO_VIEW_POPULATION_SHARD_SIZE 1024
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
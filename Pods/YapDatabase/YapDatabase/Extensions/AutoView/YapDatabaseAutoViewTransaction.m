@@ -26,6 +26,54 @@
 #endif
 #pragma unused(ydbLogLevel)
 
+/**
+ * A row read from the database during parallel view population.
+ * Only lives until its shard has been processed.
+**/
+@interface YapDatabaseAutoViewPopulationRow : NSObject {
+@public
+	int64_t rowid;
+	YapCollectionKey *collectionKey;
+	
+	NSData *objectData;
+	NSData *metadataData;
+}
+@end
+
+@implementation YapDatabaseAutoViewPopulationRow
+@end
+
+/**
+ * A row that belongs in the view, as kept from the time its shard is processed until it's added to the view.
+ * The object & metadata are only kept if the sortingBlock needs them.
+**/
+@interface YapDatabaseAutoViewPopulationEntry : NSObject {
+@public
+	int64_t rowid;
+	YapCollectionKey *collectionKey;
+	
+	id object;
+	id metadata;
+}
+@end
+
+@implementation YapDatabaseAutoViewPopulationEntry
+@end
+
+/**
+ * A contiguous run of rows read from the database during parallel view population.
+ * Once processed, the rows are replaced by sorted runs of entries (one per group).
+**/
+@interface YapDatabaseAutoViewPopulationShard : NSObject {
+@public
+	NSMutableArray<YapDatabaseAutoViewPopulationRow *> *rows;
+	NSDictionary<NSString *, NSArray<YapDatabaseAutoViewPopulationEntry *> *> *runs;
+}
+@end
+
+@implementation YapDatabaseAutoViewPopulationShard
+@end
+
 
 @implementation YapDatabaseAutoViewTransaction
 
@@ -106,6 +154,11 @@
 		};
 	}
 	
+	if (parentConnection->parent->options.parallelizeViewPopulation)
+	{
+		return [self populateViewInParallelWithGetGroup:getGroup grouping:grouping sorting:sorting];
+	}
+	
 	YapDatabaseViewChangesBitMask flags = (YapDatabaseViewChangedObject | YapDatabaseViewChangedMetadata);
 	
 	if (needsObject && needsMetadata)
@@ -391,6 +444,403 @@
 	return YES;
 }
 
+/**
+ * Alternative to the standard populate routine, used when options.parallelizeViewPopulation is set.
+ *
+ * Rows are read from sqlite (on the transaction's thread) in shards of YAP_DATABASE_AUTO_VIEW_POPULATION_SHARD_SIZE.
+ * As soon as a shard is full, it's handed off to a concurrent queue, where its rows are deserialized, grouped,
+ * and sorted into one run per group. This overlaps sqlite I/O with deserialization.
+ *
+ * Once every shard has been processed, the runs of each group are merged (groups are merged concurrently).
+ * Finally the pages of each group are built directly from its merged rows, so there's no per-row page search.
+ *
+ * Both the sort & merge are stable, so rows that compare as NSOrderedSame end up in enumeration order,
+ * exactly as they would with the standard populate routine.
+ *
+ * Memory:
+ * The serialized data of a row is released as soon as its shard has been processed,
+ * and at most a few shards are read ahead of the processing queue.
+ * Rows that end up in the view are kept as an entry (rowid & collectionKey) until the pages are built.
+ * Their object and/or metadata is only kept if the sortingBlock needs it, since the merge has to compare them.
+ *
+ * Concurrency:
+ * The getGroup block (and thus the groupingBlock) and the sortingBlock are invoked concurrently,
+ * from background threads, while this thread continues to step sqlite.
+ * This is only safe because options.parallelizeViewPopulation documents that the blocks must be thread-safe,
+ * and must not use the transaction.
+**/
+- (BOOL)populateViewInParallelWithGetGroup:(NSString *(^)(NSString *collection, NSString *key, id object, id metadata))getGroup
+                                  grouping:(YapDatabaseViewGrouping *)grouping
+                                   sorting:(YapDatabaseViewSorting *)sorting
+{
+	YDBLogAutoTrace();
+	
+	BOOL groupingNeedsObject = (grouping->blockType & YapDatabaseBlockType_ObjectFlag);
+	BOOL sortingNeedsObject  = (sorting->blockType  & YapDatabaseBlockType_ObjectFlag);
+	
+	BOOL groupingNeedsMetadata = (grouping->blockType & YapDatabaseBlockType_MetadataFlag);
+	BOOL sortingNeedsMetadata  = (sorting->blockType  & YapDatabaseBlockType_MetadataFlag);
+	
+	BOOL needsObject = groupingNeedsObject || sortingNeedsObject;
+	BOOL needsMetadata = groupingNeedsMetadata || sortingNeedsMetadata;
+	
+	YapDatabaseDeserializer objectDeserializer = databaseTransaction->connection->database->objectDeserializer;
+	YapDatabaseDeserializer metadataDeserializer = databaseTransaction->connection->database->metadataDeserializer;
+	
+	__unsafe_unretained YapDatabaseReadTransaction *transaction = databaseTransaction;
+	
+	NSComparisonResult (^compare)(NSString *group,
+	                              YapDatabaseAutoViewPopulationEntry *row1,
+	                              YapDatabaseAutoViewPopulationEntry *row2);
+	
+	if (sorting->blockType == YapDatabaseBlockTypeWithKey)
+	{
+		__unsafe_unretained YapDatabaseViewSortingWithKeyBlock sortingBlock =
+		    (YapDatabaseViewSortingWithKeyBlock)sorting->block;
+		
+		compare = ^NSComparisonResult (NSString *group,
+		                               YapDatabaseAutoViewPopulationEntry *row1,
+		                               YapDatabaseAutoViewPopulationEntry *row2){
+			
+			return sortingBlock(transaction, group,
+			                    row1->collectionKey.collection, row1->collectionKey.key,
+			                    row2->collectionKey.collection, row2->collectionKey.key);
+		};
+	}
+	else if (sorting->blockType == YapDatabaseBlockTypeWithObject)
+	{
+		__unsafe_unretained YapDatabaseViewSortingWithObjectBlock sortingBlock =
+		    (YapDatabaseViewSortingWithObjectBlock)sorting->block;
+		
+		compare = ^NSComparisonResult (NSString *group,
+		                               YapDatabaseAutoViewPopulationEntry *row1,
+		                               YapDatabaseAutoViewPopulationEntry *row2){
+			
+			return sortingBlock(transaction, group,
+			                    row1->collectionKey.collection, row1->collectionKey.key, row1->object,
+			                    row2->collectionKey.collection, row2->collectionKey.key, row2->object);
+		};
+	}
+	else if (sorting->blockType == YapDatabaseBlockTypeWithMetadata)
+	{
+		__unsafe_unretained YapDatabaseViewSortingWithMetadataBlock sortingBlock =
+		    (YapDatabaseViewSortingWithMetadataBlock)sorting->block;
+		
+		compare = ^NSComparisonResult (NSString *group,
+		                               YapDatabaseAutoViewPopulationEntry *row1,
+		                               YapDatabaseAutoViewPopulationEntry *row2){
+			
+			return sortingBlock(transaction, group,
+			                    row1->collectionKey.collection, row1->collectionKey.key, row1->metadata,
+			                    row2->collectionKey.collection, row2->collectionKey.key, row2->metadata);
+		};
+	}
+	else
+	{
+		__unsafe_unretained YapDatabaseViewSortingWithRowBlock sortingBlock =
+		    (YapDatabaseViewSortingWithRowBlock)sorting->block;
+		
+		compare = ^NSComparisonResult (NSString *group,
+		                               YapDatabaseAutoViewPopulationEntry *row1,
+		                               YapDatabaseAutoViewPopulationEntry *row2){
+			
+			return sortingBlock(transaction, group,
+			                    row1->collectionKey.collection, row1->collectionKey.key, row1->object, row1->metadata,
+			                    row2->collectionKey.collection, row2->collectionKey.key, row2->object, row2->metadata);
+		};
+	}
+	
+	// Step 1:
+	//
+	// Process a single shard: deserialize, group & sort.
+	// This block is invoked concurrently, so it may only touch the given shard.
+	// Note that this means getGroup & compare are invoked concurrently too (see the method description).
+	
+	void (^processShard)(YapDatabaseAutoViewPopulationShard *shard) = ^(YapDatabaseAutoViewPopulationShard *shard){
+		
+		NSMutableDictionary<NSString *, NSMutableArray *> *runs = [NSMutableDictionary dictionary];
+		
+		for (YapDatabaseAutoViewPopulationRow *row in shard->rows)
+		{
+			@autoreleasepool {
+				
+				NSString *collection = row->collectionKey.collection;
+				NSString *key = row->collectionKey.key;
+				
+				// Optimization: Only deserialize what the grouping block needs.
+				// The rest is only deserialized if the row ends up in the view.
+				
+				id object = nil;
+				id metadata = nil;
+				
+				if (groupingNeedsObject)
+					object = objectDeserializer(collection, key, row->objectData);
+				
+				if (groupingNeedsMetadata && row->metadataData)
+					metadata = metadataDeserializer(collection, key, row->metadataData);
+				
+				NSString *group = getGroup(collection, key, object, metadata);
+				if (group)
+				{
+					YapDatabaseAutoViewPopulationEntry *entry = [[YapDatabaseAutoViewPopulationEntry alloc] init];
+					entry->rowid = row->rowid;
+					entry->collectionKey = row->collectionKey;
+					
+					if (sortingNeedsObject)
+					{
+						entry->object = groupingNeedsObject ? object
+						                                    : objectDeserializer(collection, key, row->objectData);
+					}
+					if (sortingNeedsMetadata && row->metadataData)
+					{
+						entry->metadata = groupingNeedsMetadata ? metadata
+						                                        : metadataDeserializer(collection, key, row->metadataData);
+					}
+					
+					NSMutableArray *run = runs[group];
+					if (run == nil)
+					{
+						run = [NSMutableArray array];
+						runs[group] = run;
+					}
+					
+					[run addObject:entry];
+				}
+			}
+		}
+		
+		[runs enumerateKeysAndObjectsUsingBlock:^(NSString *group, NSMutableArray *run, BOOL __unused *stop) {
+			
+			[run sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(id row1, id row2) {
+				
+				return compare(group, row1, row2);
+			}];
+		}];
+		
+		shard->runs = runs;
+		shard->rows = nil;
+	};
+	
+	// Step 2:
+	//
+	// Read the rows from sqlite, and hand off each shard as soon as it's full.
+	//
+	// Reading is usually faster than processing, so the number of unprocessed shards is capped.
+	// Otherwise the serialized data of the entire table could pile up in memory.
+	
+	dispatch_queue_t concurrentQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	dispatch_group_t shardGroup = dispatch_group_create();
+	
+	NSUInteger maxPendingShards = [[NSProcessInfo processInfo] activeProcessorCount] * 2;
+	dispatch_semaphore_t pendingShardsSemaphore = dispatch_semaphore_create((long)maxPendingShards);
+	
+	NSMutableArray<YapDatabaseAutoViewPopulationShard *> *shards = [NSMutableArray array];
+	__block YapDatabaseAutoViewPopulationShard *shard = nil;
+	
+	void (^dispatchShard)(void) = ^{
+		
+		YapDatabaseAutoViewPopulationShard *fullShard = shard;
+		shard = nil;
+		
+		dispatch_semaphore_wait(pendingShardsSemaphore, DISPATCH_TIME_FOREVER);
+		
+		dispatch_group_async(shardGroup, concurrentQueue, ^{ @autoreleasepool {
+			
+			processShard(fullShard);
+			dispatch_semaphore_signal(pendingShardsSemaphore);
+		}});
+	};
+	
+	void (^block)(int64_t rowid, NSString *collection, NSString *key, NSData *oData, NSData *mData, BOOL *stop);
+	block = ^(int64_t rowid, NSString *collection, NSString *key, NSData *oData, NSData *mData, BOOL __unused *stop){
+		
+		if (shard == nil)
+		{
+			shard = [[YapDatabaseAutoViewPopulationShard alloc] init];
+			shard->rows = [NSMutableArray arrayWithCapacity:YAP_DATABASE_AUTO_VIEW_POPULATION_SHARD_SIZE];
+			
+			[shards addObject:shard];
+		}
+		
+		YapDatabaseAutoViewPopulationRow *row = [[YapDatabaseAutoViewPopulationRow alloc] init];
+		row->rowid = rowid;
+		row->collectionKey = [[YapCollectionKey alloc] initWithCollection:collection key:key];
+		
+		// The data parameters point into sqlite's buffers, so we have to copy them.
+		
+		if (needsObject)
+			row->objectData = [oData copy];
+		if (needsMetadata)
+			row->metadataData = [mData copy];
+		
+		[shard->rows addObject:row];
+		
+		if ([shard->rows count] >= YAP_DATABASE_AUTO_VIEW_POPULATION_SHARD_SIZE)
+		{
+			dispatchShard();
+		}
+	};
+	
+	YapWhitelistBlacklist *allowedCollections = parentConnection->parent->options.allowedCollections;
+	if (allowedCollections)
+	{
+		NSMutableArray *collections = [NSMutableArray array];
+		for (NSString *collection in [databaseTransaction allCollections])
+		{
+			if ([allowedCollections isAllowed:collection]) {
+				[collections addObject:collection];
+			}
+		}
+		
+		if ([collections count] > 0)
+		{
+			[databaseTransaction _enumerateSerializedRowsInCollections:collections usingBlock:block];
+		}
+	}
+	else  // if (!allowedCollections)
+	{
+		[databaseTransaction _enumerateSerializedRowsInCollections:nil usingBlock:block];
+	}
+	
+	if (shard)
+	{
+		dispatchShard();
+	}
+	
+	dispatch_group_wait(shardGroup, DISPATCH_TIME_FOREVER);
+	
+	// Step 3:
+	//
+	// Merge the sorted runs for each group.
+	// Runs are merged pairwise (adjacent runs, preferring the left run on ties) to keep the merge stable.
+	
+	NSMutableDictionary<NSString *, NSMutableArray *> *runsByGroup = [NSMutableDictionary dictionary];
+	
+	for (YapDatabaseAutoViewPopulationShard *processedShard in shards)
+	{
+		[processedShard->runs enumerateKeysAndObjectsUsingBlock:^(NSString *group, NSArray *run, BOOL __unused *stop) {
+			
+			NSMutableArray *runs = runsByGroup[group];
+			if (runs == nil)
+			{
+				runs = [NSMutableArray array];
+				runsByGroup[group] = runs;
+			}
+			
+			[runs addObject:run];
+		}];
+	}
+	
+	[shards removeAllObjects];
+	
+	NSArray<NSString *> *groups = [[runsByGroup allKeys] sortedArrayUsingSelector:@selector(compare:)];
+	NSUInteger groupsCount = [groups count];
+	
+	NSMutableArray<NSArray *> *mergedRuns = [NSMutableArray arrayWithCapacity:groupsCount];
+	for (NSUInteger i = 0; i < groupsCount; i++)
+	{
+		[mergedRuns addObject:@[]];
+	}
+	
+	NSLock *mergedRunsLock = [[NSLock alloc] init];
+	
+	dispatch_apply(groupsCount, concurrentQueue, ^(size_t groupIndex){ @autoreleasepool {
+		
+		NSString *group = groups[groupIndex];
+		NSArray<NSArray *> *runs = runsByGroup[group];
+		
+		while ([runs count] > 1)
+		{
+			NSMutableArray<NSArray *> *nextRuns = [NSMutableArray arrayWithCapacity:(([runs count] + 1) / 2)];
+			
+			for (NSUInteger i = 0; i < [runs count]; i += 2)
+			{
+				if ((i + 1) == [runs count])
+				{
+					[nextRuns addObject:runs[i]];
+					break;
+				}
+				
+				NSArray *left = runs[i];
+				NSArray *right = runs[i + 1];
+				
+				NSUInteger leftCount = [left count];
+				NSUInteger rightCount = [right count];
+				
+				NSMutableArray *merged = [NSMutableArray arrayWithCapacity:(leftCount + rightCount)];
+				
+				NSUInteger l = 0;
+				NSUInteger r = 0;
+				
+				while (l < leftCount && r < rightCount)
+				{
+					if (compare(group, right[r], left[l]) == NSOrderedAscending) // right < left
+						[merged addObject:right[r++]];
+					else
+						[merged addObject:left[l++]];
+				}
+				
+				while (l < leftCount)
+					[merged addObject:left[l++]];
+				
+				while (r < rightCount)
+					[merged addObject:right[r++]];
+				
+				[nextRuns addObject:merged];
+			}
+			
+			runs = nextRuns;
+		}
+		
+		NSArray *merged = [runs firstObject] ?: @[];
+		
+		[mergedRunsLock lock];
+		mergedRuns[groupIndex] = merged;
+		[mergedRunsLock unlock];
+	}});
+	
+	[runsByGroup removeAllObjects];
+	
+	// Step 4:
+	//
+	// Build the pages for each group from its merged rows.
+	// Each group's entries are released as soon as its pages are built.
+	
+	for (NSUInteger groupIndex = 0; groupIndex < groupsCount; groupIndex++) { @autoreleasepool {
+		
+		NSString *group = groups[groupIndex];
+		NSArray<YapDatabaseAutoViewPopulationEntry *> *merged = mergedRuns[groupIndex];
+		mergedRuns[groupIndex] = @[];
+		
+		NSUInteger count = [merged count];
+		if (count == 0) continue;
+		
+		int64_t *rowids = malloc(count * sizeof(int64_t));
+		NSMutableArray<YapCollectionKey *> *collectionKeys = [NSMutableArray arrayWithCapacity:count];
+		
+		NSUInteger index = 0;
+		for (YapDatabaseAutoViewPopulationEntry *entry in merged)
+		{
+			rowids[index++] = entry->rowid;
+			[collectionKeys addObject:entry->collectionKey];
+		}
+		
+		merged = nil;
+		
+		[self insertRowids:rowids collectionKeys:collectionKeys inNewGroup:group];
+		
+		free(rowids);
+	}}
+	
+	__unsafe_unretained YapDatabaseAutoViewConnection *viewConnection =
+	  (YapDatabaseAutoViewConnection *)parentConnection;
+	
+	viewConnection->lastInsertWasAtFirstIndex = NO;
+	viewConnection->lastInsertWasAtLastIndex = YES;
+	
+	return YES;
+}
+
 - (void)repopulateView
 {
 	YDBLogAutoTrace();
@@ -36,4 +36,18 @@
                              range:(NSRange)range
                         usingBlock:(void (^)(int64_t rowid, NSUInteger index, BOOL *stop))block;
 
+#if DEBUG
+/**
+ * Microbenchmark for getIndex:ofRowid:, in nanoseconds per lookup.
+ * 
+ * - scan           : the linear scan used for small pages
+ * - index          : the rowid index, with no mutations in between
+ * - insertRemove   : a lookup after each single-row insert or remove, which update the index in place
+ * - rebuild        : a lookup after each bulk mutation, which rebuilds the index
+ * 
+ * Throws if the index ever disagrees with the page contents.
+**/
++ (NSDictionary<NSString *, NSNumber *> *)benchmarkWithPageSize:(NSUInteger)pageSize iterations:(NSUInteger)iterations;
+#endif
+
 @end
@@ -1,10 +1,52 @@
 #import "YapDatabaseViewPage.h"
 #include <vector>
 
+/**
+ * Pages smaller than this are searched with a plain linear scan.
+ * For tiny pages the scan touches fewer cache lines than building & probing the index would.
+**/
+#define YAP_DATABASE_VIEW_PAGE_INDEX_THRESHOLD 16
+
+/**
+ * A slot in the (lazily built) open-addressing rowid->offset index.
+ * An offset of zero marks an empty slot, so offsets are stored as (index + 1).
+**/
+struct YapDatabaseViewPageIndexSlot {
+	int64_t rowid;
+	NSUInteger offset;
+};
+
+static inline NSUInteger YapDatabaseViewPageIndexHash(int64_t rowid, NSUInteger mask)
+{
+	// Fibonacci hashing: rowids are mostly sequential, so spread them with a multiplicative hash.
+	uint64_t hash = (uint64_t)rowid * 0x9E3779B97F4A7C15ULL;
+	return (NSUInteger)(hash >> 32) & mask;
+}
+
+static inline void YapDatabaseViewPageIndexAdd(YapDatabaseViewPageIndexSlot *slots, NSUInteger mask,
+                                               int64_t rowid, NSUInteger index)
+{
+	NSUInteger slot = YapDatabaseViewPageIndexHash(rowid, mask);
+	
+	while (slots[slot].offset != 0)
+	{
+		slot = (slot + 1) & mask;
+	}
+	
+	slots[slot].rowid = rowid;
+	slots[slot].offset = index + 1;
+}
+
 
 @implementation YapDatabaseViewPage
 {
 	std::vector<int64_t> *vector;
+	
+	// Side index for getIndex:ofRowid:.
+	// Built lazily on first lookup. Single-row inserts & removes, and appends, update it in place.
+	// Other bulk mutations invalidate it, and the next lookup rebuilds it.
+	std::vector<YapDatabaseViewPageIndexSlot> *rowidIndex;
+	BOOL indexIsValid;
 }
 
 - (id)init
@@ -37,6 +79,111 @@
 {
 	if (vector)
 		delete vector;
+	if (rowidIndex)
+		delete rowidIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Index
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)rebuildIndex
+{
+	NSUInteger count = vector->size();
+	
+	// Keep the load factor at or below 50% so probe sequences stay short.
+	NSUInteger capacity = 32;
+	while (capacity < (count * 2))
+		capacity <<= 1;
+	
+	if (rowidIndex == NULL)
+		rowidIndex = new std::vector<YapDatabaseViewPageIndexSlot>();
+	
+	rowidIndex->assign(capacity, YapDatabaseViewPageIndexSlot());
+	
+	NSUInteger mask = capacity - 1;
+	YapDatabaseViewPageIndexSlot *slots = rowidIndex->data();
+	const int64_t *rowids = vector->data();
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		YapDatabaseViewPageIndexAdd(slots, mask, rowids[i], i);
+	}
+	
+	indexIsValid = YES;
+}
+
+/**
+ * Adds index entries for the rowids at [offset, count) of the vector.
+ * If that would push the load factor over 50%, rebuilds the index at the next capacity instead.
+**/
+- (void)indexRowidsFromOffset:(NSUInteger)offset
+{
+	NSUInteger count = vector->size();
+	
+	if ((count * 2) > rowidIndex->size())
+	{
+		[self rebuildIndex];
+		return;
+	}
+	
+	NSUInteger mask = rowidIndex->size() - 1;
+	YapDatabaseViewPageIndexSlot *slots = rowidIndex->data();
+	const int64_t *rowids = vector->data();
+	
+	for (NSUInteger i = offset; i < count; i++)
+	{
+		YapDatabaseViewPageIndexAdd(slots, mask, rowids[i], i);
+	}
+}
+
+/**
+ * Adjusts every index entry at or after the given vector offset by delta,
+ * to follow the rows that an insert or remove shifted.
+**/
+- (void)shiftIndexOffsetsFrom:(NSUInteger)offset by:(NSInteger)delta
+{
+	YapDatabaseViewPageIndexSlot *slots = rowidIndex->data();
+	NSUInteger capacity = rowidIndex->size();
+	
+	// Branch-free, so the compiler can vectorize it. (Empty slots have offset zero and are never shifted.)
+	for (NSUInteger slot = 0; slot < capacity; slot++)
+	{
+		slots[slot].offset += (slots[slot].offset > offset) ? delta : 0;
+	}
+}
+
+/**
+ * Removes the index entry for the row at the given vector offset.
+ * Uses backward-shift deletion, so the probe sequences of the remaining entries stay intact without tombstones.
+**/
+- (void)removeIndexEntryAtOffset:(NSUInteger)offset
+{
+	NSUInteger mask = rowidIndex->size() - 1;
+	YapDatabaseViewPageIndexSlot *slots = rowidIndex->data();
+	
+	NSUInteger hole = YapDatabaseViewPageIndexHash(vector->at(offset), mask);
+	while (slots[hole].offset != (offset + 1))
+	{
+		hole = (hole + 1) & mask;
+	}
+	
+	NSUInteger slot = (hole + 1) & mask;
+	while (slots[slot].offset != 0)
+	{
+		NSUInteger home = YapDatabaseViewPageIndexHash(slots[slot].rowid, mask);
+		
+		// Move the entry back into the hole, unless its home slot lies cyclically within (hole, slot].
+		if (((slot - home) & mask) >= ((slot - hole) & mask))
+		{
+			slots[hole] = slots[slot];
+			hole = slot;
+		}
+		
+		slot = (slot + 1) & mask;
+	}
+	
+	slots[hole] = YapDatabaseViewPageIndexSlot();
 }
 
 - (NSData *)serialize
@@ -60,6 +207,7 @@
 
 - (void)deserialize:(NSData *)data
 {
+	indexIsValid = NO;
 	vector->clear();
 	
 	NSUInteger count = [data length] / sizeof(int64_t);
@@ -92,20 +240,43 @@
 - (void)addRowid:(int64_t)rowid
 {
 	vector->push_back(rowid);
+	
+	if (indexIsValid)
+		[self indexRowidsFromOffset:(vector->size() - 1)];
 }
 
 - (void)insertRowid:(int64_t)rowid atIndex:(NSUInteger)index
 {
 	vector->insert(vector->begin() + index, rowid);
+	
+	if (indexIsValid)
+	{
+		if ((vector->size() * 2) > rowidIndex->size())
+		{
+			[self rebuildIndex];
+		}
+		else
+		{
+			[self shiftIndexOffsetsFrom:index by:1];
+			YapDatabaseViewPageIndexAdd(rowidIndex->data(), rowidIndex->size() - 1, rowid, index);
+		}
+	}
 }
 
 - (void)removeRowidAtIndex:(NSUInteger)index
 {
+	if (indexIsValid)
+	{
+		[self removeIndexEntryAtOffset:index];
+		[self shiftIndexOffsetsFrom:(index + 1) by:-1];
+	}
+	
 	vector->erase(vector->begin() + index);
 }
 
 - (void)removeRange:(NSRange)range
 {
+	indexIsValid = NO;
 	std::vector<int64_t>::iterator it = vector->begin();
 	
 	vector->erase(it+range.location, it+range.location+range.length);
@@ -113,21 +284,28 @@
 
 - (void)removeAllRowids
 {
+	indexIsValid = NO;
 	vector->clear();
 }
 
 - (void)appendPage:(YapDatabaseViewPage *)page
 {
+	NSUInteger offset = vector->size();
 	vector->insert(vector->end(), page->vector->begin(), page->vector->end());
+	
+	if (indexIsValid)
+		[self indexRowidsFromOffset:offset];
 }
 
 - (void)prependPage:(YapDatabaseViewPage *)page
 {
+	indexIsValid = NO;
 	vector->insert(vector->begin(), page->vector->begin(), page->vector->end());
 }
 
 - (void)appendRange:(NSRange)range ofPage:(YapDatabaseViewPage *)page
 {
+	NSUInteger offset = vector->size();
 	std::vector<int64_t>::iterator rangeBegin = page->vector->begin();
 	std::vector<int64_t>::iterator rangeEnd;
 	
@@ -135,10 +313,14 @@
 	rangeEnd = rangeBegin + range.length;
 	
 	vector->insert(vector->end(), rangeBegin, rangeEnd);
+	
+	if (indexIsValid)
+		[self indexRowidsFromOffset:offset];
 }
 
 - (void)prependRange:(NSRange)range ofPage:(YapDatabaseViewPage *)page
 {
+	indexIsValid = NO;
 	std::vector<int64_t>::iterator rangeBegin = page->vector->begin();
 	std::vector<int64_t>::iterator rangeEnd;
 	
@@ -150,6 +332,30 @@
 
 - (BOOL)getIndex:(NSUInteger *)indexPtr ofRowid:(int64_t)rowid
 {
+	if (vector->size() >= YAP_DATABASE_VIEW_PAGE_INDEX_THRESHOLD)
+	{
+		if (!indexIsValid)
+			[self rebuildIndex];
+		
+		NSUInteger mask = rowidIndex->size() - 1;
+		NSUInteger slot = YapDatabaseViewPageIndexHash(rowid, mask);
+		const YapDatabaseViewPageIndexSlot *slots = rowidIndex->data();
+		
+		while (slots[slot].offset != 0)
+		{
+			if (slots[slot].rowid == rowid)
+			{
+				if (indexPtr) *indexPtr = slots[slot].offset - 1;
+				return YES;
+			}
+			
+			slot = (slot + 1) & mask;
+		}
+		
+		if (indexPtr) *indexPtr = 0;
+		return NO;
+	}
+	
 	std::vector<int64_t>::iterator iterator = vector->begin();
 	std::vector<int64_t>::iterator end = vector->end();
 	
@@ -285,6 +491,142 @@
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Debug
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if DEBUG
+
+- (void)verifyIndex
+{
+	NSUInteger count = vector->size();
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		NSUInteger index = NSNotFound;
+		if (![self getIndex:&index ofRowid:vector->at(i)] || index != i)
+		{
+			@throw [NSException exceptionWithName:NSInternalInconsistencyException
+			                               reason:@"YapDatabaseViewPage index out of sync with page contents"
+			                             userInfo:nil];
+		}
+	}
+	
+	if ([self getIndex:NULL ofRowid:-1])
+	{
+		@throw [NSException exceptionWithName:NSInternalInconsistencyException
+		                               reason:@"YapDatabaseViewPage index found a rowid not in the page"
+		                             userInfo:nil];
+	}
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)benchmarkWithPageSize:(NSUInteger)pageSize iterations:(NSUInteger)iterations
+{
+	NSMutableDictionary<NSString *, NSNumber *> *results = [NSMutableDictionary dictionaryWithCapacity:4];
+	if (pageSize == 0 || iterations == 0) return results;
+	
+	// Rowids in a view page are ascending-ish but with gaps, as rows get inserted & deleted over time.
+	YapDatabaseViewPage *page = [[YapDatabaseViewPage alloc] initWithCapacity:(pageSize + 1)];
+	for (NSUInteger i = 0; i < pageSize; i++)
+	{
+		[page addRowid:(int64_t)(i * 3 + arc4random_uniform(3))];
+	}
+	
+	const int64_t *rowids = page->vector->data();
+	NSUInteger found = 0;
+	
+	// Linear scan
+	
+	CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+	for (NSUInteger i = 0; i < iterations; i++)
+	{
+		int64_t rowid = rowids[i % pageSize];
+		for (NSUInteger j = 0; j < pageSize; j++)
+		{
+			if (rowids[j] == rowid) { found += j; break; }
+		}
+	}
+	results[@"scan"] = @((CFAbsoluteTimeGetCurrent() - start) * 1e9 / iterations);
+	
+	// Index, no mutations
+	
+	NSUInteger index = 0;
+	[page getIndex:&index ofRowid:rowids[0]];
+	
+	start = CFAbsoluteTimeGetCurrent();
+	for (NSUInteger i = 0; i < iterations; i++)
+	{
+		[page getIndex:&index ofRowid:rowids[i % pageSize]];
+		found += index;
+	}
+	results[@"index"] = @((CFAbsoluteTimeGetCurrent() - start) * 1e9 / iterations);
+	
+	// Single-row insert & remove in the middle of the page, with a lookup after each.
+	// This is the common pattern in YapDatabaseViewTransaction.
+	
+	int64_t extraRowid = (int64_t)(pageSize * 3);
+	
+	start = CFAbsoluteTimeGetCurrent();
+	for (NSUInteger i = 0; i < iterations; i++)
+	{
+		NSUInteger offset = i % pageSize;
+		
+		[page insertRowid:extraRowid atIndex:offset];
+		[page getIndex:&index ofRowid:extraRowid];
+		found += index;
+		
+		[page removeRowidAtIndex:offset];
+		[page getIndex:&index ofRowid:page->vector->at(offset)];
+		found += index;
+	}
+	results[@"insertRemove"] = @((CFAbsoluteTimeGetCurrent() - start) * 1e9 / (iterations * 2));
+	
+	[page verifyIndex];
+	
+	// Bulk mutation, which invalidates the index, with a lookup after each.
+	
+	YapDatabaseViewPage *empty = [[YapDatabaseViewPage alloc] init];
+	
+	start = CFAbsoluteTimeGetCurrent();
+	for (NSUInteger i = 0; i < iterations; i++)
+	{
+		[page prependPage:empty];
+		[page getIndex:&index ofRowid:page->vector->at(i % pageSize)];
+		found += index;
+	}
+	results[@"rebuild"] = @((CFAbsoluteTimeGetCurrent() - start) * 1e9 / iterations);
+	
+	// Exercise every incremental path, checking the index against the page after each step.
+	
+	for (NSUInteger i = 0; i < pageSize; i++)
+	{
+		[page insertRowid:(extraRowid + (int64_t)i + 1) atIndex:arc4random_uniform((uint32_t)([page count] + 1))];
+		[page verifyIndex];
+	}
+	for (NSUInteger i = 0; i < pageSize; i++)
+	{
+		[page removeRowidAtIndex:arc4random_uniform((uint32_t)[page count])];
+		[page verifyIndex];
+	}
+	YapDatabaseViewPage *tail = [[YapDatabaseViewPage alloc] init];
+	for (NSUInteger i = 0; i < pageSize; i++)
+	{
+		[tail addRowid:(extraRowid * 2 + (int64_t)i)];
+	}
+	[page appendRange:NSMakeRange(0, pageSize / 2) ofPage:tail];
+	[page verifyIndex];
+	[page appendRange:NSMakeRange(pageSize / 2, pageSize - (pageSize / 2)) ofPage:tail];
+	[page verifyIndex];
+	
+	// Keep the compiler from discarding the lookups.
+	volatile NSUInteger sink = found;
+	(void)sink;
+	
+	return results;
+}
+
+#endif
+
 - (NSString *)debugDescription
 {
 	NSMutableString *string = [NSMutableString stringWithCapacity:100];
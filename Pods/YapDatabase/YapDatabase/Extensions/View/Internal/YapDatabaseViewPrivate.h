@@ -205,6 +205,9 @@ static NSString *const changeset_key_changes    = @"changes";
                                          inGroup:(NSString *)group
                                          atIndex:(NSUInteger)index;
 
+- (void)insertRowids:(const int64_t *)rowids collectionKeys:(NSArray<YapCollectionKey *> *)collectionKeys
+                                                   inNewGroup:(NSString *)group;
+
 - (void)removeRowid:(int64_t)rowid collectionKey:(YapCollectionKey *)collectionKey;
 
 - (void)removeRowid:(int64_t)rowid collectionKey:(YapCollectionKey *)collectionKey
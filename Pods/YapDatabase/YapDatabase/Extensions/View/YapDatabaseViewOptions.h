@@ -70,6 +70,28 @@ NS_ASSUME_NONNULL_BEGIN
 **/
 @property (nonatomic, assign, readwrite) BOOL skipInitialViewPopulation;
 
+/**
+ * You can configure the view to deserialize, group & sort rows concurrently during view population.
+ *
+ * When enabled, the rows are read from sqlite in shards, and each shard is deserialized, grouped & sorted
+ * on a background queue. The sorted runs for each group are then merged, and the pages of each group are built
+ * directly from the merged rows. This avoids the cost of a binary search (and the associated sortingBlock invocations)
+ * for every row, and allows large views to populate in a fraction of the time on multi-core devices.
+ *
+ * Note that if the sortingBlock takes the object and/or metadata, then those are kept in memory for every row
+ * in the view until the view is populated (the standard routine only keeps the rows currently being inserted).
+ *
+ * IMPORTANT:
+ * When enabled, the groupingBlock & sortingBlock are invoked concurrently from multiple threads.
+ * Thus they must be thread-safe, and they must NOT use the transaction parameter.
+ * (For example, a groupingBlock that queries another view via the transaction is not compatible with this option.)
+ *
+ * This option only affects AutoView population. After the view is populated, changes are processed as usual.
+ *
+ * The default value is NO.
+**/
+@property (nonatomic, assign, readwrite) BOOL parallelizeViewPopulation;
+
 @end
 
 NS_ASSUME_NONNULL_END
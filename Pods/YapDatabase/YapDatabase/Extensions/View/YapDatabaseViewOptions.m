@@ -6,6 +6,7 @@
 @synthesize isPersistent = isPersistent;
 @synthesize allowedCollections = allowedCollections;
 @synthesize skipInitialViewPopulation = skipInitialViewPopulation;
+@synthesize parallelizeViewPopulation = parallelizeViewPopulation;
 
 - (id)init
 {
@@ -22,6 +23,7 @@
 	copy->isPersistent = isPersistent;
 	copy->allowedCollections = allowedCollections;
 	copy->skipInitialViewPopulation = skipInitialViewPopulation;
+	copy->parallelizeViewPopulation = parallelizeViewPopulation;
 
 	return copy;
 }
@@ -1346,6 +1346,90 @@
 	}
 }
 
+/**
+ * This is an internal method that modifies the underlying structures that hold the arrays of rowids.
+ * These structures are meant to be private, and knowledge of how they work shouldn't be required by subclasses.
+ * Subclasses should always use these internal methods,
+ * and should never attempt to modify the internal structures themselves.
+ *
+ * Remember:
+ * The internal structure may change in future versions.
+ * When this happens, subclasses that disobey this rule will break.
+ *
+ * Creates the given group, containing the given rowids in the given order.
+ * The group must not already exist.
+ *
+ * This is equivalent to inserting each rowid at the end of the group,
+ * but the pages are filled directly, so there's no page search per rowid.
+**/
+- (void)insertRowids:(const int64_t *)rowids collectionKeys:(NSArray<YapCollectionKey *> *)collectionKeys
+                                                   inNewGroup:(NSString *)group
+{
+	YDBLogAutoTrace();
+	
+	NSParameterAssert(group != nil);
+	NSAssert([parentConnection->state pagesMetadataForGroup:group] == nil, @"Group(%@) already exists", group);
+	
+	NSUInteger count = [collectionKeys count];
+	if (count == 0) return;
+	
+	NSUInteger maxPageSize = YAP_DATABASE_VIEW_MAX_PAGE_SIZE;
+	
+	[parentConnection->state createGroup:group withCapacity:((count + maxPageSize - 1) / maxPageSize)];
+	
+	[parentConnection->changes addObject:
+	  [YapDatabaseViewSectionChange insertGroup:group]];
+	
+	NSString *prevPageKey = nil;
+	NSUInteger index = 0;
+	
+	while (index < count)
+	{
+		NSUInteger pageCount = MIN(count - index, maxPageSize);
+		
+		NSString *pageKey = [self generatePageKey];
+		YapDatabaseViewPage *page = [[YapDatabaseViewPage alloc] initWithCapacity:pageCount];
+		
+		for (NSUInteger i = index; i < (index + pageCount); i++)
+		{
+			int64_t rowid = rowids[i];
+			
+			[page addRowid:rowid];
+			
+			// Mark map as dirty
+			
+			[parentConnection->dirtyMaps setObject:pageKey forKey:@(rowid) withPreviousValue:nil];
+			[parentConnection->mapCache setObject:pageKey forKey:@(rowid)];
+			
+			// Add change to log
+			
+			[parentConnection->changes addObject:
+			  [YapDatabaseViewRowChange insertCollectionKey:collectionKeys[i] inGroup:group atIndex:i]];
+		}
+		
+		// Create pageMetadata, and append it to the group
+		
+		YapDatabaseViewPageMetadata *pageMetadata = [[YapDatabaseViewPageMetadata alloc] init];
+		pageMetadata->pageKey = pageKey;
+		pageMetadata->prevPageKey = prevPageKey;
+		pageMetadata->group = group;
+		pageMetadata->count = pageCount;
+		pageMetadata->isNew = YES;
+		
+		[parentConnection->state addPageMetadata:pageMetadata toGroup:group];
+		
+		// Mark page as dirty
+		
+		[parentConnection->dirtyPages setObject:page forKey:pageKey];
+		[parentConnection->pageCache setObject:page forKey:pageKey];
+		
+		prevPageKey = pageKey;
+		index += pageCount;
+	}
+	
+	[parentConnection->mutatedGroups addObject:group];
+}
+
 /**
  * This is an internal method that modifies the underlying structures that hold the arrays of rowids.
  * These structures are meant to be private, and knowledge of how they work shouldn't be required by subclasses.
@@ -1,5 +1,62 @@
 #import <Foundation/Foundation.h>
 #import "YapDatabaseConnection.h"
+#import "YapRowidSet.h"
+
+/**
+ * A coalesced changeset stops tracking individual keys once this many have been changed.
+ * The connection flushes its object & metadata caches instead when it catches up.
+**/
+#define YDB_COALESCED_CHANGESET_MAX_KEYS 2048
+
+/**
+ * A coalesced changeset stops retaining extension changesets once this many have been coalesced.
+ * The connection flushes its extension state instead when it catches up.
+**/
+#define YDB_COALESCED_CHANGESET_MAX_EXTENSION_CHANGESETS 128
+
+/**
+ * The compact delta of one or more consecutive changesets, for a connection with coalescesChangesets enabled.
+ * 
+ * Instead of handing every committed changeset to the connection (to be processed one at a time on its queue),
+ * the database merges them into this object within the snapshotQueue.
+ * The connection applies it in a single pass at the start of its next transaction.
+ * 
+ * Only the information needed to invalidate the connection's in-memory state is kept.
+ * Removed rows are tracked by rowid, and changed objects & metadata by collection/key.
+**/
+@interface YapDatabaseCoalescedChangeset : NSObject {
+@public
+	
+	uint64_t firstSnapshot;
+	uint64_t snapshot;
+	NSUInteger changesetCount;
+	
+	YapRowidSet *removedRowids;
+	NSMutableSet<YapCollectionKey *> *changedObjectKeys;
+	NSMutableSet<YapCollectionKey *> *changedMetadataKeys;
+	NSMutableSet<NSString *> *removedCollections;
+	
+	BOOL allKeysRemoved;
+	BOOL flushCaches;
+	BOOL flushExtensionState;
+	
+	NSDictionary *registeredExtensions;
+	NSArray *extensionsOrder;
+	NSDictionary *extensionDependencies;
+	NSDictionary *registeredMemoryTables;
+	
+	// Each item is a minimal changeset containing only the snapshot & YapDatabaseExtensionsKey,
+	// in commit order.
+	NSMutableArray<NSDictionary *> *extensionChangesets;
+}
+
+/**
+ * Merges the given (committed) changeset into the receiver.
+ * Changesets must be added in commit order.
+**/
+- (void)addChangeset:(NSDictionary *)changeset;
+
+@end
 
 
 @interface YapDatabaseConnectionState : NSObject {
@@ -18,6 +75,9 @@
 	
 	uint64_t lastTransactionSnapshot;
 	uint64_t lastTransactionTime;
+	
+	BOOL coalescesChangesets;
+	YapDatabaseCoalescedChangeset *coalescedChangeset;
 }
 
 - (id)initWithConnection:(YapDatabaseConnection *)connection;
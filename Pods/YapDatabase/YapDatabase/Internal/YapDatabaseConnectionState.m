@@ -1,10 +1,163 @@
 #import "YapDatabaseConnectionState.h"
+#import "YapDatabasePrivate.h"
+#import "YapTouch.h"
 
 #if ! __has_feature(objc_arc)
 #warning This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
 #endif
 
 
+@implementation YapDatabaseCoalescedChangeset
+
+- (instancetype)init
+{
+	if ((self = [super init]))
+	{
+		removedRowids = YapRowidSetCreate(0);
+		changedObjectKeys = [[NSMutableSet alloc] init];
+		changedMetadataKeys = [[NSMutableSet alloc] init];
+		removedCollections = [[NSMutableSet alloc] init];
+		extensionChangesets = [[NSMutableArray alloc] init];
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	YapRowidSetRelease(removedRowids);
+}
+
+- (void)addChangeset:(NSDictionary *)changeset
+{
+	uint64_t changesetSnapshot = [[changeset objectForKey:YapDatabaseSnapshotKey] unsignedLongLongValue];
+	
+	NSAssert(changesetCount == 0 || changesetSnapshot > snapshot, @"Changesets must be added in commit order");
+	
+	if (changesetCount == 0)
+		firstSnapshot = changesetSnapshot;
+	
+	snapshot = changesetSnapshot;
+	changesetCount++;
+	
+	// Registered extensions & memory tables: only the most recent lists matter.
+	
+	NSDictionary *changeset_registeredExtensions = [changeset objectForKey:YapDatabaseRegisteredExtensionsKey];
+	if (changeset_registeredExtensions)
+	{
+		registeredExtensions = changeset_registeredExtensions;
+		extensionsOrder = [changeset objectForKey:YapDatabaseExtensionsOrderKey];
+		extensionDependencies = [changeset objectForKey:YapDatabaseExtensionDependenciesKey];
+	}
+	
+	NSDictionary *changeset_registeredMemoryTables = [changeset objectForKey:YapDatabaseRegisteredMemoryTablesKey];
+	if (changeset_registeredMemoryTables)
+	{
+		registeredMemoryTables = changeset_registeredMemoryTables;
+	}
+	
+	if ([[changeset objectForKey:YapDatabaseModifiedExternallyKey] boolValue])
+	{
+		flushCaches = YES;
+		flushExtensionState = YES;
+	}
+	
+	// Core changes
+	
+	if ([[changeset objectForKey:YapDatabaseAllKeysRemovedKey] boolValue])
+	{
+		flushCaches = YES;
+	}
+	
+	if (!flushCaches)
+	{
+		NSSet *changeset_removedRowids = [changeset objectForKey:YapDatabaseRemovedRowidsKey];
+		for (NSNumber *rowidNumber in changeset_removedRowids)
+		{
+			YapRowidSetAdd(removedRowids, [rowidNumber longLongValue]);
+		}
+		
+		id yapTouch = [YapTouch touch]; // value == yapTouch : touchObjectForKey: was used
+		
+		NSDictionary *changeset_objectChanges = [changeset objectForKey:YapDatabaseObjectChangesKey];
+		[changeset_objectChanges enumerateKeysAndObjectsUsingBlock:^(id key, id newObject, BOOL __unused *stop) {
+			
+			if (newObject != yapTouch) {
+				[changedObjectKeys addObject:(YapCollectionKey *)key];
+			}
+		}];
+		
+		NSDictionary *changeset_metadataChanges = [changeset objectForKey:YapDatabaseMetadataChangesKey];
+		[changeset_metadataChanges enumerateKeysAndObjectsUsingBlock:^(id key, id newMetadata, BOOL __unused *stop) {
+			
+			if (newMetadata != yapTouch) {
+				[changedMetadataKeys addObject:(YapCollectionKey *)key];
+			}
+		}];
+		
+		NSSet *changeset_removedKeys = [changeset objectForKey:YapDatabaseRemovedKeysKey];
+		if ([changeset_removedKeys count] > 0)
+		{
+			[changedObjectKeys unionSet:changeset_removedKeys];
+			[changedMetadataKeys unionSet:changeset_removedKeys];
+		}
+		
+		NSSet *changeset_removedCollections = [changeset objectForKey:YapDatabaseRemovedCollectionsKey];
+		if ([changeset_removedCollections count] > 0)
+		{
+			[removedCollections unionSet:changeset_removedCollections];
+		}
+		
+		if ([changedObjectKeys count] > YDB_COALESCED_CHANGESET_MAX_KEYS ||
+		    [changedMetadataKeys count] > YDB_COALESCED_CHANGESET_MAX_KEYS ||
+		    YapRowidSetCount(removedRowids) > YDB_COALESCED_CHANGESET_MAX_KEYS)
+		{
+			flushCaches = YES;
+		}
+	}
+	
+	if (flushCaches)
+	{
+		YapRowidSetRemoveAll(removedRowids);
+		[changedObjectKeys removeAllObjects];
+		[changedMetadataKeys removeAllObjects];
+		[removedCollections removeAllObjects];
+	}
+	
+	// Extension changes
+	
+	if (!flushExtensionState)
+	{
+		NSDictionary *changeset_extensions = [changeset objectForKey:YapDatabaseExtensionsKey];
+		if ([changeset_extensions count] > 0)
+		{
+			if ([extensionChangesets count] < YDB_COALESCED_CHANGESET_MAX_EXTENSION_CHANGESETS)
+			{
+				[extensionChangesets addObject:@{
+				  YapDatabaseSnapshotKey   : [changeset objectForKey:YapDatabaseSnapshotKey],
+				  YapDatabaseExtensionsKey : changeset_extensions
+				}];
+			}
+			else
+			{
+				flushExtensionState = YES;
+				[extensionChangesets removeAllObjects];
+			}
+		}
+	}
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@[%p] snapshots %llu-%llu (%lu changesets)>",
+	          [self class], self, firstSnapshot, snapshot, (unsigned long)changesetCount];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 @implementation YapDatabaseConnectionState
 
 - (id)initWithConnection:(YapDatabaseConnection *)inConnection
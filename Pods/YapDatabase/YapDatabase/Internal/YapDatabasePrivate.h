@@ -48,6 +48,18 @@ NS_INLINE void sqlite_enum_reset(sqlite3_stmt *stmt, BOOL needsFinalize)
 #define SQLITE_COLUMN_START 0
 #endif
 
+/**
+ * The number of rowid host parameters in the getDataForRowidsStatement.
+ * Batch fetches are executed in chunks of this size.
+**/
+#define YDB_BATCH_FETCH_ROWID_COUNT 64
+
+/**
+ * Batch fetches with at least this many rows to deserialize do so concurrently.
+ * Below this, the dispatch overhead outweighs the benefit.
+**/
+#define YDB_CONCURRENT_DESERIALIZATION_THRESHOLD 16
+
 /**
  * Keys for changeset dictionary.
 **/
@@ -185,7 +197,21 @@ static NSString *const ext_key_class = @"class";
  * then read-write transactions will automatically start performing checkpoint operations after each commit.
 **/
 - (BOOL)aggressiveCheckpointEnabled;
-- (void)noteCheckpointWithTotalFrames:(int)totalFrameCount checkpointedFrames:(int)checkpointedFrameCount;
+- (void)noteCheckpointWithTotalFrames:(int)totalFrameCount
+                   checkpointedFrames:(int)checkpointedFrameCount
+                             duration:(NSTimeInterval)duration;
+
+/**
+ * Returns NO if options.checkpointLatencyBudget is set,
+ * and the estimated time to checkpoint the current WAL backlog exceeds it.
+ * In which case connections should skip checkpointing on the write path.
+**/
+- (BOOL)checkpointFitsLatencyBudget;
+
+/**
+ * Invoked by YapDatabaseConnection after every sqlite commit of a read-write transaction.
+**/
+- (void)noteCommitLatency:(NSTimeInterval)latency;
 
 #ifdef SQLITE_HAS_CODEC
 /**
@@ -225,6 +251,9 @@ static NSString *const ext_key_class = @"class";
 	NSUInteger objectCacheLimit;          // Read-only by transaction. Use as consideration of whether to add to cache.
 	NSUInteger metadataCacheLimit;        // Read-only by transaction. Use as consideration of whether to add to cache.
 	
+	NSUInteger objectCacheCostLimit;
+	NSUInteger metadataCacheCostLimit;
+	
 	YapDatabasePolicy objectPolicy;       // Read-only by transaction. Use to determine what goes in objectChanges.
 	YapDatabasePolicy metadataPolicy;     // Read-only by transaction. Use to determine what goes in metadataChanges.
 	
@@ -260,6 +289,7 @@ static NSString *const ext_key_class = @"class";
 - (sqlite3_stmt *)getRowidForKeyStatement;
 - (sqlite3_stmt *)getKeyForRowidStatement;
 - (sqlite3_stmt *)getDataForRowidStatement;
+- (sqlite3_stmt *)getDataForRowidsStatement;
 - (sqlite3_stmt *)getMetadataForRowidStatement;
 - (sqlite3_stmt *)getAllForRowidStatement;
 - (sqlite3_stmt *)getDataForKeyStatement;
@@ -449,6 +479,10 @@ static NSString *const ext_key_class = @"class";
                    inCollection:(NSString *)collection
             unorderedUsingBlock:(void (^)(NSUInteger keyIndex, int64_t rowid, BOOL *stop))block;
 
+- (void)_enumerateSerializedRowsInCollections:(NSArray *)collections
+     usingBlock:(void (^)(int64_t rowid, NSString *collection, NSString *key,
+                          NSData *objectData, NSData *metadataData, BOOL *stop))block;
+
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
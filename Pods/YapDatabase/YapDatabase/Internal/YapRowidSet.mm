@@ -38,7 +38,7 @@ void YapRowidSetRelease(YapRowidSet *set)
 	if (set == NULL) return;
 	
 	if (set->rowids) {
-		free(set->rowids);
+		delete set->rowids;
 		set->rowids = NULL;
 	}
 	
@@ -1,11 +1,15 @@
 #import <Foundation/Foundation.h>
 
-#ifndef YapCache_Enable_Statistics
-  #define YapCache_Enable_Statistics 0
-#endif
-
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * Optional block used to calculate the cost of an object that's added via setObject:forKey:.
+ * The cost is an arbitrary unit, but is generally the (approximate) number of bytes the object occupies.
+ *
+ * @see YapCache costBlock
+**/
+typedef NSUInteger (^YapCacheCostBlock)(id key, id object);
+
 /**
  * YapCache implements a simple strict cache.
  *
@@ -31,6 +35,10 @@ NS_ASSUME_NONNULL_BEGIN
  * or from within the same serial dispatch queue. The various YapDatabase classes which use it inherently
  * serialize access to the cache via their own internal serial queue.
  * 
+ * YapCache can optionally enforce a totalCostLimit in addition to the countLimit.
+ * Each item is given a cost (typically its size in bytes), and the least recently used items are evicted
+ * until the totalCost is back within the limit. This allows a cache full of large objects to be capped predictably.
+ *
  * Also, YapCache does NOT automatically purge itself in the even of a low memory condition. (Whereas NSCache does.)
  * This also has to do with YapCache not being thread-safe.
  * And thus performing this action (if desired) is up to you.
@@ -85,6 +93,33 @@ NS_ASSUME_NONNULL_BEGIN
 **/
 @property (nonatomic, assign, readwrite) NSUInteger countLimit;
 
+/**
+ * The totalCostLimit specifies the maximum total cost of all items in the cache.
+ * Like the countLimit, this limit is strictly enforced,
+ * with one exception: the most recently added item is never evicted to make room for itself.
+ * So a single item whose cost exceeds the totalCostLimit is kept until the next item is added.
+ *
+ * The default totalCostLimit is zero, which means there is no cost limit.
+ *
+ * You may change the totalCostLimit at any time.
+ * Changes to the totalCostLimit take immediate effect on the cache (before the set method returns).
+**/
+@property (nonatomic, assign, readwrite) NSUInteger totalCostLimit;
+
+/**
+ * The sum of the costs of all items currently in the cache.
+**/
+@property (nonatomic, assign, readonly) NSUInteger totalCost;
+
+/**
+ * If set, the costBlock is invoked by setObject:forKey: to calculate the cost of the given object.
+ * If not set, setObject:forKey: assigns a cost of zero to new items,
+ * and preserves the existing cost when replacing the object for an existing key.
+ *
+ * Use setObject:forKey:cost: to specify the cost explicitly.
+**/
+@property (nonatomic, copy, readwrite, nullable) YapCacheCostBlock costBlock;
+
 /**
  * These methods are for "debugging".
  * 
@@ -106,6 +141,7 @@ NS_ASSUME_NONNULL_BEGIN
 //
 
 - (void)setObject:(ObjectType)object forKey:(KeyType)key;
+- (void)setObject:(ObjectType)object forKey:(KeyType)key cost:(NSUInteger)cost;
 
 - (nullable ObjectType)objectForKey:(KeyType)key;
 - (BOOL)containsKey:(KeyType)key;
@@ -120,11 +156,9 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)enumerateKeysAndObjectsWithBlock:(void (^)(KeyType key, ObjectType obj, BOOL *stop))block;
 
 //
-// Some debugging stuff that gets compiled out
+// Statistics
 //
 
-#if YapCache_Enable_Statistics
-
 /**
  * When querying the cache for an object via objectForKey,
  * the hitCount is incremented if the object is in the cache,
@@ -135,12 +169,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * When adding objects to the cache via setObject:forKey:,
- * the evictionCount is incremented if the cache is full,
- * and the added object causes another object (the least recently used object) to be evicted.
+ * the evictionCount is incremented for each object (the least recently used object)
+ * that is evicted because the cache exceeded its countLimit or totalCostLimit.
 **/
 @property (nonatomic, readonly) NSUInteger evictionCount;
 
-#endif
+/**
+ * Resets the hitCount, missCount & evictionCount to zero.
+**/
+- (void)resetStatistics;
 
 @end
 
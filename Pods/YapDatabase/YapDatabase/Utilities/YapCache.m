@@ -37,6 +37,8 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 
 	__unsafe_unretained id key; // retained by cfdict as key
 	__strong id value;          // retained only by us
+	
+	NSUInteger cost;
 }
 
 - (id)initWithKey:(id)key value:(id)value;
@@ -70,6 +72,8 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 {
 	CFMutableDictionaryRef cfdict;
 	NSUInteger countLimit;
+	NSUInteger totalCostLimit;
+	NSUInteger totalCost;
 	
 	__unsafe_unretained YapCacheItem *mostRecentCacheItem;
 	__unsafe_unretained YapCacheItem *leastRecentCacheItem;
@@ -79,12 +83,11 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 
 @synthesize allowedKeyClasses = allowedKeyClasses;
 @synthesize allowedObjectClasses = allowedObjectClasses;
+@synthesize costBlock = costBlock;
 
-#if YapCache_Enable_Statistics
 @synthesize hitCount = hitCount;
 @synthesize missCount = missCount;
 @synthesize evictionCount = evictionCount;
-#endif
 
 - (instancetype)init
 {
@@ -128,37 +131,74 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 	if (countLimit != newCountLimit)
 	{
 		countLimit = newCountLimit;
-		if (countLimit != 0)
+		[self evictIfNeeded];
+	}
+}
+
+- (NSUInteger)totalCostLimit
+{
+	return totalCostLimit;
+}
+
+- (void)setTotalCostLimit:(NSUInteger)newTotalCostLimit
+{
+	if (totalCostLimit != newTotalCostLimit)
+	{
+		totalCostLimit = newTotalCostLimit;
+		[self evictIfNeeded];
+	}
+}
+
+- (NSUInteger)totalCost
+{
+	return totalCost;
+}
+
+/**
+ * Evicts items from the end of the linked-list (least recently used)
+ * until the cache is within both its countLimit and totalCostLimit.
+ *
+ * The mostRecentCacheItem is never evicted here.
+ * So adding an item whose cost exceeds the totalCostLimit evicts everything else,
+ * but the new item itself remains in the cache (until the next addition).
+**/
+- (void)evictIfNeeded
+{
+	while (leastRecentCacheItem && (leastRecentCacheItem != mostRecentCacheItem))
+	{
+		BOOL overCountLimit = (countLimit != 0) && (CFDictionaryGetCount(cfdict) > (CFIndex)countLimit);
+		BOOL overCostLimit = (totalCostLimit != 0) && (totalCost > totalCostLimit);
+		
+		if (!overCountLimit && !overCostLimit) break;
+		
+		YDBLogVerbose(@"out(%@) [count=%ld, cost=%lu]",
+		              leastRecentCacheItem->key, CFDictionaryGetCount(cfdict), (unsigned long)totalCost);
+		
+		__unsafe_unretained id keyToEvict = leastRecentCacheItem->key;
+		totalCost -= leastRecentCacheItem->cost;
+		
+		if (evictedCacheItem == nil)
 		{
-			while (CFDictionaryGetCount(cfdict) > (CFIndex)countLimit)
-			{
-				__unsafe_unretained id keyToEvict = leastRecentCacheItem->key;
-				
-				if (evictedCacheItem == nil)
-				{
-					evictedCacheItem = leastRecentCacheItem;
-					
-					leastRecentCacheItem = leastRecentCacheItem->prev;
-					leastRecentCacheItem->next = nil;
-					
-					evictedCacheItem->prev = nil;
-					evictedCacheItem->next = nil;
-					evictedCacheItem->key = nil;
-					evictedCacheItem->value = nil;
-				}
-				else
-				{
-					leastRecentCacheItem = leastRecentCacheItem->prev;
-					leastRecentCacheItem->next = nil;
-				}
-				
-				CFDictionaryRemoveValue(cfdict, (const void *)(keyToEvict));
-				
-				#if YapCache_Enable_Statistics
-				evictionCount++;
-				#endif
-			}
+			evictedCacheItem = leastRecentCacheItem;
+			
+			leastRecentCacheItem = leastRecentCacheItem->prev;
+			leastRecentCacheItem->next = nil;
+			
+			evictedCacheItem->prev = nil;
+			evictedCacheItem->next = nil;
+			evictedCacheItem->key = nil;
+			evictedCacheItem->value = nil;
+			evictedCacheItem->cost = 0;
+		}
+		else
+		{
+			leastRecentCacheItem = leastRecentCacheItem->prev;
+			leastRecentCacheItem->next = nil;
 		}
+		
+		CFDictionaryRemoveValue(cfdict, (const void *)(keyToEvict));
+		
+		evictionCount++;
 	}
 }
 
@@ -196,16 +236,12 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 			mostRecentCacheItem = item;
 		}
 		
-		#if YapCache_Enable_Statistics
 		hitCount++;
-		#endif
 		return item->value;
 	}
 	else
 	{
-		#if YapCache_Enable_Statistics
 		missCount++;
-		#endif
 		return nil;
 	}
 }
@@ -220,6 +256,23 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 }
 
 - (void)setObject:(id)object forKey:(id)key
+{
+	if (costBlock)
+	{
+		[self setObject:object forKey:key cost:costBlock(key, object) preserveExistingCost:NO];
+	}
+	else
+	{
+		[self setObject:object forKey:key cost:0 preserveExistingCost:YES];
+	}
+}
+
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost
+{
+	[self setObject:object forKey:key cost:cost preserveExistingCost:NO];
+}
+
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost preserveExistingCost:(BOOL)preserveExistingCost
 {
 	#ifndef NS_BLOCK_ASSERTIONS
 	AssertAllowedKeyClass(key, allowedKeyClasses);
@@ -232,6 +285,13 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 		// Update item value
 		existingItem->value = object;
 		
+		if (!preserveExistingCost)
+		{
+			totalCost -= existingItem->cost;
+			totalCost += cost;
+			existingItem->cost = cost;
+		}
+		
 		if (existingItem != mostRecentCacheItem)
 		{
 			// Remove item from current position in linked-list
@@ -274,14 +334,18 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 			newItem = evictedCacheItem;
 			newItem->key = key;
 			newItem->value = object;
+			newItem->cost = cost;
 			
 			evictedCacheItem = nil;
 		}
 		else
 		{
 			newItem = [[YapCacheItem alloc] initWithKey:key value:object];
+			newItem->cost = cost;
 		}
 		
+		totalCost += cost;
+		
 		// Add item to set
 		CFDictionarySetValue(cfdict, (const void *)key, (const void *)newItem);
 		
@@ -294,48 +358,16 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 		
 		mostRecentCacheItem = newItem;
 		
-		// Evict leastRecentCacheItem if needed
+		if (leastRecentCacheItem == nil)
+			leastRecentCacheItem = newItem;
 		
-		if ((countLimit != 0) && (CFDictionaryGetCount(cfdict) > (CFIndex)countLimit))
-		{
-			YDBLogVerbose(@"key(%@), out(%@)", key, leastRecentCacheItem->key);
-			
-			__unsafe_unretained id keyToEvict = leastRecentCacheItem->key;
-			
-			if (evictedCacheItem == nil)
-			{
-				evictedCacheItem = leastRecentCacheItem;
-				
-				leastRecentCacheItem = leastRecentCacheItem->prev;
-				leastRecentCacheItem->next = nil;
-			
-				evictedCacheItem->prev = nil;
-				evictedCacheItem->next = nil;
-				evictedCacheItem->key = nil;
-				evictedCacheItem->value = nil;
-			}
-			else
-			{
-				leastRecentCacheItem = leastRecentCacheItem->prev;
-				leastRecentCacheItem->next = nil;
-			}
-			
-			CFDictionaryRemoveValue(cfdict, (const void *)(keyToEvict));
-			
-			#if YapCache_Enable_Statistics
-			evictionCount++;
-			#endif
-		}
-		else
-		{
-			if (leastRecentCacheItem == nil)
-				leastRecentCacheItem = newItem;
-			
-			YDBLogVerbose(@"key(%@) <- new, new mostRecent [%ld of %lu]",
-			              key, CFDictionaryGetCount(cfdict), (unsigned long)countLimit);
-		}
+		YDBLogVerbose(@"key(%@) <- new, new mostRecent [%ld of %lu]",
+		              key, CFDictionaryGetCount(cfdict), (unsigned long)countLimit);
 	}
 	
+	// Evict leastRecentCacheItem(s) if needed
+	[self evictIfNeeded];
+	
 	if (ydbLogLevel & YDB_LOG_FLAG_VERBOSE)
 	{
 		YDBLogVerbose(@"cfdict: %@", cfdict);
@@ -363,6 +395,7 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 	mostRecentCacheItem = nil;
 	leastRecentCacheItem = nil;
 	evictedCacheItem = nil;
+	totalCost = 0;
 	
 	CFDictionaryRemoveAllValues(cfdict);
 }
@@ -386,6 +419,7 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 		else if (item->next)
 			item->next->prev = item->prev;
 		
+		totalCost -= item->cost;
 		CFDictionaryRemoveValue(cfdict, (const void *)key);
 	}
 }
@@ -411,11 +445,19 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 			else if (item->next)
 				item->next->prev = item->prev;
 			
+			totalCost -= item->cost;
 			CFDictionaryRemoveValue(cfdict, (const void *)key);
 		}
 	}
 }
 
+- (void)resetStatistics
+{
+	hitCount = 0;
+	missCount = 0;
+	evictionCount = 0;
+}
+
 - (void)enumerateKeysWithBlock:(void (^)(id key, BOOL *stop))block
 {
 	NSDictionary *nsdict = (__bridge NSDictionary *)cfdict;
@@ -444,7 +486,8 @@ static const NSUInteger YapCache_Default_CountLimit = 40;
 - (NSString *)description
 {
 	NSMutableString *description = [NSMutableString string];
-	[description appendFormat:@"%@, count=%ld, keys=\n", NSStringFromClass([self class]), CFDictionaryGetCount(cfdict)];
+	[description appendFormat:@"%@, count=%ld, totalCost=%lu, keys=\n",
+	  NSStringFromClass([self class]), CFDictionaryGetCount(cfdict), (unsigned long)totalCost];
 	
 	YapCacheItem *item = mostRecentCacheItem;
 	NSUInteger itemIndex = 0;
@@ -10,9 +10,11 @@
  *
  * @see YapDatabase defaultObjectCacheEnabled
  * @see YapDatabase defaultObjectCacheLimit
+ * @see YapDatabase defaultObjectCacheCostLimit
  * 
  * @see YapDatabase defaultMetadataCacheEnabled
  * @see YapDatabase defaultMetadataCacheLimit
+ * @see YapDatabase defaultMetadataCacheCostLimit
  * 
  * @see YapDatabase defaultObjectPolicy
  * @see YapDatabase defaultMetadataPolicy
@@ -23,9 +25,11 @@
 
 @property (nonatomic, assign, readwrite) BOOL objectCacheEnabled;
 @property (nonatomic, assign, readwrite) NSUInteger objectCacheLimit;
+@property (nonatomic, assign, readwrite) NSUInteger objectCacheCostLimit;
 
 @property (nonatomic, assign, readwrite) BOOL metadataCacheEnabled;
 @property (nonatomic, assign, readwrite) NSUInteger metadataCacheLimit;
+@property (nonatomic, assign, readwrite) NSUInteger metadataCacheCostLimit;
 
 @property (nonatomic, assign, readwrite) YapDatabasePolicy objectPolicy;
 @property (nonatomic, assign, readwrite) YapDatabasePolicy metadataPolicy;
@@ -8,9 +8,11 @@ static NSUInteger const DEFAULT_METADATA_CACHE_LIMIT = 250;
 
 @synthesize objectCacheEnabled = objectCacheEnabled;
 @synthesize objectCacheLimit = objectCacheLimit;
+@synthesize objectCacheCostLimit = objectCacheCostLimit;
 
 @synthesize metadataCacheEnabled = metadataCacheEnabled;
 @synthesize metadataCacheLimit = metadataCacheLimit;
+@synthesize metadataCacheCostLimit = metadataCacheCostLimit;
 
 @synthesize objectPolicy = objectPolicy;
 @synthesize metadataPolicy = metadataPolicy;
@@ -25,9 +27,11 @@ static NSUInteger const DEFAULT_METADATA_CACHE_LIMIT = 250;
 	{
 		objectCacheEnabled = YES;
 		objectCacheLimit = DEFAULT_OBJECT_CACHE_LIMIT;
+		objectCacheCostLimit = 0;
 		
 		metadataCacheEnabled = YES;
 		metadataCacheLimit = DEFAULT_METADATA_CACHE_LIMIT;
+		metadataCacheCostLimit = 0;
 		
 		objectPolicy = YapDatabasePolicyContainment;
 		metadataPolicy = YapDatabasePolicyContainment;
@@ -45,9 +49,11 @@ static NSUInteger const DEFAULT_METADATA_CACHE_LIMIT = 250;
 	
 	copy->objectCacheEnabled = objectCacheEnabled;
 	copy->objectCacheLimit = objectCacheLimit;
+	copy->objectCacheCostLimit = objectCacheCostLimit;
 	
 	copy->metadataCacheEnabled = metadataCacheEnabled;
 	copy->metadataCacheLimit = metadataCacheLimit;
+	copy->metadataCacheCostLimit = metadataCacheCostLimit;
 	
 	copy->objectPolicy = objectPolicy;
 	copy->metadataPolicy = metadataPolicy;
@@ -6,6 +6,8 @@
 #import "YapDatabaseExtension.h"
 #import "YapDatabaseConnectionConfig.h"
 
+@class YapDatabaseCheckpointMetrics;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /**
@@ -434,6 +436,15 @@ extern NSString *const YapDatabaseModifiedExternallyKey;
 @property (atomic, assign, readwrite) BOOL defaultObjectCacheEnabled;
 @property (atomic, assign, readwrite) NSUInteger defaultObjectCacheLimit;
 
+/**
+ * Allows you to set the default objectCacheCostLimit for all new connections.
+ *
+ * The default defaultObjectCacheCostLimit is zero (no cost limit).
+ *
+ * @see YapDatabaseConnection objectCacheCostLimit
+**/
+@property (atomic, assign, readwrite) NSUInteger defaultObjectCacheCostLimit;
+
 /**
  * Allows you to set the default metadataCacheEnabled and metadataCacheLimit for all new connections.
  *
@@ -454,6 +465,15 @@ extern NSString *const YapDatabaseModifiedExternallyKey;
 @property (atomic, assign, readwrite) BOOL defaultMetadataCacheEnabled;
 @property (atomic, assign, readwrite) NSUInteger defaultMetadataCacheLimit;
 
+/**
+ * Allows you to set the default metadataCacheCostLimit for all new connections.
+ *
+ * The default defaultMetadataCacheCostLimit is zero (no cost limit).
+ *
+ * @see YapDatabaseConnection metadataCacheCostLimit
+**/
+@property (atomic, assign, readwrite) NSUInteger defaultMetadataCacheCostLimit;
+
 /**
  * Allows you to set the default objectPolicy and metadataPolicy for all new connections.
  * 
@@ -852,6 +872,60 @@ extern NSString *const YapDatabaseModifiedExternallyKey;
 **/
 @property (atomic, assign, readwrite) NSTimeInterval connectionPoolLifetime;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Checkpointing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns a snapshot of the statistics gathered by the checkpoint scheduler since the database was opened.
+ * 
+ * This is primarily useful for tuning YapDatabaseOptions.aggressiveWALTruncationSize & checkpointLatencyBudget.
+**/
+- (YapDatabaseCheckpointMetrics *)checkpointMetrics;
+
+@end
+
+/**
+ * Statistics gathered by the checkpoint scheduler. See -[YapDatabase checkpointMetrics].
+ * 
+ * WAL sizes are approximated from the frame counts reported by sqlite (frameCount * pageSize).
+**/
+@interface YapDatabaseCheckpointMetrics : NSObject
+
+/** Approximate size of the WAL (in bytes) as of the most recent checkpoint. **/
+@property (nonatomic, assign, readonly) uint64_t walSize;
+
+/** Number of frames in the WAL as of the most recent checkpoint. **/
+@property (nonatomic, assign, readonly) uint64_t walFrameCount;
+
+/** Number of frames in the WAL that had yet to be checkpointed, as of the most recent checkpoint. **/
+@property (nonatomic, assign, readonly) uint64_t walBacklogFrameCount;
+
+/** Total number of WAL frames copied into the database file by checkpoints. **/
+@property (nonatomic, assign, readonly) uint64_t framesCheckpointed;
+
+/** Smoothed rate at which frames are being appended to the WAL (frames per second). **/
+@property (nonatomic, assign, readonly) double walFrameGrowthRate;
+
+/** Smoothed time spent by checkpoints per frame copied (in seconds). **/
+@property (nonatomic, assign, readonly) double checkpointSecondsPerFrame;
+
+/** Smoothed duration of the sqlite commit of read-write transactions (in seconds). **/
+@property (nonatomic, assign, readonly) NSTimeInterval commitLatency;
+
+/** The most recent snapshot reported as checkpointable (i.e. the oldest snapshot any reader was on). **/
+@property (nonatomic, assign, readonly) uint64_t checkpointableSnapshot;
+
+/** Number of passive checkpoints run in the background (in parallel with writes). **/
+@property (nonatomic, assign, readonly) NSUInteger passiveCheckpointCount;
+
+/** Number of checkpoints run on the write path (blocking writes). **/
+@property (nonatomic, assign, readonly) NSUInteger blockingCheckpointCount;
+
+/** Total & maximum time that read-write transactions were blocked by checkpoints (in seconds). **/
+@property (nonatomic, assign, readonly) NSTimeInterval writerStallTime;
+@property (nonatomic, assign, readonly) NSTimeInterval maxWriterStallTime;
+
 @end
 
 NS_ASSUME_NONNULL_END
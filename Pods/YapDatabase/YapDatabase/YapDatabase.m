@@ -74,6 +74,64 @@ static NSString *const YDBConnectionPoolValueKey_db        = @"db";
 static NSString *const YDBConnectionPoolValueKey_main_file = @"main_file";
 static NSString *const YDBConnectionPoolValueKey_wal_file  = @"wal_file";
 
+/**
+ * Tuning for the adaptive checkpoint scheduler (see YapDatabaseOptions.checkpointLatencyBudget).
+ *
+ * - Smoothing factor for the moving averages (growth rate, cost per frame, commit latency).
+ * - Cost per frame to assume until the first checkpoint has been measured.
+ * - How far ahead to project WAL growth when deciding whether to start checkpointing in slices.
+ * - Bounds on the delay between consecutive background slices.
+ * - WAL size (as a multiple of aggressiveWALTruncationSize) at which the budget is ignored.
+**/
+#define YDB_CHECKPOINT_SMOOTHING                  0.25
+#define YDB_CHECKPOINT_DEFAULT_SECONDS_PER_FRAME  0.00002
+#define YDB_CHECKPOINT_PROJECTION_INTERVAL        1.0
+#define YDB_CHECKPOINT_MIN_SLICE_INTERVAL         0.005
+#define YDB_CHECKPOINT_MAX_SLICE_INTERVAL         0.100
+#define YDB_CHECKPOINT_HARD_LIMIT_MULTIPLIER      4
+
+/**
+ * Checkpoint scheduler state. Protected by checkpointLock.
+**/
+typedef struct {
+	uint64_t walFrameCount;
+	uint64_t walBacklogFrameCount;
+	uint64_t walCheckpointedFrameCount;
+	uint64_t framesCheckpointed;
+	double walFrameGrowthRate;
+	double secondsPerFrame;
+	double commitLatency;
+	double lastSampleTime;
+	uint64_t checkpointableSnapshot;
+	NSUInteger passiveCheckpointCount;
+	NSUInteger blockingCheckpointCount;
+	double writerStallTime;
+	double maxWriterStallTime;
+} YDBCheckpointState;
+
+static inline double YDBCheckpointSmooth(double average, double sample)
+{
+	if (average <= 0.0) return sample;
+	return average + (YDB_CHECKPOINT_SMOOTHING * (sample - average));
+}
+
+@interface YapDatabaseCheckpointMetrics () {
+@public
+	uint64_t walSize;
+	uint64_t walFrameCount;
+	uint64_t walBacklogFrameCount;
+	uint64_t framesCheckpointed;
+	double walFrameGrowthRate;
+	double checkpointSecondsPerFrame;
+	NSTimeInterval commitLatency;
+	uint64_t checkpointableSnapshot;
+	NSUInteger passiveCheckpointCount;
+	NSUInteger blockingCheckpointCount;
+	NSTimeInterval writerStallTime;
+	NSTimeInterval maxWriterStallTime;
+}
+@end
+
 /**
  * The database version is stored (via pragma user_version) to sqlite.
  * It is used to represent the version of the userlying architecture of YapDatabase.
@@ -137,6 +195,9 @@ static int connectionBusyHandler(void *ptr, int count) {
 	atomic_flag pendingPassiveCheckpoint;
 	atomic_flag pendingAggressiveCheckpoint;
 	atomic_bool aggressiveCheckpointEnabled;
+	
+	YAPUnfairLock checkpointLock;
+	YDBCheckpointState checkpointState;
 }
 
 /**
@@ -558,6 +619,8 @@ static int connectionBusyHandler(void *ptr, int count) {
 		changesets = [[NSMutableArray alloc] init];
 		connectionStates = [[NSMutableArray alloc] init];
 		
+		checkpointLock = YAP_UNFAIR_LOCK_INIT;
+		
 		connectionDefaults = [[YapDatabaseConnectionConfig alloc] init];
 		
 		registeredExtensions = [[NSDictionary alloc] init];
@@ -581,6 +644,36 @@ static int connectionBusyHandler(void *ptr, int count) {
 		objectSerializer = (YapDatabaseSerializer)[inObjectSerializer copy] ?: defaultSerializer;
 		objectDeserializer = (YapDatabaseDeserializer)[inObjectDeserializer copy] ?: defaultDeserializer;
 		
+		// Per-collection object serializers (registered via YapDatabaseOptions).
+		// We wrap the main serializer & deserializer, so the rest of the codebase doesn't need to know about them.
+		
+		NSDictionary *collectionObjectSerializers = options.collectionObjectSerializers;
+		NSDictionary *collectionObjectDeserializers = options.collectionObjectDeserializers;
+		
+		if ([collectionObjectSerializers count] > 0)
+		{
+			YapDatabaseSerializer mainObjectSerializer = objectSerializer;
+			YapDatabaseDeserializer mainObjectDeserializer = objectDeserializer;
+			
+			objectSerializer = ^NSData *(NSString *collection, NSString *key, id object){
+				
+				YapDatabaseSerializer serializer = collectionObjectSerializers[collection];
+				if (serializer)
+					return serializer(collection, key, object);
+				else
+					return mainObjectSerializer(collection, key, object);
+			};
+			
+			objectDeserializer = ^id (NSString *collection, NSString *key, NSData *data){
+				
+				YapDatabaseDeserializer deserializer = collectionObjectDeserializers[collection];
+				if (deserializer)
+					return deserializer(collection, key, data);
+				else
+					return mainObjectDeserializer(collection, key, data);
+			};
+		}
+		
 		metadataSerializer = (YapDatabaseSerializer)[inMetadataSerializer copy] ?: defaultSerializer;
 		metadataDeserializer = (YapDatabaseDeserializer)[inMetadataDeserializer copy] ?: defaultDeserializer;
 		
@@ -1553,6 +1646,26 @@ static int connectionBusyHandler(void *ptr, int count) {
 	});
 }
 
+- (NSUInteger)defaultObjectCacheCostLimit
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_sync(internalQueue, ^{
+		
+		result = connectionDefaults.objectCacheCostLimit;
+	});
+	
+	return result;
+}
+
+- (void)setDefaultObjectCacheCostLimit:(NSUInteger)defaultObjectCacheCostLimit
+{
+	dispatch_sync(internalQueue, ^{
+		
+		connectionDefaults.objectCacheCostLimit = defaultObjectCacheCostLimit;
+	});
+}
+
 - (BOOL)defaultMetadataCacheEnabled
 {
 	__block BOOL result = NO;
@@ -1593,6 +1706,26 @@ static int connectionBusyHandler(void *ptr, int count) {
 	});
 }
 
+- (NSUInteger)defaultMetadataCacheCostLimit
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_sync(internalQueue, ^{
+		
+		result = connectionDefaults.metadataCacheCostLimit;
+	});
+	
+	return result;
+}
+
+- (void)setDefaultMetadataCacheCostLimit:(NSUInteger)defaultMetadataCacheCostLimit
+{
+	dispatch_sync(internalQueue, ^{
+		
+		connectionDefaults.metadataCacheCostLimit = defaultMetadataCacheCostLimit;
+	});
+}
+
 - (YapDatabasePolicy)defaultObjectPolicy
 {
 	__block YapDatabasePolicy result = YapDatabasePolicyShare;
@@ -2740,12 +2873,36 @@ static int connectionBusyHandler(void *ptr, int count) {
 	// Forward the changeset to all other connections so they can perform any needed updates.
 	// Generally this means updating the in-memory components such as the cache.
 	
+	//
+	// Connections with coalescesChangesets enabled don't get a block per changeset.
+	// Instead the changeset is merged into their pending coalescedChangeset (right here, within the snapshotQueue),
+	// which they apply in a single pass when they start their next transaction.
+	
+	uint64_t changesetSnapshot = snapshot;
 	dispatch_group_t group = NULL;
 	
 	for (YapDatabaseConnectionState *state in connectionStates)
 	{
 		if (state->connection != sender)
 		{
+			if (state->coalescesChangesets && !state->longLivedReadTransaction && !options.enableMultiProcessSupport)
+			{
+				if (changesetSnapshot > state->lastTransactionSnapshot)
+				{
+					if (state->coalescedChangeset == nil)
+						state->coalescedChangeset = [[YapDatabaseCoalescedChangeset alloc] init];
+					
+					[state->coalescedChangeset addChangeset:changeset];
+				}
+				else
+				{
+					// The connection already processed this changeset,
+					// as its last transaction started after the sqlite commit (see preReadTransaction).
+				}
+				
+				continue;
+			}
+			
 			// Create strong reference (state->connection is weak)
 			__strong YapDatabaseConnection *connection = state->connection;
 			
@@ -2814,7 +2971,13 @@ static int connectionBusyHandler(void *ptr, int count) {
 		YDBLogVerbose(@"Checkpoint possible up to snapshot %llu", maxCheckpointableSnapshot);
 	}
 	
-	bool aggressive = atomic_load(&aggressiveCheckpointEnabled);
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		checkpointState.checkpointableSnapshot = maxCheckpointableSnapshot;
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+	
+	bool aggressive = atomic_load(&aggressiveCheckpointEnabled) && [self checkpointFitsLatencyBudget];
 	if (aggressive)
 	{
 		[self asyncAggressiveCheckpoint];
@@ -2843,7 +3006,7 @@ static int connectionBusyHandler(void *ptr, int count) {
 		
 		atomic_flag_clear(&strongSelf->pendingPassiveCheckpoint);
 		
-		if (atomic_load(&strongSelf->aggressiveCheckpointEnabled)) {
+		if (atomic_load(&strongSelf->aggressiveCheckpointEnabled) && [strongSelf checkpointFitsLatencyBudget]) {
 			return;
 		}
 		
@@ -2875,8 +3038,21 @@ static int connectionBusyHandler(void *ptr, int count) {
 			return;
 		}
 		
+		if (![strongSelf checkpointFitsLatencyBudget])
+		{
+			// The backlog has grown since this was scheduled.
+			// Keep checkpointing in the background until it fits within the budget again.
+			
+			[strongSelf asyncPassiveCheckpoint];
+			return;
+		}
+		
+		CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+		
 		[strongSelf aggressiveCheckpoint];
 		
+		[strongSelf recordWriterStall:(CFAbsoluteTimeGetCurrent() - start)];
+		
 	#pragma clang diagnostic pop
 	});
 }
@@ -2892,9 +3068,13 @@ static int connectionBusyHandler(void *ptr, int count) {
 	// The checkpoint can only write pages from snapshots if all connections are at or beyond the snapshot.
 	// Thus, this method is only called by a connection that moves the min snapshot forward.
 	
+	CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+	
 	checkpointResult = sqlite3_wal_checkpoint_v2(db, "main", SQLITE_CHECKPOINT_PASSIVE,
 	                                             &totalFrameCount, &checkpointedFrameCount);
 	
+	NSTimeInterval duration = CFAbsoluteTimeGetCurrent() - start;
+	
 	// totalFrameCount        = total number of frames in the WAL file
 	// checkpointedFrameCount = total number of checkpointed frames (those copied into db file)
 	//                          (including any that were already checkpointed before the function was called)
@@ -2914,6 +3094,16 @@ static int connectionBusyHandler(void *ptr, int count) {
 		return;// from_block
 	}
 	
+	uint64_t copiedFrameCount = [self recordCheckpointWithTotalFrames:totalFrameCount
+	                                                checkpointedFrames:checkpointedFrameCount
+	                                                          duration:duration];
+	
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		checkpointState.passiveCheckpointCount++;
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+	
 	// Did we checkpoint the entire WAL file ?
 	
 	BOOL didCheckpointEntireWAL = (totalFrameCount == checkpointedFrameCount);
@@ -2954,7 +3144,14 @@ static int connectionBusyHandler(void *ptr, int count) {
 	uint64_t walApproximateFileSize = totalFrameCount * pageSize;
 	BOOL needsAggressiveCheckpoint = (walApproximateFileSize >= options.aggressiveWALTruncationSize);
 	
-	if (needsAggressiveCheckpoint)
+	if (options.checkpointLatencyBudget > 0)
+	{
+		[self scheduleCheckpointSliceWithTotalFrames:totalFrameCount
+		                          checkpointedFrames:checkpointedFrameCount
+		                                copiedFrames:copiedFrameCount
+		                   needsAggressiveCheckpoint:needsAggressiveCheckpoint];
+	}
+	else if (needsAggressiveCheckpoint)
 	{
 		atomic_store(&aggressiveCheckpointEnabled, true);
 		
@@ -2962,6 +3159,78 @@ static int connectionBusyHandler(void *ptr, int count) {
 	}
 }
 
+/**
+ * Invoked after every successful passive checkpoint, when options.checkpointLatencyBudget is set.
+ *
+ * An aggressive checkpoint blocks writes for as long as it takes to copy the WAL backlog into the database.
+ * So rather than waiting for the WAL to reach aggressiveWALTruncationSize and then paying for the whole backlog
+ * at once, we start running passive checkpoints (which don't block writes) in repeated slices as soon as the
+ * WAL is projected to get there. And we only move to the write path once what's left fits within the budget.
+**/
+- (void)scheduleCheckpointSliceWithTotalFrames:(int)totalFrameCount
+                            checkpointedFrames:(int)checkpointedFrameCount
+                                  copiedFrames:(uint64_t)copiedFrameCount
+                     needsAggressiveCheckpoint:(BOOL)needsAggressiveCheckpoint
+{
+	if (needsAggressiveCheckpoint)
+	{
+		atomic_store(&aggressiveCheckpointEnabled, true);
+		
+		if ([self checkpointFitsLatencyBudget])
+		{
+			[self asyncAggressiveCheckpoint];
+			return;
+		}
+	}
+	
+	double growthRate = 0.0;
+	double commitLatency = 0.0;
+	
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		growthRate = checkpointState.walFrameGrowthRate;
+		commitLatency = checkpointState.commitLatency;
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+	
+	double projectedFrameCount = totalFrameCount + (growthRate * YDB_CHECKPOINT_PROJECTION_INTERVAL);
+	BOOL approachingLimit = needsAggressiveCheckpoint ||
+	                        (projectedFrameCount * pageSize >= options.aggressiveWALTruncationSize);
+	
+	BOOL hasBacklog = (checkpointedFrameCount < totalFrameCount);
+	
+	// If the last slice didn't copy anything, then a reader is holding back the checkpoint.
+	// There's no point spinning. The next transaction to finish will trigger another checkpoint.
+	
+	if (!approachingLimit || !hasBacklog || copiedFrameCount == 0) {
+		return;
+	}
+	
+	// Space the slices out based on how long commits are taking,
+	// so the slices interleave with writes rather than competing with them for I/O.
+	
+	NSTimeInterval interval = MIN(MAX(commitLatency * 2.0, YDB_CHECKPOINT_MIN_SLICE_INTERVAL),
+	                              YDB_CHECKPOINT_MAX_SLICE_INTERVAL);
+	
+	YDBLogVerbose(@"Scheduling checkpoint slice in %.3f seconds: frames(%d) checkpointed(%d) growth(%.1f/sec)",
+	              interval, totalFrameCount, checkpointedFrameCount, growthRate);
+	
+	__weak YapDatabase *weakSelf = self;
+	
+	dispatch_time_t when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC));
+	dispatch_after(when, checkpointQueue, ^{ @autoreleasepool {
+	#pragma clang diagnostic push
+	#pragma clang diagnostic warning "-Wimplicit-retain-self"
+		
+		__strong YapDatabase *strongSelf = weakSelf;
+		if (strongSelf == nil) return;
+		
+		[strongSelf asyncPassiveCheckpoint];
+		
+	#pragma clang diagnostic pop
+	}});
+}
+
 - (void)aggressiveCheckpoint
 {
 	int checkpointResult = 0;
@@ -2972,7 +3241,7 @@ static int connectionBusyHandler(void *ptr, int count) {
 	// We're going to run a non-passive checkpoint.
 	// Which may cause it to busy-wait while waiting on read transactions to complete.
 	
-	sqlite3_busy_timeout(db, 50); // milliseconds
+	sqlite3_busy_timeout(db, [self checkpointBusyTimeout]); // milliseconds
 	
 	// Step 1 of 3:
 	//
@@ -2987,6 +3256,11 @@ static int connectionBusyHandler(void *ptr, int count) {
 	YDBLogInfo(@"Post-checkpoint: src(b) mode(full) result(%d) frames(%d) checkpointed(%d)",
 	           checkpointResult, totalFrameCount, checkpointedFrameCount);
 	
+	if (checkpointResult == SQLITE_OK)
+	{
+		[self recordCheckpointWithTotalFrames:totalFrameCount checkpointedFrames:checkpointedFrameCount duration:0];
+	}
+	
 	if (totalFrameCount != checkpointedFrameCount)
 	{
 		return;
@@ -3141,7 +3415,8 @@ static int connectionBusyHandler(void *ptr, int count) {
 		}
 	}});
 	
-	long ready = dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(50 * NSEC_PER_MSEC)));
+	long ready = dispatch_group_wait(group,
+	                       dispatch_time(DISPATCH_TIME_NOW, (int64_t)([self checkpointBusyTimeout] * NSEC_PER_MSEC)));
 	
 	if (ready != 0)
 	{
@@ -3170,8 +3445,13 @@ static int connectionBusyHandler(void *ptr, int count) {
 	return atomic_load(&aggressiveCheckpointEnabled);
 }
 
-- (void)noteCheckpointWithTotalFrames:(int)totalFrameCount checkpointedFrames:(int)checkpointedFrameCount
+- (void)noteCheckpointWithTotalFrames:(int)totalFrameCount
+                   checkpointedFrames:(int)checkpointedFrameCount
+                             duration:(NSTimeInterval)duration
 {
+	[self recordCheckpointWithTotalFrames:totalFrameCount checkpointedFrames:checkpointedFrameCount duration:duration];
+	[self recordWriterStall:duration];
+	
 	uint64_t walApproximateFileSize = totalFrameCount * pageSize;
 	
 	if (walApproximateFileSize < options.aggressiveWALTruncationSize)
@@ -3180,4 +3460,195 @@ static int connectionBusyHandler(void *ptr, int count) {
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Checkpoint Scheduling
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * How long (in milliseconds) an aggressive checkpoint may wait on readers.
+**/
+- (int)checkpointBusyTimeout
+{
+	NSTimeInterval budget = options.checkpointLatencyBudget;
+	if (budget <= 0) {
+		return 50;
+	}
+	
+	return MAX(1, (int)(budget * 1000));
+}
+
+- (BOOL)checkpointFitsLatencyBudget
+{
+	NSTimeInterval budget = options.checkpointLatencyBudget;
+	if (budget <= 0) {
+		return YES;
+	}
+	
+	uint64_t walFrameCount = 0;
+	double backlogFrameCount = 0;
+	double secondsPerFrame = 0;
+	
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		walFrameCount = checkpointState.walFrameCount;
+		secondsPerFrame = checkpointState.secondsPerFrame;
+		
+		// Account for the frames that have (likely) been appended since the last checkpoint.
+		
+		double elapsed = MAX(0.0, CFAbsoluteTimeGetCurrent() - checkpointState.lastSampleTime);
+		backlogFrameCount = checkpointState.walBacklogFrameCount + (checkpointState.walFrameGrowthRate * elapsed);
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+	
+	if ((walFrameCount * pageSize) >= (options.aggressiveWALTruncationSize * YDB_CHECKPOINT_HARD_LIMIT_MULTIPLIER))
+	{
+		// The WAL is way too big. Stop being polite.
+		return YES;
+	}
+	
+	if (secondsPerFrame <= 0) {
+		secondsPerFrame = YDB_CHECKPOINT_DEFAULT_SECONDS_PER_FRAME;
+	}
+	
+	return (backlogFrameCount * secondsPerFrame) <= budget;
+}
+
+/**
+ * Updates the checkpoint metrics with the result of a successful checkpoint.
+ * Returns the number of frames copied into the database by the checkpoint.
+ *
+ * The duration is used to estimate the cost of checkpointing each frame, and may be zero if unknown.
+**/
+- (uint64_t)recordCheckpointWithTotalFrames:(int)totalFrameCount
+                          checkpointedFrames:(int)checkpointedFrameCount
+                                    duration:(NSTimeInterval)duration
+{
+	uint64_t totalFrames = (uint64_t)MAX(totalFrameCount, 0);
+	uint64_t checkpointedFrames = (uint64_t)MAX(checkpointedFrameCount, 0);
+	
+	uint64_t copiedFrames = 0;
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+	
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		// If the WAL was reset since the last checkpoint, the frame counts start over from zero.
+		
+		BOOL walWasReset = (totalFrames < checkpointState.walFrameCount);
+		
+		uint64_t previousFrames = walWasReset ? 0 : checkpointState.walFrameCount;
+		uint64_t previousCheckpointed = walWasReset ? 0 : checkpointState.walCheckpointedFrameCount;
+		
+		if (checkpointedFrames > previousCheckpointed) {
+			copiedFrames = checkpointedFrames - previousCheckpointed;
+		}
+		
+		if (checkpointState.lastSampleTime > 0 && now > checkpointState.lastSampleTime)
+		{
+			double appendedFrames = (double)(totalFrames - previousFrames);
+			double growthRate = appendedFrames / (now - checkpointState.lastSampleTime);
+			
+			checkpointState.walFrameGrowthRate = YDBCheckpointSmooth(checkpointState.walFrameGrowthRate, growthRate);
+		}
+		
+		if (copiedFrames > 0 && duration > 0)
+		{
+			double secondsPerFrame = duration / copiedFrames;
+			
+			checkpointState.secondsPerFrame = YDBCheckpointSmooth(checkpointState.secondsPerFrame, secondsPerFrame);
+		}
+		
+		checkpointState.walFrameCount = totalFrames;
+		checkpointState.walCheckpointedFrameCount = checkpointedFrames;
+		checkpointState.walBacklogFrameCount = (totalFrames > checkpointedFrames) ? (totalFrames - checkpointedFrames) : 0;
+		checkpointState.framesCheckpointed += copiedFrames;
+		checkpointState.lastSampleTime = now;
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+	
+	return copiedFrames;
+}
+
+/**
+ * Records time spent checkpointing on the write path (i.e. time read-write transactions were blocked).
+**/
+- (void)recordWriterStall:(NSTimeInterval)stall
+{
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		checkpointState.blockingCheckpointCount++;
+		checkpointState.writerStallTime += stall;
+		checkpointState.maxWriterStallTime = MAX(checkpointState.maxWriterStallTime, stall);
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+}
+
+- (void)noteCommitLatency:(NSTimeInterval)latency
+{
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		checkpointState.commitLatency = YDBCheckpointSmooth(checkpointState.commitLatency, latency);
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+}
+
+- (YapDatabaseCheckpointMetrics *)checkpointMetrics
+{
+	YDBCheckpointState state;
+	
+	YAPUnfairLockLock(&checkpointLock);
+	{
+		state = checkpointState;
+	}
+	YAPUnfairLockUnlock(&checkpointLock);
+	
+	YapDatabaseCheckpointMetrics *metrics = [[YapDatabaseCheckpointMetrics alloc] init];
+	
+	metrics->walSize = state.walFrameCount * pageSize;
+	metrics->walFrameCount = state.walFrameCount;
+	metrics->walBacklogFrameCount = state.walBacklogFrameCount;
+	metrics->framesCheckpointed = state.framesCheckpointed;
+	metrics->walFrameGrowthRate = state.walFrameGrowthRate;
+	metrics->checkpointSecondsPerFrame = state.secondsPerFrame;
+	metrics->commitLatency = state.commitLatency;
+	metrics->checkpointableSnapshot = state.checkpointableSnapshot;
+	metrics->passiveCheckpointCount = state.passiveCheckpointCount;
+	metrics->blockingCheckpointCount = state.blockingCheckpointCount;
+	metrics->writerStallTime = state.writerStallTime;
+	metrics->maxWriterStallTime = state.maxWriterStallTime;
+	
+	return metrics;
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation YapDatabaseCheckpointMetrics
+
+@synthesize walSize = walSize;
+@synthesize walFrameCount = walFrameCount;
+@synthesize walBacklogFrameCount = walBacklogFrameCount;
+@synthesize framesCheckpointed = framesCheckpointed;
+@synthesize walFrameGrowthRate = walFrameGrowthRate;
+@synthesize checkpointSecondsPerFrame = checkpointSecondsPerFrame;
+@synthesize commitLatency = commitLatency;
+@synthesize checkpointableSnapshot = checkpointableSnapshot;
+@synthesize passiveCheckpointCount = passiveCheckpointCount;
+@synthesize blockingCheckpointCount = blockingCheckpointCount;
+@synthesize writerStallTime = writerStallTime;
+@synthesize maxWriterStallTime = maxWriterStallTime;
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:
+	  @"<%@[%p] wal(%llu bytes, %llu frames, %llu backlog) checkpointed(%llu frames) growth(%.1f frames/sec)"
+	  @" cost(%.1f us/frame) commit(%.2f ms) passive(%lu) blocking(%lu) stall(%.2f ms total, %.2f ms max)>",
+	  [self class], self, walSize, walFrameCount, walBacklogFrameCount, framesCheckpointed, walFrameGrowthRate,
+	  (checkpointSecondsPerFrame * 1000000), (commitLatency * 1000),
+	  (unsigned long)passiveCheckpointCount, (unsigned long)blockingCheckpointCount,
+	  (writerStallTime * 1000), (maxWriterStallTime * 1000)];
+}
+
 @end
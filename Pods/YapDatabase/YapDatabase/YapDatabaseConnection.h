@@ -149,6 +149,41 @@ typedef NS_OPTIONS(NSUInteger, YapDatabaseConnectionFlushMemoryFlags) {
 @property (atomic, assign, readwrite) BOOL metadataCacheEnabled;
 @property (atomic, assign, readwrite) NSUInteger metadataCacheLimit;
 
+/**
+ * In addition to the count limits above, each cache may be capped by total cost.
+ *
+ * The cost of a cached object (or metadata) is the size in bytes of its serialized form,
+ * as read from or written to the database. When the total cost of the cache exceeds the cost limit,
+ * the least recently used items are evicted until the cache is back under budget.
+ * This allows the memory used by a cache full of large objects to be capped predictably,
+ * whereas the count limit treats a tiny object and a multi-megabyte object the same.
+ *
+ * Like the count limits, changes take immediate effect.
+ * A value of zero (the default) means there is no cost limit.
+ *
+ * @see YapDatabase defaultObjectCacheCostLimit
+ * @see YapDatabase defaultMetadataCacheCostLimit
+**/
+@property (atomic, assign, readwrite) NSUInteger objectCacheCostLimit;
+@property (atomic, assign, readwrite) NSUInteger metadataCacheCostLimit;
+
+/**
+ * Cache statistics, useful for tuning the limits above.
+ *
+ * The total cost is the sum of the (serialized) sizes of the items currently in the cache.
+ * The hit rate is the fraction of cache lookups that were satisfied by the cache (0.0 to 1.0),
+ * since the cache was enabled or the statistics were last reset.
+ *
+ * If the corresponding cache is disabled, these return zero.
+**/
+@property (atomic, readonly) NSUInteger objectCacheTotalCost;
+@property (atomic, readonly) NSUInteger metadataCacheTotalCost;
+
+@property (atomic, readonly) double objectCacheHitRate;
+@property (atomic, readonly) double metadataCacheHitRate;
+
+- (void)resetCacheStatistics;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Policy
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -452,6 +487,24 @@ typedef NS_OPTIONS(NSUInteger, YapDatabaseConnectionFlushMemoryFlags) {
 #pragma mark Changesets
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Normally, every changeset committed by a sibling connection is handed to this connection as soon as it's committed,
+ * and processed (on this connection's queue) one at a time.
+ * For a connection that's idle during a burst of writes, that's a lot of work it may never benefit from.
+ *
+ * When enabled, committed changesets are instead merged into a single compact delta
+ * (removed rowids, plus the set of changed collection/key tuples),
+ * which the connection applies in a single pass at the start of its next transaction.
+ * Cached objects & metadata for changed keys are evicted rather than updated in place.
+ *
+ * This is intended for background connections.
+ * It has no effect while the connection is within a longLivedReadTransaction,
+ * or if the database has enableMultiProcessSupport set.
+ *
+ * The default value is NO.
+**/
+@property (atomic, assign, readwrite) BOOL coalescesChangesets;
+
 /**
  * A YapDatabaseModifiedNotification is posted for every readwrite transaction that makes changes to the database.
  *
@@ -124,6 +124,7 @@ static int connectionBusyHandler(void *ptr, int count)
 	sqlite3_stmt *getRowidForKeyStatement;
 	sqlite3_stmt *getKeyForRowidStatement;
 	sqlite3_stmt *getDataForRowidStatement;
+	sqlite3_stmt *getDataForRowidsStatement;
 	sqlite3_stmt *getMetadataForRowidStatement;
 	sqlite3_stmt *getAllForRowidStatement;
 	sqlite3_stmt *getDataForKeyStatement;
@@ -212,6 +213,9 @@ static int connectionBusyHandler(void *ptr, int count)
 		objectCacheLimit = defaults.objectCacheLimit;
 		metadataCacheLimit = defaults.metadataCacheLimit;
 		
+		objectCacheCostLimit = defaults.objectCacheCostLimit;
+		metadataCacheCostLimit = defaults.metadataCacheCostLimit;
+		
 		if (defaults.objectCacheEnabled)
 		{
 			[self initializeObjectCache];
@@ -480,6 +484,7 @@ static int connectionBusyHandler(void *ptr, int count)
 	sqlite_finalize_null(&getRowidForKeyStatement);
 	sqlite_finalize_null(&getKeyForRowidStatement);
 	sqlite_finalize_null(&getDataForRowidStatement);
+	sqlite_finalize_null(&getDataForRowidsStatement);
 	sqlite_finalize_null(&getMetadataForRowidStatement);
 	sqlite_finalize_null(&getAllForRowidStatement);
 	sqlite_finalize_null(&getDataForKeyStatement);
@@ -583,6 +588,43 @@ static int connectionBusyHandler(void *ptr, int count)
 @synthesize autoFlushMemoryFlags;
 #endif
 
+- (BOOL)coalescesChangesets
+{
+	__block BOOL result = NO;
+	
+	dispatch_sync(database->snapshotQueue, ^{
+		
+		for (YapDatabaseConnectionState *state in database->connectionStates)
+		{
+			if (state->connection == self)
+			{
+				result = state->coalescesChangesets;
+				break;
+			}
+		}
+	});
+	
+	return result;
+}
+
+- (void)setCoalescesChangesets:(BOOL)flag
+{
+	dispatch_sync(database->snapshotQueue, ^{
+		
+		// Any pending coalescedChangeset is left in place,
+		// and is still applied at the start of the next transaction.
+		
+		for (YapDatabaseConnectionState *state in database->connectionStates)
+		{
+			if (state->connection == self)
+			{
+				state->coalescesChangesets = flag;
+				break;
+			}
+		}
+	});
+}
+
 - (BOOL)objectCacheEnabled
 {
 	__block BOOL result = NO;
@@ -749,6 +791,152 @@ static int connectionBusyHandler(void *ptr, int count)
 		dispatch_async(connectionQueue, block);
 }
 
+- (NSUInteger)objectCacheCostLimit
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_block_t block = ^{
+		result = objectCacheCostLimit;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (void)setObjectCacheCostLimit:(NSUInteger)newObjectCacheCostLimit
+{
+	dispatch_block_t block = ^{
+		
+		objectCacheCostLimit = newObjectCacheCostLimit;
+		objectCache.totalCostLimit = objectCacheCostLimit;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_async(connectionQueue, block);
+}
+
+- (NSUInteger)metadataCacheCostLimit
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_block_t block = ^{
+		result = metadataCacheCostLimit;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (void)setMetadataCacheCostLimit:(NSUInteger)newMetadataCacheCostLimit
+{
+	dispatch_block_t block = ^{
+		
+		metadataCacheCostLimit = newMetadataCacheCostLimit;
+		metadataCache.totalCostLimit = metadataCacheCostLimit;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_async(connectionQueue, block);
+}
+
+- (NSUInteger)objectCacheTotalCost
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_block_t block = ^{
+		result = objectCache.totalCost;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (NSUInteger)metadataCacheTotalCost
+{
+	__block NSUInteger result = 0;
+	
+	dispatch_block_t block = ^{
+		result = metadataCache.totalCost;
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+static double YapCacheHitRate(YapCache *cache)
+{
+	NSUInteger lookups = cache.hitCount + cache.missCount;
+	if (lookups == 0) return 0.0;
+	
+	return (double)cache.hitCount / (double)lookups;
+}
+
+- (double)objectCacheHitRate
+{
+	__block double result = 0.0;
+	
+	dispatch_block_t block = ^{
+		result = YapCacheHitRate(objectCache);
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (double)metadataCacheHitRate
+{
+	__block double result = 0.0;
+	
+	dispatch_block_t block = ^{
+		result = YapCacheHitRate(metadataCache);
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_sync(connectionQueue, block);
+	
+	return result;
+}
+
+- (void)resetCacheStatistics
+{
+	dispatch_block_t block = ^{
+		
+		[objectCache resetStatistics];
+		[metadataCache resetStatistics];
+	};
+	
+	if (dispatch_get_specific(IsOnConnectionQueueKey))
+		block();
+	else
+		dispatch_async(connectionQueue, block);
+}
+
 - (YapDatabasePolicy)objectPolicy
 {
 	__block YapDatabasePolicy policy = YapDatabasePolicyContainment;
@@ -847,6 +1035,7 @@ static int connectionBusyHandler(void *ptr, int count)
 	                                      keyCallbacks:[YapCollectionKey keyCallbacks]];
 	
 	objectCache.allowedKeyClasses = [NSSet setWithObject:[YapCollectionKey class]];
+	objectCache.totalCostLimit = objectCacheCostLimit;
 }
 
 - (void)initializeMetadataCache
@@ -855,6 +1044,7 @@ static int connectionBusyHandler(void *ptr, int count)
 	                                        keyCallbacks:[YapCollectionKey keyCallbacks]];
 	
 	metadataCache.allowedKeyClasses = [NSSet setWithObject:[YapCollectionKey class]];
+	metadataCache.totalCostLimit = metadataCacheCostLimit;
 }
 
 - (NSUInteger)calculateKeyCacheLimit
@@ -894,9 +1084,11 @@ static int connectionBusyHandler(void *ptr, int count)
 		
 		config.objectCacheEnabled = (objectCache != nil);
 		config.objectCacheLimit = objectCacheLimit;
+		config.objectCacheCostLimit = objectCacheCostLimit;
 		
 		config.metadataCacheEnabled = (metadataCache != nil);
 		config.metadataCacheLimit = metadataCacheLimit;
+		config.metadataCacheCostLimit = metadataCacheCostLimit;
 		
 		config.objectPolicy = objectPolicy;
 		config.metadataPolicy = metadataPolicy;
@@ -918,9 +1110,11 @@ static int connectionBusyHandler(void *ptr, int count)
 {
 	self.objectCacheEnabled = config.objectCacheEnabled;
 	self.objectCacheLimit = config.objectCacheLimit;
+	self.objectCacheCostLimit = config.objectCacheCostLimit;
 	
 	self.metadataCacheEnabled = config.metadataCacheEnabled;
 	self.metadataCacheLimit = config.metadataCacheLimit;
+	self.metadataCacheCostLimit = config.metadataCacheCostLimit;
 	
 	self.objectPolicy = config.objectPolicy;
 	self.metadataPolicy = config.metadataPolicy;
@@ -1204,6 +1398,36 @@ static int connectionBusyHandler(void *ptr, int count)
 	return *statement;
 }
 
+- (sqlite3_stmt *)getDataForRowidsStatement
+{
+	sqlite3_stmt **statement = &getDataForRowidsStatement;
+	if (*statement == NULL)
+	{
+		// SELECT "rowid", "data" FROM "database2" WHERE "rowid" IN (?, ?, ...);
+		//
+		// The number of host parameters is fixed so the statement can be reused.
+		// Unused parameters are bound to NULL, which never matches a rowid.
+		
+		NSMutableString *query = [NSMutableString stringWithCapacity:(64 + (YDB_BATCH_FETCH_ROWID_COUNT * 3))];
+		[query appendString:@"SELECT \"rowid\", \"data\" FROM \"database2\" WHERE \"rowid\" IN (?"];
+		
+		for (NSUInteger i = 1; i < YDB_BATCH_FETCH_ROWID_COUNT; i++)
+		{
+			[query appendString:@", ?"];
+		}
+		
+		[query appendString:@");"];
+		
+		int status = sqlite3_prepare_v2(db, [query UTF8String], -1, statement, NULL);
+		if (status != SQLITE_OK)
+		{
+			YDBLogError(@"Error creating '%@': %d %s", THIS_METHOD, status, sqlite3_errmsg(db));
+		}
+	}
+	
+	return *statement;
+}
+
 - (sqlite3_stmt *)getMetadataForRowidStatement
 {
 	sqlite3_stmt **statement = &getMetadataForRowidStatement;
@@ -2267,6 +2491,7 @@ static int connectionBusyHandler(void *ptr, int count)
 	__block uint64_t dbSnapshot = 0;
 	__block BOOL expectsChangesets = NO;
 	__block NSArray *changesets = nil;
+	__block YapDatabaseCoalescedChangeset *coalescedChangeset = nil;
 	
 	dispatch_sync(database->snapshotQueue, ^{ @autoreleasepool {
 		
@@ -2307,6 +2532,12 @@ static int connectionBusyHandler(void *ptr, int count)
 		
 		NSAssert(myState != nil, @"Missing state in database->connectionStates");
 		
+		// Take any changesets that were coalesced for us (see coalescesChangesets).
+		// These are no longer in the database's changesets list.
+		
+		coalescedChangeset = myState->coalescedChangeset;
+		myState->coalescedChangeset = nil;
+		
 		// Pre-Read-Transaction: Step 4 of 5
 		//
 		// Compare our snapshot with the database's snapshot.
@@ -2407,19 +2638,18 @@ static int connectionBusyHandler(void *ptr, int count)
 		}
 		else
 		{
-			isFastForwarding = YES;
-			for (NSDictionary *changeset in changesets)
-			{
-				[self noteCommittedChangeset:changeset];
-			}
-			isFastForwarding = NO;
+			[self fastForwardWithChangesets:changesets coalescedChangeset:coalescedChangeset];
 			
-			// The noteCommittedChangeset method (invoked above) updates our 'snapshot' variable.
+			// The fastForward method (invoked above) updates our 'snapshot' variable.
 			NSAssert(snapshot == dbSnapshot,
 			         @"Invalid connection state in preReadTransaction: snapshot(%llu) != dbSnapshot(%llu): %@",
 			         snapshot, dbSnapshot, changesets);
 		}
 	}
+	else if (coalescedChangeset)
+	{
+		[self fastForwardWithChangesets:nil coalescedChangeset:coalescedChangeset];
+	}
 	
 	// Pre-Read-Transaction: Step 6 of 6
 	//
@@ -2620,6 +2850,7 @@ static int connectionBusyHandler(void *ptr, int count)
 	__block uint64_t dbSnapshot = 0;
 	__block BOOL expectsChangesets = NO;
 	__block NSArray *changesets = nil;
+	__block YapDatabaseCoalescedChangeset *coalescedChangeset = nil;
 	
 	dispatch_sync(database->snapshotQueue, ^{ @autoreleasepool {
 		
@@ -2643,6 +2874,9 @@ static int connectionBusyHandler(void *ptr, int count)
 		
 		NSAssert(myState != nil, @"Missing state in database->connectionStates");
 		
+		coalescedChangeset = myState->coalescedChangeset;
+		myState->coalescedChangeset = nil;
+		
 		// Pre-Write-Transaction: Step 5 of 7
 		//
 		// Compare our snapshot with the database's snapshot.
@@ -2718,14 +2952,9 @@ static int connectionBusyHandler(void *ptr, int count)
 		}
 		else
 		{
-			isFastForwarding = YES;
-			for (NSDictionary *changeset in changesets)
-			{
-				[self noteCommittedChangeset:changeset];
-			}
-			isFastForwarding = NO;
+			[self fastForwardWithChangesets:changesets coalescedChangeset:coalescedChangeset];
 			
-			// The noteCommittedChangeset method (invoked above) updates our 'snapshot' variable.
+			// The fastForward method (invoked above) updates our 'snapshot' variable.
 			NSAssert(snapshot == dbSnapshot,
 			         @"Invalid connection state in preReadWriteTransaction: snapshot(%llu) != dbSnapshot(%llu)",
 			         snapshot, dbSnapshot);
@@ -2734,6 +2963,10 @@ static int connectionBusyHandler(void *ptr, int count)
 	else
 	{
 		externallyModified = NO;
+		
+		if (coalescedChangeset) {
+			[self fastForwardWithChangesets:nil coalescedChangeset:coalescedChangeset];
+		}
 	}
 	
 	// Pre-Write-Transaction: Step 7 of 7
@@ -3010,8 +3243,12 @@ static int connectionBusyHandler(void *ptr, int count)
 		// from the database. If it doesn't match what we expect, then we know we've run into the race condition,
 		// and we make the read-only transaction back out and try again.
 		
+		CFAbsoluteTime commitStart = CFAbsoluteTimeGetCurrent();
+		
 		[transaction commitTransaction];
 		
+		[database noteCommitLatency:(CFAbsoluteTimeGetCurrent() - commitStart)];
+		
 		__block uint64_t minSnapshot = UINT64_MAX;
 	
 		dispatch_sync(database->snapshotQueue, ^{ @autoreleasepool {
@@ -3069,22 +3306,31 @@ static int connectionBusyHandler(void *ptr, int count)
 		//
 		// If the WAL has gotten too big, then we perform a checkpoint right away.
 		// We purposefuly do this BEFORE posting the notification.
+		//
+		// Unless the backlog is too big to checkpoint within the configured latency budget,
+		// in which case the database continues checkpointing it in the background.
 		
-		if ([database aggressiveCheckpointEnabled])
+		if ([database aggressiveCheckpointEnabled] && [database checkpointFitsLatencyBudget])
 		{
 			int totalFrameCount = 0;
 			int checkpointedFrameCount = 0;
 			
+			CFAbsoluteTime checkpointStart = CFAbsoluteTimeGetCurrent();
+			
 			int checkpointResult = sqlite3_wal_checkpoint_v2(db, "main", SQLITE_CHECKPOINT_PASSIVE,
 			                                                 &totalFrameCount, &checkpointedFrameCount);
 			
+			NSTimeInterval checkpointDuration = CFAbsoluteTimeGetCurrent() - checkpointStart;
+			
 			YDBLogInfo(@"Post-checkpoint: src(d) mode(passive) result(%d) frames(%d) checkpointed(%d)",
 			           checkpointResult, totalFrameCount, checkpointedFrameCount);
 
 			
 			if (checkpointResult == SQLITE_OK)
 			{
-				[database noteCheckpointWithTotalFrames:totalFrameCount checkpointedFrames:checkpointedFrameCount];
+				[database noteCheckpointWithTotalFrames:totalFrameCount
+				                     checkpointedFrames:checkpointedFrameCount
+				                               duration:checkpointDuration];
 			}
 		}
 		
@@ -4278,6 +4524,199 @@ static int connectionBusyHandler(void *ptr, int count)
 	}];
 }
 
+/**
+ * Internal method.
+ *
+ * Invoked from preReadTransaction & preReadWriteTransaction to get caught up.
+ * The coalescedChangeset (if any) always precedes the given changesets,
+ * with the exception of changesets that were dispatched to us before coalescesChangesets was enabled.
+ * The given changesets may also include the ones the coalescedChangeset covers, which are skipped.
+**/
+- (void)fastForwardWithChangesets:(NSArray *)changesets
+               coalescedChangeset:(YapDatabaseCoalescedChangeset *)coalescedChangeset
+{
+	NSAssert(dispatch_get_specific(IsOnConnectionQueueKey), @"Must be invoked within connectionQueue");
+	
+	isFastForwarding = YES;
+	
+	uint64_t coalescedSnapshot = 0;
+	for (NSDictionary *changeset in changesets)
+	{
+		uint64_t changesetSnapshot = [[changeset objectForKey:YapDatabaseSnapshotKey] unsignedLongLongValue];
+		
+		if (coalescedChangeset && changesetSnapshot >= coalescedChangeset->firstSnapshot)
+		{
+			// Apply the coalesced changeset before any of the changesets it covers.
+			// The database may still hold those (if a sibling connection is lagging),
+			// and replaying them first would leave the coalesced changeset's firstSnapshot out of step with ours,
+			// which flushes every cache.
+			
+			coalescedSnapshot = coalescedChangeset->snapshot;
+			[self processCoalescedChangeset:coalescedChangeset];
+			coalescedChangeset = nil;
+		}
+		
+		if (changesetSnapshot <= coalescedSnapshot)
+		{
+			// Already applied as part of the coalesced changeset.
+			continue;
+		}
+		
+		[self noteCommittedChangeset:changeset];
+	}
+	
+	if (coalescedChangeset)
+	{
+		[self processCoalescedChangeset:coalescedChangeset];
+	}
+	isFastForwarding = NO;
+}
+
+/**
+ * Internal method.
+ *
+ * Applies the changesets that were coalesced for this connection (see coalescesChangesets) in a single pass.
+ * This is the equivalent of noteCommittedChangeset for each of them,
+ * except that cached objects & metadata for changed keys are evicted rather than updated.
+**/
+- (void)processCoalescedChangeset:(YapDatabaseCoalescedChangeset *)coalescedChangeset
+{
+	NSAssert(dispatch_get_specific(IsOnConnectionQueueKey), @"Must be invoked within connectionQueue");
+	
+	if (coalescedChangeset->snapshot <= snapshot)
+	{
+		YDBLogVerbose(@"Ignoring previously processed %@ for connection %@, database %@",
+		              coalescedChangeset, self, database);
+		return;
+	}
+	
+	YDBLogVerbose(@"Processing %@ for connection %@, database %@", coalescedChangeset, self, database);
+	
+	BOOL flushCaches = coalescedChangeset->flushCaches;
+	BOOL flushExtensionState = coalescedChangeset->flushExtensionState;
+	
+	if (coalescedChangeset->firstSnapshot != snapshot + 1)
+	{
+		// Snapshot numbers do not match (see noteCommittedChangeset).
+		
+		flushCaches = YES;
+		flushExtensionState = YES;
+	}
+	
+	snapshot = coalescedChangeset->snapshot;
+	
+	// Did registered extensions change ?
+	
+	if (coalescedChangeset->registeredExtensions)
+	{
+		registeredExtensions = coalescedChangeset->registeredExtensions;
+		extensionsOrder = coalescedChangeset->extensionsOrder;
+		extensionDependencies = coalescedChangeset->extensionDependencies;
+		
+		// An extension may have been dropped and re-registered (with the same name) in between,
+		// so we can't keep any of the existing extConnections.
+		// They're lazily re-created as needed.
+		
+		[extensions removeAllObjects];
+		extensionsReady = ([registeredExtensions count] == 0);
+	}
+	
+	// Did registered memory tables change ?
+	
+	if (coalescedChangeset->registeredMemoryTables)
+	{
+		registeredMemoryTables = coalescedChangeset->registeredMemoryTables;
+	}
+	
+	// Update keyCache, objectCache & metadataCache
+	
+	if (flushCaches)
+	{
+		[keyCache removeAllObjects];
+		[objectCache removeAllObjects];
+		[metadataCache removeAllObjects];
+	}
+	else
+	{
+		YapRowidSetEnumerate(coalescedChangeset->removedRowids, ^(int64_t rowid, BOOL __unused *stop) {
+			
+			[keyCache removeObjectForKey:@(rowid)];
+		});
+		
+		[objectCache removeObjectsForKeys:coalescedChangeset->changedObjectKeys];
+		[metadataCache removeObjectsForKeys:coalescedChangeset->changedMetadataKeys];
+		
+		NSSet<NSString *> *removedCollections = coalescedChangeset->removedCollections;
+		if ([removedCollections count] > 0)
+		{
+			NSMutableArray *rowidsToRemove = [NSMutableArray array];
+			[keyCache enumerateKeysAndObjectsWithBlock:^(id key, id obj, BOOL __unused *stop) {
+				
+				if ([removedCollections containsObject:[(YapCollectionKey *)obj collection]]) {
+					[rowidsToRemove addObject:key];
+				}
+			}];
+			[keyCache removeObjectsForKeys:rowidsToRemove];
+			
+			NSMutableArray *keysToRemove = [NSMutableArray array];
+			[objectCache enumerateKeysWithBlock:^(id key, BOOL __unused *stop) {
+				
+				if ([removedCollections containsObject:[(YapCollectionKey *)key collection]]) {
+					[keysToRemove addObject:key];
+				}
+			}];
+			[objectCache removeObjectsForKeys:keysToRemove];
+			
+			[keysToRemove removeAllObjects];
+			[metadataCache enumerateKeysWithBlock:^(id key, BOOL __unused *stop) {
+				
+				if ([removedCollections containsObject:[(YapCollectionKey *)key collection]]) {
+					[keysToRemove addObject:key];
+				}
+			}];
+			[metadataCache removeObjectsForKeys:keysToRemove];
+		}
+	}
+	
+	// Allow extensions to process their individual changesets
+	//
+	// Use existing extensions (extensions ivar, not [self extensions]).
+	// There's no need to create any new extConnections at this point.
+	
+	if (flushExtensionState)
+	{
+		[extensions enumerateKeysAndObjectsUsingBlock:
+		    ^(NSString __unused *extName, YapDatabaseExtensionConnection *extConnection, BOOL __unused *stop)
+		{
+			[extConnection _flushMemoryWithFlags:YapDatabaseConnectionFlushMemoryFlags_Extension_State];
+		}];
+	}
+	
+	SEL selector = @selector(noteCommittedChangeset:registeredName:);
+	IMP defaultIMP = [YapDatabaseExtensionConnection instanceMethodForSelector:selector];
+	
+	for (NSString *extName in [extensions allKeys])
+	{
+		YapDatabaseExtensionConnection *extConnection = [extensions objectForKey:extName];
+		
+		if ([extConnection methodForSelector:selector] != defaultIMP)
+		{
+			// This extConnection inspects the core changes in the full changeset,
+			// which aren't retained by the coalescedChangeset. So drop it, and let it be re-created as needed.
+			
+			[extensions removeObjectForKey:extName];
+			extensionsReady = NO;
+		}
+		else if (!flushExtensionState)
+		{
+			for (NSDictionary *extensionChangeset in coalescedChangeset->extensionChangesets)
+			{
+				[extConnection noteCommittedChangeset:extensionChangeset registeredName:extName];
+			}
+		}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Changeset Inspection
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
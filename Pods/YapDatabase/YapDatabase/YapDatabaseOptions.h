@@ -266,6 +266,32 @@ typedef NSData *_Nonnull (^YapDatabaseCipherKeyBlock)(void);
 **/
 @property (nonatomic, assign, readwrite) unsigned long long aggressiveWALTruncationSize;
 
+/**
+ * The maximum amount of time a single checkpoint operation should block read-write transactions.
+ *
+ * When aggressive checkpointing kicks in (see aggressiveWALTruncationSize), checkpoints are run
+ * between read-write transactions, and writes have to wait for them.
+ * The time this takes is proportional to the number of WAL frames that haven't been checkpointed yet,
+ * so during sustained writes a single aggressive checkpoint can cause a noticeable stall.
+ *
+ * If this value is non-zero, YapDatabase schedules checkpoints adaptively:
+ *
+ * - It tracks the WAL growth rate, the cost of checkpointing each frame, and commit latency.
+ * - It starts running passive checkpoints (which run in parallel with writes) in small, repeated slices
+ *   as soon as the WAL is projected to reach aggressiveWALTruncationSize, instead of waiting until it has.
+ * - It only checkpoints on the write path once the remaining backlog can be checkpointed within this budget.
+ *   Until then, it continues checkpointing in the background.
+ * - The busy timeouts used while waiting on readers during aggressive checkpoints are limited to this budget.
+ *
+ * As a safety valve, if the WAL reaches 4x aggressiveWALTruncationSize,
+ * aggressive checkpoints are performed regardless of the budget.
+ *
+ * See -[YapDatabase checkpointMetrics] to observe the effect.
+ *
+ * The default value is zero, meaning checkpoints are scheduled as described in aggressiveWALTruncationSize.
+**/
+@property (nonatomic, assign, readwrite) NSTimeInterval checkpointLatencyBudget;
+
 /**
  * This option enables multiprocess access to the database.
  *
@@ -289,6 +315,31 @@ typedef NSData *_Nonnull (^YapDatabaseCipherKeyBlock)(void);
 **/
 @property (nonatomic, assign, readwrite) BOOL enableMultiProcessSupport;
 
+/**
+ * Allows you to use a different serializer & deserializer for the objects within a particular collection.
+ * (The metadata always uses the serializer & deserializer given to the YapDatabase init method.)
+ *
+ * The blocks have the same signatures as YapDatabaseSerializer & YapDatabaseDeserializer.
+ * For every collection without a registered serializer, the serializer given to the init method is used.
+ *
+ * This is most useful when you want to switch some collections over to a faster (or more compact) format.
+ * Keep in mind that existing rows are NOT rewritten when you register a new serializer.
+ * They stay in whatever format they were written in, until the next time they're written.
+ * Thus the registered deserializer must be able to read both the old format & the new format.
+ * (E.g. by checking for a magic header, and falling back to the old deserializer if it's missing.)
+ *
+ * Registering a serializer for a collection replaces any serializer previously registered for it.
+ * Passing nil for both blocks removes the registration.
+ *
+ * The default value is an empty dictionary (no per-collection serializers).
+**/
+- (void)setObjectSerializer:(nullable NSData * _Nonnull (^)(NSString *collection, NSString *key, id object))serializer
+               deserializer:(nullable id _Nonnull (^)(NSString *collection, NSString *key, NSData *data))deserializer
+              forCollection:(NSString *)collection;
+
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, id> *collectionObjectSerializers;
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, id> *collectionObjectDeserializers;
+
 @end
 
 NS_ASSUME_NONNULL_END
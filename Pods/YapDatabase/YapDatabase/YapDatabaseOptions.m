@@ -13,6 +13,10 @@
  * The configuration options provided by this class are advanced (beyond the basic setup options).
 **/
 @implementation YapDatabaseOptions
+{
+	NSMutableDictionary<NSString *, id> *collectionObjectSerializers;
+	NSMutableDictionary<NSString *, id> *collectionObjectDeserializers;
+}
 
 @synthesize corruptAction = corruptAction;
 @synthesize pragmaSynchronous = pragmaSynchronous;
@@ -26,6 +30,7 @@
 @synthesize cipherPageSize = cipherPageSize;
 #endif
 @synthesize aggressiveWALTruncationSize = aggressiveWALTruncationSize;
+@synthesize checkpointLatencyBudget = checkpointLatencyBudget;
 @synthesize enableMultiProcessSupport = enableMultiProcessSupport;
 
 - (id)init
@@ -38,7 +43,10 @@
 		pragmaPageSize = 0;
 		pragmaMMapSize = 0;
 		aggressiveWALTruncationSize = (1024 * 1024 * 4); // 4 MB
+		checkpointLatencyBudget = 0.0;
         enableMultiProcessSupport = NO;
+		collectionObjectSerializers = [[NSMutableDictionary alloc] init];
+		collectionObjectDeserializers = [[NSMutableDictionary alloc] init];
 	}
 	return self;
 }
@@ -58,9 +66,41 @@
     copy->cipherPageSize = cipherPageSize;
 #endif
 	copy->aggressiveWALTruncationSize = aggressiveWALTruncationSize;
+	copy->checkpointLatencyBudget = checkpointLatencyBudget;
     copy->enableMultiProcessSupport = enableMultiProcessSupport;
+	copy->collectionObjectSerializers = [collectionObjectSerializers mutableCopy];
+	copy->collectionObjectDeserializers = [collectionObjectDeserializers mutableCopy];
 	
 	return copy;
 }
 
+- (void)setObjectSerializer:(NSData * (^)(NSString *collection, NSString *key, id object))serializer
+               deserializer:(id (^)(NSString *collection, NSString *key, NSData *data))deserializer
+              forCollection:(NSString *)collection
+{
+	NSParameterAssert(collection != nil);
+	NSParameterAssert((serializer == nil) == (deserializer == nil));
+	
+	if (serializer && deserializer)
+	{
+		collectionObjectSerializers[collection] = [serializer copy];
+		collectionObjectDeserializers[collection] = [deserializer copy];
+	}
+	else
+	{
+		[collectionObjectSerializers removeObjectForKey:collection];
+		[collectionObjectDeserializers removeObjectForKey:collection];
+	}
+}
+
+- (NSDictionary<NSString *, id> *)collectionObjectSerializers
+{
+	return [collectionObjectSerializers copy];
+}
+
+- (NSDictionary<NSString *, id> *)collectionObjectDeserializers
+{
+	return [collectionObjectDeserializers copy];
+}
+
 @end
@@ -1,5 +1,6 @@
 #import <Foundation/Foundation.h>
 
+@class YapCollectionKey;
 @class YapDatabaseConnection;
 @class YapDatabaseExtensionTransaction;
 
@@ -427,6 +428,27 @@ NS_ASSUME_NONNULL_BEGIN
                 inCollection:(nullable NSString *)collection
          unorderedUsingBlock:(void (^)(NSUInteger keyIndex, __nullable id object, __nullable id metadata, BOOL *stop))block;
 
+/**
+ * Fetches the objects for the given list of collection/key tuples, which may span any number of collections,
+ * and then enumerates them in the same order as the 'collectionKeys' parameter.
+ *
+ * Objects in the cache are used directly. The remaining rows are fetched by rowid, in batches,
+ * using a single prepared statement that is cached by the connection.
+ * That statement has a fixed list of 64 rowid parameters ("WHERE rowid IN (?, ?, ...)"),
+ * so larger requests step it once per 64 rows, and the unused parameters of the last batch are bound to NULL.
+ * (SQLite's carray extension, which would bind the whole array at once, isn't part of the system library.)
+ * When there are enough of them, the fetched rows are deserialized concurrently (off the transaction's thread)
+ * before being added to the cache.
+ *
+ * This is the method to use when you know exactly which items you need,
+ * such as a page of interactions in a conversation, or a list of contacts.
+ *
+ * If any keys are missing from the database, the 'object' parameter will be nil.
+**/
+- (void)enumerateObjectsForCollectionKeys:(NSArray<YapCollectionKey *> *)collectionKeys
+                               usingBlock:(void (^)(NSUInteger keyIndex, YapCollectionKey *collectionKey,
+                                                    __nullable id object, BOOL *stop))block;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Extensions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
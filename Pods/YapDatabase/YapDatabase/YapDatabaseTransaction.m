@@ -593,7 +593,7 @@
 		object = connection->database->objectDeserializer(cacheKey.collection, cacheKey.key, data);
 		
 		if (object)
-			[connection->objectCache setObject:object forKey:cacheKey];
+			[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)blobSize];
 	}
 	else if (status == SQLITE_ERROR)
 	{
@@ -652,9 +652,9 @@
 		}
 		
 		if (metadata)
-			[connection->metadataCache setObject:metadata forKey:cacheKey];
+			[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)blobSize];
 		else
-			[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+			[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 	}
 	else if (status == SQLITE_ERROR)
 	{
@@ -737,7 +737,7 @@
 				object = connection->database->objectDeserializer(cacheKey.collection, cacheKey.key, oData);
 				
 				if (object)
-					[connection->objectCache setObject:object forKey:cacheKey];
+					[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 			}
 			
 			if (metadataPtr)
@@ -755,9 +755,9 @@
 				}
 				
 				if (metadata)
-					[connection->metadataCache setObject:metadata forKey:cacheKey];
+					[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 				else
-					[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+					[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 			}
 			
 			found = YES;
@@ -838,7 +838,7 @@
 			object = connection->database->objectDeserializer(cacheKey.collection, cacheKey.key, data);
 			
 			if (object)
-				[connection->objectCache setObject:object forKey:cacheKey];
+				[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)blobSize];
 		}
 		else if (status == SQLITE_ERROR)
 		{
@@ -885,7 +885,7 @@
 			[connection->keyCache setObject:cacheKey forKey:@(rowid)];
 			
 			if (object) {
-				[connection->objectCache setObject:object forKey:cacheKey];
+				[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)blobSize];
 			}
 		}
 		else if (status == SQLITE_ERROR)
@@ -952,9 +952,9 @@
 			// Update cache
 			
 			if (metadata)
-				[connection->metadataCache setObject:metadata forKey:cacheKey];
+				[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)blobSize];
 			else
-				[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+				[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 		}
 		else if (status == SQLITE_ERROR)
 		{
@@ -1004,9 +1004,9 @@
 			[connection->keyCache setObject:cacheKey forKey:@(rowid)];
 			
 			if (metadata)
-				[connection->metadataCache setObject:metadata forKey:cacheKey];
+				[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)blobSize];
 			else
-				[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+				[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 		}
 		else if (status == SQLITE_ERROR)
 		{
@@ -1098,7 +1098,7 @@
 					object = connection->database->objectDeserializer(cacheKey.collection, cacheKey.key, oData);
 					
 					if (object)
-						[connection->objectCache setObject:object forKey:cacheKey];
+						[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 				}
 				
 				if (metadataPtr)
@@ -1116,9 +1116,9 @@
 					}
 					
 					if (metadata)
-						[connection->metadataCache setObject:metadata forKey:cacheKey];
+						[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 					else
-						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 				}
 				
 				found = YES;
@@ -1170,7 +1170,7 @@
 					object = connection->database->objectDeserializer(collection, key, oData);
 					
 					if (object)
-						[connection->objectCache setObject:object forKey:cacheKey];
+						[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 				}
 				
 				if (metadataPtr)
@@ -1185,9 +1185,9 @@
 					}
 					
 					if (metadata)
-						[connection->metadataCache setObject:metadata forKey:cacheKey];
+						[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 					else
-						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 				}
 				
 				found = YES;
@@ -2172,7 +2172,7 @@
 			if (object)
 			{
 				YapCollectionKey *cacheKey = [[YapCollectionKey alloc] initWithCollection:collection key:key];
-				[connection->objectCache setObject:object forKey:cacheKey];
+				[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)blobSize];
 			}
 			
 			block(keyIndex, object, &stop);
@@ -2383,7 +2383,7 @@
 			{
 				YapCollectionKey *cacheKey = [[YapCollectionKey alloc] initWithCollection:collection key:key];
 				
-				[connection->metadataCache setObject:metadata forKey:cacheKey];
+				[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)blobSize];
 			}
 			
 			block(keyIndex, metadata, &stop);
@@ -2608,7 +2608,7 @@
 				object = connection->database->objectDeserializer(collection, key, oData);
 				
 				if (object)
-					[connection->objectCache setObject:object forKey:cacheKey];
+					[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 			}
 			
 			id metadata = [connection->metadataCache objectForKey:cacheKey];
@@ -2629,9 +2629,9 @@
 				}
 				
 				if (metadata)
-					[connection->metadataCache setObject:metadata forKey:cacheKey];
+					[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 				else
-					[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+					[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 			}
 			
 			block(keyIndex, object, metadata, &stop);
@@ -2687,6 +2687,231 @@
 	FreeYapDatabaseString(&_collection);
 }
 
+/**
+ * Fetches the objects for the given list of collection/key tuples, which may span any number of collections,
+ * and then enumerates them in the same order as the 'collectionKeys' parameter.
+ *
+ * If any keys are missing from the database, the 'object' parameter will be nil.
+**/
+- (void)enumerateObjectsForCollectionKeys:(NSArray<YapCollectionKey *> *)collectionKeys
+                               usingBlock:(void (^)(NSUInteger keyIndex, YapCollectionKey *collectionKey,
+                                                    id object, BOOL *stop))block
+{
+	if (block == NULL) return;
+	
+	NSUInteger count = [collectionKeys count];
+	if (count == 0) return;
+	
+	// Step 1:
+	// Check the cache, and lookup the rowid for everything else.
+	// The rowids generally come straight from the keyCache.
+	
+	NSPointerArray *objects = [NSPointerArray strongObjectsPointerArray];
+	objects.count = count;
+	
+	NSMutableArray<NSNumber *> *missingRowids = [NSMutableArray arrayWithCapacity:count];
+	NSMutableDictionary<NSNumber *, NSMutableIndexSet *> *rowidIndexes = nil;
+	
+	NSUInteger keyIndex = 0;
+	for (YapCollectionKey *cacheKey in collectionKeys)
+	{
+		id object = [connection->objectCache objectForKey:cacheKey];
+		if (object)
+		{
+			[objects replacePointerAtIndex:keyIndex withPointer:(__bridge void *)object];
+		}
+		else
+		{
+			int64_t rowid = 0;
+			if ([self getRowid:&rowid forCollectionKey:cacheKey])
+			{
+				if (rowidIndexes == nil)
+					rowidIndexes = [NSMutableDictionary dictionaryWithCapacity:(count - keyIndex)];
+				
+				// The same key may be requested more than once.
+				
+				NSNumber *rowidNumber = @(rowid);
+				NSMutableIndexSet *indexes = [rowidIndexes objectForKey:rowidNumber];
+				if (indexes == nil)
+				{
+					indexes = [NSMutableIndexSet indexSet];
+					[rowidIndexes setObject:indexes forKey:rowidNumber];
+					[missingRowids addObject:rowidNumber];
+				}
+				[indexes addIndex:keyIndex];
+			}
+		}
+		
+		keyIndex++;
+	}
+	
+	// Step 2:
+	// Fetch the remaining rows, YDB_BATCH_FETCH_ROWID_COUNT at a time.
+	//
+	// Small fetches are deserialized as we go, straight from sqlite's buffer.
+	// Larger fetches copy the blobs out, and deserialize them concurrently afterwards.
+	
+	NSUInteger missingCount = [missingRowids count];
+	if (missingCount > 0)
+	{
+		sqlite3_stmt *statement = [connection getDataForRowidsStatement];
+		if (statement)
+		{
+			BOOL deserializeConcurrently = (missingCount >= YDB_CONCURRENT_DESERIALIZATION_THRESHOLD);
+			
+			NSMutableArray<NSNumber *> *fetchedRowids = [NSMutableArray arrayWithCapacity:missingCount];
+			NSMutableArray<NSData *> *fetchedData = deserializeConcurrently
+			  ? [NSMutableArray arrayWithCapacity:missingCount]
+			  : nil;
+			
+			// SELECT "rowid", "data" FROM "database2" WHERE "rowid" IN (?, ?, ...);
+			
+			int const column_idx_rowid = SQLITE_COLUMN_START + 0;
+			int const column_idx_data  = SQLITE_COLUMN_START + 1;
+			
+			for (NSUInteger offset = 0; offset < missingCount; offset += YDB_BATCH_FETCH_ROWID_COUNT)
+			{
+				NSUInteger batchCount = MIN(YDB_BATCH_FETCH_ROWID_COUNT, missingCount - offset);
+				
+				for (NSUInteger i = 0; i < YDB_BATCH_FETCH_ROWID_COUNT; i++)
+				{
+					int bind_idx = (int)(SQLITE_BIND_START + i);
+					
+					if (i < batchCount)
+						sqlite3_bind_int64(statement, bind_idx, [missingRowids[offset + i] longLongValue]);
+					else
+						sqlite3_bind_null(statement, bind_idx);
+				}
+				
+				int status;
+				while ((status = sqlite3_step(statement)) == SQLITE_ROW)
+				{
+					int64_t rowid = sqlite3_column_int64(statement, column_idx_rowid);
+					
+					const void *blob = sqlite3_column_blob(statement, column_idx_data);
+					int blobSize = sqlite3_column_bytes(statement, column_idx_data);
+					
+					NSNumber *rowidNumber = @(rowid);
+					
+					if (deserializeConcurrently)
+					{
+						[fetchedRowids addObject:rowidNumber];
+						[fetchedData addObject:[NSData dataWithBytes:blob length:blobSize]];
+					}
+					else
+					{
+						NSUInteger firstIndex = [[rowidIndexes objectForKey:rowidNumber] firstIndex];
+						YapCollectionKey *cacheKey = collectionKeys[firstIndex];
+						
+						// Performance tuning:
+						// Use dataWithBytesNoCopy to avoid an extra allocation and memcpy.
+						
+						NSData *data = [NSData dataWithBytesNoCopy:(void *)blob length:blobSize freeWhenDone:NO];
+						id object = connection->database->objectDeserializer(cacheKey.collection, cacheKey.key, data);
+						
+						[self didFetchObject:object
+						            forRowid:rowidNumber
+						                cost:(NSUInteger)blobSize
+						            cacheKey:cacheKey
+						             indexes:[rowidIndexes objectForKey:rowidNumber]
+						             objects:objects];
+					}
+				}
+				
+				if (status != SQLITE_DONE)
+				{
+					YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD, status, sqlite3_errmsg(connection->db));
+				}
+				
+				sqlite3_clear_bindings(statement);
+				sqlite3_reset(statement);
+			}
+			
+			if (deserializeConcurrently)
+			{
+				NSUInteger fetchedCount = [fetchedRowids count];
+				YapDatabaseDeserializer objectDeserializer = connection->database->objectDeserializer;
+				
+				// Deserializers are already required to be thread-safe,
+				// as multiple connections may use them simultaneously.
+				
+				__strong id *deserialized = (__strong id *)calloc(fetchedCount, sizeof(id));
+				__strong YapCollectionKey **deserializedKeys =
+				  (__strong YapCollectionKey **)calloc(fetchedCount, sizeof(YapCollectionKey *));
+				
+				for (NSUInteger i = 0; i < fetchedCount; i++)
+				{
+					NSUInteger firstIndex = [[rowidIndexes objectForKey:fetchedRowids[i]] firstIndex];
+					deserializedKeys[i] = collectionKeys[firstIndex];
+				}
+				
+				dispatch_apply(fetchedCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+					
+					YapCollectionKey *cacheKey = deserializedKeys[i];
+					deserialized[i] = objectDeserializer(cacheKey.collection, cacheKey.key, fetchedData[i]);
+				});
+				
+				for (NSUInteger i = 0; i < fetchedCount; i++)
+				{
+					NSNumber *rowidNumber = fetchedRowids[i];
+					
+					[self didFetchObject:deserialized[i]
+					            forRowid:rowidNumber
+					                cost:[fetchedData[i] length]
+					            cacheKey:deserializedKeys[i]
+					             indexes:[rowidIndexes objectForKey:rowidNumber]
+					             objects:objects];
+					
+					deserialized[i] = nil;
+					deserializedKeys[i] = nil;
+				}
+				
+				free(deserialized);
+				free(deserializedKeys);
+			}
+		}
+	}
+	
+	// Step 3:
+	// Enumerate everything, in order.
+	
+	YapMutationStackItem_Bool *mutation = [connection->mutationStack push]; // mutation during enumeration protection
+	BOOL stop = NO;
+	
+	for (keyIndex = 0; keyIndex < count; keyIndex++)
+	{
+		id object = (__bridge id)[objects pointerAtIndex:keyIndex];
+		
+		block(keyIndex, collectionKeys[keyIndex], object, &stop);
+		
+		if (stop || mutation.isMutated) break;
+	}
+	
+	if (!stop && mutation.isMutated) {
+		@throw [self mutationDuringEnumerationException];
+	}
+}
+
+/**
+ * Helper method for enumerateObjectsForCollectionKeys:usingBlock:
+ * Adds a freshly deserialized object to the cache, and to each requested index.
+**/
+- (void)didFetchObject:(id)object
+              forRowid:(NSNumber *)rowidNumber
+                  cost:(NSUInteger)cost
+              cacheKey:(YapCollectionKey *)cacheKey
+               indexes:(NSIndexSet *)indexes
+               objects:(NSPointerArray *)objects
+{
+	if (object == nil) return;
+	
+	[connection->objectCache setObject:object forKey:cacheKey cost:cost];
+	
+	[indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL __unused *stop) {
+		[objects replacePointerAtIndex:idx withPointer:(__bridge void *)object];
+	}];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Internal Enumerate (using rowid)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2959,7 +3184,7 @@
 				if (unlimitedObjectCacheLimit || [connection->objectCache count] < connection->objectCacheLimit)
 				{
 					if (object)
-						[connection->objectCache setObject:object forKey:cacheKey];
+						[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 				}
 			}
 			
@@ -3073,7 +3298,7 @@
 					    [connection->objectCache count] < connection->objectCacheLimit)
 					{
 						if (object)
-							[connection->objectCache setObject:object forKey:cacheKey];
+							[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 					}
 				}
 				
@@ -3189,7 +3414,7 @@
 				if (unlimitedObjectCacheLimit || [connection->objectCache count] < connection->objectCacheLimit)
 				{
 					if (object)
-						[connection->objectCache setObject:object forKey:cacheKey];
+						[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 				}
 			}
 			
@@ -3310,9 +3535,9 @@
 				    [connection->metadataCache count] < connection->metadataCacheLimit)
 				{
 					if (metadata)
-						[connection->metadataCache setObject:metadata forKey:cacheKey];
+						[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 					else
-						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 				}
 			}
 			
@@ -3436,9 +3661,9 @@
 					    [connection->metadataCache count] < connection->metadataCacheLimit)
 					{
 						if (metadata)
-							[connection->metadataCache setObject:metadata forKey:cacheKey];
+							[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 						else
-							[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+							[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 					}
 				}
 				
@@ -3574,9 +3799,9 @@
 				    [connection->metadataCache count] < connection->metadataCacheLimit)
 				{
 					if (metadata)
-						[connection->metadataCache setObject:metadata forKey:cacheKey];
+						[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 					else
-						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 				}
 			}
 			
@@ -3688,7 +3913,7 @@
 				if (unlimitedObjectCacheLimit || [connection->objectCache count] < connection->objectCacheLimit)
 				{
 					if (object)
-						[connection->objectCache setObject:object forKey:cacheKey];
+						[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 				}
 			}
 			
@@ -3723,9 +3948,9 @@
 				    [connection->metadataCache count] < connection->metadataCacheLimit)
 				{
 					if (metadata)
-						[connection->metadataCache setObject:metadata forKey:cacheKey];
+						[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 					else
-						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 				}
 			}
 			
@@ -3841,7 +4066,7 @@
 					    [connection->objectCache count] < connection->objectCacheLimit)
 					{
 						if (object)
-							[connection->objectCache setObject:object forKey:cacheKey];
+							[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 					}
 				}
 				
@@ -3876,9 +4101,9 @@
 					    [connection->metadataCache count] < connection->metadataCacheLimit)
 					{
 						if (metadata)
-							[connection->metadataCache setObject:metadata forKey:cacheKey];
+							[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 						else
-							[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+							[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 					}
 				}
 				
@@ -3996,7 +4221,7 @@
 				if (unlimitedObjectCacheLimit || [connection->objectCache count] < connection->objectCacheLimit)
 				{
 					if (object)
-						[connection->objectCache setObject:object forKey:cacheKey];
+						[connection->objectCache setObject:object forKey:cacheKey cost:(NSUInteger)oBlobSize];
 				}
 			}
 			
@@ -4021,9 +4246,9 @@
 				    [connection->metadataCache count] < connection->metadataCacheLimit)
 				{
 					if (metadata)
-						[connection->metadataCache setObject:metadata forKey:cacheKey];
+						[connection->metadataCache setObject:metadata forKey:cacheKey cost:(NSUInteger)mBlobSize];
 					else
-						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+						[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 				}
 			}
 			
@@ -4191,6 +4416,127 @@
 	FreeYapDatabaseString(&_collection);
 }
 
+/**
+ * Enumerates the serialized rows in the given collections (or in all collections if collections is nil).
+ *
+ * Nothing is deserialized, and the object & metadata caches are neither consulted nor populated.
+ * This allows the caller to perform the deserialization elsewhere (e.g. concurrently on other threads).
+ *
+ * The given data parameters point directly into sqlite's buffers, and are only valid for the duration of the block.
+ * The caller must copy them if they're needed after the block returns.
+ * The metadata parameter is nil if the row doesn't have any metadata.
+**/
+- (void)_enumerateSerializedRowsInCollections:(NSArray *)collections
+     usingBlock:(void (^)(int64_t rowid, NSString *collection, NSString *key,
+                          NSData *objectData, NSData *metadataData, BOOL *stop))block
+{
+	if (block == NULL) return;
+	if (collections && [collections count] == 0) return;
+	
+	BOOL needsFinalize;
+	sqlite3_stmt *statement = NULL;
+	
+	if (collections)
+		statement = [connection enumerateRowsInCollectionStatement:&needsFinalize];
+	else
+		statement = [connection enumerateRowsInAllCollectionsStatement:&needsFinalize];
+	
+	if (statement == NULL) return;
+	
+	YapMutationStackItem_Bool *mutation = [connection->mutationStack push]; // mutation during enumeration protection
+	BOOL stop = NO;
+	
+	// collections != nil:
+	// SELECT "rowid", "key", "data", "metadata" FROM "database2" WHERE "collection" = ?;
+	//
+	// collections == nil:
+	// SELECT "rowid", "collection", "key", "data", "metadata" FROM "database2" ORDER BY \"collection\" ASC;";
+	
+	int const column_offset = collections ? 0 : 1;
+	
+	int const column_idx_rowid      = SQLITE_COLUMN_START + 0;
+	int const column_idx_collection = SQLITE_COLUMN_START + 1;
+	int const column_idx_key        = SQLITE_COLUMN_START + 1 + column_offset;
+	int const column_idx_data       = SQLITE_COLUMN_START + 2 + column_offset;
+	int const column_idx_metadata   = SQLITE_COLUMN_START + 3 + column_offset;
+	int const bind_idx_collection   = SQLITE_BIND_START;
+	
+	NSArray *passes = collections ?: @[ [NSNull null] ];
+	
+	for (id pass in passes)
+	{
+		NSString *collection = nil;
+		YapDatabaseString _collection;
+		
+		if (collections)
+		{
+			collection = (NSString *)pass;
+			
+			MakeYapDatabaseString(&_collection, collection);
+			sqlite3_bind_text(statement, bind_idx_collection, _collection.str, _collection.length, SQLITE_STATIC);
+		}
+		
+		int status;
+		while ((status = sqlite3_step(statement)) == SQLITE_ROW)
+		{
+			int64_t rowid = sqlite3_column_int64(statement, column_idx_rowid);
+			
+			if (collections == nil)
+			{
+				const unsigned char *text = sqlite3_column_text(statement, column_idx_collection);
+				int textSize = sqlite3_column_bytes(statement, column_idx_collection);
+				
+				collection = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+			}
+			
+			const unsigned char *text = sqlite3_column_text(statement, column_idx_key);
+			int textSize = sqlite3_column_bytes(statement, column_idx_key);
+			
+			NSString *key = [[NSString alloc] initWithBytes:text length:textSize encoding:NSUTF8StringEncoding];
+			
+			const void *oBlob = sqlite3_column_blob(statement, column_idx_data);
+			int oBlobSize = sqlite3_column_bytes(statement, column_idx_data);
+			
+			const void *mBlob = sqlite3_column_blob(statement, column_idx_metadata);
+			int mBlobSize = sqlite3_column_bytes(statement, column_idx_metadata);
+			
+			NSData *oData = [NSData dataWithBytesNoCopy:(void *)oBlob length:oBlobSize freeWhenDone:NO];
+			NSData *mData = nil;
+			
+			if (mBlobSize > 0)
+				mData = [NSData dataWithBytesNoCopy:(void *)mBlob length:mBlobSize freeWhenDone:NO];
+			
+			block(rowid, collection, key, oData, mData, &stop);
+			
+			if (stop || mutation.isMutated) break;
+		}
+		
+		if ((status != SQLITE_DONE) && !stop && !mutation.isMutated)
+		{
+			YDBLogError(@"%@ - sqlite_step error: %d %s", THIS_METHOD, status, sqlite3_errmsg(connection->db));
+		}
+		
+		if (collections)
+		{
+			sqlite3_clear_bindings(statement); // ok: within loop
+			sqlite3_reset(statement);          // ok: within loop
+			FreeYapDatabaseString(&_collection);
+		}
+		
+		if (stop || mutation.isMutated)
+		{
+			break;
+		}
+	}
+	
+	sqlite_enum_reset(statement, needsFinalize);
+	
+	if (!stop && mutation.isMutated)
+	{
+		@throw [self mutationDuringEnumerationException];
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Extensions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -4893,7 +5239,7 @@
 			_object = [YapNull null];
 	}
 	
-	[connection->objectCache setObject:object forKey:cacheKey];
+	[connection->objectCache setObject:object forKey:cacheKey cost:[serializedObject length]];
 	[connection->objectChanges setObject:_object forKey:cacheKey];
 	
 	if (metadata)
@@ -4913,12 +5259,12 @@
 				_metadata = [YapNull null];
 		}
 		
-		[connection->metadataCache setObject:metadata forKey:cacheKey];
+		[connection->metadataCache setObject:metadata forKey:cacheKey cost:[serializedMetadata length]];
 		[connection->metadataChanges setObject:_metadata forKey:cacheKey];
 	}
 	else
 	{
-		[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+		[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 		[connection->metadataChanges setObject:[YapNull null] forKey:cacheKey];
 	}
 	
@@ -5114,7 +5460,7 @@
 			_object = [YapNull null];
 	}
 	
-	[connection->objectCache setObject:object forKey:cacheKey];
+	[connection->objectCache setObject:object forKey:cacheKey cost:[serializedObject length]];
 	[connection->objectChanges setObject:_object forKey:cacheKey];
 	
 	for (YapDatabaseExtensionTransaction *extTransaction in [self orderedExtensions])
@@ -5296,12 +5642,12 @@
 				_metadata = [YapNull null];
 		}
 		
-		[connection->metadataCache setObject:metadata forKey:cacheKey];
+		[connection->metadataCache setObject:metadata forKey:cacheKey cost:[serializedMetadata length]];
 		[connection->metadataChanges setObject:_metadata forKey:cacheKey];
 	}
 	else
 	{
-		[connection->metadataCache setObject:[YapNull null] forKey:cacheKey];
+		[connection->metadataCache setObject:[YapNull null] forKey:cacheKey cost:0];
 		[connection->metadataChanges setObject:[YapNull null] forKey:cacheKey];
 	}
 	
@@ -30,6 +30,135 @@ static NSString *StringByTrimming(NSString *aString) {
   return [aString stringByTrimmingCharactersInSet:whitespaceCharSet];
 }
 
+#pragma mark - Binary metadata
+
+// kPhoneNumberMetaData is a flat, offset-based encoding of the metadata JSON, compiled at build time.
+// See scripts/GeneratePhoneNumberBinaryMetaData.py for the format. It's read in place: nothing is
+// parsed up front, and a region's NBPhoneMetaData is only materialized the first time it's asked for.
+
+static const uint32_t kNBMetaDataVersion = 1;
+
+static const size_t kNBMetaDataVersionOffset = 4;
+static const size_t kNBMetaDataLengthOffset = 8;
+static const size_t kNBMetaDataStringCountOffset = 12;
+static const size_t kNBMetaDataStringTableOffset = 16;
+static const size_t kNBMetaDataRegionCountOffset = 20;
+static const size_t kNBMetaDataRegionTableOffset = 24;
+static const size_t kNBMetaDataCountryCodeCountOffset = 28;
+static const size_t kNBMetaDataCountryCodeTableOffset = 32;
+
+typedef NS_ENUM(uint8_t, NBMetaDataTag) {
+  NBMetaDataTagNull = 0,
+  NBMetaDataTagInt = 1,
+  NBMetaDataTagString = 2,
+  NBMetaDataTagArray = 3,
+};
+
+static inline uint32_t NBMetaDataUInt32(size_t offset) {
+  NSCAssert(offset + sizeof(uint32_t) <= kPhoneNumberMetaDataLength, @"Metadata offset out of bounds");
+  uint32_t value;
+  memcpy(&value, kPhoneNumberMetaData + offset, sizeof(value));
+  return CFSwapInt32LittleToHost(value);
+}
+
+static BOOL NBMetaDataIsValid(void) {
+  static BOOL isValid = NO;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    isValid = kPhoneNumberMetaDataLength > kNBMetaDataCountryCodeTableOffset + sizeof(uint32_t) &&
+              memcmp(kPhoneNumberMetaData, "NBMD", 4) == 0 &&
+              NBMetaDataUInt32(kNBMetaDataVersionOffset) == kNBMetaDataVersion &&
+              NBMetaDataUInt32(kNBMetaDataLengthOffset) == kPhoneNumberMetaDataLength;
+    NSCAssert(isValid, @"Invalid phone number metadata. Regenerate NBGeneratedPhoneNumberMetaData.h");
+  });
+  return isValid;
+}
+
+static const char *NBMetaDataStringBytes(uint32_t index, uint32_t *length) {
+  NSCAssert(index < NBMetaDataUInt32(kNBMetaDataStringCountOffset), @"Metadata string out of bounds");
+  size_t entry = NBMetaDataUInt32(kNBMetaDataStringTableOffset) + (size_t)index * 8;
+  *length = NBMetaDataUInt32(entry + 4);
+  return (const char *)kPhoneNumberMetaData + NBMetaDataUInt32(entry);
+}
+
+static NSString *NBMetaDataString(uint32_t index) {
+  uint32_t length = 0;
+  const char *bytes = NBMetaDataStringBytes(index, &length);
+  // The metadata is static, so the string can point straight at it.
+  return [[NSString alloc] initWithBytesNoCopy:(void *)bytes
+                                        length:length
+                                      encoding:NSUTF8StringEncoding
+                                  freeWhenDone:NO];
+}
+
+// Decodes the value at *offset, and advances *offset past it.
+// Nulls are decoded as NSNull, so array indexes line up with the JSON (as with NSJSONSerialization).
+static id NBMetaDataValue(size_t *offset) {
+  NSCAssert(*offset < kPhoneNumberMetaDataLength, @"Metadata offset out of bounds");
+  NBMetaDataTag tag = kPhoneNumberMetaData[*offset];
+  *offset += 1;
+
+  switch (tag) {
+    case NBMetaDataTagNull:
+      return [NSNull null];
+    case NBMetaDataTagInt: {
+      int32_t value = (int32_t)NBMetaDataUInt32(*offset);
+      *offset += sizeof(uint32_t);
+      return @(value);
+    }
+    case NBMetaDataTagString: {
+      uint32_t index = NBMetaDataUInt32(*offset);
+      *offset += sizeof(uint32_t);
+      return NBMetaDataString(index);
+    }
+    case NBMetaDataTagArray: {
+      uint32_t count = NBMetaDataUInt32(*offset);
+      *offset += sizeof(uint32_t);
+      NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:count];
+      for (uint32_t i = 0; i < count; i++) {
+        [array addObject:NBMetaDataValue(offset)];
+      }
+      return array;
+    }
+  }
+
+  NSCAssert(NO, @"Unknown metadata tag %d", tag);
+  return [NSNull null];
+}
+
+// Binary search of the region table. Returns the offset of the region's entry, or 0 if there isn't one.
+static size_t NBMetaDataEntryOffsetForRegion(NSString *regionCode) {
+  if (!NBMetaDataIsValid()) {
+    return 0;
+  }
+
+  const char *key = regionCode.UTF8String;
+  size_t keyLength = strlen(key);
+
+  size_t table = NBMetaDataUInt32(kNBMetaDataRegionTableOffset);
+  uint32_t low = 0;
+  uint32_t high = NBMetaDataUInt32(kNBMetaDataRegionCountOffset);
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    uint32_t length = 0;
+    const char *bytes = NBMetaDataStringBytes(NBMetaDataUInt32(table + (size_t)mid * 8), &length);
+
+    int result = memcmp(bytes, key, MIN(length, keyLength));
+    if (result == 0) {
+      result = (length < keyLength) ? -1 : (length > keyLength ? 1 : 0);
+    }
+
+    if (result == 0) {
+      return NBMetaDataUInt32(table + (size_t)mid * 8 + 4);
+    } else if (result < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return 0;
+}
+
 @implementation NBMetadataHelper
 
 /*
@@ -38,39 +167,6 @@ static NSString *StringByTrimming(NSString *aString) {
  - Country Code   (CC) : ISO country codes (2 chars)
  Ref. site (countrycode.org)
  */
-+ (NSDictionary *)phoneNumberDataMap {
-  static NSDictionary *phoneNumberDataDictionary;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    // Data is a gzipped JSON file that is embedded in the binary.
-    // See GeneratePhoneNumberHeader.sh and PhoneNumberMetaData.h for details.
-    NSMutableData *gunzippedData =
-        [NSMutableData dataWithLength:kPhoneNumberMetaDataExpandedLength];
-
-    z_stream zStream;
-    memset(&zStream, 0, sizeof(zStream));
-    __attribute((unused)) int err = inflateInit2(&zStream, 16);
-    NSAssert(err == Z_OK, @"Unable to init stream. err = %d", err);
-
-    zStream.next_in = kPhoneNumberMetaData;
-    zStream.avail_in = (uint)kPhoneNumberMetaDataCompressedLength;
-    zStream.next_out = (Bytef *)gunzippedData.bytes;
-    zStream.avail_out = (uint)gunzippedData.length;
-
-    err = inflate(&zStream, Z_FINISH);
-    NSAssert(err == Z_STREAM_END, @"Unable to inflate compressed data. err = %d", err);
-
-    err = inflateEnd(&zStream);
-    NSAssert(err == Z_OK, @"Unable to inflate compressed data. err = %d", err);
-
-    NSError *error = nil;
-    phoneNumberDataDictionary =
-        [NSJSONSerialization JSONObjectWithData:gunzippedData options:0 error:&error];
-    NSAssert(error == nil, @"Unable to convert JSON - %@", error);
-  });
-  return phoneNumberDataDictionary;
-}
-
 + (NSDictionary *)CCode2CNMap {
   static NSMutableDictionary *mapCCode2CN;
   static dispatch_once_t onceToken;
@@ -88,7 +184,42 @@ static NSString *StringByTrimming(NSString *aString) {
 }
 
 + (NSDictionary *)CN2CCodeMap {
-  return [self phoneNumberDataMap][@"countryCodeToRegionCodeMap"];
+  static NSMutableDictionary *mapCN2CCode;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mapCN2CCode = [[NSMutableDictionary alloc] init];
+    if (!NBMetaDataIsValid()) {
+      return;
+    }
+
+    size_t table = NBMetaDataUInt32(kNBMetaDataCountryCodeTableOffset);
+    uint32_t count = NBMetaDataUInt32(kNBMetaDataCountryCodeCountOffset);
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t countryCode = NBMetaDataUInt32(table + (size_t)i * 8);
+      size_t list = NBMetaDataUInt32(table + (size_t)i * 8 + 4);
+
+      uint32_t regionCount = NBMetaDataUInt32(list);
+      NSMutableArray *regionCodes = [[NSMutableArray alloc] initWithCapacity:regionCount];
+      for (uint32_t j = 0; j < regionCount; j++) {
+        [regionCodes addObject:NBMetaDataString(NBMetaDataUInt32(list + 4 + (size_t)j * 4))];
+      }
+      mapCN2CCode[[@(countryCode) stringValue]] = regionCodes;
+    }
+  });
+  return mapCN2CCode;
+}
+
+/**
+ * Materialized NBPhoneMetaData, shared by all helpers.
+ * Only regions that have been asked for are ever decoded.
+ */
++ (NSCache *)metadataCache {
+  static NSCache *metadataCache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    metadataCache = [[NSCache alloc] init];
+  });
+  return metadataCache;
 }
 
 - (NSArray *)getAllMetadata {
@@ -160,16 +291,22 @@ static NSString *StringByTrimming(NSString *aString) {
     return _cachedMetaData;
   }
 
-  NSDictionary *dict = [[self class] phoneNumberDataMap][@"countryToMetadata"];
-  NSArray *entry = dict[regionCode];
-  if (entry) {
-    NBPhoneMetaData *metadata = [[NBPhoneMetaData alloc] initWithEntry:entry];
-    _cachedMetaData = metadata;
-    _cachedMetaDataKey = regionCode;
-    return metadata;
+  NSCache *metadataCache = [[self class] metadataCache];
+  NBPhoneMetaData *metadata = [metadataCache objectForKey:regionCode];
+  if (!metadata) {
+    size_t offset = NBMetaDataEntryOffsetForRegion(regionCode);
+    if (offset == 0) {
+      return nil;
+    }
+
+    NSArray *entry = NBMetaDataValue(&offset);
+    metadata = [[NBPhoneMetaData alloc] initWithEntry:entry];
+    [metadataCache setObject:metadata forKey:regionCode];
   }
 
-  return nil;
+  _cachedMetaData = metadata;
+  _cachedMetaDataKey = regionCode;
+  return metadata;
 }
 
 /**
@@ -103,6 +103,10 @@
                                   error:(NSError **)error;
 - (NBPhoneNumber *)parseWithPhoneCarrierRegion:(NSString *)numberToParse error:(NSError **)error;
 
+// Parses the numbers on several threads. Returns an NBPhoneNumber, or NSNull if
+// the number couldn't be parsed, for each of the numbers in order.
+- (NSArray *)parseNumbers:(NSArray *)numbersToParse defaultRegion:(NSString *)defaultRegion;
+
 - (NSString *)format:(NBPhoneNumber *)phoneNumber
         numberFormat:(NBEPhoneNumberFormat)numberFormat
                error:(NSError **)error;
@@ -24,6 +24,335 @@ static NSString *NormalizeNonBreakingSpace(NSString *aString) {
   return [aString stringByReplacingOccurrencesOfString:NB_NON_BREAKING_SPACE withString:@" "];
 }
 
+#pragma mark - Character scanners -
+
+// Table-driven equivalents of the hottest patterns, so that normalizing and
+// parsing ordinary numbers doesn't have to go through NSRegularExpression.
+// Each gives exactly the result of the pattern (or mapping) it stands in for.
+
+// Numbers longer than this are copied to the heap rather than the stack.
+#define NB_SCANNER_STACK_LENGTH 256
+
+// Keypad digits for 'A' to 'Z', as in ALL_NORMALIZATION_MAPPINGS (ITU E.161).
+static const char kNBKeypadDigits[] = "22233344455566677778889999";
+
+// The digits in NB_VALID_DIGITS_STRING: ASCII, fullwidth, Arabic-Indic and
+// Eastern-Arabic. Returns the digit's value, or -1.
+static inline int NBValidDigitValue(unichar c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 0x0660 && c <= 0x0669) {
+    return c - 0x0660;
+  } else if (c >= 0x06F0 && c <= 0x06F9) {
+    return c - 0x06F0;
+  } else if (c >= 0xFF10 && c <= 0xFF19) {
+    return c - 0xFF10;
+  }
+  return -1;
+}
+
+// The digits in DIGIT_MAPPINGS, which also include Devanagari and Bengali.
+static inline int NBMappedDigitValue(unichar c) {
+  int value = NBValidDigitValue(c);
+  if (value < 0) {
+    if (c >= 0x0966 && c <= 0x096F) {
+      value = c - 0x0966;
+    } else if (c >= 0x09E6 && c <= 0x09EF) {
+      value = c - 0x09E6;
+    }
+  }
+  return value;
+}
+
+static inline BOOL NBIsPlusChar(unichar c) {
+  return c == '+' || c == 0xFF0B;
+}
+
+static inline BOOL NBIsASCIIAlpha(unichar c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+// Characters that '.' doesn't match.
+static inline BOOL NBIsLineTerminator(unichar c) {
+  return (c >= 0x000A && c <= 0x000D) || c == 0x0085 || c == 0x2028 || c == 0x2029;
+}
+
+// The punctuation allowed between digits by VALID_PHONE_NUMBER_PATTERN.
+static BOOL NBIsValidPunctuation(unichar c) {
+  switch (c) {
+    case '-':
+    case 'x':
+    case ' ':
+    case '(':
+    case ')':
+    case '.':
+    case '[':
+    case ']':
+    case '/':
+    case '~':
+    case '*':
+    case 0x00A0:
+    case 0x00AD:
+    case 0x200B:
+    case 0x2053:
+    case 0x2060:
+    case 0x2212:
+    case 0x223C:
+    case 0x3000:
+    case 0x30FC:
+    case 0xFF08:
+    case 0xFF09:
+    case 0xFF3B:
+    case 0xFF3D:
+    case 0xFF5E:
+      return YES;
+    default:
+      return (c >= 0x2010 && c <= 0x2015) || (c >= 0xFF0D && c <= 0xFF0F);
+  }
+}
+
+typedef NS_ENUM(NSInteger, NBScanResult) {
+  NBScanResultNoMatch,
+  NBScanResultMatch,
+  // The scanner can't tell, and the regular expression has to decide.
+  NBScanResultUnknown,
+};
+
+/**
+ * Calls the block with the characters of the string in a writable buffer, and
+ * returns the string made of the first n characters, where n is what the block
+ * returns. Each normalization maps a character to at most one character, so the
+ * buffer is compacted in place.
+ */
+static NSString *NBStringByCompactingCharacters(NSString *string,
+                                                NSUInteger (^block)(unichar *characters,
+                                                                    NSUInteger length)) {
+  NSUInteger length = string.length;
+  if (length == 0) {
+    return @"";
+  }
+
+  unichar stackBuffer[NB_SCANNER_STACK_LENGTH];
+  unichar *characters =
+      (length <= NB_SCANNER_STACK_LENGTH) ? stackBuffer : malloc(length * sizeof(unichar));
+  [string getCharacters:characters range:NSMakeRange(0, length)];
+
+  NSUInteger resultLength = block(characters, length);
+  NSString *result = [NSString stringWithCharacters:characters length:resultLength];
+
+  if (characters != stackBuffer) {
+    free(characters);
+  }
+  return result;
+}
+
+// Equivalent to mapping the string with DIGIT_MAPPINGS, removing non-matches.
+static NSString *NBStringByNormalizingDigits(NSString *string) {
+  return NBStringByCompactingCharacters(string, ^NSUInteger(unichar *characters, NSUInteger length) {
+    NSUInteger resultLength = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+      int value = NBMappedDigitValue(characters[i]);
+      if (value >= 0) {
+        characters[resultLength++] = (unichar)('0' + value);
+      }
+    }
+    return resultLength;
+  });
+}
+
+// Equivalent to mapping the string with DIALLABLE_CHAR_MAPPINGS, removing non-matches.
+static NSString *NBStringByNormalizingDiallableChars(NSString *string) {
+  return NBStringByCompactingCharacters(string, ^NSUInteger(unichar *characters, NSUInteger length) {
+    NSUInteger resultLength = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+      unichar c = characters[i];
+      if ((c >= '0' && c <= '9') || c == '+' || c == '*' || c == '#') {
+        characters[resultLength++] = c;
+      }
+    }
+    return resultLength;
+  });
+}
+
+// Equivalent to -normalizeHelper: with ALL_NORMALIZATION_MAPPINGS, removing
+// non-matches. Non-ASCII characters other than digits are rare, so they still
+// go through the (uppercased) dictionary lookup.
+static NSString *NBStringByNormalizingAlphaNumber(NSString *string, NSDictionary *mappings) {
+  return NBStringByCompactingCharacters(string, ^NSUInteger(unichar *characters, NSUInteger length) {
+    NSUInteger resultLength = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+      unichar c = characters[i];
+      int value = NBValidDigitValue(c);
+      if (value >= 0) {
+        characters[resultLength++] = (unichar)('0' + value);
+      } else if (NBIsASCIIAlpha(c)) {
+        characters[resultLength++] = (unichar)kNBKeypadDigits[(c | 0x20) - 'a'];
+      } else if (c >= 0x80) {
+        NSString *key = [[NSString stringWithCharacters:&c length:1] uppercaseString];
+        NSString *mapped = mappings[key];
+        if (mapped.length == 1) {
+          characters[resultLength++] = [mapped characterAtIndex:0];
+        }
+      }
+    }
+    return resultLength;
+  });
+}
+
+// Equivalent to matching VALID_ALPHA_PHONE_PATTERN_STRING against the entire
+// string: at least three ASCII letters, and nothing that '.' can't match.
+static BOOL NBIsAlphaPhoneNumber(NSString *string) {
+  CFIndex length = (CFIndex)string.length;
+  if (length < 3) {
+    return NO;
+  }
+
+  CFStringInlineBuffer buffer;
+  CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+  NSUInteger letterCount = 0;
+  for (CFIndex i = 0; i < length; i++) {
+    unichar c = CFStringGetCharacterFromInlineBuffer(&buffer, i);
+    if (NBIsASCIIAlpha(c)) {
+      letterCount++;
+    } else if (NBIsLineTerminator(c)) {
+      return NO;
+    }
+  }
+  return letterCount >= 3;
+}
+
+// The number of characters matched by LEADING_PLUS_CHARS_PATTERN.
+static NSUInteger NBLeadingPlusCharCount(NSString *string) {
+  NSUInteger length = string.length;
+  NSUInteger count = 0;
+  while (count < length && NBIsPlusChar([string characterAtIndex:count])) {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * Finds the possible number in the string, as -extractPossibleNumber: did with
+ * VALID_START_CHAR_PATTERN, UNWANTED_END_CHAR_PATTERN and
+ * SECOND_NUMBER_START_PATTERN. Returns NSNotFound for the location if there's no
+ * valid start character.
+ */
+static NSRange NBRangeOfPossibleNumber(NSString *string) {
+  CFIndex length = (CFIndex)string.length;
+  if (length == 0) {
+    return NSMakeRange(NSNotFound, 0);
+  }
+
+  CFStringInlineBuffer buffer;
+  CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+  // [+＋ digits]
+  CFIndex start = 0;
+  while (start < length) {
+    unichar c = CFStringGetCharacterFromInlineBuffer(&buffer, start);
+    if (NBIsPlusChar(c) || NBValidDigitValue(c) >= 0) {
+      break;
+    }
+    start++;
+  }
+  if (start == length) {
+    return NSMakeRange(NSNotFound, 0);
+  }
+
+  // [^digits A-Za-z #]+$
+  CFIndex end = length;
+  while (end > start) {
+    unichar c = CFStringGetCharacterFromInlineBuffer(&buffer, end - 1);
+    if (NBValidDigitValue(c) >= 0 || NBIsASCIIAlpha(c) || c == '#') {
+      break;
+    }
+    end--;
+  }
+
+  // [\\/] *x, which has to be past the start of the number to count.
+  for (CFIndex i = start + 1; i < end; i++) {
+    unichar c = CFStringGetCharacterFromInlineBuffer(&buffer, i);
+    if (c != '\\' && c != '/') {
+      continue;
+    }
+    CFIndex j = i + 1;
+    while (j < end && CFStringGetCharacterFromInlineBuffer(&buffer, j) == ' ') {
+      j++;
+    }
+    if (j < end && CFStringGetCharacterFromInlineBuffer(&buffer, j) == 'x') {
+      end = i;
+      break;
+    }
+  }
+
+  return NSMakeRange((NSUInteger)start, (NSUInteger)(end - start));
+}
+
+/**
+ * Decides the common cases of matching VALID_PHONE_NUMBER_PATTERN against the
+ * entire string: a run of digits and punctuation (with at least three digits)
+ * after any plus signs, or exactly two digits. Anything with letters or other
+ * characters, which might be an alpha number or an extension, is left to the
+ * pattern.
+ */
+static NBScanResult NBScanViablePhoneNumber(NSString *string) {
+  CFIndex length = (CFIndex)string.length;
+  if (length == 0) {
+    return NBScanResultNoMatch;
+  }
+
+  CFStringInlineBuffer buffer;
+  CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+  CFIndex i = 0;
+  while (i < length && NBIsPlusChar(CFStringGetCharacterFromInlineBuffer(&buffer, i))) {
+    i++;
+  }
+
+  NSUInteger digitCount = 0;
+  BOOL isDigitsAndPunctuation = YES;
+  for (; i < length; i++) {
+    unichar c = CFStringGetCharacterFromInlineBuffer(&buffer, i);
+    if (NBValidDigitValue(c) >= 0) {
+      digitCount++;
+    } else if (!NBIsValidPunctuation(c)) {
+      isDigitsAndPunctuation = NO;
+    }
+  }
+
+  // Every alternative needs at least three digits, apart from a string of exactly two digits.
+  if (digitCount < 3) {
+    return (digitCount == 2 && length == 2) ? NBScanResultMatch : NBScanResultNoMatch;
+  }
+  return isDigitsAndPunctuation ? NBScanResultMatch : NBScanResultUnknown;
+}
+
+// NO if the string can't match EXTN_PATTERN, because it has none of the
+// characters that an extension has to be introduced by (';', ',', '#', '~',
+// letters, or anything non-ASCII other than digits).
+static BOOL NBMayContainExtension(NSString *string) {
+  CFIndex length = (CFIndex)string.length;
+  if (length == 0) {
+    return NO;
+  }
+
+  CFStringInlineBuffer buffer;
+  CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+  for (CFIndex i = 0; i < length; i++) {
+    unichar c = CFStringGetCharacterFromInlineBuffer(&buffer, i);
+    if (c < 0x80) {
+      if (NBIsASCIIAlpha(c) || c == ';' || c == ',' || c == '#' || c == '~') {
+        return YES;
+      }
+    } else if (NBValidDigitValue(c) < 0) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
 #pragma mark - NBPhoneNumberUtil interface -
 
 @interface NBPhoneNumberUtil ()
@@ -179,18 +508,15 @@ static NSArray *GEO_MOBILE_COUNTRIES;
   NSError *error = nil;
   NSRegularExpression *currentPattern =
       [self regularExpressionWithPattern:pattern options:0 error:&error];
-  NSArray *matches = [currentPattern matchesInString:sourceString
-                                             options:0
-                                               range:NSMakeRange(0, sourceString.length)];
+  NSRange matchRange = [currentPattern rangeOfFirstMatchInString:sourceString
+                                                         options:0
+                                                           range:NSMakeRange(0, sourceString.length)];
 
-  int foundPosition = -1;
-
-  if (matches.count > 0) {
-    NSTextCheckingResult *match = [matches objectAtIndex:0];
-    return (int)match.range.location;
+  if (matchRange.location != NSNotFound) {
+    return (int)matchRange.location;
   }
 
-  return foundPosition;
+  return -1;
 }
 
 - (int)indexOfStringByString:(NSString *)sourceString target:(NSString *)targetString {
@@ -269,11 +595,9 @@ static NSArray *GEO_MOBILE_COUNTRIES;
   NSError *error = nil;
   NSRegularExpression *currentPattern =
       [self regularExpressionWithPattern:pattern options:0 error:&error];
-  NSArray *matches = [currentPattern matchesInString:sourceString
-                                             options:0
-                                               range:NSMakeRange(0, sourceString.length)];
-  if ([matches count] > 0) return [matches objectAtIndex:0];
-  return nil;
+  return [currentPattern firstMatchInString:sourceString
+                                    options:0
+                                      range:NSMakeRange(0, sourceString.length)];
 }
 
 - (NSArray *)matchesByRegex:(NSString *)sourceString regex:(NSString *)pattern {
@@ -302,17 +626,12 @@ static NSArray *GEO_MOBILE_COUNTRIES;
   NSError *error = nil;
   NSRegularExpression *currentPattern =
       [self regularExpressionWithPattern:pattern options:0 error:&error];
-  NSArray *matches = [currentPattern matchesInString:sourceString
-                                             options:0
-                                               range:NSMakeRange(0, sourceString.length)];
-
-  for (NSTextCheckingResult *match in matches) {
-    if (match.range.location == 0) {
-      return YES;
-    }
-  }
+  // Matches don't overlap, so if any match starts at 0 it's the first one.
+  NSRange matchRange = [currentPattern rangeOfFirstMatchInString:sourceString
+                                                         options:0
+                                                           range:NSMakeRange(0, sourceString.length)];
 
-  return NO;
+  return matchRange.location == 0;
 }
 
 - (NSString *)stringByReplacingOccurrencesString:(NSString *)sourceString
@@ -560,26 +879,14 @@ static NSArray *GEO_MOBILE_COUNTRIES;
 - (NSString *)extractPossibleNumber:(NSString *)number {
   number = NormalizeNonBreakingSpace(number);
 
-  NSString *possibleNumber = @"";
-  int start = [self stringPositionByRegex:number regex:VALID_START_CHAR_PATTERN];
-
-  if (start >= 0) {
-    possibleNumber = [number substringFromIndex:start];
-    // Remove trailing non-alpha non-numerical characters.
-    possibleNumber =
-        [self replaceStringByRegex:possibleNumber regex:UNWANTED_END_CHAR_PATTERN withTemplate:@""];
-
-    // Check for extra numbers at the end.
-    int secondNumberStart =
-        [self stringPositionByRegex:possibleNumber regex:SECOND_NUMBER_START_PATTERN];
-    if (secondNumberStart > 0) {
-      possibleNumber = [possibleNumber substringWithRange:NSMakeRange(0, secondNumberStart)];
-    }
-  } else {
-    possibleNumber = @"";
+  // Strips the leading characters up to VALID_START_CHAR_PATTERN, the trailing
+  // non-alpha non-numerical characters, and any extra numbers at the end.
+  NSRange possibleNumberRange = NBRangeOfPossibleNumber(number);
+  if (possibleNumberRange.location == NSNotFound) {
+    return @"";
   }
 
-  return possibleNumber;
+  return [number substringWithRange:possibleNumberRange];
 }
 
 /**
@@ -601,6 +908,15 @@ static NSArray *GEO_MOBILE_COUNTRIES;
     return NO;
   }
 
+  switch (NBScanViablePhoneNumber(phoneNumber)) {
+    case NBScanResultMatch:
+      return YES;
+    case NBScanResultNoMatch:
+      return NO;
+    case NBScanResultUnknown:
+      break;
+  }
+
   return [self matchesEntirely:VALID_PHONE_NUMBER_PATTERN string:phoneNumber];
 }
 
@@ -622,10 +938,8 @@ static NSArray *GEO_MOBILE_COUNTRIES;
  * @return {string} the normalized string version of the phone number.
  */
 - (NSString *)normalize:(NSString *)number {
-  if ([self matchesEntirely:VALID_ALPHA_PHONE_PATTERN_STRING string:number]) {
-    return [self normalizeHelper:number
-        normalizationReplacements:ALL_NORMALIZATION_MAPPINGS
-                 removeNonMatches:true];
+  if (NBIsAlphaPhoneNumber(number)) {
+    return NBStringByNormalizingAlphaNumber(number, ALL_NORMALIZATION_MAPPINGS);
   } else {
     return [self normalizeDigitsOnly:number];
   }
@@ -660,11 +974,8 @@ static NSArray *GEO_MOBILE_COUNTRIES;
  * @return {string} the normalized string version of the phone number.
  */
 - (NSString *)normalizeDigitsOnly:(NSString *)number {
-  number = NormalizeNonBreakingSpace(number);
-
-  return [self stringByReplacingOccurrencesString:number
-                                          withMap:self.DIGIT_MAPPINGS
-                                 removeNonMatches:YES];
+  // Non-breaking spaces aren't digits, so there's no need to normalize them first.
+  return NBStringByNormalizingDigits(number);
 }
 
 /**
@@ -676,11 +987,7 @@ static NSArray *GEO_MOBILE_COUNTRIES;
  * @return {string} the normalized string version of the phone number.
  */
 - (NSString *)normalizeDiallableCharsOnly:(NSString *)number {
-  number = NormalizeNonBreakingSpace(number);
-
-  return [self stringByReplacingOccurrencesString:number
-                                          withMap:DIALLABLE_CHAR_MAPPINGS
-                                 removeNonMatches:YES];
+  return NBStringByNormalizingDiallableChars(number);
 }
 
 /**
@@ -2610,7 +2917,7 @@ static NSArray *GEO_MOBILE_COUNTRIES;
   NSString *strippedNumber = [number copy];
   [self maybeStripExtension:&strippedNumber];
 
-  return [self matchesEntirely:VALID_ALPHA_PHONE_PATTERN_STRING string:strippedNumber];
+  return NBIsAlphaPhoneNumber(strippedNumber);
 }
 
 /**
@@ -3210,9 +3517,9 @@ static NSArray *GEO_MOBILE_COUNTRIES;
   }
 
   // Check to see if the number begins with one or more plus signs.
-  if ([self isStartingStringByRegex:(*numberStr)regex:LEADING_PLUS_CHARS_PATTERN]) {
-    (*numberStr) =
-        [self replaceStringByRegex:(*numberStr)regex:LEADING_PLUS_CHARS_PATTERN withTemplate:@""];
+  NSUInteger leadingPlusCharCount = NBLeadingPlusCharCount(*numberStr);
+  if (leadingPlusCharCount > 0) {
+    (*numberStr) = [(*numberStr) substringFromIndex:leadingPlusCharCount];
     // Can now normalize the rest of the number since we've consumed the '+'
     // sign at the start.
     (*numberStr) = [self normalize:(*numberStr)];
@@ -3329,6 +3636,11 @@ static NSArray *GEO_MOBILE_COUNTRIES;
     return @"";
   }
 
+  // Most numbers have nothing that could introduce an extension.
+  if (!NBMayContainExtension(*number)) {
+    return @"";
+  }
+
   NSString *numberStr = [(*number)copy];
   int mStart = [self stringPositionByRegex:numberStr regex:EXTN_PATTERN];
 
@@ -3373,8 +3685,7 @@ static NSArray *GEO_MOBILE_COUNTRIES;
 - (BOOL)checkRegionForParsing:(NSString *)numberToParse defaultRegion:(NSString *)defaultRegion {
   // If the number is nil or empty, we can't infer the region.
   return [self isValidRegionCode:defaultRegion] ||
-         (numberToParse != nil && numberToParse.length > 0 &&
-          [self isStartingStringByRegex:numberToParse regex:LEADING_PLUS_CHARS_PATTERN]);
+         NBLeadingPlusCharCount(numberToParse) > 0;
 }
 
 /**
@@ -3417,6 +3728,66 @@ static NSArray *GEO_MOBILE_COUNTRIES;
   return phoneNumber;
 }
 
+/**
+ * Parses each of the numbers with the same default region, on several threads.
+ *
+ * The numbers are split into contiguous chunks, one per worker. A util keeps
+ * per-instance caches (the metadata helper's current region in particular), so
+ * every worker other than the first gets a util of its own.
+ *
+ * - param {Array.<string>} numbersToParse the numbers to parse.
+ * - param {?string} defaultRegion region that we are expecting the numbers to be
+ *     from.
+ * @return {Array} an NBPhoneNumber for each of the numbers, in order, or NSNull
+ *     if the number couldn't be parsed.
+ */
+- (NSArray *)parseNumbers:(NSArray *)numbersToParse defaultRegion:(NSString *)defaultRegion {
+  NSUInteger count = numbersToParse.count;
+  if (count == 0) {
+    return @[];
+  }
+
+  // Below this, a worker isn't worth its setup.
+  const NSUInteger minChunkLength = 64;
+  NSUInteger workerCount = MAX((NSUInteger)1, [NSProcessInfo processInfo].activeProcessorCount);
+  NSUInteger chunkCount = MIN(workerCount, (count + minChunkLength - 1) / minChunkLength);
+  NSUInteger chunkLength = (count + chunkCount - 1) / chunkCount;
+
+  NSMutableArray *chunkResults = [[NSMutableArray alloc] initWithCapacity:chunkCount];
+  for (NSUInteger chunk = 0; chunk < chunkCount; chunk++) {
+    [chunkResults addObject:[NSNull null]];
+  }
+  NSLock *chunkResultsLock = [[NSLock alloc] init];
+
+  dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                 ^(size_t chunk) {
+                   NBPhoneNumberUtil *util = (chunk == 0) ? self : [[[self class] alloc] init];
+                   NSUInteger start = chunk * chunkLength;
+                   NSUInteger end = MIN(count, start + chunkLength);
+
+                   NSMutableArray *results = [[NSMutableArray alloc] initWithCapacity:end - start];
+                   for (NSUInteger i = start; i < end; i++) {
+                     @autoreleasepool {
+                       NSError *error = nil;
+                       NBPhoneNumber *phoneNumber = [util parse:numbersToParse[i]
+                                                  defaultRegion:defaultRegion
+                                                          error:&error];
+                       [results addObject:(phoneNumber && !error) ? phoneNumber : [NSNull null]];
+                     }
+                   }
+
+                   [chunkResultsLock lock];
+                   chunkResults[chunk] = results;
+                   [chunkResultsLock unlock];
+                 });
+
+  NSMutableArray *parsedNumbers = [[NSMutableArray alloc] initWithCapacity:count];
+  for (NSArray *results in chunkResults) {
+    [parsedNumbers addObjectsFromArray:results];
+  }
+  return parsedNumbers;
+}
+
 /**
  * Parses a string using the phone's carrier region (when available, ZZ otherwise).
  * This uses the country the sim card in the phone is registered with.
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+#
+# Compiles PhoneNumberMetaData.json (and PhoneNumberMetaDataForTesting.json) into
+# libPhoneNumber/NBGeneratedPhoneNumberMetaData.h.
+#
+# The JSON used to be embedded gzipped, and was inflated & parsed with NSJSONSerialization
+# the first time any metadata was needed. Instead, it's compiled here into a flat, offset-based
+# binary format which NBMetadataHelper reads in place, only materializing the regions it's asked for.
+#
+# Usage:
+#   GeneratePhoneNumberBinaryMetaData.py PhoneNumberMetaData.json PhoneNumberMetaDataForTesting.json \
+#       > ../libPhoneNumber/NBGeneratedPhoneNumberMetaData.h
+#
+# Format (all integers are little-endian, all offsets are from the start of the data):
+#
+#   Header
+#     char[4]   magic "NBMD"
+#     uint32    version (1)
+#     uint32    total length in bytes
+#     uint32    string count,       uint32 string table offset
+#     uint32    region count,       uint32 region table offset
+#     uint32    country code count, uint32 country code table offset
+#
+#   String table: {uint32 offset, uint32 length} per string.
+#     Strings are UTF-8, deduplicated, and NUL terminated (the length excludes the NUL).
+#
+#   Region table: {uint32 region code string index, uint32 entry offset} per region,
+#     sorted by region code (bytewise). Non-geographical entities use their calling code as the region code.
+#
+#   Country code table: {uint32 country calling code, uint32 region list offset} per calling code,
+#     sorted by calling code. A region list is a uint32 count followed by that many string indexes,
+#     main country first.
+#
+#   Entries are the same nested arrays as in the JSON, encoded as tagged values:
+#     0x00  null
+#     0x01  int32
+#     0x02  string (uint32 string index)
+#     0x03  array (uint32 count, followed by that many values)
+
+import json
+import struct
+import sys
+
+MAGIC = b'NBMD'
+VERSION = 1
+HEADER_LENGTH = 36
+
+TAG_NULL = 0
+TAG_INT = 1
+TAG_STRING = 2
+TAG_ARRAY = 3
+
+
+class StringTable(object):
+
+    def __init__(self):
+        self.indexes = {}
+        self.strings = []
+
+    def index(self, string):
+        if string not in self.indexes:
+            self.indexes[string] = len(self.strings)
+            self.strings.append(string)
+        return self.indexes[string]
+
+
+def encode_value(value, strings, out):
+    if value is None:
+        out += struct.pack('<B', TAG_NULL)
+    elif isinstance(value, bool):
+        out += struct.pack('<Bi', TAG_INT, int(value))
+    elif isinstance(value, int):
+        out += struct.pack('<Bi', TAG_INT, value)
+    elif isinstance(value, str):
+        out += struct.pack('<BI', TAG_STRING, strings.index(value))
+    elif isinstance(value, list):
+        out += struct.pack('<BI', TAG_ARRAY, len(value))
+        for item in value:
+            encode_value(item, strings, out)
+    else:
+        raise ValueError('Unsupported metadata value: %r' % (value,))
+
+
+def compile_metadata(metadata):
+    strings = StringTable()
+
+    regions = sorted(metadata['countryToMetadata'].items(), key=lambda item: item[0].encode('utf-8'))
+    country_codes = sorted(metadata['countryCodeToRegionCodeMap'].items(), key=lambda item: int(item[0]))
+
+    # Entries are laid out right after the header, so their offsets are known as they're encoded.
+    entries = bytearray()
+    region_table = []
+    for region_code, entry in regions:
+        region_table.append((strings.index(region_code), HEADER_LENGTH + len(entries)))
+        encode_value(entry, strings, entries)
+
+    region_lists = bytearray()
+    region_lists_offset = HEADER_LENGTH + len(entries)
+    country_code_table = []
+    for country_code, region_codes in country_codes:
+        country_code_table.append((int(country_code), region_lists_offset + len(region_lists)))
+        region_lists += struct.pack('<I', len(region_codes))
+        for region_code in region_codes:
+            region_lists += struct.pack('<I', strings.index(region_code))
+
+    string_data = bytearray()
+    string_data_offset = region_lists_offset + len(region_lists)
+    string_table = []
+    for string in strings.strings:
+        encoded = string.encode('utf-8')
+        string_table.append((string_data_offset + len(string_data), len(encoded)))
+        string_data += encoded + b'\0'
+
+    # Tables are aligned, since they're read as uint32s.
+    padding = (4 - (string_data_offset + len(string_data)) % 4) % 4
+    string_data += b'\0' * padding
+
+    tables = bytearray()
+    tables_offset = string_data_offset + len(string_data)
+
+    string_table_offset = tables_offset + len(tables)
+    for offset, length in string_table:
+        tables += struct.pack('<II', offset, length)
+
+    region_table_offset = tables_offset + len(tables)
+    for string_index, entry_offset in region_table:
+        tables += struct.pack('<II', string_index, entry_offset)
+
+    country_code_table_offset = tables_offset + len(tables)
+    for country_code, list_offset in country_code_table:
+        tables += struct.pack('<II', country_code, list_offset)
+
+    total_length = tables_offset + len(tables)
+
+    header = MAGIC + struct.pack('<IIIIIIII',
+                                 VERSION, total_length,
+                                 len(string_table), string_table_offset,
+                                 len(region_table), region_table_offset,
+                                 len(country_code_table), country_code_table_offset)
+    assert len(header) == HEADER_LENGTH
+
+    data = header + entries + region_lists + string_data + tables
+    assert len(data) == total_length
+    return bytes(data)
+
+
+def format_bytes(data):
+    lines = []
+    for start in range(0, len(data), 12):
+        chunk = data[start:start + 12]
+        lines.append('  ' + ', '.join('0x%02x' % byte for byte in chunk) + ',')
+    if lines:
+        lines[-1] = lines[-1].rstrip(',')
+    return '\n'.join(lines)
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: %s PhoneNumberMetaData.json PhoneNumberMetaDataForTesting.json\n' % argv[0])
+        return 1
+
+    with open(argv[1]) as f:
+        metadata = compile_metadata(json.load(f))
+    with open(argv[2]) as f:
+        testing_metadata = compile_metadata(json.load(f))
+
+    sys.stdout.write('''/*****
+ * Data Generated from GeneratePhoneNumberBinaryMetaData.py
+ * Off of PhoneNumberMetaDataForTesting.json and PhoneNumberMetaData.json
+ *
+ * The format is described in GeneratePhoneNumberBinaryMetaData.py.
+ * The data is read in place (it's mapped in from the binary along with the rest of __TEXT),
+ * so only the pages for the regions that are actually used ever get touched.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if TESTING==1
+
+const uint8_t kPhoneNumberMetaData[] __attribute__((aligned(4))) = {
+%s
+};
+const size_t kPhoneNumberMetaDataLength = sizeof(kPhoneNumberMetaData);
+
+#else  // TESTING == 1
+
+const uint8_t kPhoneNumberMetaData[] __attribute__((aligned(4))) = {
+%s
+};
+const size_t kPhoneNumberMetaDataLength = sizeof(kPhoneNumberMetaData);
+
+#endif  // TESTING
+''' % (format_bytes(testing_metadata), format_bytes(metadata)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
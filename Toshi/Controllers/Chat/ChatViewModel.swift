@@ -331,11 +331,27 @@ final class ChatViewModel {
             let numberOfItemsInSection = strongSelf.loadedMappings.numberOfItems(inSection: 0)
             strongSelf.loadedMessagesCount += numberOfItemsInSection
 
+            guard let dbExtension = transaction.ext(TSMessageDatabaseViewExtensionName) as? YapDatabaseViewTransaction else { return }
+
+            // Look up the whole page's keys first, so that the messages themselves are fetched in one batch.
+            var collectionKeys = [YapCollectionKey]()
             for i in 0 ..< numberOfItemsInSection {
                 let indexPath = IndexPath(row: Int(i), section: 0)
-                guard let dbExtension = transaction.ext(TSMessageDatabaseViewExtensionName) as? YapDatabaseViewTransaction else { return }
 
-                guard let signalMessage = dbExtension.object(at: indexPath, with: strongSelf.loadedMappings) as? TSMessage else { return }
+                var key: NSString?
+                var collection: NSString?
+                guard dbExtension.getKey(&key, collection: &collection, at: indexPath, with: strongSelf.loadedMappings), let messageKey = key else { return }
+
+                collectionKeys.append(YapCollectionKey(collection: collection as String?, key: messageKey as String))
+            }
+
+            var didLoadAllMessages = true
+            transaction.enumerateObjects(forCollectionKeys: collectionKeys) { _, _, object, stop in
+                guard let signalMessage = object as? TSMessage else {
+                    didLoadAllMessages = false
+                    stop.pointee = true
+                    return
+                }
 
                 var shouldProcess = false
                 if SofaType(sofa: String.contentsOrEmpty(for: signalMessage.body)) == .paymentRequest {
@@ -345,6 +361,8 @@ final class ChatViewModel {
                 messages.append(strongSelf.interactor.handleSignalMessage(signalMessage, shouldProcessCommands: shouldProcess))
             }
 
+            guard didLoadAllMessages else { return }
+
             let current = Set(messages)
             let previous = Set(strongSelf.messages)
             let new = current.subtracting(previous).sorted { (message1, message2) -> Bool in
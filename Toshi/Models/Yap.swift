@@ -277,8 +277,13 @@ final class Yap: NSObject, Singleton {
         var objects = [Any]()
 
         mainConnection?.read { transaction in
-            transaction.enumerateKeysAndObjects(inCollection: collection) { _, object, _ in
-                objects.append(object)
+            // Fetching by key lets cached objects be reused, and deserializes the rest in parallel.
+            let collectionKeys = transaction.allKeys(inCollection: collection).map { YapCollectionKey(collection: collection, key: $0) }
+
+            transaction.enumerateObjects(forCollectionKeys: collectionKeys) { _, _, object, _ in
+                if let object = object {
+                    objects.append(object)
+                }
             }
         }
 
@@ -31,6 +31,7 @@
 #import <YapDatabase/YapDatabaseFilteredViewConnection.h>
 #import <YapDatabase/YapDatabaseFilteredViewTransaction.h>
 #import <YapDatabase/YapDatabaseAutoView.h>
+#import <YapDatabase/YapCollectionKey.h>
 
 #import <SignalServiceKit/NotificationsProtocol.h>
 #import <SignalServiceKit/OWSGetMessagesRequest.h>
@@ -67,6 +68,7 @@
 #import <SignalServiceKit/TSStorageManager.h>
 #import <SignalServiceKit/OWSIdentityManager.h>
 #import <SignalServiceKit/OWSMessageManager.h>
+#import <SignalServiceKit/OWSIncomingMessageFinder.h>
 #import <SignalServiceKit/TSStorageManager+SessionStore.h>
 #import <SignalServiceKit/TSAccountManager.h>
 #import <SignalServiceKit/TSStorageManager+PreKeyStore.h>
@@ -100,6 +102,9 @@
 
 #import <Mantle/MTLModel.h>
 
+#import <CocoaLumberjack/DDLog.h>
+#import <CocoaLumberjack/DDFileLogger.h>
+
 #import "PrekeysRequest.h"
 
 #import <Curve25519.h>
@@ -66,6 +66,8 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
 
         APIKeysManager.setup()
 
+        setupLogging()
+
         Theme.setupBasicAppearance()
 
         UIApplication.shared.applicationIconBadgeNumber = 0
@@ -198,6 +200,19 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
         NotificationCenter.default.post(name: .ChatDatabaseCreated, object: nil)
     }
 
+    private func setupLogging() {
+        #if DEBUG
+            // Chat logs can contain private data, so they're only written to disk in debug builds.
+            // Buffering keeps the file logger from doing a write for every message the chat kit logs.
+            let fileLogger = DDFileLogger()
+            fileLogger.rollingFrequency = 60 * 60 * 24
+            fileLogger.logFileManager.maximumNumberOfLogFiles = 3
+            fileLogger.logBufferSize = 64 * 1024
+
+            DDLog.add(fileLogger)
+        #endif
+    }
+
     private func setupTSKitEnvironment() {
         ALog("Setting up Signal KIT environment")
 
@@ -254,7 +269,16 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
 
         // We need to make sure completion handler is called within 30 seconds after notification is received
         DispatchQueue.main.asyncAfter(seconds: 20, execute: {
-            completionHandler(.newData)
+            // The app can be suspended after this without resigning active or entering the background,
+            // so save the duplicate message filter before reporting the fetch as done.
+            guard let database = TSStorageManager.shared().database() else {
+                completionHandler(.newData)
+                return
+            }
+
+            OWSIncomingMessageFinder.persistDuplicateFilter(for: database) {
+                completionHandler(.newData)
+            }
         })
 
         SessionManager.shared.messageFetcherJob?.run()